@@ -0,0 +1,225 @@
+# 共享的shader编译模块
+#
+# compile_shaders(<target> [shader files...])
+#   不指定shader文件时，编译 ${CMAKE_CURRENT_SOURCE_DIR}/Shaders/*.hlsl。
+#   每个shader文件编译其中定义了的VSMain、PSMain和CSMain入口，生成：
+#   - 头文件 <name>VS.h / <name>PS.h / <name>CS.h，字节码数组为 g_<name>_VSMain / g_<name>_PSMain / g_<name>_CSMain
+#   - 打包了target所有字节码的 <target>.shaderpack，构建后复制到可执行文件所在目录
+#   - ShaderBindgen从hlsl声明生成的 <name>Bindings.h：常量缓冲区结构体、VSMain的输入布局、图形和计算的根签名
+#
+# fill_shader_cache(<target> [shader files...])
+#   只编译Debug和Release两种配置的全部入口并生成绑定，不生成shaderpack。
+#   用于没有D3D12的平台，例如Linux构建集群预先填充SHADER_CACHE_DIR，同时检查hlsl的声明都能生成绑定。
+#
+# 优先使用DXC (Shader Model 6)，找不到时在Windows上退回fxc (Shader Model 5)。
+# 每个入口是一条独立的编译命令，Ninja/Makefile生成器会并行执行。
+# 编译结果按内容哈希(源文件、同目录的头文件、编译器版本、参数)存放在SHADER_CACHE_DIR中，
+# 多个构建目录共用，内容不变的shader不会重新编译。DXC的版本取自 dxc --version，
+# 同一版本在Windows和Linux上的键相同，见Scripts/ShaderCompilerVersion.cmake。
+
+set(SHADER_COMPILER "" CACHE STRING "DXC or FXC, empty picks DXC when it can be found")
+set(SHADER_CACHE_DIR ${CMAKE_SOURCE_DIR}/Library/ShaderCache CACHE PATH "Compiled shaders shared by every build directory")
+
+set(_compile_shaders_script_dir ${CMAKE_CURRENT_LIST_DIR}/Scripts)
+include(${_compile_shaders_script_dir}/ShaderCompilerVersion.cmake)
+
+# 寻找shader编译器
+if(WIN32)
+    get_filename_component(WINDOWS_KITS_DIR
+        "[HKEY_LOCAL_MACHINE\\SOFTWARE\\Microsoft\\Windows Kits\\Installed Roots;KitsRoot10]" ABSOLUTE)
+    set(_windows_kits_bin_dir ${WINDOWS_KITS_DIR}/bin/${CMAKE_VS_WINDOWS_TARGET_PLATFORM_VERSION}/x64)
+endif()
+
+find_program(DXC_EXECUTABLE dxc HINTS ${_windows_kits_bin_dir} $ENV{VULKAN_SDK}/bin)
+find_program(FXC_EXECUTABLE fxc HINTS ${_windows_kits_bin_dir})
+
+if(SHADER_COMPILER STREQUAL "")
+    if(DXC_EXECUTABLE)
+        set(_shader_compiler_kind DXC)
+    else()
+        set(_shader_compiler_kind FXC)
+    endif()
+else()
+    string(TOUPPER ${SHADER_COMPILER} _shader_compiler_kind)
+endif()
+
+if(_shader_compiler_kind STREQUAL "DXC")
+    set(_shader_compiler ${DXC_EXECUTABLE})
+    set(_shader_model 6_0)
+elseif(_shader_compiler_kind STREQUAL "FXC")
+    set(_shader_compiler ${FXC_EXECUTABLE})
+    set(_shader_model 5_0)
+else()
+    message(FATAL_ERROR "Unknown SHADER_COMPILER ${SHADER_COMPILER}, use DXC or FXC")
+endif()
+
+if(NOT _shader_compiler)
+    message(FATAL_ERROR "No shader compiler found, set DXC_EXECUTABLE or FXC_EXECUTABLE")
+endif()
+
+# 编译器版本也是哈希的一部分，升级编译器后缓存自动失效
+get_shader_compiler_version(_shader_compiler_version ${_shader_compiler} ${_shader_compiler_kind})
+message(STATUS "Shader compiler: ${_shader_compiler} (${_shader_compiler_version})")
+
+# 为shader文件中定义了的每个入口添加一条编译命令，生成的stamp和字节码追加到 _out_stamps 和 _out_objects
+# _debug 传给CompileShader.cmake的DEBUG，可以是生成器表达式
+function(_add_shader_entry_commands _shader_file _debug _header_dir _object_dir _out_stamps _out_objects)
+    # 同目录的头文件可能被include，修改后也需要重新编译
+    get_filename_component(_shader_dir ${_shader_file} DIRECTORY)
+    file(GLOB _shader_includes CONFIGURE_DEPENDS ${_shader_dir}/*.hlsli ${_shader_dir}/*.h)
+
+    get_filename_component(_shader_name ${_shader_file} NAME_WE)
+
+    # 只编译文件中定义了的入口，入口的增减在重新配置时生效
+    file(READ ${_shader_file} _shader_source)
+    set(_shader_stages "")
+    foreach(_stage VS PS CS)
+        if(_shader_source MATCHES "${_stage}Main[ \t\r\n]*\\(")
+            list(APPEND _shader_stages ${_stage})
+        endif()
+    endforeach()
+
+    set(_stamps ${${_out_stamps}})
+    set(_objects ${${_out_objects}})
+    foreach(_stage ${_shader_stages})
+        string(TOLOWER ${_stage} _stage_prefix)
+        set(_shader_header ${_header_dir}/${_shader_name}${_stage}.h)
+        set(_shader_object ${_object_dir}/${_shader_name}${_stage}.cso)
+        set(_shader_stamp ${_object_dir}/${_shader_name}${_stage}.stamp)
+
+        # 头文件内容不变时不会被改写，引用它的cpp也就不会重新编译
+        add_custom_command(
+            OUTPUT ${_shader_stamp}
+            BYPRODUCTS ${_shader_header} ${_shader_object}
+            COMMAND ${CMAKE_COMMAND}
+                -DCOMPILER=${_shader_compiler}
+                -DCOMPILER_KIND=${_shader_compiler_kind}
+                -DCOMPILER_VERSION=${_shader_compiler_version}
+                -DSOURCE=${_shader_file}
+                -DENTRY_POINT=${_stage}Main
+                -DPROFILE=${_stage_prefix}_${_shader_model}
+                -DVARIABLE_NAME=g_${_shader_name}_${_stage}Main
+                -DDEBUG=${_debug}
+                -DCACHE_DIR=${SHADER_CACHE_DIR}
+                -DOUTPUT_HEADER=${_shader_header}
+                -DOUTPUT_OBJECT=${_shader_object}
+                -DOUTPUT_STAMP=${_shader_stamp}
+                -P ${_compile_shaders_script_dir}/CompileShader.cmake
+            DEPENDS ${_shader_file} ${_shader_includes} ${_compile_shaders_script_dir}/CompileShader.cmake
+            COMMENT "Compiling shader ${_shader_name} ${_stage}Main"
+            VERBATIM
+        )
+
+        list(APPEND _stamps ${_shader_stamp})
+        list(APPEND _objects ${_shader_object})
+    endforeach()
+
+    set(${_out_stamps} ${_stamps} PARENT_SCOPE)
+    set(${_out_objects} ${_objects} PARENT_SCOPE)
+endfunction()
+
+function(compile_shaders _target_name)
+    set(_shader_files ${ARGN})
+    if(NOT _shader_files)
+        file(GLOB _shader_files CONFIGURE_DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/Shaders/*.hlsl)
+    endif()
+
+    # shader文件编译所生成头文件和字节码的存放路径
+    set(_generated_shader_header_dir ${CMAKE_CURRENT_BINARY_DIR}/$<CONFIG>/GeneratedShaderHeaders)
+    set(_generated_shader_object_dir ${CMAKE_CURRENT_BINARY_DIR}/$<CONFIG>/GeneratedShaderObjects)
+    target_include_directories(${_target_name} PRIVATE ${_generated_shader_header_dir})
+
+    set(_shader_stamp_files "")
+    set(_shader_object_files "")
+
+    foreach(_single_shader_file ${_shader_files})
+        # 将shader(hlsl)文件加入VS工程
+        target_sources(${_target_name} PRIVATE ${_single_shader_file})
+        set_property(SOURCE ${_single_shader_file} PROPERTY VS_SETTINGS "ExcludedFromBuild=true")
+        source_group("Shader Files" FILES ${_single_shader_file})
+
+        _add_shader_entry_commands(${_single_shader_file} $<CONFIG:Debug>
+            ${_generated_shader_header_dir} ${_generated_shader_object_dir} _shader_stamp_files _shader_object_files)
+
+        get_filename_component(_shader_name ${_single_shader_file} NAME_WE)
+
+        # C++侧的绑定声明由hlsl生成，两边不会再不一致；内容不变时同样不改写头文件
+        set(_bindings_header ${_generated_shader_header_dir}/${_shader_name}Bindings.h)
+        set(_bindings_stamp ${CMAKE_CURRENT_BINARY_DIR}/$<CONFIG>/GeneratedShaderObjects/${_shader_name}Bindings.stamp)
+
+        add_custom_command(
+            OUTPUT ${_bindings_stamp}
+            BYPRODUCTS ${_bindings_header}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${_generated_shader_header_dir}
+            COMMAND $<TARGET_FILE:ShaderBindgen> ${_single_shader_file} ${_bindings_header}
+            COMMAND ${CMAKE_COMMAND} -E touch ${_bindings_stamp}
+            DEPENDS ${_single_shader_file} ShaderBindgen
+            COMMENT "Generating shader bindings ${_shader_name}Bindings.h"
+            VERBATIM
+        )
+
+        list(APPEND _shader_stamp_files ${_bindings_stamp})
+    endforeach()
+
+    # 所有字节码打包为一个文件，运行时不需要链接头文件也能加载，构建后复制到可执行文件旁边
+    set(_shader_pack ${CMAKE_CURRENT_BINARY_DIR}/$<CONFIG>/${_target_name}.shaderpack)
+
+    add_custom_command(
+        OUTPUT ${_shader_pack}
+        COMMAND ${CMAKE_COMMAND}
+            "-DINPUTS=${_shader_object_files}"
+            -DOUTPUT=${_shader_pack}
+            -P ${_compile_shaders_script_dir}/PackShaders.cmake
+        DEPENDS ${_shader_stamp_files} ${_compile_shaders_script_dir}/PackShaders.cmake
+        COMMENT "Packing shaders of ${_target_name}"
+        VERBATIM
+    )
+
+    add_custom_command(TARGET ${_target_name} POST_BUILD
+        COMMAND ${CMAKE_COMMAND} -E copy_if_different ${_shader_pack} $<TARGET_FILE_DIR:${_target_name}>
+        VERBATIM
+    )
+
+    # 实现对shader头文件的依赖
+    set(_shader_target ${_target_name}Shader)
+    add_custom_target(${_shader_target} DEPENDS ${_shader_stamp_files} ${_shader_pack})
+    set_target_properties(${_shader_target} PROPERTIES FOLDER AutoGeneratedTargets)
+    add_dependencies(${_target_name} ${_shader_target})
+endfunction()
+
+function(fill_shader_cache _target_name)
+    set(_shader_stamp_files "")
+    set(_shader_object_files "")
+
+    foreach(_single_shader_file ${ARGN})
+        # 不同示例的shader可以同名，输出按源文件所在目录分开
+        get_filename_component(_shader_dir ${_single_shader_file} DIRECTORY)
+        file(RELATIVE_PATH _relative_dir ${CMAKE_SOURCE_DIR} ${_shader_dir})
+
+        foreach(_config Debug Release)
+            string(COMPARE EQUAL ${_config} Debug _debug)
+            set(_output_dir ${CMAKE_CURRENT_BINARY_DIR}/${_target_name}/${_relative_dir}/${_config})
+            _add_shader_entry_commands(${_single_shader_file} ${_debug}
+                ${_output_dir} ${_output_dir} _shader_stamp_files _shader_object_files)
+        endforeach()
+
+        # 与compile_shaders()相同，内容不变时不改写头文件，所以依赖stamp文件
+        get_filename_component(_shader_name ${_single_shader_file} NAME_WE)
+        set(_bindings_dir ${CMAKE_CURRENT_BINARY_DIR}/${_target_name}/${_relative_dir})
+        set(_bindings_stamp ${_bindings_dir}/${_shader_name}Bindings.stamp)
+        add_custom_command(
+            OUTPUT ${_bindings_stamp}
+            BYPRODUCTS ${_bindings_dir}/${_shader_name}Bindings.h
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${_bindings_dir}
+            COMMAND $<TARGET_FILE:ShaderBindgen> ${_single_shader_file} ${_bindings_dir}/${_shader_name}Bindings.h
+            COMMAND ${CMAKE_COMMAND} -E touch ${_bindings_stamp}
+            DEPENDS ${_single_shader_file} ShaderBindgen
+            COMMENT "Generating shader bindings ${_relative_dir}/${_shader_name}Bindings.h"
+            VERBATIM
+        )
+        list(APPEND _shader_stamp_files ${_bindings_stamp})
+    endforeach()
+
+    add_custom_target(${_target_name} ALL DEPENDS ${_shader_stamp_files})
+    set_target_properties(${_target_name} PROPERTIES FOLDER AutoGeneratedTargets)
+endfunction()
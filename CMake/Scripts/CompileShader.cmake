@@ -0,0 +1,89 @@
+# 编译一个shader入口，由CompileShaders.cmake中的custom command以 cmake -P 调用
+#
+# 输入: COMPILER COMPILER_KIND COMPILER_VERSION SOURCE ENTRY_POINT PROFILE VARIABLE_NAME DEBUG CACHE_DIR
+# 输出: OUTPUT_HEADER OUTPUT_OBJECT OUTPUT_STAMP
+#
+# 结果以内容哈希为名存放在CACHE_DIR中，命中时直接复制，不调用编译器。
+# 也可以在没有完整工程的机器上单独调用，例如在构建集群上预先填充缓存；
+# 这时可以不传COMPILER_VERSION，由get_shader_compiler_version()求得。
+
+cmake_minimum_required(VERSION 3.21)
+
+include(${CMAKE_CURRENT_LIST_DIR}/ShaderCompilerVersion.cmake)
+
+foreach(_input COMPILER COMPILER_KIND SOURCE ENTRY_POINT PROFILE VARIABLE_NAME CACHE_DIR OUTPUT_HEADER OUTPUT_OBJECT)
+    if(NOT DEFINED ${_input})
+        message(FATAL_ERROR "CompileShader.cmake: ${_input} is not set")
+    endif()
+endforeach()
+
+if(NOT DEFINED COMPILER_VERSION)
+    get_shader_compiler_version(COMPILER_VERSION ${COMPILER} ${COMPILER_KIND})
+endif()
+
+# 编译参数，fxc和dxc都接受 - 开头的参数
+if(COMPILER_KIND STREQUAL "DXC")
+    if(DEBUG)
+        set(_flags -Od -Zi -Qembed_debug)
+    else()
+        set(_flags -O3 -Qstrip_debug -Qstrip_reflect)
+    endif()
+else()
+    if(DEBUG)
+        set(_flags -nologo -Od -Zi)
+    else()
+        set(_flags -nologo)
+    endif()
+endif()
+
+# 哈希：源文件、同目录可能被include的头文件、编译器版本和全部参数
+# Windows上签出的文件可能是CRLF换行，统一为LF后各平台的键相同
+get_filename_component(_source_dir ${SOURCE} DIRECTORY)
+file(GLOB _includes ${_source_dir}/*.hlsli ${_source_dir}/*.h)
+list(SORT _includes)
+
+file(READ ${SOURCE} _key_input)
+foreach(_include ${_includes})
+    get_filename_component(_include_name ${_include} NAME)
+    file(READ ${_include} _include_content)
+    string(APPEND _key_input "\n#include ${_include_name}\n${_include_content}")
+endforeach()
+string(REPLACE "\r\n" "\n" _key_input "${_key_input}")
+string(APPEND _key_input "\n${COMPILER_VERSION} ${ENTRY_POINT} ${PROFILE} ${VARIABLE_NAME} ${_flags}")
+string(SHA256 _key "${_key_input}")
+
+set(_cached_header ${CACHE_DIR}/${_key}.h)
+set(_cached_object ${CACHE_DIR}/${_key}.cso)
+
+if(NOT EXISTS ${_cached_header} OR NOT EXISTS ${_cached_object})
+    file(MAKE_DIRECTORY ${CACHE_DIR})
+
+    # 先写临时文件再改名，并行的构建不会读到写了一半的结果
+    string(RANDOM LENGTH 8 _suffix)
+    set(_temporary_header ${CACHE_DIR}/${_key}.${_suffix}.h.tmp)
+    set(_temporary_object ${CACHE_DIR}/${_key}.${_suffix}.cso.tmp)
+
+    execute_process(
+        COMMAND ${COMPILER} ${_flags} -T ${PROFILE} -E ${ENTRY_POINT} -Vn ${VARIABLE_NAME}
+            -Fh ${_temporary_header} -Fo ${_temporary_object} ${SOURCE}
+        RESULT_VARIABLE _result
+    )
+    if(NOT _result EQUAL 0)
+        file(REMOVE ${_temporary_header} ${_temporary_object})
+        message(FATAL_ERROR "Compiling ${SOURCE} ${ENTRY_POINT} (${PROFILE}) failed")
+    endif()
+
+    file(RENAME ${_temporary_object} ${_cached_object})
+    file(RENAME ${_temporary_header} ${_cached_header})
+endif()
+
+# 内容相同时不改写，保留时间戳
+get_filename_component(_header_dir ${OUTPUT_HEADER} DIRECTORY)
+get_filename_component(_object_dir ${OUTPUT_OBJECT} DIRECTORY)
+file(MAKE_DIRECTORY ${_header_dir} ${_object_dir})
+file(COPY_FILE ${_cached_header} ${OUTPUT_HEADER} ONLY_IF_DIFFERENT)
+file(COPY_FILE ${_cached_object} ${OUTPUT_OBJECT} ONLY_IF_DIFFERENT)
+
+if(DEFINED OUTPUT_STAMP)
+    file(TOUCH ${OUTPUT_STAMP})
+endif()
@@ -0,0 +1,34 @@
+# 把多个shader字节码打包为一个文件，由CompileShaders.cmake中的custom command以 cmake -P 调用
+#
+# 输入: INPUTS (字节码文件列表)
+# 输出: OUTPUT
+#
+# 格式为文本索引加上按索引顺序紧密排列的字节码：
+#   SHADERPACK 1
+#   <条目数>
+#   <名字> <字节数>      每个条目一行，名字是去掉扩展名的文件名，例如 ShadersVS
+#   之后是各条目的字节码
+
+cmake_minimum_required(VERSION 3.21)
+
+list(LENGTH INPUTS _count)
+set(_index "SHADERPACK 1\n${_count}\n")
+foreach(_input ${INPUTS})
+    get_filename_component(_name ${_input} NAME_WE)
+    file(SIZE ${_input} _size)
+    string(APPEND _index "${_name} ${_size}\n")
+endforeach()
+
+set(_index_file ${OUTPUT}.index)
+file(WRITE ${_index_file} "${_index}")
+
+# cmake -E cat 按字节拼接，不会改动二进制内容
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E cat ${_index_file} ${INPUTS}
+    OUTPUT_FILE ${OUTPUT}
+    RESULT_VARIABLE _result
+)
+file(REMOVE ${_index_file})
+if(NOT _result EQUAL 0)
+    message(FATAL_ERROR "Packing shaders into ${OUTPUT} failed")
+endif()
@@ -0,0 +1,32 @@
+# 求shader编译器的版本标识，作为缓存键的一部分，由CompileShaders.cmake和CompileShader.cmake共用
+#
+# get_shader_compiler_version(<out_var> <compiler> <kind>)
+#   DXC使用 dxc --version 的输出，例如
+#     Windows: dxcompiler.dll: 1.7 - 1.7.2308.7 (69e54e290); dxil.dll: 1.7(101.7.2308.12)
+#     Linux:   libdxcompiler.so: 1.7 - 1.7.2308.7 (69e54e290); libdxil.so: 1.7(101.7.2308.12)
+#   去掉各平台不同的库文件名后，同一个DXC版本在各平台上得到相同的键，Linux构建集群填充的缓存在Windows上也能命中。
+#   验证器(dxil)的版本保留在键中，没有验证器时生成的字节码没有签名，不能与有签名的混用。
+#   不支持--version的旧版DXC和只有Windows版本的fxc使用可执行文件的SHA256。
+
+function(get_shader_compiler_version _out_var _compiler _kind)
+    if(_kind STREQUAL "DXC")
+        execute_process(
+            COMMAND ${_compiler} --version
+            RESULT_VARIABLE _result
+            OUTPUT_VARIABLE _version
+            ERROR_QUIET
+            OUTPUT_STRIP_TRAILING_WHITESPACE
+        )
+        if(_result EQUAL 0 AND _version MATCHES "dxcompiler")
+            string(REGEX REPLACE "(lib)?(dxcompiler|dxil)\\.(dll|so|dylib)" "\\2" _version "${_version}")
+            string(REGEX REPLACE "[ \t\r\n]+" " " _version "${_version}")
+            # 分号会把custom command的参数拆开
+            string(REPLACE ";" "," _version "${_version}")
+            set(${_out_var} "DXC ${_version}" PARENT_SCOPE)
+            return()
+        endif()
+    endif()
+
+    file(SHA256 ${_compiler} _compiler_hash)
+    set(${_out_var} "${_kind} ${_compiler_hash}" PARENT_SCOPE)
+endfunction()
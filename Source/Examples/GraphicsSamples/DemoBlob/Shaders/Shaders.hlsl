@@ -13,7 +13,6 @@ cbuffer SceneConstantBuffer : register(b0)
 {
 	float2 offset;
 	float aspect;
-	float padding[62];
 };
 
 struct PSInput
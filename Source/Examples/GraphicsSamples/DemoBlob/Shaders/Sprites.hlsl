@@ -0,0 +1,34 @@
+// Instanced soft discs drawn by graphics::SpriteBatch, one instance per sprite.
+// The instance streams are laid out by graphics::D3D12SpriteBatch, the generated VSMainInputLayout isn't used.
+
+cbuffer SpriteMaterialConstantBuffer : register(b0)
+{
+	float4 tint;
+	float edge;
+};
+
+struct PSInput
+{
+	float4 position : SV_POSITION;
+	float4 color : COLOR;
+	float2 uv : TEXCOORD0;
+};
+
+PSInput VSMain(float2 center : CENTER, float2 extent : EXTENT, float4 color : COLOR, uint vertexId : SV_VertexID)
+{
+	// Triangle strip corners: (0, 0), (1, 0), (0, 1), (1, 1), top-left first like the blob quad.
+	float2 corner = float2(vertexId & 1, vertexId >> 1);
+
+	PSInput result;
+	result.position = float4(center + float2(corner.x * 2 - 1, 1 - corner.y * 2) * extent, 0, 1);
+	result.color = color;
+	result.uv = corner;
+	return result;
+}
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+	float dist = length(input.uv * 2 - 1);
+	float alpha = 1 - smoothstep(1 - edge, 1, dist);
+	return float4(input.color.rgb * tint.rgb * alpha, 0);
+}
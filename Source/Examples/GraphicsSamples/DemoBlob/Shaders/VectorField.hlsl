@@ -0,0 +1,70 @@
+// Swirling vector field, stepped by CSMain on the compute queue and drawn in a corner by VSMain and PSMain.
+// StepVectorField() in VectorField.cpp is the CPU reference of CSMain, the two are kept operation for operation.
+
+cbuffer VectorFieldConstants : register(b0)
+{
+	float2 center;
+	float aspect;
+	float radius;
+	float strength;
+	float decay;
+	float advection;
+	uint width;
+	uint height;
+};
+
+// Velocities in rg mapped from [-1, 1], their length over sqrt(2) in b.
+Texture2D<float4> sourceField : register(t0);
+RWTexture2D<float4> targetField : register(u0);
+
+struct PSInput
+{
+	float4 position : SV_POSITION;
+	float2 uv : TEXCOORD0;
+};
+
+float2 LoadVelocity(int2 texel)
+{
+	return sourceField.Load(int3(texel, 0)).xy * 2 - 1;
+}
+
+// Advect the source field along itself, nearest texel, decay it and add a swirl around the center.
+[numthreads(8, 8, 1)]
+void CSMain(uint3 id : SV_DispatchThreadID)
+{
+	if (id.x >= width || id.y >= height)
+	{
+		return;
+	}
+
+	float2 texel = float2(id.xy);
+	float2 velocity = LoadVelocity(int2(id.xy));
+	float2 position = texel - velocity * advection;
+	int2 nearest = clamp(int2(floor(position + 0.5)), int2(0, 0), int2(width, height) - 1);
+	float2 advected = LoadVelocity(nearest);
+
+	float2 uv = (texel + 0.5) / float2(width, height);
+	float2 offset = (uv - center) * float2(aspect, 1);
+	float dist = length(offset);
+	float falloff = saturate(1 - dist / radius);
+	float2 swirl = float2(-offset.y, offset.x) / max(dist, 0.0001) * (strength * falloff);
+
+	float2 result = clamp(advected * decay + swirl, -1, 1);
+	targetField[id.xy] = float4(result * 0.5 + 0.5, length(result) * 0.70710678, 1);
+}
+
+PSInput VSMain(float2 position : POSITION, float2 uv : TEXCOORD0)
+{
+	PSInput result;
+
+	result.position = float4(position, 0, 1);
+	result.uv = uv;
+	return result;
+}
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+	uint2 size;
+	sourceField.GetDimensions(size.x, size.y);
+	return float4(sourceField.Load(int3(input.uv * size, 0)).rgb, 1);
+}
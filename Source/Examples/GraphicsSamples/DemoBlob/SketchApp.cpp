@@ -3,6 +3,9 @@
 #include <iostream>
 #include <chrono>
 #include <algorithm>
+#include <memory>
+#include <vector>
+#include <random>
 
 #include <wrl/client.h>
 #include <dxgi1_6.h>
@@ -12,8 +15,42 @@
 #include <DirectXMath.h>
 
 #include "Launcher.h"
+#include "Alignment.h"
+#include "D3D12FenceSource.h"
+#include "FenceTimeline.h"
+#include "DeferredReleaseQueue.h"
+#include "D3D12UploadService.h"
+#include "GeometryArena.h"
+#include "D3D12HeapAllocator.h"
+#include "D3D12ResidencyDevice.h"
+#include "ResidencyManager.h"
+#include "VertexFormat.h"
+#include "D3D12VertexFormat.h"
+#include "DynamicConstantAllocator.h"
+#include "DescriptorAllocator.h"
+#include "D3D12ResourceStateTracker.h"
+#include "RenderGraph.h"
+#include "D3D12RenderGraphResources.h"
+#include "PipelineStateCache.h"
+#include "PipelineService.h"
+#include "RootSignatureRegistry.h"
+#include "ShaderCache.h"
+#include "ShaderReloader.h"
+#include "CommandStream.h"
+#include "D3D12CommandSink.h"
+#include "SpriteBatch.h"
+#include "D3D12SpriteBatch.h"
 #include "ShadersVS.h"
 #include "ShadersPS.h"
+#include "ShadersBindings.h"
+#include "SpritesVS.h"
+#include "SpritesPS.h"
+#include "SpritesBindings.h"
+#include "VectorFieldCS.h"
+#include "VectorFieldVS.h"
+#include "VectorFieldPS.h"
+#include "VectorFieldBindings.h"
+#include "VectorField.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -55,6 +92,26 @@ inline void ThrowIfFailed(HRESULT hr, const std::string& context = "")
 class DemoBlob : public sketch::SketchBase
 {
     static const UINT kNumSwapChainBuffers = 2;
+    static const UINT kNumFrames = 3;
+    static const UINT64 kUploadRingSize = 4 * 1024 * 1024;
+    static const UINT64 kUploadBatchSize = 1024 * 1024;
+    static const UINT64 kConstantsSizePerFrame = 64 * 1024;
+    static const UINT64 kGeometryArenaSize = 1024 * 1024;
+    static const UINT kNumStaticDescriptors = 256;
+    static const UINT kNumDynamicDescriptors = 1024;
+    static const UINT kNumSprites = 100000;
+    static const UINT kNumSpriteMaterials = 2;
+    static const UINT64 kSpriteInstancesSizePerFrame = 4 * 1024 * 1024;
+    static const UINT kVectorFieldThreadGroupSize = 8;
+    // Debug builds read this step back and check it against the CPU reference.
+    static const UINT64 kVectorFieldValidationStep = 60;
+
+    // Categories of the residency statistics
+    enum ResidencyCategory : uint32_t
+    {
+        kResidencyGeometry,
+        kResidencyTexture,
+    };
 
     struct Vertex
     {
@@ -62,41 +119,120 @@ class DemoBlob : public sketch::SketchBase
         DirectX::XMFLOAT4 color;
         DirectX::XMFLOAT2 uv;
     };
+    static_assert(sizeof(Vertex) == ShadersBindings::VSMainVertexStride, "Vertex doesn't match the input of VSMain");
+
+    // Vertex as the vertex buffer stores it, 12 bytes instead of 32: positions are within [-1, 1], colors and
+    // texture coordinates within [0, 1].
+    static graphics::VertexFormat CreatePackedVertexFormat()
+    {
+        graphics::VertexFormat format;
+        format.Add("POSITION", 0, graphics::VertexAttributeFormat::Snorm16x2, offsetof(Vertex, position))
+            .Add("COLOR", 0, graphics::VertexAttributeFormat::Unorm8x4, offsetof(Vertex, color))
+            .Add("TEXCOORD", 0, graphics::VertexAttributeFormat::Unorm16x2, offsetof(Vertex, uv));
+        return format;
+    }
+
+    // Laid out from the cbuffer of Shaders.hlsl, slices of constantAllocator_ are 256-byte aligned already.
+    using SceneConstantBuffer = ShadersBindings::SceneConstantBuffer;
+    using SpriteMaterialConstantBuffer = SpritesBindings::SpriteMaterialConstantBuffer;
 
-    struct SceneConstantBuffer
+    // Simulated on the CPU, in normalized device coordinates.
+    struct Sprite
     {
-        DirectX::XMFLOAT2 center;
-        float aspect;
-        float padding[61]; // Padding so the constant buffer is 256-byte aligned.
+        DirectX::XMFLOAT2 position;
+        DirectX::XMFLOAT2 velocity;
+        uint32_t color;
+        uint32_t material;
     };
-    static_assert((sizeof(SceneConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
 
     ComPtr<ID3D12Device> device_;
+    ComPtr<IDXGIAdapter3> adapter_;
     ComPtr<ID3D12CommandQueue> commandQueue_;
     ComPtr<IDXGISwapChain3> swapChain_;
-    ComPtr<ID3D12DescriptorHeap> rtvHeap_;
-    ComPtr<ID3D12DescriptorHeap> cbvSrvHeap_;
-    UINT rtvDescriptorSize_;
-    UINT cbvSrvDescriptorSize_;
+    std::unique_ptr<graphics::CpuDescriptorAllocator> rtvDescriptors_;
+    std::unique_ptr<graphics::CpuDescriptorAllocator> srvStagingDescriptors_;
+    std::unique_ptr<graphics::GpuDescriptorHeap> shaderVisibleDescriptors_;
+    graphics::DescriptorRange swapChainRtvs_;
     ComPtr<ID3D12Resource> swapChainBuffers_[kNumSwapChainBuffers];
-    ComPtr<ID3D12CommandAllocator> commandAllocator_;
+    ComPtr<ID3D12CommandAllocator> commandAllocators_[kNumFrames];
     ComPtr<ID3D12GraphicsCommandList> commandList_;
-    ComPtr<ID3D12Fence> fence_;
-    UINT64 fenceValue_;
-    HANDLE fenceEventHandle_;
+    ComPtr<ID3D12GraphicsCommandList> barrierCommandList_;
+    graphics::ResourceStateRegistry resourceStates_;
+    graphics::D3D12ResourceStateTracker stateTracker_{ resourceStates_ };
+    graphics::RenderGraph renderGraph_;
+    std::unique_ptr<graphics::D3D12RenderGraphResources> renderGraphResources_;
+    graphics::CommandStream blobCommands_;
+    graphics::D3D12CommandSink commandSink_;
+    UINT64 frameFenceValues_[kNumFrames] = {};
+    UINT frameIndex_ = 0;
+    std::unique_ptr<graphics::D3D12FenceSource> fence_;
+    ComPtr<ID3D12CommandQueue> computeQueue_;
+    ComPtr<ID3D12CommandAllocator> computeCommandAllocators_[kNumFrames];
+    ComPtr<ID3D12GraphicsCommandList> computeCommandList_;
+    std::unique_ptr<graphics::D3D12FenceSource> computeFence_;
+    std::unique_ptr<graphics::FenceTimeline> fenceTimeline_;
+    graphics::DeferredReleaseQueue<ComPtr<IUnknown>> releaseQueue_;
+    std::unique_ptr<graphics::D3D12UploadService> uploadService_;
+    std::unique_ptr<graphics::RootSignatureRegistry> rootSignatures_;
+    std::unique_ptr<graphics::PipelineStateCache> pipelineCache_;
     ComPtr<ID3D12RootSignature> rootSignature_;
-    ComPtr<ID3D12PipelineState> pipelineState_;
-    ComPtr<ID3D12Resource> vertexBuffer_;
-    D3D12_VERTEX_BUFFER_VIEW vertexBufferView_;
+    uint64_t rootSignatureHash_ = 0;
+    std::unique_ptr<graphics::PipelineService> pipelineService_;
+    graphics::PipelineService::PipelineHandle pipelineState_ = graphics::PipelineService::kInvalidPipeline;
+    std::unique_ptr<graphics::ShaderCache> shaderCache_;
+    std::unique_ptr<graphics::ShaderReloader> shaderReloader_;
+    std::unique_ptr<graphics::GeometryArena> geometryArena_;
+    std::unique_ptr<graphics::D3D12HeapAllocator> heapAllocator_;
+    std::unique_ptr<graphics::D3D12ResidencyDevice> residencyDevice_;
+    std::unique_ptr<graphics::ResidencyManager> residencyManager_;
+    graphics::ResidencyManager::Handle geometryResidency_ = graphics::ResidencyManager::kInvalidHandle;
+    graphics::ResidencyManager::Handle vectorFieldResidency_ = graphics::ResidencyManager::kInvalidHandle;
+    float nextResidencyReportTime_ = 1.0f;
+    graphics::GeometryArena::Handle quadVertices_ = graphics::GeometryArena::kInvalidHandle;
+    graphics::D3D12UploadService::Ticket quadUpload_ = 0;
+    const graphics::VertexFormat packedVertexFormat_ = CreatePackedVertexFormat();
+    const graphics::D3D12VertexFormat packedVertexLayout_{ packedVertexFormat_ };
     SceneConstantBuffer constantBufferData_;
-    ComPtr<ID3D12Resource> constantBuffer_;
-    UINT8* cbvDataBegin_;
+    std::unique_ptr<graphics::DynamicConstantAllocator> constantAllocator_;
+
+    std::vector<Sprite> sprites_;
+    graphics::SpriteBatch spriteBatch_;
+    SpriteMaterialConstantBuffer spriteMaterials_[kNumSpriteMaterials];
+    std::unique_ptr<graphics::DynamicConstantAllocator> spriteInstanceAllocator_;
+    ComPtr<ID3D12RootSignature> spriteRootSignature_;
+    uint64_t spriteRootSignatureHash_ = 0;
+    graphics::PipelineService::PipelineHandle spritePipelineState_ = graphics::PipelineService::kInvalidPipeline;
 
     UINT fieldWidth_ = 480;
     UINT fieldHeight_ = 270;
     ComPtr<ID3D12Resource> vectorFieldBuffers[2];
+    graphics::D3D12HeapAllocator::Allocation vectorFieldAllocations_[2];
+    graphics::DescriptorRange vectorFieldSrvs_;
+    graphics::DescriptorRange vectorFieldUavs_;
+    graphics::DescriptorRange vectorFieldSrvTable_;
+    // Per target buffer, the SRV of the other buffer followed by the UAV of the target
+    graphics::DescriptorRange vectorFieldComputeTables_;
+    graphics::GeometryArena::Handle vectorFieldVertices_ = graphics::GeometryArena::kInvalidHandle;
+    graphics::D3D12UploadService::Ticket vectorFieldUpload_ = 0;
     ComPtr<ID3D12RootSignature> vectorFieldRootSignature_;
-    ComPtr<ID3D12PipelineState> vectorFieldPipelineState_;
+    uint64_t vectorFieldRootSignatureHash_ = 0;
+    ComPtr<ID3D12RootSignature> vectorFieldComputeRootSignature_;
+    uint64_t vectorFieldComputeRootSignatureHash_ = 0;
+    graphics::PipelineService::PipelineHandle vectorFieldPipelineState_ = graphics::PipelineService::kInvalidPipeline;
+    graphics::PipelineService::PipelineHandle vectorFieldComputePipelineState_ = graphics::PipelineService::kInvalidPipeline;
+    VectorFieldParameters vectorFieldParameters_;
+    bool vectorFieldInitialized_ = false;
+    UINT64 vectorFieldSteps_ = 0;
+    // Buffer written by the latest step, and the compute fence value signaled after it
+    UINT vectorFieldIndex_ = 0;
+    UINT64 vectorFieldFenceValue_ = 0;
+    // Fence value of the last frame drawing each buffer, the step overwriting it waits for it
+    UINT64 vectorFieldReadFenceValues_[2] = {};
+    ComPtr<ID3D12Resource> vectorFieldReadback_;
+    graphics::D3D12HeapAllocator::Allocation vectorFieldReadbackAllocation_;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT vectorFieldReadbackFootprints_[2] = {};
+    VectorFieldParameters vectorFieldReadbackParameters_;
+    UINT64 vectorFieldReadbackFenceValue_ = 0;
 
 public:
     virtual void OnInit() override
@@ -107,9 +243,17 @@ public:
         // Create fence
         CreateFence();
 
+        // Copy queue and staging memory shared by every upload
+        CreateUploadService();
+
+        // Heaps the placed resources are sub-allocated from
+        CreateHeapAllocator();
+
         // Descriptor heaps
-        CreateRenderTargetDescriptorHeap();
-        CreateConstantBufferDescriptorHeap();
+        CreateDescriptorAllocators();
+
+        // Root signatures and pipelines built by earlier runs
+        CreatePipelineCache();
 
         // Root Signature
         CreateRootSignature();
@@ -117,43 +261,99 @@ public:
         // Pipeline state object
         CreatePipelineState();
 
-        // Create the constant buffer
-        CreateConstantBuffer();
+        // Instanced sprites drawn over the blob
+        CreateSpritePipelineState();
+
+        // Recompile the shaders and rebuild the pipeline whenever Shaders.hlsl is edited
+        CreateShaderReloader();
+
+        // Per-frame constants
+        CreateDynamicConstantAllocator();
+
+        // Sprite simulation, and the upload memory its instances are packed into every frame
+        CreateSprites();
 
         // Create the vertex buffer.
         CreateVertexBuffer();
 
+        // Start all the uploads recorded above on the copy queue in a single submission
+        uploadService_->Flush();
+
         // Command allocator and list
         CreateCommandList();
 
+        // Queue, command lists and fence of the vector field steps
+        CreateComputeQueue();
+
         CreateVectorFieldBuffers();
         CreateVectorFieldRootSignature();
         CreateVectorFieldPipelineState();
+
+        // Video memory budget, and the resources evicted when it is exceeded
+        CreateResidencyManager();
     }
 
     virtual void OnUpdate() override
     {
+        BeginFrame();
+
+        UpdateSprites();
+
+        // Step the vector field on the compute queue, next to the graphics work of the previous frame
+        GenerateVectorField();
+
         RenderToBackBuffer();
 
         PresentAndSwapBuffers();
 
-        FlushCommandQueue();
+        EndFrame();
+
+        // Release the resources retired by frames the GPU has finished
+        releaseQueue_.ReleaseCompleted(fenceTimeline_->GetCompletedValue());
+        geometryArena_->ReleaseCompleted(fenceTimeline_->GetCompletedValue());
+        heapAllocator_->ReleaseCompleted(fenceTimeline_->GetCompletedValue());
+
+        CheckVectorFieldReadback();
+
+        // Evict the least recently used resources while over the budget
+        residencyManager_->Update(fenceTimeline_->GetCompletedValue());
+        ReportResidency();
     }
 
     virtual void OnQuit() override
     {
         FlushCommandQueue();
-        constantBuffer_->Unmap(0, nullptr);
-        CloseHandle(fenceEventHandle_);
+        computeFence_->WaitForValue(vectorFieldFenceValue_);
+        vectorFieldReadback_.Reset();
+        releaseQueue_.ReleaseAll();
+        // Finish the pipelines still compiling, so that they make it into the library on disk.
+        shaderReloader_.reset();
+        pipelineService_.reset();
+        shaderCache_->Save();
+        pipelineCache_->Save();
+        rootSignatures_->Save();
+        renderGraphResources_.reset();
+        residencyManager_.reset();
+        residencyDevice_.reset();
+        constantAllocator_.reset();
+        spriteInstanceAllocator_.reset();
+        geometryArena_.reset();
+        // Placed resources keep their heap alive, the vector field buffers may outlive the allocator.
+        heapAllocator_.reset();
+        uploadService_.reset();
+        fenceTimeline_.reset();
     }
     
     virtual void OnResize(int width, int height) override
     {
+        // IDXGISwapChain::ResizeBuffers requires that no in-flight command list still references the back buffers,
+        // so swap chain buffers are the one case which can't go through the deferred release queue.
         FlushCommandQueue();
 
         // Release the resources holding references to the swap chain (requirement of IDXGISwapChain::ResizeBuffers)
         for (UINT index = 0; index < kNumSwapChainBuffers; index++)
         {
+            graphics::D3D12ResourceStateTracker::Unregister(resourceStates_, swapChainBuffers_[index].Get());
             swapChainBuffers_[index].Reset();
         }
 
@@ -164,8 +364,8 @@ public:
 
         CreateSwapChainRTV();
 
+        // Constants are pushed to the GPU every frame
         constantBufferData_.aspect = static_cast<float>(width) / static_cast<float>(height);
-        memcpy(cbvDataBegin_, &constantBufferData_, sizeof(constantBufferData_));
     }
 
     virtual void OnMouseDrag(int x, int y, sketch::MouseButtonType buttonType) override
@@ -174,8 +374,7 @@ public:
 
         float xNormalized = static_cast<float>(x) / static_cast<float>(GetState().ViewportWidth);
         float yNormalized = static_cast<float>(y) / static_cast<float>(GetState().ViewportHeight);
-        constantBufferData_.center = DirectX::XMFLOAT2(xNormalized, yNormalized);
-        memcpy(cbvDataBegin_, &constantBufferData_, sizeof(constantBufferData_));
+        constantBufferData_.offset = DirectX::XMFLOAT2(xNormalized, yNormalized);
     }
 
     void CreateInfrastructure()
@@ -210,6 +409,9 @@ public:
         // Device
         ThrowIfFailed(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device_)), "D3D12CreateDevice");
 
+        // Video memory budget queries
+        ThrowIfFailed(adapter.As(&adapter_), "QueryInterface for IDXGIAdapter3");
+
         // MSAA support
         D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS qualityLevels = {};
         qualityLevels.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -254,74 +456,51 @@ public:
         ThrowIfFailed(dxgiFactory6->MakeWindowAssociation(launcher::GetMainWindow(), DXGI_MWA_NO_ALT_ENTER));
     }
 
-    void CreateRenderTargetDescriptorHeap()
+    void CreateDescriptorAllocators()
     {
-        // Describe and create a render target view (RTV) descriptor heap
-        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-        rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-        rtvHeapDesc.NumDescriptors = kNumSwapChainBuffers + 2;  // + 2 vector field generation buffers
+        // Non-shader-visible heaps grow on demand, views are created there and referenced or copied at record time.
+        rtvDescriptors_ = std::make_unique<graphics::CpuDescriptorAllocator>(device_.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+        srvStagingDescriptors_ = std::make_unique<graphics::CpuDescriptorAllocator>(device_.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-        ThrowIfFailed(device_->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&rtvHeap_)), "CreateDescriptorHeap");
-
-        // Descriptor size
-        rtvDescriptorSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+        // The single shader visible heap, constants are bound as root CBVs and don't need descriptors.
+        shaderVisibleDescriptors_ = std::make_unique<graphics::GpuDescriptorHeap>(device_.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+            kNumStaticDescriptors, kNumDynamicDescriptors);
     }
 
-    void CreateConstantBufferDescriptorHeap()
+    void CreateRootSignature()
     {
-        // Describe and create a constant buffer view (CBV) descriptor heap
-        D3D12_DESCRIPTOR_HEAP_DESC cbvSrvHeapDesc = {};
-        cbvSrvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        cbvSrvHeapDesc.NumDescriptors = 1 + 2;  // One CBV + 2 SRV for vector field
-        cbvSrvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        // Root Signagure generated from the bindings Shaders.hlsl uses: a single root CBV, visible to the pixel
+        // shader only, which points into the per-frame dynamic constants.
+        const ShadersBindings::RootSignature rootSignatureDesc;
 
-        ThrowIfFailed(device_->CreateDescriptorHeap(&cbvSrvHeapDesc, IID_PPV_ARGS(&cbvSrvHeap_)));
-
-        // Descriptor Size
-        cbvSrvDescriptorSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        // Shared with any equal layout, and created from the blob serialized by an earlier run when there is one.
+        rootSignature_ = rootSignatures_->Get(rootSignatureDesc.Desc, &rootSignatureHash_);
     }
 
-    void CreateRootSignature()
+    void CreatePipelineState()
     {
-        // Root Signagure, consisting of a descriptor table with a single CBV
-        CD3DX12_DESCRIPTOR_RANGE1 ranges[] = { CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC) };
-        CD3DX12_ROOT_PARAMETER1 rootParameters[] = { CD3DX12_ROOT_PARAMETER1() };
-        rootParameters[0].InitAsDescriptorTable(_countof(ranges), ranges, D3D12_SHADER_VISIBILITY_PIXEL);
-
-        // Allow input layout and deny uneccessary access to certain pipeline stages.
-        D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
-            D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
-
-        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-        rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, rootSignatureFlags);
+        // The formats are packed, but the semantics still have to be the parameters of VSMain.
+        if (!packedVertexLayout_.MatchesSemantics(ShadersBindings::VSMainInputLayout, _countof(ShadersBindings::VSMainInputLayout)))
+        {
+            throw std::runtime_error("Packed vertex format doesn't match the input of VSMain");
+        }
 
-        ComPtr<ID3DBlob> signature;
-        ThrowIfFailed(D3D12SerializeVersionedRootSignature(&rootSignatureDesc, signature.GetAddressOf(), nullptr), "D3D12SerializeVersionedRootSignature");
-        ThrowIfFailed(device_->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature_)), "CreateRootSignature");
+        RequestBlobPipeline(CD3DX12_SHADER_BYTECODE(g_Shaders_VSMain, sizeof(g_Shaders_VSMain)),
+            CD3DX12_SHADER_BYTECODE(g_Shaders_PSMain, sizeof(g_Shaders_PSMain)));
     }
 
-    void CreatePipelineState()
+    void RequestBlobPipeline(const D3D12_SHADER_BYTECODE& vertexShader, const D3D12_SHADER_BYTECODE& pixelShader)
     {
-        // Define the vertex input layout.
-        D3D12_INPUT_ELEMENT_DESC inputElementDesc[] =
-        {
-            { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-        };
-        D3D12_INPUT_LAYOUT_DESC inputLayoutDesc{ inputElementDesc, _countof(inputElementDesc) };
+        // The vertex input layout, reading the packed vertices as the floats VSMain takes.
+        D3D12_INPUT_LAYOUT_DESC inputLayoutDesc = packedVertexLayout_.GetInputLayout();
 
         // Pipeline state object
         // Describe and create the graphics pipeline state object (PSO).
         D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
         psoDesc.InputLayout = inputLayoutDesc;
         psoDesc.pRootSignature = rootSignature_.Get();
-        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_Shaders_VSMain, sizeof(g_Shaders_VSMain));
-        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_Shaders_PSMain, sizeof(g_Shaders_PSMain));
+        psoDesc.VS = vertexShader;
+        psoDesc.PS = pixelShader;
         psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
         psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
         psoDesc.DepthStencilState.DepthEnable = FALSE;
@@ -332,43 +511,229 @@ public:
         psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
         psoDesc.SampleDesc.Count = 1;
 
-        ThrowIfFailed(device_->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState_)), "CreateGraphicsPipelineState");
+        auto onCompletion = [this](graphics::PipelineService::PipelineHandle handle, bool succeeded)
+            {
+                if (!succeeded)
+                {
+                    std::cerr << "Failed to create the blob pipeline: " << pipelineService_->GetError(handle) << std::endl;
+                }
+            };
+
+        // Compiled on a worker thread, the blob is skipped until the pipeline is ready.
+        // Compiled once, later launches load it from the pipeline library on disk.
+        if (pipelineState_ == graphics::PipelineService::kInvalidPipeline)
+        {
+            pipelineState_ = pipelineService_->RequestGraphicsPipeline(psoDesc, rootSignatureHash_, onCompletion);
+        }
+        else
+        {
+            // Reloaded shaders, the current pipeline stays in use until the new one is published.
+            pipelineService_->ReplaceGraphicsPipeline(pipelineState_, psoDesc, rootSignatureHash_, onCompletion);
+        }
     }
 
-    void CreateConstantBuffer()
+    void CreateSpritePipelineState()
     {
-        // Create the constant buffer
-        const UINT constantBufferSize = sizeof(SceneConstantBuffer);
+        // Root signature generated from Sprites.hlsl: the root CBV of the material constants, pixel shader only.
+        const SpritesBindings::RootSignature rootSignatureDesc;
+        spriteRootSignature_ = rootSignatures_->Get(rootSignatureDesc.Desc, &spriteRootSignatureHash_);
 
-        CD3DX12_HEAP_PROPERTIES uploadPropety(D3D12_HEAP_TYPE_UPLOAD);
-        CD3DX12_RESOURCE_DESC constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(constantBufferSize);
-        ThrowIfFailed(device_->CreateCommittedResource(&uploadPropety, D3D12_HEAP_FLAG_NONE, &constantBufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&constantBuffer_)));
+        // Per-instance streams of graphics::SpriteBatch, the corners come from SV_VertexID.
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.InputLayout = graphics::D3D12SpriteBatch::GetInputLayout();
+        psoDesc.pRootSignature = spriteRootSignature_.Get();
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_Sprites_VSMain, sizeof(g_Sprites_VSMain));
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_Sprites_PSMain, sizeof(g_Sprites_PSMain));
+        psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+        // Additive, overlapping sprites don't need sorting.
+        psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+        psoDesc.BlendState.RenderTarget[0].BlendEnable = TRUE;
+        psoDesc.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_ONE;
+        psoDesc.BlendState.RenderTarget[0].DestBlend = D3D12_BLEND_ONE;
+        psoDesc.DepthStencilState.DepthEnable = FALSE;
+        psoDesc.DepthStencilState.StencilEnable = FALSE;
+        psoDesc.SampleMask = UINT_MAX;
+        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        psoDesc.NumRenderTargets = 1;
+        psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        psoDesc.SampleDesc.Count = 1;
 
-        // Describe and create a constant buffer view (CBV)
-        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-        cbvDesc.BufferLocation = constantBuffer_->GetGPUVirtualAddress();
-        cbvDesc.SizeInBytes = constantBufferSize;
+        spritePipelineState_ = pipelineService_->RequestGraphicsPipeline(psoDesc, spriteRootSignatureHash_,
+            [this](graphics::PipelineService::PipelineHandle handle, bool succeeded)
+            {
+                if (!succeeded)
+                {
+                    std::cerr << "Failed to create the sprite pipeline: " << pipelineService_->GetError(handle) << std::endl;
+                }
+            });
+    }
 
-        CD3DX12_CPU_DESCRIPTOR_HANDLE cbvHandle(cbvSrvHeap_->GetCPUDescriptorHandleForHeapStart());
-        device_->CreateConstantBufferView(&cbvDesc, cbvHandle);
+    void CreateShaderReloader()
+    {
+#if defined(_DEBUG)
+        // Debuggable like the embedded shaders of a debug build.
+        UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+        UINT compileFlags = 0;
+#endif
+        std::wstring path(SHADER_DIR);
+        path += L"/Shaders.hlsl";
+
+        shaderCache_ = std::make_unique<graphics::ShaderCache>("DemoBlob.shaders");
+        shaderReloader_ = std::make_unique<graphics::ShaderReloader>(*shaderCache_);
+        try
+        {
+            AddBlobProgram(path, compileFlags);
+        }
+        catch (const std::exception& exception)
+        {
+            // The sources aren't around, e.g. when the executable was copied elsewhere. Run with the built-in shaders.
+            std::cerr << "Shader hot reload is disabled: " << exception.what() << std::endl;
+            shaderReloader_.reset();
+        }
+    }
+
+    void AddBlobProgram(const std::wstring& path, UINT compileFlags)
+    {
+        shaderReloader_->AddProgram({ { path, "VSMain", "vs_5_0", {}, compileFlags }, { path, "PSMain", "ps_5_0", {}, compileFlags } },
+            [this](graphics::ShaderReloader::ProgramHandle, const std::vector<ComPtr<ID3DBlob>>& shaders, const std::string& error)
+            {
+                if (shaders.empty())
+                {
+                    // Keep drawing with the previous shaders until the next edit fixes the error.
+                    std::cerr << "Failed to reload Shaders.hlsl: " << error << std::endl;
+                    return;
+                }
+                RequestBlobPipeline(CD3DX12_SHADER_BYTECODE(shaders[0].Get()), CD3DX12_SHADER_BYTECODE(shaders[1].Get()));
+            });
+    }
+
+    void CreatePipelineCache()
+    {
+        rootSignatures_ = std::make_unique<graphics::RootSignatureRegistry>(device_.Get(), "DemoBlob.rootsignatures");
+        pipelineCache_ = std::make_unique<graphics::PipelineStateCache>(device_.Get(), "DemoBlob.psocache");
+        pipelineService_ = std::make_unique<graphics::PipelineService>(*pipelineCache_);
+    }
 
-        // Map and initialize the constant buffer. We don't unmap this until the
-        // app closes. Keeping things mapped for the lifetime of the resource is okay.
-        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-        ThrowIfFailed(constantBuffer_->Map(0, &readRange, reinterpret_cast<void**>(&cbvDataBegin_)));
-        constantBufferData_.center = DirectX::XMFLOAT2(0.5f, 0.5f);
+    void CreateDynamicConstantAllocator()
+    {
+        // Every frame in flight owns a region of the upload buffer, so updating constants never races with the GPU.
+        constantAllocator_ = std::make_unique<graphics::DynamicConstantAllocator>(device_.Get(), *fenceTimeline_, kNumFrames, kConstantsSizePerFrame);
+
+        constantBufferData_ = {};
+        constantBufferData_.offset = DirectX::XMFLOAT2(0.5f, 0.5f);
         constantBufferData_.aspect = 1.0f;
-        memcpy(cbvDataBegin_, &constantBufferData_, constantBufferSize);
+    }
+
+    void CreateSprites()
+    {
+        // 100k instances are 2MB of streams, more than the constants, so they get their own per-frame regions.
+        spriteInstanceAllocator_ = std::make_unique<graphics::DynamicConstantAllocator>(device_.Get(), *fenceTimeline_, kNumFrames, kSpriteInstancesSizePerFrame);
+        spriteBatch_.Reserve(kNumSprites);
+
+        // One draw per material, whatever order the sprites are in.
+        spriteMaterials_[0] = {};
+        spriteMaterials_[0].tint = DirectX::XMFLOAT4(1.0f, 0.6f, 0.3f, 1.0f);
+        spriteMaterials_[0].edge = 0.5f;
+        spriteMaterials_[1] = {};
+        spriteMaterials_[1].tint = DirectX::XMFLOAT4(0.3f, 0.6f, 1.0f, 1.0f);
+        spriteMaterials_[1].edge = 1.0f;
+
+        std::mt19937 generator(0);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_int_distribution<uint32_t> intensity(0x20, 0x60);
+        sprites_.resize(kNumSprites);
+        for (Sprite& sprite : sprites_)
+        {
+            sprite.position = DirectX::XMFLOAT2(unit(generator), unit(generator));
+            sprite.velocity = DirectX::XMFLOAT2(unit(generator) * 0.2f, unit(generator) * 0.2f);
+            const uint32_t gray = intensity(generator);
+            sprite.color = gray | (gray << 8) | (gray << 16) | 0xff000000;
+            sprite.material = generator() % kNumSpriteMaterials;
+        }
+    }
+
+    void UpdateSprites()
+    {
+        // Bounce off the edges of the viewport, and refill the batch from scratch.
+        const float deltaTime = GetDeltaTime();
+        if (GetState().ViewportWidth <= 0 || GetState().ViewportHeight <= 0)
+        {
+            return;
+        }
+        const float halfWidth = 3.0f / static_cast<float>(GetState().ViewportWidth);
+        const float halfHeight = 3.0f / static_cast<float>(GetState().ViewportHeight);
+
+        spriteBatch_.Clear();
+        for (Sprite& sprite : sprites_)
+        {
+            sprite.position.x += sprite.velocity.x * deltaTime;
+            sprite.position.y += sprite.velocity.y * deltaTime;
+            if ((sprite.position.x < -1.0f && sprite.velocity.x < 0.0f) || (sprite.position.x > 1.0f && sprite.velocity.x > 0.0f))
+            {
+                sprite.velocity.x = -sprite.velocity.x;
+            }
+            if ((sprite.position.y < -1.0f && sprite.velocity.y < 0.0f) || (sprite.position.y > 1.0f && sprite.velocity.y > 0.0f))
+            {
+                sprite.velocity.y = -sprite.velocity.y;
+            }
+            spriteBatch_.Add(sprite.material, sprite.position.x, sprite.position.y, halfWidth, halfHeight, sprite.color);
+        }
     }
 
     void CreateFence()
     {
-        // Fence
-        UINT64 initialFenceValue = 0;
-        ThrowIfFailed(device_->CreateFence(initialFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)), "CreateFence");
-        fenceValue_ = initialFenceValue + 1;
-        fenceEventHandle_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        // Fence, and the timeline which reports its progress on a waiter thread
+        fence_ = std::make_unique<graphics::D3D12FenceSource>(device_.Get());
+        fenceTimeline_ = std::make_unique<graphics::FenceTimeline>(*fence_);
+    }
+
+    void CreateUploadService()
+    {
+        // Copies run on a queue of their own, the direct queue only waits for the uploads a frame reads.
+        uploadService_ = std::make_unique<graphics::D3D12UploadService>(device_.Get(), commandQueue_.Get(), kUploadRingSize, kUploadBatchSize);
+    }
+
+    void CreateHeapAllocator()
+    {
+        heapAllocator_ = std::make_unique<graphics::D3D12HeapAllocator>(device_.Get());
+    }
+
+    void CreateResidencyManager()
+    {
+        residencyDevice_ = std::make_unique<graphics::D3D12ResidencyDevice>(device_.Get(), adapter_.Get());
+        residencyManager_ = std::make_unique<graphics::ResidencyManager>(*residencyDevice_, std::vector<std::string>{ "Geometry", "Texture" });
+
+        // Tracked at the granularity of the memory, the arena's buffer and the heap both vector field buffers are placed in.
+        ID3D12Pageable* geometryBuffer = geometryArena_->GetResource();
+        geometryResidency_ = residencyManager_->Track(geometryBuffer, kGeometryArenaSize, kResidencyGeometry);
+        ID3D12Heap* vectorFieldHeap = vectorFieldAllocations_[0].Heap;
+        vectorFieldResidency_ = residencyManager_->Track(static_cast<ID3D12Pageable*>(vectorFieldHeap), vectorFieldHeap->GetDesc().SizeInBytes, kResidencyTexture);
+    }
+
+    void ReportResidency()
+    {
+        if (GetElapsedTime() < nextResidencyReportTime_)
+        {
+            return;
+        }
+        nextResidencyReportTime_ = GetElapsedTime() + 1.0f;
+
+        const graphics::ResidencyManager::Statistics statistics = residencyManager_->GetStatistics();
+        const double kMegabyte = 1024.0 * 1024.0;
+        std::cout << "Residency:"
+            << "\n\tBudget: " << statistics.Budget.Budget / kMegabyte << " MB"
+            << "\n\tUsage: " << statistics.Budget.Usage / kMegabyte << " MB"
+            << "\n\tEvictions: " << statistics.NumEvictions
+            << "\n\tMade Resident: " << statistics.NumMadeResident;
+        for (uint32_t category = 0; category < statistics.Categories.size(); category++)
+        {
+            const graphics::ResidencyManager::CategoryStatistics& categoryStatistics = statistics.Categories[category];
+            std::cout << "\n\t" << residencyManager_->GetCategoryName(category) << ": "
+                << categoryStatistics.ResidentSize / kMegabyte << " MB resident, "
+                << categoryStatistics.EvictedSize / kMegabyte << " MB evicted";
+        }
+        std::cout << std::endl;
     }
 
     void CreateVertexBuffer()
@@ -382,117 +747,186 @@ public:
             { { 1.0f, -1.0f }, { 1.0f, 1.0f, 0.0f, 1.0f }, {1.0f, 1.0f} }
         };
 
-        const UINT vertexBufferSize = sizeof(quadVertices);
-
-        // Note: using upload heaps to transfer static data like vert buffers is not recommended.
-        // Every time the GPU needs it, the upload heap will be marshalled over. Use default heaps instead.
-        CD3DX12_RESOURCE_DESC vertexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
-
-        CD3DX12_HEAP_PROPERTIES defaultProperty(D3D12_HEAP_TYPE_DEFAULT);
-        ThrowIfFailed(device_->CreateCommittedResource(&defaultProperty, D3D12_HEAP_FLAG_NONE, &vertexBufferDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&vertexBuffer_)), "CreateCommittedResource");
-
-        ComPtr<ID3D12Resource> vertexBufferUpload;
-        CD3DX12_HEAP_PROPERTIES uploadPropety(D3D12_HEAP_TYPE_UPLOAD);
-        ThrowIfFailed(device_->CreateCommittedResource(&uploadPropety, D3D12_HEAP_FLAG_NONE, &vertexBufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&vertexBufferUpload)), "CreateCommittedResource");
-
-        // Copy the triangle data to the vertex buffer in upload heap.
-        UINT8* vertexDataBegin;
-        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-        ThrowIfFailed(vertexBufferUpload->Map(0, &readRange, reinterpret_cast<void**>(&vertexDataBegin)), "Map");
-        memcpy(vertexDataBegin, quadVertices, sizeof(quadVertices));
-        vertexBufferUpload->Unmap(0, nullptr);
-
-        ComPtr<ID3D12CommandAllocator> copyCommandAllocator;
-        ComPtr<ID3D12GraphicsCommandList> copyCommandList;
-        // Command allocator
-        ThrowIfFailed(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&copyCommandAllocator)), "CreateCommandAllocator");
-        ThrowIfFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, copyCommandAllocator.Get(), nullptr, IID_PPV_ARGS(&copyCommandList)), "CreateCommandList");
-
-        // 将顶点数据由 upload heap 拷贝至 default heap
-        // 这里只是记录指令，实际执行在本函数的末尾。因此，必须保证 upload heap 中分配的资源在指令执行时是有效的。
-        copyCommandList->CopyBufferRegion(vertexBuffer_.Get(), 0, vertexBufferUpload.Get(), 0, vertexBufferSize);
-
-        // 切换顶点缓冲的状态
-        CD3DX12_RESOURCE_BARRIER toVertexBufferBarrier = CD3DX12_RESOURCE_BARRIER::Transition(vertexBuffer_.Get(),
-            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-        copyCommandList->ResourceBarrier(1, &toVertexBufferBarrier);
-
-        // Initialize the vertex buffer view.
-        vertexBufferView_.BufferLocation = vertexBuffer_->GetGPUVirtualAddress();
-        vertexBufferView_.StrideInBytes = sizeof(Vertex);
-        vertexBufferView_.SizeInBytes = vertexBufferSize;
-
-        // Command lists are created in the recording state.
-        // Close the resource creation command list and execute it to begin the vertex buffer copy into the default heap.
-        ThrowIfFailed(copyCommandList->Close(), "Close command list");
-        ID3D12CommandList* commandLists[] = { copyCommandList.Get() };
-        commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
+        // One default heap buffer shared by all the geometry, instead of a committed resource (and 64KB) per mesh.
+        geometryArena_ = std::make_unique<graphics::GeometryArena>(device_.Get(), kGeometryArenaSize);
+        std::vector<uint8_t> packedVertices(_countof(quadVertices) * packedVertexFormat_.GetStride());
+        packedVertexFormat_.Encode(quadVertices, sizeof(Vertex), _countof(quadVertices), packedVertices.data());
+        quadVertices_ = geometryArena_->AllocateVertices(static_cast<UINT>(_countof(quadVertices)), packedVertexFormat_.GetStride());
 
-        FlushCommandQueue();
+        // 将顶点数据经由 upload ring 拷贝至 arena
+        // 这里只是记录指令，实际在 copy queue 上执行。arena 依赖隐式状态提升，不需要 barrier。
+        geometryArena_->Write(quadVertices_, packedVertices.data(), uploadService_->GetUploadRing());
+        quadUpload_ = uploadService_->Commit();
     }
 
     void CreateCommandList()
     {
-        // Command allocator
-        ThrowIfFailed(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator_)), "CreateCommandAllocator");
+        // Command allocator for each frame in flight
+        for (UINT index = 0; index < kNumFrames; index++)
+        {
+            ThrowIfFailed(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocators_[index])), "CreateCommandAllocator");
+        }
 
         // Command list
-        ThrowIfFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator_.Get(), pipelineState_.Get(), IID_PPV_ARGS(&commandList_)), "CreateCommandList");
+        ThrowIfFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators_[frameIndex_].Get(), nullptr, IID_PPV_ARGS(&commandList_)), "CreateCommandList");
         ThrowIfFailed(commandList_->Close(), "Close command list when initializing");
+
+        // Small list executed ahead of commandList_, carrying the transitions which are only known at submit time.
+        ThrowIfFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators_[frameIndex_].Get(), nullptr, IID_PPV_ARGS(&barrierCommandList_)), "CreateCommandList for barriers");
+        ThrowIfFailed(barrierCommandList_->Close(), "Close barrier command list when initializing");
+
+        // Backing memory of the render graph's transient resources
+        renderGraphResources_ = std::make_unique<graphics::D3D12RenderGraphResources>(device_.Get());
     }
 
     void RenderToBackBuffer()
     {
         // Command list allocators can only be reset when the associated command lists have finished execution on the GPU.
-        // Apps shoud use fences to determin GPU execution progress, which we will do at the end of this function.
-        ThrowIfFailed(commandAllocator_->Reset(), "Reset command allocator");
+        // BeginFrame() has waited for the frame which used this allocator last time.
+        ThrowIfFailed(commandAllocators_[frameIndex_]->Reset(), "Reset command allocator");
 
         // After ExecuteCommandList() has been called on a particular command list,
         // that command list can then be reset at any time before re-recoding.
-        ThrowIfFailed(commandList_->Reset(commandAllocator_.Get(), pipelineState_.Get()), "Reset command list");
+        ThrowIfFailed(commandList_->Reset(commandAllocators_[frameIndex_].Get(), nullptr), "Reset command list");
+        stateTracker_.Reset(commandList_.Get());
 
-        // Indicate the the back buffer will be used as a render target.
+        // Describe the frame as a graph, passes only declare what they read and write,
+        // the graph culls what doesn't reach the back buffer and works out the barriers.
         const UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
-        CD3DX12_RESOURCE_BARRIER toRenderBarrier = CD3DX12_RESOURCE_BARRIER::Transition(swapChainBuffers_[backBufferIndex].Get(),
-            D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        commandList_->ResourceBarrier(1, &toRenderBarrier);
+        renderGraphResources_->BeginFrame(renderGraph_);
+        const auto backBuffer = renderGraphResources_->Import(renderGraph_, "BackBuffer", swapChainBuffers_[backBufferIndex].Get(),
+            resourceStates_, D3D12_RESOURCE_STATE_PRESENT);
+
+        // The geometry arena isn't imported, buffers are promoted to the vertex buffer state implicitly.
+        renderGraph_.AddPass("Blob", [this, backBufferIndex]() { RecordBlobPass(swapChainRtvs_.GetCpu(backBufferIndex)); })
+            .Write(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+        renderGraph_.Compile();
+        // 替换下来的 transient 资源在本帧的 fence 完成后释放
+        renderGraphResources_->Realize(renderGraph_, releaseQueue_, fence_->GetNextValue());
+        renderGraphResources_->Execute(renderGraph_, commandList_.Get(), stateTracker_);
+
+        // Command list is expected to be closed before calling Reset again.
+        ThrowIfFailed(commandList_->Close(), "Clost command list");
+
+        // Bring back what the frame draws from if it was evicted, before the lists referencing it are submitted.
+        const graphics::ResidencyManager::Handle residencyHandles[] = { geometryResidency_, vectorFieldResidency_ };
+        residencyManager_->Use(residencyHandles, _countof(residencyHandles), fence_->GetNextValue(), fenceTimeline_->GetCompletedValue());
+
+        // The quads are drawn from the arena, wait on the GPU for their uploads unless they have landed already.
+        uploadService_->Require(quadUpload_);
+        uploadService_->Require(vectorFieldUpload_);
+        uploadService_->PrepareSubmission();
+
+        // The field drawn is the one stepped this frame, wait for the compute queue to finish it.
+        if (vectorFieldFenceValue_ != 0)
+        {
+            if (vectorFieldFenceValue_ > computeFence_->GetCompletedValue())
+            {
+                ThrowIfFailed(commandQueue_->Wait(computeFence_->GetFence(), vectorFieldFenceValue_), "Wait for the vector field");
+            }
+            vectorFieldReadFenceValues_[vectorFieldIndex_] = fence_->GetNextValue();
+        }
 
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(rtvHeap_->GetCPUDescriptorHandleForHeapStart(), backBufferIndex, rtvDescriptorSize_);
+        // Execulte the command list, preceded by the transitions into the states it starts with.
+        // 第一次使用时的状态在提交时才与全局状态比对，所需的 barrier 合并成一次 ResourceBarrier 调用。
+        const std::vector<D3D12_RESOURCE_BARRIER>& barriers = stateTracker_.Resolve();
+        if (barriers.empty())
+        {
+            ID3D12CommandList* commandLists[] = { commandList_.Get() };
+            commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
+        }
+        else
+        {
+            ThrowIfFailed(barrierCommandList_->Reset(commandAllocators_[frameIndex_].Get(), nullptr), "Reset barrier command list");
+            barrierCommandList_->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+            ThrowIfFailed(barrierCommandList_->Close(), "Close barrier command list");
 
-        commandList_->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+            ID3D12CommandList* commandLists[] = { barrierCommandList_.Get(), commandList_.Get() };
+            commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
+        }
+    }
+
+    void RecordBlobPass(D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle)
+    {
+        // 先录制到与API无关的命令流，最后一次性翻译到 commandList_
+        blobCommands_.Reset();
+        RecordBlobCommands(blobCommands_, rtvHandle);
+        commandSink_.Execute(blobCommands_, commandList_.Get());
+    }
+
+    void RecordBlobCommands(graphics::CommandStream& commands, D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle)
+    {
+        const uint64_t renderTargets[] = { rtvHandle.ptr };
+        commands.SetRenderTargets(_countof(renderTargets), renderTargets);
 
         // Set necessary state.
-        commandList_->SetGraphicsRootSignature(rootSignature_.Get());
-        // 绑定数据
-        ID3D12DescriptorHeap* descriptorHeaps[] = { cbvSrvHeap_.Get() };
-        commandList_->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-        commandList_->SetGraphicsRootDescriptorTable(0, cbvSrvHeap_->GetGPUDescriptorHandleForHeapStart());
+        commands.SetGraphicsRootSignature(rootSignature_.Get());
+        graphics::CommandObject descriptorHeaps[] = { shaderVisibleDescriptors_->GetHeap() };
+        commands.SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+        // 绑定数据，每帧将常量写入新的 slice
+        commands.SetGraphicsRootConstantBufferView(ShadersBindings::kRootSceneConstantBuffer, constantAllocator_->Push(constantBufferData_));
 
         CD3DX12_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(GetState().ViewportWidth), static_cast<float>(GetState().ViewportHeight));
         CD3DX12_RECT scissorRect(0, 0, static_cast<LONG>(GetState().ViewportWidth), static_cast<LONG>(GetState().ViewportHeight));
-        commandList_->RSSetViewports(1, &viewport);
-        commandList_->RSSetScissorRects(1, &scissorRect);
+        graphics::D3D12CommandSink::RecordViewport(commands, viewport);
+        graphics::D3D12CommandSink::RecordScissorRect(commands, scissorRect);
 
         // Record commands
         const FLOAT clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-        commandList_->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-        commandList_->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-        commandList_->IASetVertexBuffers(0, 1, &vertexBufferView_);
-        commandList_->DrawInstanced(4, 1, 0, 0);
+        commands.ClearRenderTarget(rtvHandle.ptr, clearColor);
 
-        // Indicate that the back buffer will now be used to present.
-        CD3DX12_RESOURCE_BARRIER toPresentBarrier = CD3DX12_RESOURCE_BARRIER::Transition(swapChainBuffers_[backBufferIndex].Get(),
-            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-        commandList_->ResourceBarrier(1, &toPresentBarrier);
+        // 管线仍在后台编译时跳过绘制
+        ID3D12PipelineState* pipelineState = pipelineService_->Get(pipelineState_);
+        if (pipelineState != nullptr)
+        {
+            commands.SetPipelineState(pipelineState);
+            commands.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+            // The arena's view is shared by every mesh with this stride, the quad is selected by its first vertex.
+            const D3D12_VERTEX_BUFFER_VIEW vertexBufferView = geometryArena_->GetVertexBufferView(packedVertexFormat_.GetStride());
+            graphics::D3D12CommandSink::RecordVertexBuffers(commands, 0, 1, &vertexBufferView);
+            commands.Draw(geometryArena_->GetNumElements(quadVertices_), 1, geometryArena_->GetFirstElement(quadVertices_), 0);
+        }
 
-        // Command list is expected to be closed before calling Reset again.
-        ThrowIfFailed(commandList_->Close(), "Clost command list");
+        RecordVectorFieldCommands(commands);
+        RecordSpriteCommands(commands);
+    }
 
-        // Execulte the command list
-        ID3D12CommandList* commandLists[] = { commandList_.Get() };
-        commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
+    void RecordVectorFieldCommands(graphics::CommandStream& commands)
+    {
+        ID3D12PipelineState* pipelineState = pipelineService_->Get(vectorFieldPipelineState_);
+        if (pipelineState == nullptr || vectorFieldFenceValue_ == 0)
+        {
+            return;
+        }
+        commands.SetGraphicsRootSignature(vectorFieldRootSignature_.Get());
+        commands.SetPipelineState(pipelineState);
+        commands.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        commands.SetGraphicsRootDescriptorTable(VectorFieldBindings::kRootViews, vectorFieldSrvTable_.GetGpu(vectorFieldIndex_).ptr);
+
+        const D3D12_VERTEX_BUFFER_VIEW vertexBufferView = geometryArena_->GetVertexBufferView(VectorFieldBindings::VSMainVertexStride);
+        graphics::D3D12CommandSink::RecordVertexBuffers(commands, 0, 1, &vertexBufferView);
+        commands.Draw(geometryArena_->GetNumElements(vectorFieldVertices_), 1, geometryArena_->GetFirstElement(vectorFieldVertices_), 0);
+    }
+
+    void RecordSpriteCommands(graphics::CommandStream& commands)
+    {
+        ID3D12PipelineState* pipelineState = pipelineService_->Get(spritePipelineState_);
+        if (pipelineState == nullptr)
+        {
+            return;
+        }
+        commands.SetGraphicsRootSignature(spriteRootSignature_.Get());
+        commands.SetPipelineState(pipelineState);
+        commands.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+        // 所有实例数据一次性上传，每个材质一次 instanced draw
+        graphics::D3D12SpriteBatch::Record(commands, spriteBatch_, *spriteInstanceAllocator_,
+            [this](graphics::CommandStream& materialCommands, uint32_t material)
+            {
+                materialCommands.SetGraphicsRootConstantBufferView(SpritesBindings::kRootSpriteMaterialConstantBuffer,
+                    constantAllocator_->Push(spriteMaterials_[material]));
+            });
     }
 
     void PresentAndSwapBuffers()
@@ -510,100 +944,337 @@ public:
 
     void CreateSwapChainRTV()
     {
-        // Create RTV for each back buffer, RTV for back buffers are stored at the start of render target descriptor heap.
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(rtvHeap_->GetCPUDescriptorHandleForHeapStart());
+        // Create RTV for each back buffer, the descriptors are allocated once and rewritten on resize.
+        if (!swapChainRtvs_.IsValid())
+        {
+            swapChainRtvs_ = rtvDescriptors_->Allocate(kNumSwapChainBuffers);
+        }
+
         for (UINT index = 0; index < kNumSwapChainBuffers; index++)
         {
             // Save pointers to back buffers in swapChainBuffers.
             ThrowIfFailed(swapChain_->GetBuffer(index, IID_PPV_ARGS(&swapChainBuffers_[index])), "GetBuffer");
+            graphics::D3D12ResourceStateTracker::Register(resourceStates_, swapChainBuffers_[index].Get(), D3D12_RESOURCE_STATE_PRESENT);
 
-            device_->CreateRenderTargetView(swapChainBuffers_[index].Get(), nullptr, rtvHandle);
-            rtvHandle.Offset(1, rtvDescriptorSize_);
+            device_->CreateRenderTargetView(swapChainBuffers_[index].Get(), nullptr, swapChainRtvs_.GetCpu(index));
         }
     }
 
+    void CreateComputeQueue()
+    {
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+        queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        ThrowIfFailed(device_->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&computeQueue_)), "CreateCommandQueue for compute");
+
+        // The compute work of a frame completes before its graphics work, which waits for it, so the allocators
+        // are recycled along with the frame's.
+        for (UINT index = 0; index < kNumFrames; index++)
+        {
+            ThrowIfFailed(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&computeCommandAllocators_[index])), "CreateCommandAllocator for compute");
+        }
+        ThrowIfFailed(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, computeCommandAllocators_[frameIndex_].Get(), nullptr, IID_PPV_ARGS(&computeCommandList_)), "CreateCommandList for compute");
+        ThrowIfFailed(computeCommandList_->Close(), "Close compute command list when initializing");
+
+        computeFence_ = std::make_unique<graphics::D3D12FenceSource>(device_.Get());
+    }
+
     void CreateVectorFieldBuffers()
     {
-        CD3DX12_HEAP_PROPERTIES defaultProperty(D3D12_HEAP_TYPE_DEFAULT);
-        CD3DX12_RESOURCE_DESC renderTargetDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+        // Simultaneous access lets both queues use the buffers without transitions: they are promoted to what each
+        // list does with them and decay back to COMMON after it, the fences order the accesses.
+        CD3DX12_RESOURCE_DESC fieldDesc = CD3DX12_RESOURCE_DESC::Tex2D(
             DXGI_FORMAT_R8G8B8A8_UNORM,
             fieldWidth_, fieldHeight_,
             1, 1, 1, 0,
-            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(rtvHeap_->GetCPUDescriptorHandleForHeapStart(), kNumSwapChainBuffers, rtvDescriptorSize_);
-        CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle(cbvSrvHeap_->GetCPUDescriptorHandleForHeapStart(), 1, cbvSrvDescriptorSize_);
-        for (int i = 0; i < 2; i++)
+            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS | D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS);
+        vectorFieldSrvs_ = srvStagingDescriptors_->Allocate(2);
+        vectorFieldUavs_ = srvStagingDescriptors_->Allocate(2);
+        for (UINT i = 0; i < 2; i++)
         {
-            ThrowIfFailed(device_->CreateCommittedResource(&defaultProperty, D3D12_HEAP_FLAG_NONE, &renderTargetDesc,
-                D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, IID_PPV_ARGS(&vectorFieldBuffers[i])), "Create vector field buffer");
-
-            // null pDesc argument will inherit the resource format and dimension (if not typeless) and RTVs target the first mip and all array slices.
-            device_->CreateRenderTargetView(vectorFieldBuffers[i].Get(), nullptr, rtvHandle);
-            rtvHandle.Offset(1, rtvDescriptorSize_);
+            // Both placed in the same texture heap.
+            vectorFieldBuffers[i] = heapAllocator_->CreateResource(D3D12_HEAP_TYPE_DEFAULT, fieldDesc,
+                D3D12_RESOURCE_STATE_COMMON, nullptr, vectorFieldAllocations_[i]);
 
             // null pDesc argument will inherit the resource format and dimension (if not typeless) and for buffers SRVs target a full buffer and are typed (not raw or structured), 
             // and for textures SRVs target a full texture, all mips and all array slices.
-            device_->CreateShaderResourceView(vectorFieldBuffers[i].Get(), nullptr, srvHandle);
-            srvHandle.Offset(1, cbvSrvDescriptorSize_);
+            device_->CreateShaderResourceView(vectorFieldBuffers[i].Get(), nullptr, vectorFieldSrvs_.GetCpu(i));
+            device_->CreateUnorderedAccessView(vectorFieldBuffers[i].Get(), nullptr, nullptr, vectorFieldUavs_.GetCpu(i));
         }
+
+        // The SRVs live as long as the buffers, so they go to the static region of the shader visible heap in one copy.
+        D3D12_CPU_DESCRIPTOR_HANDLE srvHandles[] = { vectorFieldSrvs_.GetCpu(0), vectorFieldSrvs_.GetCpu(1) };
+        vectorFieldSrvTable_ = shaderVisibleDescriptors_->AllocateStatic(_countof(srvHandles));
+        shaderVisibleDescriptors_->CopyTo(vectorFieldSrvTable_, 0, srvHandles, _countof(srvHandles));
+
+        // A step reads one buffer and writes the other, the table of the step writing buffer i starts at 2 * i.
+        D3D12_CPU_DESCRIPTOR_HANDLE computeHandles[] =
+        {
+            vectorFieldSrvs_.GetCpu(1), vectorFieldUavs_.GetCpu(0),
+            vectorFieldSrvs_.GetCpu(0), vectorFieldUavs_.GetCpu(1)
+        };
+        vectorFieldComputeTables_ = shaderVisibleDescriptors_->AllocateStatic(_countof(computeHandles));
+        shaderVisibleDescriptors_->CopyTo(vectorFieldComputeTables_, 0, computeHandles, _countof(computeHandles));
+
+        vectorFieldParameters_.Width = fieldWidth_;
+        vectorFieldParameters_.Height = fieldHeight_;
+        vectorFieldParameters_.Aspect = static_cast<float>(fieldWidth_) / static_cast<float>(fieldHeight_);
+
+        // Drawn in the bottom left quarter of the viewport, which has the field's aspect ratio at the default size.
+        const float quadVertices[][4] =
+        {
+            { -1.0f, -0.5f, 0.0f, 0.0f },
+            { -0.5f, -0.5f, 1.0f, 0.0f },
+            { -1.0f, -1.0f, 0.0f, 1.0f },
+            { -0.5f, -1.0f, 1.0f, 1.0f }
+        };
+        static_assert(sizeof(quadVertices[0]) == VectorFieldBindings::VSMainVertexStride, "Vertices don't match the input of VSMain");
+        vectorFieldVertices_ = geometryArena_->AllocateVertices(static_cast<UINT>(_countof(quadVertices)), VectorFieldBindings::VSMainVertexStride);
+        geometryArena_->Write(vectorFieldVertices_, quadVertices, uploadService_->GetUploadRing());
+        vectorFieldUpload_ = uploadService_->Commit();
     }
 
     void CreateVectorFieldRootSignature()
     {
-        CD3DX12_DESCRIPTOR_RANGE1 ranges[] = { CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0) };
-        CD3DX12_ROOT_PARAMETER1 rootParameters[] = { CD3DX12_ROOT_PARAMETER1() };
-        rootParameters[0].InitAsDescriptorTable(_countof(ranges), ranges, D3D12_SHADER_VISIBILITY_PIXEL);
-
-        D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags = 
-            D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
-
-        // Create a sampler
-        D3D12_STATIC_SAMPLER_DESC samplerDesc = {};
-        samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-        samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-        samplerDesc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-        samplerDesc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-        samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
-        samplerDesc.MaxLOD = D3D12_FLOAT32_MAX;
-        samplerDesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-
-        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-        rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 1, &samplerDesc, rootSignatureFlags);
-        ComPtr<ID3DBlob> signature;
-        ThrowIfFailed(D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &signature, nullptr), "D3D12SerializeVersionedRootSignature for vector field");
-        ThrowIfFailed(device_->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&vectorFieldRootSignature_)), "CreateRootSignature for vector field");
+        // Both generated from VectorField.hlsl: the SRV table of the pixel shader, and the constants and the
+        // SRV and UAV table of the compute shader.
+        const VectorFieldBindings::RootSignature rootSignatureDesc;
+        vectorFieldRootSignature_ = rootSignatures_->Get(rootSignatureDesc.Desc, &vectorFieldRootSignatureHash_);
+
+        const VectorFieldBindings::ComputeRootSignature computeRootSignatureDesc;
+        vectorFieldComputeRootSignature_ = rootSignatures_->Get(computeRootSignatureDesc.Desc, &vectorFieldComputeRootSignatureHash_);
     }
 
     void CreateVectorFieldPipelineState()
     {
-        D3D12_INPUT_ELEMENT_DESC inputElementDesc[] =
+        D3D12_INPUT_LAYOUT_DESC inputLayoutDesc{ VectorFieldBindings::VSMainInputLayout, _countof(VectorFieldBindings::VSMainInputLayout) };
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.InputLayout = inputLayoutDesc;
+        psoDesc.pRootSignature = vectorFieldRootSignature_.Get();
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_VectorField_VSMain, sizeof(g_VectorField_VSMain));
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_VectorField_PSMain, sizeof(g_VectorField_PSMain));
+        psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+        psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+        psoDesc.DepthStencilState.DepthEnable = FALSE;
+        psoDesc.DepthStencilState.StencilEnable = FALSE;
+        psoDesc.SampleMask = UINT_MAX;
+        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        psoDesc.NumRenderTargets = 1;
+        psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        psoDesc.SampleDesc.Count = 1;
+
+        auto onCompletion = [this](graphics::PipelineService::PipelineHandle handle, bool succeeded)
+            {
+                if (!succeeded)
+                {
+                    std::cerr << "Failed to create a vector field pipeline: " << pipelineService_->GetError(handle) << std::endl;
+                }
+            };
+        vectorFieldPipelineState_ = pipelineService_->RequestGraphicsPipeline(psoDesc, vectorFieldRootSignatureHash_, onCompletion);
+
+        // The field isn't stepped nor drawn until the pipelines are ready.
+        D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+        computePsoDesc.pRootSignature = vectorFieldComputeRootSignature_.Get();
+        computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(g_VectorField_CSMain, sizeof(g_VectorField_CSMain));
+        vectorFieldComputePipelineState_ = pipelineService_->RequestComputePipeline(computePsoDesc, vectorFieldComputeRootSignatureHash_, onCompletion);
+    }
+
+    void GenerateVectorField()
+    {
+        ID3D12PipelineState* pipelineState = pipelineService_->Get(vectorFieldComputePipelineState_);
+        if (pipelineState == nullptr)
+        {
+            return;
+        }
+
+        // Ping-pong: read the buffer the previous frame draws, write the other one. The previous frame only reads
+        // its buffer as well, so the two overlap; the frame before it drew the target and has to be done with it.
+        const UINT source = vectorFieldIndex_;
+        const UINT target = 1 - source;
+        if (vectorFieldReadFenceValues_[target] > fence_->GetCompletedValue())
+        {
+            ThrowIfFailed(computeQueue_->Wait(fence_->GetFence(), vectorFieldReadFenceValues_[target]), "Wait for the frame drawing the vector field");
+        }
+
+        // The blob's position is the center of the swirl.
+        vectorFieldParameters_.CenterX = constantBufferData_.offset.x;
+        vectorFieldParameters_.CenterY = constantBufferData_.offset.y;
+        VectorFieldBindings::VectorFieldConstants constants = {};
+        constants.center = DirectX::XMFLOAT2(vectorFieldParameters_.CenterX, vectorFieldParameters_.CenterY);
+        constants.aspect = vectorFieldParameters_.Aspect;
+        constants.radius = vectorFieldParameters_.Radius;
+        constants.strength = vectorFieldParameters_.Strength;
+        constants.decay = vectorFieldParameters_.Decay;
+        constants.advection = vectorFieldParameters_.Advection;
+        constants.width = vectorFieldParameters_.Width;
+        constants.height = vectorFieldParameters_.Height;
+
+        // BeginFrame() has waited for the frame which used this allocator last time, and with it for its compute work.
+        ThrowIfFailed(computeCommandAllocators_[frameIndex_]->Reset(), "Reset compute command allocator");
+        ThrowIfFailed(computeCommandList_->Reset(computeCommandAllocators_[frameIndex_].Get(), pipelineState), "Reset compute command list");
+
+        ID3D12DescriptorHeap* descriptorHeaps[] = { shaderVisibleDescriptors_->GetHeap() };
+        computeCommandList_->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+
+        if (!vectorFieldInitialized_)
+        {
+            // Placed resources start out undefined, the first step reads a field at rest: velocity 0 maps to 0.5.
+            const FLOAT restValue[] = { 0.5f, 0.5f, 0.0f, 1.0f };
+            computeCommandList_->ClearUnorderedAccessViewFloat(vectorFieldComputeTables_.GetGpu(2 * source + 1), vectorFieldUavs_.GetCpu(source),
+                vectorFieldBuffers[source].Get(), restValue, 0, nullptr);
+            CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(vectorFieldBuffers[source].Get(),
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            computeCommandList_->ResourceBarrier(1, &barrier);
+            vectorFieldInitialized_ = true;
+        }
+
+        computeCommandList_->SetComputeRootSignature(vectorFieldComputeRootSignature_.Get());
+        computeCommandList_->SetComputeRootConstantBufferView(VectorFieldBindings::kComputeRootVectorFieldConstants, constantAllocator_->Push(constants));
+        computeCommandList_->SetComputeRootDescriptorTable(VectorFieldBindings::kComputeRootViews, vectorFieldComputeTables_.GetGpu(2 * target));
+        computeCommandList_->Dispatch((fieldWidth_ + kVectorFieldThreadGroupSize - 1) / kVectorFieldThreadGroupSize,
+            (fieldHeight_ + kVectorFieldThreadGroupSize - 1) / kVectorFieldThreadGroupSize, 1);
+
+#ifndef NDEBUG
+        if (vectorFieldSteps_ == kVectorFieldValidationStep)
+        {
+            RecordVectorFieldReadback(source, target);
+        }
+#endif // !NDEBUG
+
+        ThrowIfFailed(computeCommandList_->Close(), "Close compute command list");
+
+        // Last used by this frame as far as residency is concerned, the frame's graphics work completes after it.
+        residencyManager_->Use(&vectorFieldResidency_, 1, fence_->GetNextValue(), fenceTimeline_->GetCompletedValue());
+
+        ID3D12CommandList* commandLists[] = { computeCommandList_.Get() };
+        computeQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
+        vectorFieldFenceValue_ = computeFence_->Signal(computeQueue_.Get());
+        vectorFieldIndex_ = target;
+        vectorFieldSteps_++;
+
+        if (vectorFieldReadback_ && vectorFieldReadbackFenceValue_ == 0)
         {
-            { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+            vectorFieldReadbackFenceValue_ = vectorFieldFenceValue_;
+        }
+    }
+
+    void RecordVectorFieldReadback(UINT source, UINT target)
+    {
+        // Both buffers of the step, so the CPU can repeat it from the same source.
+        D3D12_RESOURCE_DESC fieldDesc = vectorFieldBuffers[0]->GetDesc();
+        UINT64 fieldSize = 0;
+        device_->GetCopyableFootprints(&fieldDesc, 0, 1, 0, &vectorFieldReadbackFootprints_[0], nullptr, nullptr, &fieldSize);
+        vectorFieldReadbackFootprints_[1] = vectorFieldReadbackFootprints_[0];
+        vectorFieldReadbackFootprints_[1].Offset = graphics::AlignUp(fieldSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+        CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(vectorFieldReadbackFootprints_[1].Offset + fieldSize);
+        vectorFieldReadback_ = heapAllocator_->CreateResource(D3D12_HEAP_TYPE_READBACK, bufferDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, vectorFieldReadbackAllocation_);
+        vectorFieldReadbackParameters_ = vectorFieldParameters_;
+        vectorFieldReadbackFenceValue_ = 0;
+
+        CD3DX12_RESOURCE_BARRIER barriers[] =
+        {
+            CD3DX12_RESOURCE_BARRIER::Transition(vectorFieldBuffers[source].Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE),
+            CD3DX12_RESOURCE_BARRIER::Transition(vectorFieldBuffers[target].Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE)
         };
-        D3D12_INPUT_LAYOUT_DESC inputLayoutDesc{ inputElementDesc, _countof(inputElementDesc) };
+        computeCommandList_->ResourceBarrier(_countof(barriers), barriers);
+
+        const UINT buffers[] = { source, target };
+        for (UINT i = 0; i < 2; i++)
+        {
+            CD3DX12_TEXTURE_COPY_LOCATION destinationLocation(vectorFieldReadback_.Get(), vectorFieldReadbackFootprints_[i]);
+            CD3DX12_TEXTURE_COPY_LOCATION sourceLocation(vectorFieldBuffers[buffers[i]].Get(), 0);
+            computeCommandList_->CopyTextureRegion(&destinationLocation, 0, 0, 0, &sourceLocation, nullptr);
+        }
+    }
+
+    void CheckVectorFieldReadback()
+    {
+        if (!vectorFieldReadback_ || vectorFieldReadbackFenceValue_ == 0 || computeFence_->GetCompletedValue() < vectorFieldReadbackFenceValue_)
+        {
+            return;
+        }
+
+        // Rows are padded to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT in the readback buffer, the reference packs them.
+        const UINT rowSize = fieldWidth_ * kVectorFieldTexelSize;
+        std::vector<uint8_t> texels[2];
+        UINT8* readback = nullptr;
+        ThrowIfFailed(vectorFieldReadback_->Map(0, nullptr, reinterpret_cast<void**>(&readback)), "Map vector field readback");
+        for (UINT i = 0; i < 2; i++)
+        {
+            texels[i].resize(static_cast<size_t>(rowSize) * fieldHeight_);
+            for (UINT row = 0; row < fieldHeight_; row++)
+            {
+                memcpy(texels[i].data() + static_cast<size_t>(rowSize) * row,
+                    readback + vectorFieldReadbackFootprints_[i].Offset + static_cast<UINT64>(vectorFieldReadbackFootprints_[i].Footprint.RowPitch) * row, rowSize);
+            }
+        }
+        CD3DX12_RANGE writtenRange(0, 0);
+        vectorFieldReadback_->Unmap(0, &writtenRange);
+
+        // Within one step of rounding, except for the rare texel whose nearest source flips.
+        std::vector<uint8_t> expected(texels[1].size());
+        StepVectorField(vectorFieldReadbackParameters_, texels[0].data(), expected.data());
+        const size_t numTexels = static_cast<size_t>(fieldWidth_) * fieldHeight_;
+        const VectorFieldDifference difference = CompareVectorFields(expected.data(), texels[1].data(), numTexels, 1);
+        std::cout << "Vector field validation:"
+            << "\n\tMax Difference: " << difference.MaxDifference << "/255"
+            << "\n\tMismatches: " << difference.NumMismatches << " of " << numTexels << " texels" << std::endl;
+        if (difference.NumMismatches > numTexels / 1000)
+        {
+            std::cerr << "The vector field doesn't match the CPU reference" << std::endl;
+        }
+
+        // The compute queue is done with it.
+        vectorFieldReadback_.Reset();
+        heapAllocator_->Free(vectorFieldReadbackAllocation_, fenceTimeline_->GetCompletedValue());
+        vectorFieldReadbackAllocation_ = {};
+    }
+
+    void BeginFrame()
+    {
+        // Wait until the GPU has finished the frame which used this frame's allocator and constants kNumFrames frames ago.
+        fenceTimeline_->Wait(frameFenceValues_[frameIndex_]);
+
+        constantAllocator_->BeginFrame();
+        spriteInstanceAllocator_->BeginFrame();
+
+        // Shaders recompiled in the background request a new pipeline here.
+        if (shaderReloader_)
+        {
+            shaderReloader_->Poll();
+        }
+
+        // Pipelines finished on worker threads become visible at frame boundaries only. A replaced pipeline may still
+        // be used by the frames in flight, it is released once the fence of the frame recorded next has completed.
+        pipelineService_->Poll(releaseQueue_, fence_->GetNextValue());
+    }
+
+    void EndFrame()
+    {
+        // Mark the end of this frame's commands, and move on to the next frame resources.
+        const UINT64 fenceValue = fence_->Signal(commandQueue_.Get());
+        frameFenceValues_[frameIndex_] = fenceValue;
+        constantAllocator_->EndFrame(fenceValue);
+        spriteInstanceAllocator_->EndFrame(fenceValue);
+        shaderVisibleDescriptors_->EndFrame(fenceValue, fenceTimeline_->GetCompletedValue());
+
+        // Copies recorded during the frame start right away, not when a frame first needs them.
+        uploadService_->Flush();
+
+        frameIndex_ = (frameIndex_ + 1) % kNumFrames;
     }
 
     void FlushCommandQueue()
     {
-        // Add an instruction to the command queue to set a new fence point by instructing 'fence_' to wait for the 'fenceValue_'.
+        // Add an instruction to the command queue to set a new fence point.
         // `fence_` value won't be set by GPU until it finishes processing all the commands prior to this `Signal()`.
-        const UINT64 fenceValueToWaitFor = fenceValue_;
-        ThrowIfFailed(commandQueue_->Signal(fence_.Get(), fenceValueToWaitFor), "Signal");
-        fenceValue_++;
+        const UINT64 fenceValueToWaitFor = fence_->Signal(commandQueue_.Get());
 
         // Wait until the GPU has completed commands up to this fence point.
-        if (fence_->GetCompletedValue() < fenceValueToWaitFor)
-        {
-            // Fire event when GPU hits current fence.
-            ThrowIfFailed(fence_->SetEventOnCompletion(fenceValueToWaitFor, fenceEventHandle_), "SetEventOnCompletion");
-            // Wait until the created event is fired
-            WaitForSingleObject(fenceEventHandle_, INFINITE);
-        }
+        fenceTimeline_->Wait(fenceValueToWaitFor);
     }
 };
 
@@ -0,0 +1,103 @@
+#include "VectorField.h"
+
+#include <cmath>
+
+namespace
+{
+
+float Saturate(float value)
+{
+    return value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+}
+
+float Clamp(float value, float low, float high)
+{
+    return value < low ? low : value > high ? high : value;
+}
+
+int Clamp(int value, int low, int high)
+{
+    return value < low ? low : value > high ? high : value;
+}
+
+// D3D's float to UNORM conversion, rounding to the nearest.
+uint8_t EncodeUnorm(float value)
+{
+    return static_cast<uint8_t>(Saturate(value) * 255.0f + 0.5f);
+}
+
+float DecodeUnorm(uint8_t value)
+{
+    return static_cast<float>(value) / 255.0f;
+}
+
+void LoadVelocity(const VectorFieldParameters& parameters, const uint8_t* source, int x, int y, float& velocityX, float& velocityY)
+{
+    const uint8_t* texel = source + (static_cast<size_t>(y) * parameters.Width + x) * kVectorFieldTexelSize;
+    velocityX = DecodeUnorm(texel[0]) * 2.0f - 1.0f;
+    velocityY = DecodeUnorm(texel[1]) * 2.0f - 1.0f;
+}
+
+};
+
+void StepVectorField(const VectorFieldParameters& parameters, const uint8_t* source, uint8_t* target)
+{
+    const int width = static_cast<int>(parameters.Width);
+    const int height = static_cast<int>(parameters.Height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            float velocityX;
+            float velocityY;
+            LoadVelocity(parameters, source, x, y, velocityX, velocityY);
+            const float positionX = static_cast<float>(x) - velocityX * parameters.Advection;
+            const float positionY = static_cast<float>(y) - velocityY * parameters.Advection;
+            const int nearestX = Clamp(static_cast<int>(std::floor(positionX + 0.5f)), 0, width - 1);
+            const int nearestY = Clamp(static_cast<int>(std::floor(positionY + 0.5f)), 0, height - 1);
+            float advectedX;
+            float advectedY;
+            LoadVelocity(parameters, source, nearestX, nearestY, advectedX, advectedY);
+
+            const float u = (static_cast<float>(x) + 0.5f) / static_cast<float>(width);
+            const float v = (static_cast<float>(y) + 0.5f) / static_cast<float>(height);
+            const float offsetX = (u - parameters.CenterX) * parameters.Aspect;
+            const float offsetY = v - parameters.CenterY;
+            const float distance = std::sqrt(offsetX * offsetX + offsetY * offsetY);
+            const float falloff = Saturate(1.0f - distance / parameters.Radius);
+            const float divisor = distance > 0.0001f ? distance : 0.0001f;
+            const float swirlX = -offsetY / divisor * (parameters.Strength * falloff);
+            const float swirlY = offsetX / divisor * (parameters.Strength * falloff);
+
+            const float resultX = Clamp(advectedX * parameters.Decay + swirlX, -1.0f, 1.0f);
+            const float resultY = Clamp(advectedY * parameters.Decay + swirlY, -1.0f, 1.0f);
+            uint8_t* texel = target + (static_cast<size_t>(y) * parameters.Width + x) * kVectorFieldTexelSize;
+            texel[0] = EncodeUnorm(resultX * 0.5f + 0.5f);
+            texel[1] = EncodeUnorm(resultY * 0.5f + 0.5f);
+            texel[2] = EncodeUnorm(std::sqrt(resultX * resultX + resultY * resultY) * 0.70710678f);
+            texel[3] = 255;
+        }
+    }
+}
+
+VectorFieldDifference CompareVectorFields(const uint8_t* expected, const uint8_t* actual, size_t numTexels, uint32_t tolerance)
+{
+    VectorFieldDifference difference;
+    for (size_t index = 0; index < numTexels; index++)
+    {
+        bool mismatch = false;
+        for (uint32_t channel = 0; channel < kVectorFieldTexelSize; channel++)
+        {
+            const int expectedValue = expected[index * kVectorFieldTexelSize + channel];
+            const int actualValue = actual[index * kVectorFieldTexelSize + channel];
+            const uint32_t channelDifference = static_cast<uint32_t>(expectedValue > actualValue ? expectedValue - actualValue : actualValue - expectedValue);
+            if (channelDifference > difference.MaxDifference)
+            {
+                difference.MaxDifference = channelDifference;
+            }
+            mismatch = mismatch || channelDifference > tolerance;
+        }
+        difference.NumMismatches += mismatch ? 1 : 0;
+    }
+    return difference;
+}
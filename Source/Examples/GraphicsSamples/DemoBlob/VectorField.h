@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// CPU reference of the vector field step, CSMain of Shaders/VectorField.hlsl.
+//
+// Texels are R8G8B8A8_UNORM: the velocity in rg mapped from [-1, 1], its length over sqrt(2) in b, 1 in a.
+// Each step advects the source field along itself, fetching the nearest texel, decays it, and adds a swirl around
+// the center. The shader is followed operation for operation, results only differ by the GPU's float rounding,
+// which may flip the nearest texel of the few positions halfway between two.
+//
+struct VectorFieldParameters
+{
+    // Texture coordinates, y down like the blob's offset
+    float CenterX = 0.5f;
+    float CenterY = 0.5f;
+    // Width over height of the field
+    float Aspect = 1.0f;
+    // Reach of the swirl, in texture coordinates of the height
+    float Radius = 0.25f;
+    float Strength = 0.1f;
+    float Decay = 0.95f;
+    // Texels travelled per step at velocity 1
+    float Advection = 2.0f;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+};
+
+struct VectorFieldDifference
+{
+    // Largest difference of a channel, in 1/255 steps
+    uint32_t MaxDifference = 0;
+    // Texels with a channel differing by more than the tolerance
+    size_t NumMismatches = 0;
+};
+
+const uint32_t kVectorFieldTexelSize = 4;
+
+// `source` and `target` hold Width * Height texels in tightly packed rows.
+void StepVectorField(const VectorFieldParameters& parameters, const uint8_t* source, uint8_t* target);
+
+VectorFieldDifference CompareVectorFields(const uint8_t* expected, const uint8_t* actual, size_t numTexels, uint32_t tolerance);
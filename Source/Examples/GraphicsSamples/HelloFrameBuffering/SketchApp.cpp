@@ -191,7 +191,7 @@ public:
         ThrowIfFailed(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature_)), "CreateRootSignature");
 
         // Compile and load shaders
-        // Already compiled as g_VSMain, g_PSMain
+        // Already compiled as g_Shaders_VSMain, g_Shaders_PSMain
 
         // Define the vertex input layout.
         D3D12_INPUT_ELEMENT_DESC inputElementDesc[] =
@@ -206,8 +206,8 @@ public:
         D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
         psoDesc.InputLayout = inputLayoutDesc;
         psoDesc.pRootSignature = rootSignature_.Get();
-        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_VSMain, sizeof(g_VSMain));
-        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_PSMain, sizeof(g_PSMain));
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_Shaders_VSMain, sizeof(g_Shaders_VSMain));
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_Shaders_PSMain, sizeof(g_Shaders_PSMain));
         psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
         psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
         psoDesc.DepthStencilState.DepthEnable = FALSE;
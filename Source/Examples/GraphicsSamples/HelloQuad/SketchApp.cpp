@@ -1,6 +1,7 @@
 ﻿#include <string>
 #include <stdexcept>
 #include <iostream>
+#include <memory>
 
 #include <wrl/client.h>
 #include <dxgi1_6.h>
@@ -10,6 +11,8 @@
 #include <DirectXMath.h>
 
 #include "Launcher.h"
+#include "Hash.h"
+#include "StaticCommandListCache.h"
 #include "ShadersVS.h"
 #include "ShadersPS.h"
 
@@ -77,6 +80,7 @@ class HelloQuad : public sketch::SketchBase
     ComPtr<ID3D12Resource> swapChainBuffers_[kSwapChainBufferCount];
     ComPtr<ID3D12CommandAllocator> commandAllocator_;
     ComPtr<ID3D12GraphicsCommandList> commandList_;
+    std::unique_ptr<graphics::StaticCommandListCache> frameCommandLists_;
     ComPtr<ID3D12Fence> fence_;
     UINT64 fenceValue_;
     HANDLE fenceEventHandle_;
@@ -214,7 +218,7 @@ public:
         ThrowIfFailed(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature_)));
 
         // Compile and load shaders
-        // Already compiled as g_VSMain, g_PSMain
+        // Already compiled as g_Shaders_VSMain, g_Shaders_PSMain
 
         // Define the vertex input layout.
         D3D12_INPUT_ELEMENT_DESC inputElementDesc[] =
@@ -229,8 +233,8 @@ public:
         D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
         psoDesc.InputLayout = inputLayoutDesc;
         psoDesc.pRootSignature = rootSignature_.Get();
-        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_VSMain, sizeof(g_VSMain));
-        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_PSMain, sizeof(g_PSMain));
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_Shaders_VSMain, sizeof(g_Shaders_VSMain));
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_Shaders_PSMain, sizeof(g_Shaders_PSMain));
         psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
         psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
         psoDesc.DepthStencilState.DepthEnable = FALSE;
@@ -246,9 +250,13 @@ public:
         // Command allocator
         ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator_)));
 
-        // Command list
+        // Command list, records the uploads below
         ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator_.Get(), pipelineState_.Get(), IID_PPV_ARGS(&commandList_)));
 
+        // Frame command lists, one per back buffer. The quad moves through the constant buffer only,
+        // so each list is recorded once and executed again every frame.
+        frameCommandLists_ = std::make_unique<graphics::StaticCommandListCache>(device.Get(), kSwapChainBufferCount);
+
         // Create the vertex buffer.
 
         float aspectRatio = (float)GetConfig().Width / GetConfig().Height;
@@ -346,63 +354,71 @@ public:
         }
     }
 
-    virtual void OnUpdate() override
+    void RecordFrame(ID3D12GraphicsCommandList* commandList, UINT backBufferIndex)
     {
-        const float translationSpeed = 0.3f;
-        const float offsetBounds = 1.25f;
-
-        constantBufferData_.offset.x += translationSpeed * GetDeltaTime();
-        if (constantBufferData_.offset.x > offsetBounds)
-        {
-            constantBufferData_.offset.x = -offsetBounds;
-        }
-        memcpy(cbvDataBegin_, &constantBufferData_, sizeof(constantBufferData_));
-
-        // Command list allocators can only be reset when the associated command lists have finished execution on the GPU.
-        // Apps shoud use fences to determin GPU execution progress, which we will do at the end of this function.
-        ThrowIfFailed(commandAllocator_->Reset());
-
-        // After ExecuteCommandList() has been called on a particular command list,
-        // that command list can then be reset at any time before re-recoding.
-        ThrowIfFailed(commandList_->Reset(commandAllocator_.Get(), pipelineState_.Get()));
-
         // Indicate the the back buffer will be used as a render target.
-        const UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
         CD3DX12_RESOURCE_BARRIER toRenderBarrier = CD3DX12_RESOURCE_BARRIER::Transition(swapChainBuffers_[backBufferIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        commandList_->ResourceBarrier(1, &toRenderBarrier);
+        commandList->ResourceBarrier(1, &toRenderBarrier);
 
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(rtvHeap_->GetCPUDescriptorHandleForHeapStart(), backBufferIndex, rtvDescriptorSize_);
 
-        commandList_->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+        commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
         // Set necessary state.
-        commandList_->SetGraphicsRootSignature(rootSignature_.Get());
+        commandList->SetPipelineState(pipelineState_.Get());
+        commandList->SetGraphicsRootSignature(rootSignature_.Get());
         // 绑定数据
         ID3D12DescriptorHeap* descriptorHeaps[] = { cbvHeap_.Get() };
-        commandList_->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-        commandList_->SetGraphicsRootDescriptorTable(0, cbvHeap_->GetGPUDescriptorHandleForHeapStart());
+        commandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+        commandList->SetGraphicsRootDescriptorTable(0, cbvHeap_->GetGPUDescriptorHandleForHeapStart());
 
         CD3DX12_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(GetConfig().Width), static_cast<float>(GetConfig().Height));
         CD3DX12_RECT scissorRect(0, 0, GetConfig().Width, GetConfig().Height);
-        commandList_->RSSetViewports(1, &viewport);
-        commandList_->RSSetScissorRects(1, &scissorRect);
+        commandList->RSSetViewports(1, &viewport);
+        commandList->RSSetScissorRects(1, &scissorRect);
 
         // Record commands
         const FLOAT clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f};
-        commandList_->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-        commandList_->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-        commandList_->IASetVertexBuffers(0, 1, &vertexBufferView_);
-        commandList_->DrawInstanced(4, 1, 0, 0);
+        commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        commandList->IASetVertexBuffers(0, 1, &vertexBufferView_);
+        commandList->DrawInstanced(4, 1, 0, 0);
 
         // Indicate that the back buffer will now be used to present.
         CD3DX12_RESOURCE_BARRIER toPresentBarrier = CD3DX12_RESOURCE_BARRIER::Transition(swapChainBuffers_[backBufferIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-        commandList_->ResourceBarrier(1, &toPresentBarrier);
+        commandList->ResourceBarrier(1, &toPresentBarrier);
+    }
 
-        // Command list is expected to be closed before calling Reset again.
-        ThrowIfFailed(commandList_->Close());
+    virtual void OnUpdate() override
+    {
+        const float translationSpeed = 0.3f;
+        const float offsetBounds = 1.25f;
+
+        constantBufferData_.offset.x += translationSpeed * GetDeltaTime();
+        if (constantBufferData_.offset.x > offsetBounds)
+        {
+            constantBufferData_.offset.x = -offsetBounds;
+        }
+        memcpy(cbvDataBegin_, &constantBufferData_, sizeof(constantBufferData_));
+
+        const UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
+
+        // Everything the recorded list depends on, it is recorded again only when one of them changes.
+        // The frame below waits for the GPU, so the list is never executed twice at the same time.
+        const uint64_t inputsHash = graphics::Hasher()
+            .AppendValue(swapChainBuffers_[backBufferIndex].Get())
+            .AppendValue(GetConfig().Width)
+            .AppendValue(GetConfig().Height)
+            .AppendValue(pipelineState_.Get())
+            .AppendValue(rootSignature_.Get())
+            .AppendValue(cbvHeap_.Get())
+            .AppendValue(vertexBufferView_)
+            .Get();
+        ID3D12GraphicsCommandList* commandList = frameCommandLists_->Get(backBufferIndex, inputsHash,
+            [this](ID3D12GraphicsCommandList* commandList, UINT slot) { RecordFrame(commandList, slot); });
 
         // Execulte the command list
-        ID3D12CommandList* commandLists[] = { commandList_.Get() };
+        ID3D12CommandList* commandLists[] = { commandList };
         commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
 
         // Swap buffers
@@ -1,6 +1,7 @@
 #include <string>
 #include <stdexcept>
 #include <iostream>
+#include <memory>
 
 #include <wrl/client.h>
 #include <dxgi1_6.h>
@@ -10,6 +11,9 @@
 #include <DirectXMath.h>
 
 #include "Launcher.h"
+#include "ShaderCache.h"
+#include "Hash.h"
+#include "StaticCommandListCache.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -65,8 +69,7 @@ class HelloTriangle : public sketch::SketchBase
     ComPtr<ID3D12DescriptorHeap> rtvHeap_;
     UINT rtvDescriptorSize_;
     ComPtr<ID3D12Resource> swapChainBuffers_[kSwapChainBufferCount];
-    ComPtr<ID3D12CommandAllocator> commandAllocator_;
-    ComPtr<ID3D12GraphicsCommandList> commandList_;
+    std::unique_ptr<graphics::StaticCommandListCache> frameCommandLists_;
     ComPtr<ID3D12Fence> fence_;
     UINT64 fenceValue_;
     ComPtr<ID3D12RootSignature> rootSignature_;
@@ -169,9 +172,6 @@ public:
             rtvHandle.Offset(1, rtvDescriptorSize_);
         }
 
-        // Command allocator
-        ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator_)));
-
         // Pipeline state object
 
         // Root signature, create an empty root signature
@@ -192,8 +192,12 @@ public:
 #endif
         std::wstring path(SHADER_DIR);
         path += L"/shaders.hlsl";
-        ThrowIfFailed(D3DCompileFromFile(path.c_str(), nullptr, nullptr, "VSMain", "vs_5_0", compileFlags, 0, &vertexShader, nullptr));
-        ThrowIfFailed(D3DCompileFromFile(path.c_str(), nullptr, nullptr, "PSMain", "ps_5_0", compileFlags, 0, &pixelShader, nullptr));
+
+        // Bytecode from earlier runs is reused as long as the preprocessed source, the defines and the flags are unchanged.
+        graphics::ShaderCache shaderCache("HelloTriangle.shaders");
+        vertexShader = shaderCache.CompileFromFile(path, nullptr, "VSMain", "vs_5_0", compileFlags);
+        pixelShader = shaderCache.CompileFromFile(path, nullptr, "PSMain", "ps_5_0", compileFlags);
+        shaderCache.Save();
 
         // Define the vertex input layout.
         D3D12_INPUT_ELEMENT_DESC inputElementDesc[] =
@@ -221,12 +225,8 @@ public:
 
         ThrowIfFailed(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState_)));
 
-        // Command list
-        ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator_.Get(), pipelineState_.Get(), IID_PPV_ARGS(&commandList_)));
-
-        // Command lists are created in the recording state, but there is nothing to record yet.
-        // The first time we refer to the command list we will Reset it, and it is expected to be closed before calling Reset.
-        ThrowIfFailed(commandList_->Close());
+        // Command lists, one per back buffer, recorded once and executed again while the scene stays the same.
+        frameCommandLists_ = std::make_unique<graphics::StaticCommandListCache>(device.Get(), kSwapChainBufferCount);
 
         // Fence
         ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)));
@@ -284,50 +284,56 @@ public:
         }
     }
 
-    virtual void OnUpdate() override
+    void RecordFrame(ID3D12GraphicsCommandList* commandList, UINT backBufferIndex)
     {
-        // Command list allocators can only be reset when the associated command lists have finished execution on the GPU.
-        // Apps shoud use fences to determin GPU execution progress, which we will do at the end of this function.
-        ThrowIfFailed(commandAllocator_->Reset());
-
-        // After ExecuteCommandList() has been called on a particular command list,
-        // that command list can then be reset at any time before re-recoding.
-        ThrowIfFailed(commandList_->Reset(commandAllocator_.Get(), pipelineState_.Get()));
-
         // Set necessary state.
-        commandList_->SetGraphicsRootSignature(rootSignature_.Get());
+        commandList->SetPipelineState(pipelineState_.Get());
+        commandList->SetGraphicsRootSignature(rootSignature_.Get());
 
         CD3DX12_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(GetConfig().Width), static_cast<float>(GetConfig().Height));
         CD3DX12_RECT scissorRect(0, 0, GetConfig().Width, GetConfig().Height);
-        commandList_->RSSetViewports(1, &viewport);
-        commandList_->RSSetScissorRects(1, &scissorRect);
-
-        const UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
+        commandList->RSSetViewports(1, &viewport);
+        commandList->RSSetScissorRects(1, &scissorRect);
 
         // Indicate the the back buffer will be used as a render target.
         CD3DX12_RESOURCE_BARRIER toRenderBarrier = CD3DX12_RESOURCE_BARRIER::Transition(swapChainBuffers_[backBufferIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        commandList_->ResourceBarrier(1, &toRenderBarrier);
+        commandList->ResourceBarrier(1, &toRenderBarrier);
 
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(rtvHeap_->GetCPUDescriptorHandleForHeapStart(), backBufferIndex, rtvDescriptorSize_);
 
-        commandList_->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+        commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
         // Record commands
         const FLOAT clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f};
-        commandList_->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-        commandList_->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        commandList_->IASetVertexBuffers(0, 1, &vertexBufferView_);
-        commandList_->DrawInstanced(3, 1, 0, 0);
+        commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        commandList->IASetVertexBuffers(0, 1, &vertexBufferView_);
+        commandList->DrawInstanced(3, 1, 0, 0);
 
         // Indicate that the back buffer will now be used to present.
         CD3DX12_RESOURCE_BARRIER toPresentBarrier = CD3DX12_RESOURCE_BARRIER::Transition(swapChainBuffers_[backBufferIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-        commandList_->ResourceBarrier(1, &toPresentBarrier);
+        commandList->ResourceBarrier(1, &toPresentBarrier);
+    }
+
+    virtual void OnUpdate() override
+    {
+        const UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
 
-        // Command list is expected to be closed before calling Reset again.
-        ThrowIfFailed(commandList_->Close());
+        // Everything the recorded list depends on, it is recorded again only when one of them changes.
+        // The frame below waits for the GPU, so the list is never executed twice at the same time.
+        const uint64_t inputsHash = graphics::Hasher()
+            .AppendValue(swapChainBuffers_[backBufferIndex].Get())
+            .AppendValue(GetConfig().Width)
+            .AppendValue(GetConfig().Height)
+            .AppendValue(pipelineState_.Get())
+            .AppendValue(rootSignature_.Get())
+            .AppendValue(vertexBufferView_)
+            .Get();
+        ID3D12GraphicsCommandList* commandList = frameCommandLists_->Get(backBufferIndex, inputsHash,
+            [this](ID3D12GraphicsCommandList* commandList, UINT slot) { RecordFrame(commandList, slot); });
 
         // Execulte the command list
-        ID3D12CommandList* commandLists[] = { commandList_.Get() };
+        ID3D12CommandList* commandLists[] = { commandList };
         commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
 
         // Swap buffers
@@ -1,6 +1,7 @@
 ﻿#include <string>
 #include <stdexcept>
 #include <iostream>
+#include <vector>
 
 #include <wrl/client.h>
 #include <dxgi1_6.h>
@@ -10,6 +11,8 @@
 #include <DirectXMath.h>
 
 #include "Launcher.h"
+#include "VertexFormat.h"
+#include "D3D12VertexFormat.h"
 #include "ShadersVS.h"
 #include "ShadersPS.h"
 
@@ -62,6 +65,15 @@ class HelloVertexBuffer : public sketch::SketchBase
         DirectX::XMFLOAT4 color;
     };
 
+    // Vertex as the vertex buffer stores it, 16 bytes instead of 28: the color is quantized to 8 bits per channel.
+    static graphics::VertexFormat CreatePackedVertexFormat()
+    {
+        graphics::VertexFormat format;
+        format.Add("POSITION", 0, graphics::VertexAttributeFormat::Float32x3, offsetof(Vertex, position))
+            .Add("COLOR", 0, graphics::VertexAttributeFormat::Unorm8x4, offsetof(Vertex, color));
+        return format;
+    }
+
     struct SceneConstantBuffer
     {
         DirectX::XMFLOAT4 offset;
@@ -213,23 +225,20 @@ public:
         ThrowIfFailed(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature_)));
 
         // Compile and load shaders
-        // Already compiled as g_VSMain, g_PSMain
+        // Already compiled as g_Shaders_VSMain, g_Shaders_PSMain
 
-        // Define the vertex input layout.
-        D3D12_INPUT_ELEMENT_DESC inputElementDesc[] =
-        {
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-        };
-        D3D12_INPUT_LAYOUT_DESC inputLayoutDesc{ inputElementDesc, _countof(inputElementDesc) };
+        // Define the vertex input layout, from the packed vertex format.
+        const graphics::VertexFormat packedVertexFormat = CreatePackedVertexFormat();
+        const graphics::D3D12VertexFormat packedVertexLayout(packedVertexFormat);
+        D3D12_INPUT_LAYOUT_DESC inputLayoutDesc = packedVertexLayout.GetInputLayout();
 
         // Pipeline state object
         // Describe and create the graphics pipeline state object (PSO).
         D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
         psoDesc.InputLayout = inputLayoutDesc;
         psoDesc.pRootSignature = rootSignature_.Get();
-        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_VSMain, sizeof(g_VSMain));
-        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_PSMain, sizeof(g_PSMain));
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(g_Shaders_VSMain, sizeof(g_Shaders_VSMain));
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(g_Shaders_PSMain, sizeof(g_Shaders_PSMain));
         psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
         psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
         psoDesc.DepthStencilState.DepthEnable = FALSE;
@@ -259,7 +268,11 @@ public:
             { { -0.25f, -0.25f * aspectRatio, 0.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } }
         };
 
-        const UINT vertexBufferSize = sizeof(triangleVertices);
+        // Quantized on the CPU, the input layout turns the colors back into floats for the shader.
+        std::vector<UINT8> packedVertices(_countof(triangleVertices) * packedVertexFormat.GetStride());
+        packedVertexFormat.Encode(triangleVertices, sizeof(Vertex), _countof(triangleVertices), packedVertices.data());
+
+        const UINT vertexBufferSize = static_cast<UINT>(packedVertices.size());
 
         // Note: using upload heaps to transfer static data like vert buffers is not recommended.
         // Every time the GPU needs it, the upload heap will be marshalled over. Use default heaps instead.
@@ -278,7 +291,7 @@ public:
         UINT8* vertexDataBegin;
         CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
         ThrowIfFailed(vertexBufferUpload->Map(0, &readRange, reinterpret_cast<void**>(&vertexDataBegin)));
-        memcpy(vertexDataBegin, triangleVertices, sizeof(triangleVertices));
+        memcpy(vertexDataBegin, packedVertices.data(), vertexBufferSize);
         vertexBufferUpload->Unmap(0, nullptr);
 
         // 将顶点数据由 upload heap 拷贝至 default heap
@@ -292,7 +305,7 @@ public:
 
         // Initialize the vertex buffer view.
         vertexBufferView_.BufferLocation = vertexBuffer_->GetGPUVirtualAddress();
-        vertexBufferView_.StrideInBytes = sizeof(Vertex);
+        vertexBufferView_.StrideInBytes = packedVertexFormat.GetStride();
         vertexBufferView_.SizeInBytes = vertexBufferSize;
 
         // Create the constant buffer
@@ -1,12 +1,15 @@
 #include <string>
 #include <stdexcept>
 #include <iostream>
+#include <memory>
 
 #include <wrl/client.h>
 #include <dxgi1_6.h>
 #include <d3d12.h>
 
 #include "Launcher.h"
+#include "Hash.h"
+#include "StaticCommandListCache.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -157,8 +160,7 @@ class HelloWorld : public sketch::SketchBase
     ComPtr<ID3D12DescriptorHeap> rtvHeap_;
     UINT rtvDescriptorSize_;
     ComPtr<ID3D12Resource> swapChainBuffers_[kSwapChainBufferCount];
-    ComPtr<ID3D12CommandAllocator> commandAllocator_;
-    ComPtr<ID3D12GraphicsCommandList> commandList_;
+    std::unique_ptr<graphics::StaticCommandListCache> frameCommandLists_;
     ComPtr<ID3D12Fence> fence_;
     UINT64 fenceValue_;
 
@@ -260,52 +262,43 @@ public:
             rtvHandle.Offset(1, rtvDescriptorSize_);
         }
 
-        // Command allocator
-        ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator_)));
-
-        // Command list
-        ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator_.Get(), nullptr, IID_PPV_ARGS(&commandList_)));
-
-        // Command lists are created in the recording state, but there is nothing to record yet.
-        // The first time we refer to the command list we will Reset it, and it is expected to be closed before calling Reset.
-        ThrowIfFailed(commandList_->Close());
+        // Command lists, one per back buffer. The frame is the same every time, so each one is recorded once and executed again.
+        frameCommandLists_ = std::make_unique<graphics::StaticCommandListCache>(device.Get(), kSwapChainBufferCount);
 
         // Fence
         ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)));
         fenceValue_ = 1;
     }
 
-    virtual void OnUpdate() override
+    void RecordFrame(ID3D12GraphicsCommandList* commandList, UINT backBufferIndex)
     {
-        // Command list allocators can only be reset when the associated command lists have finished execution on the GPU.
-        // Apps shoud use fences to determin GPU execution progress, which we will do at the end of this function.
-        ThrowIfFailed(commandAllocator_->Reset());
-
-        // After ExecuteCommandList() has been called on a particular command list,
-        // that command list can then be reset at any time before re-recoding.
-        ThrowIfFailed(commandList_->Reset(commandAllocator_.Get(), nullptr));
-
-        const UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
-
         // Indicate the the back buffer will be used as a render target.
         CD3DX12_RESOURCE_BARRIER toRenderBarrier = CD3DX12_RESOURCE_BARRIER::Transition(swapChainBuffers_[backBufferIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        commandList_->ResourceBarrier(1, &toRenderBarrier);
+        commandList->ResourceBarrier(1, &toRenderBarrier);
 
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(rtvHeap_->GetCPUDescriptorHandleForHeapStart(), backBufferIndex, rtvDescriptorSize_);
 
         // Record commands
         const FLOAT clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f};
-        commandList_->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+        commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
 
         // Indicate that the back buffer will now be used to present.
         CD3DX12_RESOURCE_BARRIER toPresentBarrier = CD3DX12_RESOURCE_BARRIER::Transition(swapChainBuffers_[backBufferIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-        commandList_->ResourceBarrier(1, &toPresentBarrier);
+        commandList->ResourceBarrier(1, &toPresentBarrier);
+    }
+
+    virtual void OnUpdate() override
+    {
+        const UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
 
-        // Command list is expected to be closed before calling Reset again.
-        ThrowIfFailed(commandList_->Close());
+        // Recorded only the first time a back buffer is used, the frame below waits for the GPU,
+        // so the list is never executed twice at the same time.
+        const uint64_t inputsHash = graphics::Hasher().AppendValue(swapChainBuffers_[backBufferIndex].Get()).Get();
+        ID3D12GraphicsCommandList* commandList = frameCommandLists_->Get(backBufferIndex, inputsHash,
+            [this](ID3D12GraphicsCommandList* commandList, UINT slot) { RecordFrame(commandList, slot); });
 
         // Execulte the command list
-        ID3D12CommandList* commandLists[] = { commandList_.Get() };
+        ID3D12CommandList* commandLists[] = { commandList };
         commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
 
         // Swap buffers
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace graphics
+{
+
+// `alignment` must be a power of two
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+inline bool IsAligned(uint64_t value, uint64_t alignment)
+{
+    return (value & (alignment - 1)) == 0;
+}
+
+}; // namespace graphics
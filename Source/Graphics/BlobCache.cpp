@@ -0,0 +1,114 @@
+#include "BlobCache.h"
+
+#include <cstring>
+
+#include "CacheFile.h"
+
+namespace graphics
+{
+
+namespace
+{
+
+// Each record is the hash, the size and the bytes of one blob.
+struct RecordHeader
+{
+    uint64_t Hash;
+    uint64_t Size;
+};
+
+};
+
+BlobCache::BlobCache(const std::string& path, uint64_t key) :
+    path_(path),
+    key_(key),
+    dirty_(false)
+{
+    std::vector<uint8_t> payload;
+    if (path_.empty() || !ReadCacheFile(path_, key_, payload))
+    {
+        return;
+    }
+
+    size_t offset = 0;
+    while (payload.size() - offset >= sizeof(RecordHeader))
+    {
+        RecordHeader header;
+        memcpy(&header, payload.data() + offset, sizeof(header));
+        offset += sizeof(header);
+        if (header.Size > payload.size() - offset)
+        {
+            // The payload hash matched, so this is a bug in the writer rather than a corrupted file.
+            blobs_.clear();
+            return;
+        }
+
+        const uint8_t* data = payload.data() + offset;
+        blobs_[header.Hash].assign(data, data + header.Size);
+        offset += static_cast<size_t>(header.Size);
+    }
+}
+
+bool BlobCache::Find(uint64_t hash, std::vector<uint8_t>& blob) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blobs_.find(hash);
+    if (it == blobs_.end())
+    {
+        return false;
+    }
+    blob = it->second;
+    return true;
+}
+
+void BlobCache::Insert(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    blobs_[hash].assign(bytes, bytes + size);
+    dirty_ = true;
+}
+
+void BlobCache::Erase(uint64_t hash)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    dirty_ = blobs_.erase(hash) > 0 || dirty_;
+}
+
+bool BlobCache::Save()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty())
+    {
+        return false;
+    }
+    if (!dirty_)
+    {
+        return true;
+    }
+
+    std::vector<uint8_t> payload;
+    for (const auto& blob : blobs_)
+    {
+        const RecordHeader header = { blob.first, blob.second.size() };
+        const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+        payload.insert(payload.end(), headerBytes, headerBytes + sizeof(header));
+        payload.insert(payload.end(), blob.second.begin(), blob.second.end());
+    }
+
+    if (!WriteCacheFile(path_, key_, payload.data(), payload.size()))
+    {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+size_t BlobCache::GetNumBlobs() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blobs_.size();
+}
+
+}; // namespace graphics
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Small blobs keyed by a content hash, kept in memory and persisted as one cache file.
+//
+// The whole file is read at construction and rewritten by Save() when something was inserted. `key` versions
+// the content, see ReadCacheFile(). Thread safe.
+//
+class BlobCache
+{
+public:
+    // An empty path keeps the blobs in memory only.
+    BlobCache(const std::string& path, uint64_t key);
+
+    BlobCache(const BlobCache&) = delete;
+    BlobCache& operator=(const BlobCache&) = delete;
+
+    bool Find(uint64_t hash, std::vector<uint8_t>& blob) const;
+    void Insert(uint64_t hash, const void* data, size_t size);
+    void Erase(uint64_t hash);
+
+    bool Save();
+
+    size_t GetNumBlobs() const;
+
+private:
+    std::string path_;
+    uint64_t key_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, std::vector<uint8_t>> blobs_;
+    bool dirty_;
+};
+
+}; // namespace graphics
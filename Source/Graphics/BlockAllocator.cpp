@@ -0,0 +1,223 @@
+#include "BlockAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Alignment.h"
+
+namespace graphics
+{
+
+BlockAllocator::BlockAllocator(uint64_t blockSize, uint64_t blockAlignment, CreateBlockFunction createBlock, DestroyBlockFunction destroyBlock) :
+    blockSize_(AlignUp(blockSize, blockAlignment)),
+    blockAlignment_(blockAlignment),
+    createBlock_(std::move(createBlock)),
+    destroyBlock_(std::move(destroyBlock))
+{
+}
+
+BlockAllocator::Handle BlockAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0)
+    {
+        return kInvalidHandle;
+    }
+
+    // Larger than what a fresh regular block holds at any alignment.
+    if (alignment - 1 > blockSize_ || size > blockSize_ - (alignment - 1))
+    {
+        const uint32_t block = CreateBlock(AlignUp(size, blockAlignment_), true);
+        if (block == kInvalidHandle)
+        {
+            return kInvalidHandle;
+        }
+        // Offset 0 has any alignment, asking for it would only make the allocator look for room for the padding.
+        return CreateRecord(block, blocks_[block].Allocator->Allocate(size, 1), alignment);
+    }
+
+    // First fit over the blocks, which keeps the later ones emptier and more likely to be handed back.
+    for (uint32_t block = 0; block < static_cast<uint32_t>(blocks_.size()); block++)
+    {
+        if (blocks_[block].Allocator && !blocks_[block].Dedicated)
+        {
+            const TlsfAllocator::Allocation allocation = blocks_[block].Allocator->Allocate(size, alignment);
+            if (allocation.IsValid())
+            {
+                return CreateRecord(block, allocation, alignment);
+            }
+        }
+    }
+
+    const uint32_t block = CreateBlock(blockSize_, false);
+    if (block == kInvalidHandle)
+    {
+        return kInvalidHandle;
+    }
+    return CreateRecord(block, blocks_[block].Allocator->Allocate(size, alignment), alignment);
+}
+
+void BlockAllocator::Free(Handle handle, uint64_t fenceValue)
+{
+    if (handle == kInvalidHandle)
+    {
+        return;
+    }
+
+    Record& record = records_[handle];
+    assert(record.Allocation.IsValid());
+    pendingFrees_.push_back({ fenceValue, record.Block, record.Allocation });
+    pendingFreeSize_ += record.Allocation.Size;
+    record = {};
+    unusedHandles_.push_back(handle);
+}
+
+void BlockAllocator::ReleaseCompleted(uint64_t completedValue)
+{
+    // Frees come from the render thread in fence order.
+    bool released = false;
+    while (!pendingFrees_.empty() && pendingFrees_.front().FenceValue <= completedValue)
+    {
+        const PendingFree& pendingFree = pendingFrees_.front();
+        blocks_[pendingFree.Block].Allocator->Free(pendingFree.Allocation);
+        pendingFreeSize_ -= pendingFree.Allocation.Size;
+        pendingFrees_.pop_front();
+        released = true;
+    }
+    if (released)
+    {
+        DestroyEmptyBlocks();
+    }
+}
+
+std::vector<BlockAllocator::Move> BlockAllocator::Defragment(uint64_t maxBytes, uint64_t fenceValue)
+{
+    std::vector<Move> moves;
+
+    // Regular blocks from the emptiest to the fullest, in use and pending bytes. Allocations only move towards
+    // the fuller end, so a block never receives what another one gave away.
+    std::vector<uint32_t> order;
+    for (uint32_t block = 0; block < static_cast<uint32_t>(blocks_.size()); block++)
+    {
+        if (blocks_[block].Allocator && !blocks_[block].Dedicated && blocks_[block].Allocator->GetNumAllocations() > 0)
+        {
+            order.push_back(block);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t left, uint32_t right)
+        { return blocks_[left].Allocator->GetFreeSize() > blocks_[right].Allocator->GetFreeSize(); });
+
+    uint64_t movedBytes = 0;
+    for (size_t source = 0; source + 1 < order.size() && movedBytes < maxBytes; source++)
+    {
+        for (Handle handle = 0; handle < static_cast<Handle>(records_.size()) && movedBytes < maxBytes; handle++)
+        {
+            Record& record = records_[handle];
+            if (!record.Allocation.IsValid() || record.Block != order[source])
+            {
+                continue;
+            }
+
+            for (size_t target = order.size() - 1; target > source; target--)
+            {
+                const TlsfAllocator::Allocation allocation =
+                    blocks_[order[target]].Allocator->Allocate(record.Allocation.Size, record.Alignment);
+                if (allocation.IsValid())
+                {
+                    moves.push_back({ handle, record.Block, record.Allocation.Offset });
+                    pendingFrees_.push_back({ fenceValue, record.Block, record.Allocation });
+                    pendingFreeSize_ += record.Allocation.Size;
+                    movedBytes += record.Allocation.Size;
+                    record.Block = order[target];
+                    record.Allocation = allocation;
+                    break;
+                }
+            }
+        }
+    }
+    return moves;
+}
+
+BlockAllocator::Statistics BlockAllocator::GetStatistics() const
+{
+    Statistics statistics;
+    for (const Block& block : blocks_)
+    {
+        if (!block.Allocator)
+        {
+            continue;
+        }
+        statistics.NumBlocks++;
+        statistics.NumAllocations += block.Allocator->GetNumAllocations();
+        statistics.NumFreeRanges += block.Allocator->GetNumFreeRanges();
+        statistics.ReservedSize += block.Allocator->GetSize();
+        statistics.UsedSize += block.Allocator->GetSize() - block.Allocator->GetFreeSize();
+        if (!block.Dedicated && block.Allocator->GetLargestFreeSize() > statistics.LargestFreeSize)
+        {
+            statistics.LargestFreeSize = block.Allocator->GetLargestFreeSize();
+        }
+    }
+    // Pending frees are still allocations of the TLSF allocators.
+    statistics.NumAllocations -= static_cast<uint32_t>(pendingFrees_.size());
+    statistics.PendingFreeSize = pendingFreeSize_;
+    return statistics;
+}
+
+uint32_t BlockAllocator::CreateBlock(uint64_t size, bool dedicated)
+{
+    uint32_t block = 0;
+    while (block < blocks_.size() && blocks_[block].Allocator)
+    {
+        block++;
+    }
+    if (!createBlock_(block, size))
+    {
+        return kInvalidHandle;
+    }
+
+    if (block == blocks_.size())
+    {
+        blocks_.emplace_back();
+    }
+    blocks_[block].Allocator = std::make_unique<TlsfAllocator>(size);
+    blocks_[block].Dedicated = dedicated;
+    return block;
+}
+
+void BlockAllocator::DestroyEmptyBlocks()
+{
+    // One empty regular block stays, so freeing and allocating around a block boundary doesn't recreate it.
+    bool keptEmptyBlock = false;
+    for (uint32_t block = 0; block < static_cast<uint32_t>(blocks_.size()); block++)
+    {
+        if (!blocks_[block].Allocator || blocks_[block].Allocator->GetNumAllocations() > 0)
+        {
+            continue;
+        }
+        if (!blocks_[block].Dedicated && !keptEmptyBlock)
+        {
+            keptEmptyBlock = true;
+            continue;
+        }
+        blocks_[block].Allocator.reset();
+        destroyBlock_(block);
+    }
+}
+
+BlockAllocator::Handle BlockAllocator::CreateRecord(uint32_t block, const TlsfAllocator::Allocation& allocation, uint64_t alignment)
+{
+    Handle handle;
+    if (!unusedHandles_.empty())
+    {
+        handle = unusedHandles_.back();
+        unusedHandles_.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(records_.size());
+        records_.emplace_back();
+    }
+    records_[handle] = { block, allocation, alignment };
+    return handle;
+}
+
+}; // namespace graphics
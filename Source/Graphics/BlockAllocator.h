@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "TlsfAllocator.h"
+
+namespace graphics
+{
+
+//
+// Sub-allocator over a growing set of memory blocks, e.g. the ID3D12Heaps of one heap type.
+//
+// Every block is managed by a TlsfAllocator. An allocation goes to the first block with room, and a new block is
+// requested from the owner when none has; requests larger than the block size get a dedicated block of their own.
+// Blocks left empty are handed back to the owner, except one regular block kept for the next allocations.
+//
+// Frees are deferred until a fence value completes, since the GPU may still access the memory. Allocations are
+// referred to by handles, which stay valid when Defragment() moves them. Only offsets are managed, the owner
+// creates and destroys the memory of the blocks in the callbacks.
+//
+class BlockAllocator
+{
+public:
+    using Handle = uint32_t;
+    static const Handle kInvalidHandle = ~0u;
+
+    // Returns false when the memory can't be created, the allocation needing it fails then.
+    using CreateBlockFunction = std::function<bool(uint32_t block, uint64_t size)>;
+    using DestroyBlockFunction = std::function<void(uint32_t block)>;
+
+    // An allocation Defragment() moved, its new place is GetBlock() and GetOffset() of the handle.
+    struct Move
+    {
+        Handle Allocation;
+        uint32_t SourceBlock;
+        uint64_t SourceOffset;
+    };
+
+    struct Statistics
+    {
+        uint32_t NumBlocks = 0;
+        uint32_t NumAllocations = 0;
+        uint32_t NumFreeRanges = 0;
+        // Bytes of all blocks
+        uint64_t ReservedSize = 0;
+        // Bytes allocated, including the frees still waiting for their fence
+        uint64_t UsedSize = 0;
+        uint64_t PendingFreeSize = 0;
+        // Largest allocation which fits without a new block
+        uint64_t LargestFreeSize = 0;
+    };
+
+    // Regular blocks are `blockSize` bytes, dedicated ones are rounded up to `blockAlignment`.
+    BlockAllocator(uint64_t blockSize, uint64_t blockAlignment, CreateBlockFunction createBlock, DestroyBlockFunction destroyBlock);
+
+    BlockAllocator(const BlockAllocator&) = delete;
+    BlockAllocator& operator=(const BlockAllocator&) = delete;
+
+    // `alignment` is relative to the start of the block. Returns kInvalidHandle when a needed block can't be created.
+    Handle Allocate(uint64_t size, uint64_t alignment);
+
+    // The range can be reused once the GPU has passed `fenceValue`, see ReleaseCompleted(). The handle is invalid
+    // right away.
+    void Free(Handle handle, uint64_t fenceValue);
+    void ReleaseCompleted(uint64_t completedValue);
+
+    uint32_t GetBlock(Handle handle) const { return records_[handle].Block; }
+    uint64_t GetOffset(Handle handle) const { return records_[handle].Allocation.Offset; }
+    uint64_t GetSize(Handle handle) const { return records_[handle].Allocation.Size; }
+    uint64_t GetBlockSize() const { return blockSize_; }
+
+    // Move up to `maxBytes` of allocations out of the emptiest regular blocks into fuller ones, no block is created.
+    // The moved ranges stay reserved until `fenceValue` completes, so the owner can copy from them on the GPU, and
+    // the blocks emptied this way are handed back by ReleaseCompleted().
+    std::vector<Move> Defragment(uint64_t maxBytes, uint64_t fenceValue);
+
+    Statistics GetStatistics() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<TlsfAllocator> Allocator;
+        bool Dedicated;
+    };
+
+    struct Record
+    {
+        uint32_t Block;
+        TlsfAllocator::Allocation Allocation;
+        uint64_t Alignment;
+    };
+
+    struct PendingFree
+    {
+        uint64_t FenceValue;
+        uint32_t Block;
+        TlsfAllocator::Allocation Allocation;
+    };
+
+    uint32_t CreateBlock(uint64_t size, bool dedicated);
+    void DestroyEmptyBlocks();
+    Handle CreateRecord(uint32_t block, const TlsfAllocator::Allocation& allocation, uint64_t alignment);
+
+    uint64_t blockSize_;
+    uint64_t blockAlignment_;
+    CreateBlockFunction createBlock_;
+    DestroyBlockFunction destroyBlock_;
+
+    // Indexed by block, unused slots have no allocator
+    std::vector<Block> blocks_;
+    std::vector<Record> records_;
+    std::vector<Handle> unusedHandles_;
+    std::deque<PendingFree> pendingFrees_;
+    uint64_t pendingFreeSize_ = 0;
+};
+
+}; // namespace graphics
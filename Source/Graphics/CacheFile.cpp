@@ -0,0 +1,102 @@
+#include "CacheFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "Hash.h"
+
+namespace graphics
+{
+
+namespace
+{
+
+const uint32_t kMagic = 0x48434347; // "GCCH"
+const uint32_t kFormatVersion = 1;
+
+struct Header
+{
+    uint32_t Magic;
+    uint32_t FormatVersion;
+    uint64_t Key;
+    uint64_t PayloadSize;
+    uint64_t PayloadHash;
+};
+
+};
+
+bool ReadCacheFile(const std::string& path, uint64_t key, std::vector<uint8_t>& payload)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    Header header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.Magic != kMagic || header.FormatVersion != kFormatVersion || header.Key != key)
+    {
+        return false;
+    }
+
+    // A corrupted size must not get as far as the allocation.
+    const std::streamoff payloadStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff fileSize = file.tellg();
+    if (payloadStart < 0 || fileSize < payloadStart || header.PayloadSize > static_cast<uint64_t>(fileSize - payloadStart))
+    {
+        return false;
+    }
+    file.seekg(payloadStart);
+
+    payload.resize(static_cast<size_t>(header.PayloadSize));
+    if (!file.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload.size())) ||
+        HashBytes(payload.data(), payload.size()) != header.PayloadHash)
+    {
+        payload.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool WriteCacheFile(const std::string& path, uint64_t key, const void* payload, size_t size)
+{
+    const Header header = { kMagic, kFormatVersion, key, size, HashBytes(payload, size) };
+
+    std::vector<uint8_t> data(sizeof(header) + size);
+    memcpy(data.data(), &header, sizeof(header));
+    if (size > 0)
+    {
+        memcpy(data.data() + sizeof(header), payload, size);
+    }
+    return WriteFileAtomic(path, data.data(), data.size());
+}
+
+bool WriteFileAtomic(const std::string& path, const void* data, size_t size)
+{
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            return false;
+        }
+
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!file)
+        {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+
+    // rename() doesn't replace an existing file on Windows.
+    std::remove(path.c_str());
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+}; // namespace graphics
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Binary blobs persisted between runs (pipeline libraries, serialized root signatures, shader bytecode).
+//
+// The file starts with a small header carrying a caller defined key, which should change whenever the
+// producer of the payload changes, and a hash of the payload. A missing, stale or corrupted file reads
+// as a cache miss. Writes go to a temporary file first, so a crash never leaves a truncated cache behind.
+//
+bool ReadCacheFile(const std::string& path, uint64_t key, std::vector<uint8_t>& payload);
+bool WriteCacheFile(const std::string& path, uint64_t key, const void* payload, size_t size);
+
+// Replace the file at `path` through a temporary file, readers never see it partially written.
+bool WriteFileAtomic(const std::string& path, const void* data, size_t size);
+
+}; // namespace graphics
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Command allocators and lists recycled by fence value.
+//
+// Acquire() hands out a context with a freshly reset allocator and an open list, which belong to the caller
+// until Retire() gives them back with the fence value signaled after their execution. Allocators can't be
+// reset while the GPU still executes their commands, so a retired context waits in fence order and is handed
+// out again only once that value has completed. Free contexts are reused most recently retired first, the
+// allocator of a warm context already holds enough memory for a typical list.
+//
+// Acquire() and Retire() are thread safe and the reset happens outside of the lock, so every recording thread
+// works on its own allocator and list. `Backend` is the device side, see D3D12CommandListBackend:
+//   using Allocator, List;
+//   Allocator CreateAllocator();
+//   List CreateList(Allocator& allocator);             // Returns an open list.
+//   void Reset(Allocator& allocator, List& list);      // Reset both and leave the list open.
+//   void Close(List& list);
+//
+template <typename Backend>
+class CommandListPool
+{
+public:
+    using Allocator = typename Backend::Allocator;
+    using List = typename Backend::List;
+
+    struct Context
+    {
+        Allocator CommandAllocator;
+        List CommandList;
+    };
+
+    explicit CommandListPool(Backend& backend) :
+        backend_(backend)
+    {
+    }
+
+    CommandListPool(const CommandListPool&) = delete;
+    CommandListPool& operator=(const CommandListPool&) = delete;
+
+    // An open list nobody else records into. `completedValue` is the fence value the GPU has reached.
+    Context* Acquire(uint64_t completedValue)
+    {
+        Context* context = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (!retired_.empty() && retired_.front().first <= completedValue)
+            {
+                free_.push_back(retired_.front().second);
+                retired_.pop_front();
+            }
+            if (!free_.empty())
+            {
+                context = free_.back();
+                free_.pop_back();
+            }
+            else
+            {
+                contexts_.push_back(std::unique_ptr<Context>(new Context()));
+                context = contexts_.back().get();
+            }
+        }
+
+        try
+        {
+            if (context->CommandList)
+            {
+                backend_.Reset(context->CommandAllocator, context->CommandList);
+            }
+            else
+            {
+                context->CommandAllocator = backend_.CreateAllocator();
+                context->CommandList = backend_.CreateList(context->CommandAllocator);
+            }
+        }
+        catch (...)
+        {
+            // Keep the context, the next Acquire() resets or creates it again. It is the last choice among
+            // the free ones, so a context that keeps failing doesn't stand in front of the healthy ones.
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.insert(free_.begin(), context);
+            throw;
+        }
+        return context;
+    }
+
+    // Close the list of a context whose commands are not going to be executed, and give it back right away.
+    // The context is given back even when closing throws, the next Acquire() resets the list.
+    void Discard(Context* context)
+    {
+        try
+        {
+            backend_.Close(context->CommandList);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(context);
+            throw;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(context);
+    }
+
+    // `fenceValue` is signaled after the list of `context` has been executed.
+    void Retire(Context* context, uint64_t fenceValue)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (retired_.empty() || retired_.back().first <= fenceValue)
+        {
+            retired_.emplace_back(fenceValue, context);
+        }
+        else
+        {
+            // Only lists executed on another queue with its own fence arrive out of order.
+            auto position = retired_.begin();
+            while (position != retired_.end() && position->first <= fenceValue)
+            {
+                ++position;
+            }
+            retired_.emplace(position, fenceValue, context);
+        }
+    }
+
+    size_t GetNumContexts() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return contexts_.size();
+    }
+
+    size_t GetNumRetired() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return retired_.size();
+    }
+
+    Backend& GetBackend() const { return backend_; }
+
+private:
+    Backend& backend_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Context>> contexts_;
+    std::vector<Context*> free_;
+    std::deque<std::pair<uint64_t, Context*>> retired_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,333 @@
+#include "CommandStream.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include "Alignment.h"
+#include "Hash.h"
+
+namespace graphics
+{
+
+namespace
+{
+
+const size_t kPacketAlignment = sizeof(uint64_t);
+
+template <typename T>
+size_t GetTrailingOffset()
+{
+    return static_cast<size_t>(AlignUp(sizeof(T), kPacketAlignment));
+}
+
+template <typename E, typename T>
+E* GetTrailing(T* packet)
+{
+    return reinterpret_cast<E*>(reinterpret_cast<uint8_t*>(packet) + GetTrailingOffset<T>());
+}
+
+template <typename E, typename T>
+const E* GetTrailing(const T* packet)
+{
+    return reinterpret_cast<const E*>(reinterpret_cast<const uint8_t*>(packet) + GetTrailingOffset<T>());
+}
+
+template <typename T>
+const T& As(const commands::PacketHeader* header)
+{
+    return *reinterpret_cast<const T*>(header);
+}
+
+};
+
+template <typename T>
+T* CommandStream::Append(size_t trailingSize)
+{
+    const size_t size = static_cast<size_t>(AlignUp(GetTrailingOffset<T>() + trailingSize, kPacketAlignment));
+    if (size > UINT32_MAX)
+    {
+        throw std::runtime_error("Command packet is too large");
+    }
+
+    // Growing zero-fills, so padding and unused fields hash the same in every recording.
+    const size_t offset = data_.size();
+    data_.resize(offset + size / kPacketAlignment);
+    T* packet = new (&data_[offset]) T();
+    packet->Header.Type = T::kType;
+    packet->Header.Size = static_cast<uint32_t>(size);
+    numCommands_++;
+    return packet;
+}
+
+void CommandStream::Barrier(CommandObject resource, uint32_t before, uint32_t after, uint32_t subresource)
+{
+    commands::Barrier* packet = Append<commands::Barrier>();
+    packet->Resource = resource;
+    packet->Subresource = subresource;
+    packet->Before = before;
+    packet->After = after;
+}
+
+void CommandStream::SetPipelineState(CommandObject pipelineState)
+{
+    Append<commands::SetPipelineState>()->PipelineState = pipelineState;
+}
+
+void CommandStream::SetGraphicsRootSignature(CommandObject rootSignature)
+{
+    Append<commands::SetGraphicsRootSignature>()->RootSignature = rootSignature;
+}
+
+void CommandStream::SetDescriptorHeaps(uint32_t count, const CommandObject* heaps)
+{
+    commands::SetDescriptorHeaps* packet = Append<commands::SetDescriptorHeaps>(count * sizeof(CommandObject));
+    packet->Count = count;
+    if (count > 0)
+    {
+        memcpy(GetTrailing<CommandObject>(packet), heaps, count * sizeof(CommandObject));
+    }
+}
+
+void CommandStream::SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation)
+{
+    commands::SetGraphicsRootConstantBufferView* packet = Append<commands::SetGraphicsRootConstantBufferView>();
+    packet->RootParameterIndex = rootParameterIndex;
+    packet->BufferLocation = bufferLocation;
+}
+
+void CommandStream::SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, uint64_t baseDescriptor)
+{
+    commands::SetGraphicsRootDescriptorTable* packet = Append<commands::SetGraphicsRootDescriptorTable>();
+    packet->RootParameterIndex = rootParameterIndex;
+    packet->BaseDescriptor = baseDescriptor;
+}
+
+void CommandStream::SetViewport(float topLeftX, float topLeftY, float width, float height, float minDepth, float maxDepth)
+{
+    commands::SetViewport* packet = Append<commands::SetViewport>();
+    packet->TopLeftX = topLeftX;
+    packet->TopLeftY = topLeftY;
+    packet->Width = width;
+    packet->Height = height;
+    packet->MinDepth = minDepth;
+    packet->MaxDepth = maxDepth;
+}
+
+void CommandStream::SetScissorRect(int32_t left, int32_t top, int32_t right, int32_t bottom)
+{
+    commands::SetScissorRect* packet = Append<commands::SetScissorRect>();
+    packet->Left = left;
+    packet->Top = top;
+    packet->Right = right;
+    packet->Bottom = bottom;
+}
+
+void CommandStream::SetRenderTargets(uint32_t count, const uint64_t* renderTargets, uint64_t depthStencil)
+{
+    commands::SetRenderTargets* packet = Append<commands::SetRenderTargets>(count * sizeof(uint64_t));
+    packet->Count = count;
+    packet->DepthStencil = depthStencil;
+    if (count > 0)
+    {
+        memcpy(GetTrailing<uint64_t>(packet), renderTargets, count * sizeof(uint64_t));
+    }
+}
+
+void CommandStream::ClearRenderTarget(uint64_t renderTarget, const float color[4])
+{
+    commands::ClearRenderTarget* packet = Append<commands::ClearRenderTarget>();
+    packet->RenderTarget = renderTarget;
+    memcpy(packet->Color, color, sizeof(packet->Color));
+}
+
+void CommandStream::SetPrimitiveTopology(uint32_t topology)
+{
+    Append<commands::SetPrimitiveTopology>()->Topology = topology;
+}
+
+void CommandStream::SetVertexBuffers(uint32_t startSlot, uint32_t count, const commands::VertexBufferView* views)
+{
+    commands::SetVertexBuffers* packet = Append<commands::SetVertexBuffers>(count * sizeof(commands::VertexBufferView));
+    packet->StartSlot = startSlot;
+    packet->Count = count;
+    if (count > 0)
+    {
+        memcpy(GetTrailing<commands::VertexBufferView>(packet), views, count * sizeof(commands::VertexBufferView));
+    }
+}
+
+void CommandStream::SetIndexBuffer(uint64_t bufferLocation, uint32_t sizeInBytes, uint32_t format)
+{
+    commands::SetIndexBuffer* packet = Append<commands::SetIndexBuffer>();
+    packet->BufferLocation = bufferLocation;
+    packet->SizeInBytes = sizeInBytes;
+    packet->Format = format;
+}
+
+void CommandStream::Draw(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+{
+    commands::Draw* packet = Append<commands::Draw>();
+    packet->VertexCountPerInstance = vertexCountPerInstance;
+    packet->InstanceCount = instanceCount;
+    packet->StartVertexLocation = startVertexLocation;
+    packet->StartInstanceLocation = startInstanceLocation;
+}
+
+void CommandStream::DrawIndexed(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation,
+    uint32_t startInstanceLocation)
+{
+    commands::DrawIndexed* packet = Append<commands::DrawIndexed>();
+    packet->IndexCountPerInstance = indexCountPerInstance;
+    packet->InstanceCount = instanceCount;
+    packet->StartIndexLocation = startIndexLocation;
+    packet->BaseVertexLocation = baseVertexLocation;
+    packet->StartInstanceLocation = startInstanceLocation;
+}
+
+void CommandStream::CopyBufferRegion(CommandObject destination, uint64_t destinationOffset, CommandObject source, uint64_t sourceOffset, uint64_t numBytes)
+{
+    commands::CopyBufferRegion* packet = Append<commands::CopyBufferRegion>();
+    packet->Destination = destination;
+    packet->DestinationOffset = destinationOffset;
+    packet->Source = source;
+    packet->SourceOffset = sourceOffset;
+    packet->NumBytes = numBytes;
+}
+
+void CommandStream::CopyResource(CommandObject destination, CommandObject source)
+{
+    commands::CopyResource* packet = Append<commands::CopyResource>();
+    packet->Destination = destination;
+    packet->Source = source;
+}
+
+void CommandStream::Replay(CommandSink& sink) const
+{
+    const uint8_t* position = GetData();
+    const uint8_t* end = position + GetSize();
+    while (position < end)
+    {
+        const commands::PacketHeader* header = reinterpret_cast<const commands::PacketHeader*>(position);
+        switch (header->Type)
+        {
+        case CommandType::Barrier:
+            sink.Barrier(As<commands::Barrier>(header));
+            break;
+        case CommandType::SetPipelineState:
+            sink.SetPipelineState(As<commands::SetPipelineState>(header));
+            break;
+        case CommandType::SetGraphicsRootSignature:
+            sink.SetGraphicsRootSignature(As<commands::SetGraphicsRootSignature>(header));
+            break;
+        case CommandType::SetDescriptorHeaps:
+        {
+            const commands::SetDescriptorHeaps& command = As<commands::SetDescriptorHeaps>(header);
+            sink.SetDescriptorHeaps(command, GetTrailing<CommandObject>(&command));
+            break;
+        }
+        case CommandType::SetGraphicsRootConstantBufferView:
+            sink.SetGraphicsRootConstantBufferView(As<commands::SetGraphicsRootConstantBufferView>(header));
+            break;
+        case CommandType::SetGraphicsRootDescriptorTable:
+            sink.SetGraphicsRootDescriptorTable(As<commands::SetGraphicsRootDescriptorTable>(header));
+            break;
+        case CommandType::SetViewport:
+            sink.SetViewport(As<commands::SetViewport>(header));
+            break;
+        case CommandType::SetScissorRect:
+            sink.SetScissorRect(As<commands::SetScissorRect>(header));
+            break;
+        case CommandType::SetRenderTargets:
+        {
+            const commands::SetRenderTargets& command = As<commands::SetRenderTargets>(header);
+            sink.SetRenderTargets(command, GetTrailing<uint64_t>(&command));
+            break;
+        }
+        case CommandType::ClearRenderTarget:
+            sink.ClearRenderTarget(As<commands::ClearRenderTarget>(header));
+            break;
+        case CommandType::SetPrimitiveTopology:
+            sink.SetPrimitiveTopology(As<commands::SetPrimitiveTopology>(header));
+            break;
+        case CommandType::SetVertexBuffers:
+        {
+            const commands::SetVertexBuffers& command = As<commands::SetVertexBuffers>(header);
+            sink.SetVertexBuffers(command, GetTrailing<commands::VertexBufferView>(&command));
+            break;
+        }
+        case CommandType::SetIndexBuffer:
+            sink.SetIndexBuffer(As<commands::SetIndexBuffer>(header));
+            break;
+        case CommandType::Draw:
+            sink.Draw(As<commands::Draw>(header));
+            break;
+        case CommandType::DrawIndexed:
+            sink.DrawIndexed(As<commands::DrawIndexed>(header));
+            break;
+        case CommandType::CopyBufferRegion:
+            sink.CopyBufferRegion(As<commands::CopyBufferRegion>(header));
+            break;
+        case CommandType::CopyResource:
+            sink.CopyResource(As<commands::CopyResource>(header));
+            break;
+        default:
+            throw std::runtime_error("Corrupt command stream");
+        }
+        position += header->Size;
+    }
+    sink.Finish();
+}
+
+uint64_t CommandStream::GetHash() const
+{
+    return HashBytes(GetData(), GetSize());
+}
+
+size_t CommandStream::FindFirstDifference(const CommandStream& a, const CommandStream& b)
+{
+    const uint8_t* positionA = a.GetData();
+    const uint8_t* positionB = b.GetData();
+    const uint8_t* endA = positionA + a.GetSize();
+    const uint8_t* endB = positionB + b.GetSize();
+
+    size_t index = 0;
+    while (positionA < endA && positionB < endB)
+    {
+        const uint32_t sizeA = reinterpret_cast<const commands::PacketHeader*>(positionA)->Size;
+        const uint32_t sizeB = reinterpret_cast<const commands::PacketHeader*>(positionB)->Size;
+        if (sizeA != sizeB || memcmp(positionA, positionB, sizeA) != 0)
+        {
+            return index;
+        }
+        positionA += sizeA;
+        positionB += sizeB;
+        index++;
+    }
+    return positionA == endA && positionB == endB ? kNoDifference : index;
+}
+
+//
+// NullCommandSink
+//
+void NullCommandSink::Draw(const commands::Draw& command)
+{
+    Count(command.Header);
+    statistics_.NumVertices += static_cast<uint64_t>(command.VertexCountPerInstance) * command.InstanceCount;
+    statistics_.NumInstances += command.InstanceCount;
+}
+
+void NullCommandSink::DrawIndexed(const commands::DrawIndexed& command)
+{
+    Count(command.Header);
+    statistics_.NumVertices += static_cast<uint64_t>(command.IndexCountPerInstance) * command.InstanceCount;
+    statistics_.NumInstances += command.InstanceCount;
+}
+
+void NullCommandSink::CopyBufferRegion(const commands::CopyBufferRegion& command)
+{
+    Count(command.Header);
+    statistics_.NumCopiedBytes += command.NumBytes;
+}
+
+}; // namespace graphics
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace graphics
+{
+
+// API objects (resources, pipeline states, root signatures, descriptor heaps) are referenced by address, the
+// stream doesn't hold references. Descriptor handles and GPU addresses are stored as their integer values.
+using CommandObject = const void*;
+
+enum class CommandType : uint16_t
+{
+    Barrier,
+    SetPipelineState,
+    SetGraphicsRootSignature,
+    SetDescriptorHeaps,
+    SetGraphicsRootConstantBufferView,
+    SetGraphicsRootDescriptorTable,
+    SetViewport,
+    SetScissorRect,
+    SetRenderTargets,
+    ClearRenderTarget,
+    SetPrimitiveTopology,
+    SetVertexBuffers,
+    SetIndexBuffer,
+    Draw,
+    DrawIndexed,
+    CopyBufferRegion,
+    CopyResource,
+    kCount
+};
+
+//
+// Packets of the stream. Each one starts with a header, packets holding a variable number of elements are
+// followed by them, starting at the next multiple of 8 bytes. Everything is plain data and padding is zeroed,
+// so streams can be compared and hashed byte by byte.
+//
+namespace commands
+{
+
+struct PacketHeader
+{
+    CommandType Type;
+    uint16_t Reserved;
+    // Size of the packet including the header and trailing elements, a multiple of 8.
+    uint32_t Size;
+};
+
+struct Barrier
+{
+    static const CommandType kType = CommandType::Barrier;
+    static const uint32_t kAllSubresources = 0xffffffff;
+
+    PacketHeader Header;
+    CommandObject Resource;
+    uint32_t Subresource;
+    uint32_t Before;
+    uint32_t After;
+};
+
+struct SetPipelineState
+{
+    static const CommandType kType = CommandType::SetPipelineState;
+
+    PacketHeader Header;
+    CommandObject PipelineState;
+};
+
+struct SetGraphicsRootSignature
+{
+    static const CommandType kType = CommandType::SetGraphicsRootSignature;
+
+    PacketHeader Header;
+    CommandObject RootSignature;
+};
+
+// Followed by `Count` CommandObjects.
+struct SetDescriptorHeaps
+{
+    static const CommandType kType = CommandType::SetDescriptorHeaps;
+
+    PacketHeader Header;
+    uint32_t Count;
+};
+
+struct SetGraphicsRootConstantBufferView
+{
+    static const CommandType kType = CommandType::SetGraphicsRootConstantBufferView;
+
+    PacketHeader Header;
+    uint32_t RootParameterIndex;
+    uint64_t BufferLocation;
+};
+
+struct SetGraphicsRootDescriptorTable
+{
+    static const CommandType kType = CommandType::SetGraphicsRootDescriptorTable;
+
+    PacketHeader Header;
+    uint32_t RootParameterIndex;
+    uint64_t BaseDescriptor;
+};
+
+struct SetViewport
+{
+    static const CommandType kType = CommandType::SetViewport;
+
+    PacketHeader Header;
+    float TopLeftX;
+    float TopLeftY;
+    float Width;
+    float Height;
+    float MinDepth;
+    float MaxDepth;
+};
+
+struct SetScissorRect
+{
+    static const CommandType kType = CommandType::SetScissorRect;
+
+    PacketHeader Header;
+    int32_t Left;
+    int32_t Top;
+    int32_t Right;
+    int32_t Bottom;
+};
+
+// Followed by `Count` uint64_t render target descriptors.
+struct SetRenderTargets
+{
+    static const CommandType kType = CommandType::SetRenderTargets;
+
+    PacketHeader Header;
+    uint32_t Count;
+    // 0 binds no depth stencil view.
+    uint64_t DepthStencil;
+};
+
+struct ClearRenderTarget
+{
+    static const CommandType kType = CommandType::ClearRenderTarget;
+
+    PacketHeader Header;
+    uint64_t RenderTarget;
+    float Color[4];
+};
+
+struct SetPrimitiveTopology
+{
+    static const CommandType kType = CommandType::SetPrimitiveTopology;
+
+    PacketHeader Header;
+    uint32_t Topology;
+};
+
+struct VertexBufferView
+{
+    uint64_t BufferLocation;
+    uint32_t SizeInBytes;
+    uint32_t StrideInBytes;
+};
+
+// Followed by `Count` VertexBufferViews.
+struct SetVertexBuffers
+{
+    static const CommandType kType = CommandType::SetVertexBuffers;
+
+    PacketHeader Header;
+    uint32_t StartSlot;
+    uint32_t Count;
+};
+
+struct SetIndexBuffer
+{
+    static const CommandType kType = CommandType::SetIndexBuffer;
+
+    PacketHeader Header;
+    uint64_t BufferLocation;
+    uint32_t SizeInBytes;
+    uint32_t Format;
+};
+
+struct Draw
+{
+    static const CommandType kType = CommandType::Draw;
+
+    PacketHeader Header;
+    uint32_t VertexCountPerInstance;
+    uint32_t InstanceCount;
+    uint32_t StartVertexLocation;
+    uint32_t StartInstanceLocation;
+};
+
+struct DrawIndexed
+{
+    static const CommandType kType = CommandType::DrawIndexed;
+
+    PacketHeader Header;
+    uint32_t IndexCountPerInstance;
+    uint32_t InstanceCount;
+    uint32_t StartIndexLocation;
+    int32_t BaseVertexLocation;
+    uint32_t StartInstanceLocation;
+};
+
+struct CopyBufferRegion
+{
+    static const CommandType kType = CommandType::CopyBufferRegion;
+
+    PacketHeader Header;
+    CommandObject Destination;
+    uint64_t DestinationOffset;
+    CommandObject Source;
+    uint64_t SourceOffset;
+    uint64_t NumBytes;
+};
+
+struct CopyResource
+{
+    static const CommandType kType = CommandType::CopyResource;
+
+    PacketHeader Header;
+    CommandObject Destination;
+    CommandObject Source;
+};
+
+}; // namespace commands
+
+//
+// Receives the packets of a stream in recording order, see Replay().
+//
+class CommandSink
+{
+public:
+    virtual ~CommandSink() {}
+
+    virtual void Barrier(const commands::Barrier& command) = 0;
+    virtual void SetPipelineState(const commands::SetPipelineState& command) = 0;
+    virtual void SetGraphicsRootSignature(const commands::SetGraphicsRootSignature& command) = 0;
+    virtual void SetDescriptorHeaps(const commands::SetDescriptorHeaps& command, const CommandObject* heaps) = 0;
+    virtual void SetGraphicsRootConstantBufferView(const commands::SetGraphicsRootConstantBufferView& command) = 0;
+    virtual void SetGraphicsRootDescriptorTable(const commands::SetGraphicsRootDescriptorTable& command) = 0;
+    virtual void SetViewport(const commands::SetViewport& command) = 0;
+    virtual void SetScissorRect(const commands::SetScissorRect& command) = 0;
+    virtual void SetRenderTargets(const commands::SetRenderTargets& command, const uint64_t* renderTargets) = 0;
+    virtual void ClearRenderTarget(const commands::ClearRenderTarget& command) = 0;
+    virtual void SetPrimitiveTopology(const commands::SetPrimitiveTopology& command) = 0;
+    virtual void SetVertexBuffers(const commands::SetVertexBuffers& command, const commands::VertexBufferView* views) = 0;
+    virtual void SetIndexBuffer(const commands::SetIndexBuffer& command) = 0;
+    virtual void Draw(const commands::Draw& command) = 0;
+    virtual void DrawIndexed(const commands::DrawIndexed& command) = 0;
+    virtual void CopyBufferRegion(const commands::CopyBufferRegion& command) = 0;
+    virtual void CopyResource(const commands::CopyResource& command) = 0;
+
+    // Called after the last packet of a replay.
+    virtual void Finish() {}
+};
+
+//
+// Backend-neutral recording of one command list.
+//
+// Commands are appended as packets into one byte buffer, which Reset() keeps, so recording a frame of the
+// same size as the previous one doesn't allocate. Replay() hands the packets to a CommandSink, which
+// translates them for a device (D3D12CommandSink), or only counts them (NullCommandSink). The same stream
+// can be replayed any number of times, and two streams can be compared to see whether a frame changed.
+//
+class CommandStream
+{
+public:
+    static const size_t kNoDifference = ~size_t(0);
+
+    CommandStream() : numCommands_(0) {}
+
+    void Reset()
+    {
+        data_.clear();
+        numCommands_ = 0;
+    }
+
+    void Barrier(CommandObject resource, uint32_t before, uint32_t after, uint32_t subresource = commands::Barrier::kAllSubresources);
+    void SetPipelineState(CommandObject pipelineState);
+    void SetGraphicsRootSignature(CommandObject rootSignature);
+    void SetDescriptorHeaps(uint32_t count, const CommandObject* heaps);
+    void SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation);
+    void SetGraphicsRootDescriptorTable(uint32_t rootParameterIndex, uint64_t baseDescriptor);
+    void SetViewport(float topLeftX, float topLeftY, float width, float height, float minDepth = 0.0f, float maxDepth = 1.0f);
+    void SetScissorRect(int32_t left, int32_t top, int32_t right, int32_t bottom);
+    void SetRenderTargets(uint32_t count, const uint64_t* renderTargets, uint64_t depthStencil = 0);
+    void ClearRenderTarget(uint64_t renderTarget, const float color[4]);
+    void SetPrimitiveTopology(uint32_t topology);
+    void SetVertexBuffers(uint32_t startSlot, uint32_t count, const commands::VertexBufferView* views);
+    void SetIndexBuffer(uint64_t bufferLocation, uint32_t sizeInBytes, uint32_t format);
+    void Draw(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation);
+    void DrawIndexed(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation,
+        uint32_t startInstanceLocation);
+    void CopyBufferRegion(CommandObject destination, uint64_t destinationOffset, CommandObject source, uint64_t sourceOffset, uint64_t numBytes);
+    void CopyResource(CommandObject destination, CommandObject source);
+
+    void Replay(CommandSink& sink) const;
+
+    const uint8_t* GetData() const { return reinterpret_cast<const uint8_t*>(data_.data()); }
+    size_t GetSize() const { return data_.size() * sizeof(uint64_t); }
+    size_t GetNumCommands() const { return numCommands_; }
+    bool IsEmpty() const { return numCommands_ == 0; }
+
+    uint64_t GetHash() const;
+
+    // Index of the first command which differs between the streams, kNoDifference when they are equal.
+    static size_t FindFirstDifference(const CommandStream& a, const CommandStream& b);
+
+    bool operator==(const CommandStream& other) const
+    {
+        return data_ == other.data_;
+    }
+
+    bool operator!=(const CommandStream& other) const { return !(*this == other); }
+
+private:
+    // Append a packet of type T with `trailingSize` bytes behind it, and return it with a filled header.
+    template <typename T>
+    T* Append(size_t trailingSize = 0);
+
+    // uint64_t storage keeps every packet 8-byte aligned.
+    std::vector<uint64_t> data_;
+    size_t numCommands_;
+};
+
+//
+// Sink which only counts, for running recording code without a device.
+//
+class NullCommandSink : public CommandSink
+{
+public:
+    struct Statistics
+    {
+        size_t NumCommands[static_cast<size_t>(CommandType::kCount)] = {};
+        uint64_t NumVertices = 0;
+        uint64_t NumInstances = 0;
+        uint64_t NumCopiedBytes = 0;
+    };
+
+    virtual void Barrier(const commands::Barrier& command) override { Count(command.Header); }
+    virtual void SetPipelineState(const commands::SetPipelineState& command) override { Count(command.Header); }
+    virtual void SetGraphicsRootSignature(const commands::SetGraphicsRootSignature& command) override { Count(command.Header); }
+    virtual void SetDescriptorHeaps(const commands::SetDescriptorHeaps& command, const CommandObject*) override { Count(command.Header); }
+    virtual void SetGraphicsRootConstantBufferView(const commands::SetGraphicsRootConstantBufferView& command) override { Count(command.Header); }
+    virtual void SetGraphicsRootDescriptorTable(const commands::SetGraphicsRootDescriptorTable& command) override { Count(command.Header); }
+    virtual void SetViewport(const commands::SetViewport& command) override { Count(command.Header); }
+    virtual void SetScissorRect(const commands::SetScissorRect& command) override { Count(command.Header); }
+    virtual void SetRenderTargets(const commands::SetRenderTargets& command, const uint64_t*) override { Count(command.Header); }
+    virtual void ClearRenderTarget(const commands::ClearRenderTarget& command) override { Count(command.Header); }
+    virtual void SetPrimitiveTopology(const commands::SetPrimitiveTopology& command) override { Count(command.Header); }
+    virtual void SetVertexBuffers(const commands::SetVertexBuffers& command, const commands::VertexBufferView*) override { Count(command.Header); }
+    virtual void SetIndexBuffer(const commands::SetIndexBuffer& command) override { Count(command.Header); }
+    virtual void Draw(const commands::Draw& command) override;
+    virtual void DrawIndexed(const commands::DrawIndexed& command) override;
+    virtual void CopyBufferRegion(const commands::CopyBufferRegion& command) override;
+    virtual void CopyResource(const commands::CopyResource& command) override { Count(command.Header); }
+
+    const Statistics& GetStatistics() const { return statistics_; }
+    void ResetStatistics() { statistics_ = Statistics(); }
+
+private:
+    void Count(const commands::PacketHeader& header) { statistics_.NumCommands[static_cast<size_t>(header.Type)]++; }
+
+    Statistics statistics_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,53 @@
+#include "D3D12CommandListBackend.h"
+
+#include "GraphicsUtil.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+D3D12CommandListBackend::D3D12CommandListBackend(ID3D12Device* device, ID3D12CommandQueue* commandQueue) :
+    device_(device),
+    commandQueue_(commandQueue),
+    type_(commandQueue->GetDesc().Type)
+{
+}
+
+D3D12CommandListBackend::Allocator D3D12CommandListBackend::CreateAllocator()
+{
+    // ID3D12Device is free threaded, workers create their allocators and lists themselves.
+    Allocator allocator;
+    ThrowIfFailed(device_->CreateCommandAllocator(type_, IID_PPV_ARGS(&allocator)), "CreateCommandAllocator for command list pool");
+    return allocator;
+}
+
+D3D12CommandListBackend::List D3D12CommandListBackend::CreateList(Allocator& allocator)
+{
+    List list;
+    ThrowIfFailed(device_->CreateCommandList(0, type_, allocator.Get(), nullptr, IID_PPV_ARGS(&list)), "CreateCommandList for command list pool");
+    return list;
+}
+
+void D3D12CommandListBackend::Reset(Allocator& allocator, List& list)
+{
+    ThrowIfFailed(allocator->Reset(), "Reset pooled command allocator");
+    ThrowIfFailed(list->Reset(allocator.Get(), nullptr), "Reset pooled command list");
+}
+
+void D3D12CommandListBackend::Close(List& list)
+{
+    ThrowIfFailed(list->Close(), "Close pooled command list");
+}
+
+void D3D12CommandListBackend::Execute(List* const* lists, size_t count)
+{
+    commandLists_.clear();
+    for (size_t index = 0; index < count; index++)
+    {
+        commandLists_.push_back(lists[index]->Get());
+    }
+    commandQueue_->ExecuteCommandLists(static_cast<UINT>(commandLists_.size()), commandLists_.data());
+}
+
+}; // namespace graphics
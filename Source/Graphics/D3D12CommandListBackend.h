@@ -0,0 +1,51 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <vector>
+
+#include "CommandListPool.h"
+#include "ParallelCommandRecorder.h"
+
+namespace graphics
+{
+
+//
+// Creates and executes the command lists of a CommandListPool on one ID3D12CommandQueue.
+// The list type follows the queue, lists start without an initial pipeline state.
+//
+class D3D12CommandListBackend
+{
+public:
+    using Allocator = Microsoft::WRL::ComPtr<ID3D12CommandAllocator>;
+    using List = Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>;
+
+    D3D12CommandListBackend(ID3D12Device* device, ID3D12CommandQueue* commandQueue);
+
+    D3D12CommandListBackend(const D3D12CommandListBackend&) = delete;
+    D3D12CommandListBackend& operator=(const D3D12CommandListBackend&) = delete;
+
+    Allocator CreateAllocator();
+    List CreateList(Allocator& allocator);
+    void Reset(Allocator& allocator, List& list);
+    void Close(List& list);
+
+    // Called by the render thread only.
+    void Execute(List* const* lists, size_t count);
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue_;
+    D3D12_COMMAND_LIST_TYPE type_;
+
+    // Scratch storage for ExecuteCommandLists
+    std::vector<ID3D12CommandList*> commandLists_;
+};
+
+using D3D12CommandListPool = CommandListPool<D3D12CommandListBackend>;
+using D3D12ParallelCommandRecorder = ParallelCommandRecorder<D3D12CommandListBackend>;
+
+}; // namespace graphics
@@ -0,0 +1,184 @@
+#include "D3D12CommandSink.h"
+
+#include <d3dx12.h>
+
+namespace graphics
+{
+
+namespace
+{
+
+template <typename T>
+T* ToObject(CommandObject object)
+{
+    return static_cast<T*>(const_cast<void*>(object));
+}
+
+};
+
+D3D12CommandSink::D3D12CommandSink(ID3D12GraphicsCommandList* commandList) :
+    commandList_(commandList)
+{
+}
+
+void D3D12CommandSink::Execute(const CommandStream& stream, ID3D12GraphicsCommandList* commandList)
+{
+    commandList_ = commandList;
+    stream.Replay(*this);
+}
+
+void D3D12CommandSink::RecordVertexBuffers(CommandStream& stream, UINT startSlot, UINT count, const D3D12_VERTEX_BUFFER_VIEW* views)
+{
+    // The packet layout matches D3D12_VERTEX_BUFFER_VIEW.
+    static_assert(sizeof(commands::VertexBufferView) == sizeof(D3D12_VERTEX_BUFFER_VIEW), "Vertex buffer view layouts differ");
+    stream.SetVertexBuffers(startSlot, count, reinterpret_cast<const commands::VertexBufferView*>(views));
+}
+
+void D3D12CommandSink::RecordViewport(CommandStream& stream, const D3D12_VIEWPORT& viewport)
+{
+    stream.SetViewport(viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth);
+}
+
+void D3D12CommandSink::RecordScissorRect(CommandStream& stream, const D3D12_RECT& rect)
+{
+    stream.SetScissorRect(static_cast<int32_t>(rect.left), static_cast<int32_t>(rect.top), static_cast<int32_t>(rect.right), static_cast<int32_t>(rect.bottom));
+}
+
+void D3D12CommandSink::Barrier(const commands::Barrier& command)
+{
+    barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(ToObject<ID3D12Resource>(command.Resource),
+        static_cast<D3D12_RESOURCE_STATES>(command.Before), static_cast<D3D12_RESOURCE_STATES>(command.After), command.Subresource));
+}
+
+void D3D12CommandSink::SetPipelineState(const commands::SetPipelineState& command)
+{
+    FlushBarriers();
+    commandList_->SetPipelineState(ToObject<ID3D12PipelineState>(command.PipelineState));
+}
+
+void D3D12CommandSink::SetGraphicsRootSignature(const commands::SetGraphicsRootSignature& command)
+{
+    FlushBarriers();
+    commandList_->SetGraphicsRootSignature(ToObject<ID3D12RootSignature>(command.RootSignature));
+}
+
+void D3D12CommandSink::SetDescriptorHeaps(const commands::SetDescriptorHeaps& command, const CommandObject* heaps)
+{
+    FlushBarriers();
+    heaps_.clear();
+    for (uint32_t index = 0; index < command.Count; index++)
+    {
+        heaps_.push_back(ToObject<ID3D12DescriptorHeap>(heaps[index]));
+    }
+    commandList_->SetDescriptorHeaps(command.Count, heaps_.data());
+}
+
+void D3D12CommandSink::SetGraphicsRootConstantBufferView(const commands::SetGraphicsRootConstantBufferView& command)
+{
+    FlushBarriers();
+    commandList_->SetGraphicsRootConstantBufferView(command.RootParameterIndex, command.BufferLocation);
+}
+
+void D3D12CommandSink::SetGraphicsRootDescriptorTable(const commands::SetGraphicsRootDescriptorTable& command)
+{
+    FlushBarriers();
+    commandList_->SetGraphicsRootDescriptorTable(command.RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE{ command.BaseDescriptor });
+}
+
+void D3D12CommandSink::SetViewport(const commands::SetViewport& command)
+{
+    FlushBarriers();
+    D3D12_VIEWPORT viewport = { command.TopLeftX, command.TopLeftY, command.Width, command.Height, command.MinDepth, command.MaxDepth };
+    commandList_->RSSetViewports(1, &viewport);
+}
+
+void D3D12CommandSink::SetScissorRect(const commands::SetScissorRect& command)
+{
+    FlushBarriers();
+    D3D12_RECT rect = { command.Left, command.Top, command.Right, command.Bottom };
+    commandList_->RSSetScissorRects(1, &rect);
+}
+
+void D3D12CommandSink::SetRenderTargets(const commands::SetRenderTargets& command, const uint64_t* renderTargets)
+{
+    FlushBarriers();
+    renderTargets_.clear();
+    for (uint32_t index = 0; index < command.Count; index++)
+    {
+        renderTargets_.push_back(D3D12_CPU_DESCRIPTOR_HANDLE{ static_cast<SIZE_T>(renderTargets[index]) });
+    }
+    D3D12_CPU_DESCRIPTOR_HANDLE depthStencil = { static_cast<SIZE_T>(command.DepthStencil) };
+    commandList_->OMSetRenderTargets(command.Count, renderTargets_.data(), FALSE, command.DepthStencil != 0 ? &depthStencil : nullptr);
+}
+
+void D3D12CommandSink::ClearRenderTarget(const commands::ClearRenderTarget& command)
+{
+    FlushBarriers();
+    commandList_->ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE{ static_cast<SIZE_T>(command.RenderTarget) }, command.Color, 0, nullptr);
+}
+
+void D3D12CommandSink::SetPrimitiveTopology(const commands::SetPrimitiveTopology& command)
+{
+    FlushBarriers();
+    commandList_->IASetPrimitiveTopology(static_cast<D3D12_PRIMITIVE_TOPOLOGY>(command.Topology));
+}
+
+void D3D12CommandSink::SetVertexBuffers(const commands::SetVertexBuffers& command, const commands::VertexBufferView* views)
+{
+    FlushBarriers();
+    vertexBuffers_.clear();
+    for (uint32_t index = 0; index < command.Count; index++)
+    {
+        vertexBuffers_.push_back(D3D12_VERTEX_BUFFER_VIEW{ views[index].BufferLocation, views[index].SizeInBytes, views[index].StrideInBytes });
+    }
+    commandList_->IASetVertexBuffers(command.StartSlot, command.Count, vertexBuffers_.data());
+}
+
+void D3D12CommandSink::SetIndexBuffer(const commands::SetIndexBuffer& command)
+{
+    FlushBarriers();
+    D3D12_INDEX_BUFFER_VIEW view = { command.BufferLocation, command.SizeInBytes, static_cast<DXGI_FORMAT>(command.Format) };
+    commandList_->IASetIndexBuffer(&view);
+}
+
+void D3D12CommandSink::Draw(const commands::Draw& command)
+{
+    FlushBarriers();
+    commandList_->DrawInstanced(command.VertexCountPerInstance, command.InstanceCount, command.StartVertexLocation, command.StartInstanceLocation);
+}
+
+void D3D12CommandSink::DrawIndexed(const commands::DrawIndexed& command)
+{
+    FlushBarriers();
+    commandList_->DrawIndexedInstanced(command.IndexCountPerInstance, command.InstanceCount, command.StartIndexLocation,
+        command.BaseVertexLocation, command.StartInstanceLocation);
+}
+
+void D3D12CommandSink::CopyBufferRegion(const commands::CopyBufferRegion& command)
+{
+    FlushBarriers();
+    commandList_->CopyBufferRegion(ToObject<ID3D12Resource>(command.Destination), command.DestinationOffset,
+        ToObject<ID3D12Resource>(command.Source), command.SourceOffset, command.NumBytes);
+}
+
+void D3D12CommandSink::CopyResource(const commands::CopyResource& command)
+{
+    FlushBarriers();
+    commandList_->CopyResource(ToObject<ID3D12Resource>(command.Destination), ToObject<ID3D12Resource>(command.Source));
+}
+
+void D3D12CommandSink::Finish()
+{
+    FlushBarriers();
+}
+
+void D3D12CommandSink::FlushBarriers()
+{
+    if (!barriers_.empty())
+    {
+        commandList_->ResourceBarrier(static_cast<UINT>(barriers_.size()), barriers_.data());
+        barriers_.clear();
+    }
+}
+
+}; // namespace graphics
@@ -0,0 +1,68 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <d3d12.h>
+
+#include <vector>
+
+#include "CommandStream.h"
+
+namespace graphics
+{
+
+//
+// Translates a CommandStream into calls on a D3D12 command list.
+//
+// Consecutive barrier packets are merged into one ResourceBarrier call, issued right before the next
+// command or at the end of the stream. Object references in the stream are the D3D12 interfaces, use
+// the Record*() helpers or pass the interface pointers directly.
+//
+class D3D12CommandSink : public CommandSink
+{
+public:
+    explicit D3D12CommandSink(ID3D12GraphicsCommandList* commandList = nullptr);
+
+    D3D12CommandSink(const D3D12CommandSink&) = delete;
+    D3D12CommandSink& operator=(const D3D12CommandSink&) = delete;
+
+    // Replay `stream` into `commandList`, which is open for recording.
+    void Execute(const CommandStream& stream, ID3D12GraphicsCommandList* commandList);
+
+    // Helpers taking D3D12 types
+    static void RecordVertexBuffers(CommandStream& stream, UINT startSlot, UINT count, const D3D12_VERTEX_BUFFER_VIEW* views);
+    static void RecordViewport(CommandStream& stream, const D3D12_VIEWPORT& viewport);
+    static void RecordScissorRect(CommandStream& stream, const D3D12_RECT& rect);
+
+    virtual void Barrier(const commands::Barrier& command) override;
+    virtual void SetPipelineState(const commands::SetPipelineState& command) override;
+    virtual void SetGraphicsRootSignature(const commands::SetGraphicsRootSignature& command) override;
+    virtual void SetDescriptorHeaps(const commands::SetDescriptorHeaps& command, const CommandObject* heaps) override;
+    virtual void SetGraphicsRootConstantBufferView(const commands::SetGraphicsRootConstantBufferView& command) override;
+    virtual void SetGraphicsRootDescriptorTable(const commands::SetGraphicsRootDescriptorTable& command) override;
+    virtual void SetViewport(const commands::SetViewport& command) override;
+    virtual void SetScissorRect(const commands::SetScissorRect& command) override;
+    virtual void SetRenderTargets(const commands::SetRenderTargets& command, const uint64_t* renderTargets) override;
+    virtual void ClearRenderTarget(const commands::ClearRenderTarget& command) override;
+    virtual void SetPrimitiveTopology(const commands::SetPrimitiveTopology& command) override;
+    virtual void SetVertexBuffers(const commands::SetVertexBuffers& command, const commands::VertexBufferView* views) override;
+    virtual void SetIndexBuffer(const commands::SetIndexBuffer& command) override;
+    virtual void Draw(const commands::Draw& command) override;
+    virtual void DrawIndexed(const commands::DrawIndexed& command) override;
+    virtual void CopyBufferRegion(const commands::CopyBufferRegion& command) override;
+    virtual void CopyResource(const commands::CopyResource& command) override;
+    virtual void Finish() override;
+
+private:
+    void FlushBarriers();
+
+    ID3D12GraphicsCommandList* commandList_;
+
+    // Scratch storage reused by every replay
+    std::vector<D3D12_RESOURCE_BARRIER> barriers_;
+    std::vector<ID3D12DescriptorHeap*> heaps_;
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> renderTargets_;
+    std::vector<D3D12_VERTEX_BUFFER_VIEW> vertexBuffers_;
+};
+
+}; // namespace graphics
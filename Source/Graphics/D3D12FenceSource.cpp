@@ -0,0 +1,69 @@
+#include "D3D12FenceSource.h"
+
+#include "GraphicsUtil.h"
+
+namespace graphics
+{
+
+D3D12FenceSource::D3D12FenceSource(ID3D12Device* device, UINT64 initialValue) :
+    nextValue_(initialValue + 1)
+{
+    ThrowIfFailed(device->CreateFence(initialValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)), "CreateFence");
+
+    // Auto-reset events, each wait consumes one signal.
+    completionEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    interruptEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (completionEvent_ == nullptr || interruptEvent_ == nullptr)
+    {
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()), "CreateEventW");
+    }
+}
+
+D3D12FenceSource::~D3D12FenceSource()
+{
+    CloseHandle(completionEvent_);
+    CloseHandle(interruptEvent_);
+}
+
+UINT64 D3D12FenceSource::Signal(ID3D12CommandQueue* commandQueue)
+{
+    // `fence_` value won't be set by GPU until it finishes processing all the commands prior to this `Signal()`.
+    const UINT64 value = nextValue_++;
+    ThrowIfFailed(commandQueue->Signal(fence_.Get(), value), "Signal");
+    return value;
+}
+
+UINT64 D3D12FenceSource::GetNextValue() const
+{
+    return nextValue_;
+}
+
+ID3D12Fence* D3D12FenceSource::GetFence() const
+{
+    return fence_.Get();
+}
+
+uint64_t D3D12FenceSource::GetCompletedValue() const
+{
+    return fence_->GetCompletedValue();
+}
+
+void D3D12FenceSource::WaitForValue(uint64_t value)
+{
+    if (fence_->GetCompletedValue() >= value)
+    {
+        return;
+    }
+
+    // Fire event when GPU hits the fence value, and wait until either it or an interruption is fired.
+    ThrowIfFailed(fence_->SetEventOnCompletion(value, completionEvent_), "SetEventOnCompletion");
+    HANDLE handles[] = { completionEvent_, interruptEvent_ };
+    WaitForMultipleObjects(_countof(handles), handles, FALSE, INFINITE);
+}
+
+void D3D12FenceSource::Interrupt()
+{
+    SetEvent(interruptEvent_);
+}
+
+}; // namespace graphics
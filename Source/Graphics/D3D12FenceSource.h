@@ -0,0 +1,46 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <atomic>
+
+#include "FenceTimeline.h"
+
+namespace graphics
+{
+
+//
+// FenceSource backed by an ID3D12Fence, waited on with SetEventOnCompletion.
+//
+class D3D12FenceSource : public FenceSource
+{
+public:
+    D3D12FenceSource(ID3D12Device* device, UINT64 initialValue = 0);
+    virtual ~D3D12FenceSource();
+
+    D3D12FenceSource(const D3D12FenceSource&) = delete;
+    D3D12FenceSource& operator=(const D3D12FenceSource&) = delete;
+
+    // Schedule a Signal on `commandQueue` with the next fence value and return that value.
+    UINT64 Signal(ID3D12CommandQueue* commandQueue);
+
+    // The value which the next Signal() will use.
+    UINT64 GetNextValue() const;
+
+    ID3D12Fence* GetFence() const;
+
+    virtual uint64_t GetCompletedValue() const override;
+    virtual void WaitForValue(uint64_t value) override;
+    virtual void Interrupt() override;
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
+    std::atomic<UINT64> nextValue_;
+    HANDLE completionEvent_;
+    HANDLE interruptEvent_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,213 @@
+#include "D3D12HeapAllocator.h"
+
+#include <stdexcept>
+
+#include <d3dx12.h>
+
+#include "GraphicsUtil.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+namespace
+{
+
+const D3D12_HEAP_TYPE kHeapTypes[D3D12HeapAllocator::kNumHeapTypes] =
+{
+    D3D12_HEAP_TYPE_DEFAULT,
+    D3D12_HEAP_TYPE_UPLOAD,
+    D3D12_HEAP_TYPE_READBACK
+};
+
+// Indexed by category, tier 1 heaps hold one category only.
+const D3D12_HEAP_FLAGS kHeapFlags[D3D12HeapAllocator::kNumCategories] =
+{
+    D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+};
+
+UINT64 GetHeapAlignment(D3D12HeapAllocator::Category category)
+{
+    return category == D3D12HeapAllocator::Category::RenderTarget ?
+        D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+}
+
+};
+
+D3D12HeapAllocator::Category D3D12HeapAllocator::GetCategory(const D3D12_RESOURCE_DESC& desc)
+{
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        return Category::Buffer;
+    }
+    if ((desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0)
+    {
+        return Category::RenderTarget;
+    }
+    return Category::Texture;
+}
+
+const char* D3D12HeapAllocator::GetCategoryName(Category category)
+{
+    switch (category)
+    {
+    case Category::Buffer:
+        return "Buffer";
+    case Category::Texture:
+        return "Texture";
+    default:
+        return "RenderTarget";
+    }
+}
+
+D3D12HeapAllocator::D3D12HeapAllocator(ID3D12Device* device, UINT64 blockSize) :
+    device_(device),
+    pools_(kNumHeapTypes * kNumCategories)
+{
+    for (UINT pool = 0; pool < static_cast<UINT>(pools_.size()); pool++)
+    {
+        const UINT64 heapAlignment = GetHeapAlignment(static_cast<Category>(pool % kNumCategories));
+        pools_[pool].Allocator = std::make_unique<BlockAllocator>(blockSize, heapAlignment,
+            [this, pool](uint32_t block, uint64_t size) { return CreateHeap(pool, block, size); },
+            [this, pool](uint32_t block) { pools_[pool].Heaps[block].Reset(); });
+    }
+}
+
+D3D12HeapAllocator::Allocation D3D12HeapAllocator::Allocate(D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_DESC& desc)
+{
+    const Category category = GetCategory(desc);
+
+    // Small textures may be 4KB aligned, GetResourceAllocationInfo() tells whether this one qualifies.
+    D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {};
+    if (category == Category::Texture && desc.SampleDesc.Count <= 1)
+    {
+        desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        allocationInfo = device_->GetResourceAllocationInfo(0, 1, &desc);
+    }
+    if (allocationInfo.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        desc.Alignment = 0;
+        allocationInfo = device_->GetResourceAllocationInfo(0, 1, &desc);
+    }
+    if (allocationInfo.SizeInBytes == UINT64_MAX)
+    {
+        throw std::runtime_error("Invalid resource desc for placement");
+    }
+
+    const UINT pool = GetPoolIndex(heapType, category);
+    return GetAllocation(pool, pools_[pool].Allocator->Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment));
+}
+
+ComPtr<ID3D12Resource> D3D12HeapAllocator::CreateResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue, Allocation& allocation)
+{
+    D3D12_RESOURCE_DESC placedDesc = desc;
+    allocation = Allocate(heapType, placedDesc);
+    if (!allocation.IsValid())
+    {
+        ThrowIfFailed(E_OUTOFMEMORY, "CreateHeap for placed resources");
+    }
+
+    ComPtr<ID3D12Resource> resource;
+    const HRESULT hr = device_->CreatePlacedResource(allocation.Heap, allocation.Offset, &placedDesc, initialState, clearValue,
+        IID_PPV_ARGS(&resource));
+    if (FAILED(hr))
+    {
+        // Nothing was placed, the memory can go back right away.
+        Free(allocation, 0);
+        allocation = {};
+        ThrowIfFailed(hr, "CreatePlacedResource");
+    }
+    return resource;
+}
+
+void D3D12HeapAllocator::Free(const Allocation& allocation, UINT64 fenceValue)
+{
+    if (allocation.IsValid())
+    {
+        pools_[allocation.Pool].Allocator->Free(allocation.Id, fenceValue);
+    }
+}
+
+void D3D12HeapAllocator::ReleaseCompleted(UINT64 completedValue)
+{
+    for (Pool& pool : pools_)
+    {
+        pool.Allocator->ReleaseCompleted(completedValue);
+    }
+}
+
+void D3D12HeapAllocator::Defragment(UINT64 maxBytes, UINT64 fenceValue, const MoveFunction& move)
+{
+    for (UINT pool = 0; pool < static_cast<UINT>(pools_.size()); pool++)
+    {
+        BlockAllocator& allocator = *pools_[pool].Allocator;
+        for (const BlockAllocator::Move& blockMove : allocator.Defragment(maxBytes, fenceValue))
+        {
+            Allocation source;
+            source.Pool = pool;
+            source.Id = blockMove.Allocation;
+            source.Heap = pools_[pool].Heaps[blockMove.SourceBlock].Get();
+            source.Offset = blockMove.SourceOffset;
+            source.Size = allocator.GetSize(blockMove.Allocation);
+            move(source, GetAllocation(pool, blockMove.Allocation));
+        }
+    }
+}
+
+BlockAllocator::Statistics D3D12HeapAllocator::GetStatistics(D3D12_HEAP_TYPE heapType, Category category) const
+{
+    return pools_[GetPoolIndex(heapType, category)].Allocator->GetStatistics();
+}
+
+UINT D3D12HeapAllocator::GetPoolIndex(D3D12_HEAP_TYPE heapType, Category category)
+{
+    for (UINT heapTypeIndex = 0; heapTypeIndex < kNumHeapTypes; heapTypeIndex++)
+    {
+        if (kHeapTypes[heapTypeIndex] == heapType)
+        {
+            return heapTypeIndex * kNumCategories + static_cast<UINT>(category);
+        }
+    }
+    throw std::runtime_error("Placed resources are in DEFAULT, UPLOAD or READBACK heaps");
+}
+
+bool D3D12HeapAllocator::CreateHeap(UINT pool, uint32_t block, UINT64 size)
+{
+    const Category category = static_cast<Category>(pool % kNumCategories);
+    CD3DX12_HEAP_DESC heapDesc(size, kHeapTypes[pool / kNumCategories], GetHeapAlignment(category), kHeapFlags[static_cast<UINT>(category)]);
+
+    ComPtr<ID3D12Heap> heap;
+    if (FAILED(device_->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap))))
+    {
+        return false;
+    }
+    if (block >= pools_[pool].Heaps.size())
+    {
+        pools_[pool].Heaps.resize(block + 1);
+    }
+    pools_[pool].Heaps[block] = std::move(heap);
+    return true;
+}
+
+D3D12HeapAllocator::Allocation D3D12HeapAllocator::GetAllocation(UINT pool, BlockAllocator::Handle id) const
+{
+    Allocation allocation;
+    if (id == BlockAllocator::kInvalidHandle)
+    {
+        return allocation;
+    }
+
+    const BlockAllocator& allocator = *pools_[pool].Allocator;
+    allocation.Pool = pool;
+    allocation.Id = id;
+    allocation.Heap = pools_[pool].Heaps[allocator.GetBlock(id)].Get();
+    allocation.Offset = allocator.GetOffset(id);
+    allocation.Size = allocator.GetSize(id);
+    return allocation;
+}
+
+}; // namespace graphics
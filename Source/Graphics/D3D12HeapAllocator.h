@@ -0,0 +1,100 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "BlockAllocator.h"
+
+namespace graphics
+{
+
+//
+// Placed resources in large ID3D12Heaps, instead of one implicit heap per committed resource.
+//
+// There is a BlockAllocator per heap type and resource category, the categories being buffers, textures, and
+// render target or depth stencil textures, which keeps to resource heap tier 1. Heaps are kDefaultBlockSize,
+// larger resources get a heap of their own. Sizes and alignments come from GetResourceAllocationInfo(): 64KB,
+// 4MB for MSAA, and 4KB for the small textures which allow it. Render target heaps are 4MB aligned for MSAA.
+//
+// Memory is freed with the fence value of its last use, see BlockAllocator. Not thread safe.
+//
+class D3D12HeapAllocator
+{
+public:
+    static const UINT64 kDefaultBlockSize = 64 * 1024 * 1024;
+
+    enum class Category : UINT
+    {
+        Buffer,
+        Texture,
+        RenderTarget,   // Render targets and depth stencils
+    };
+    static const UINT kNumCategories = 3;
+    // DEFAULT, UPLOAD and READBACK
+    static const UINT kNumHeapTypes = 3;
+
+    struct Allocation
+    {
+        UINT Pool = 0;
+        BlockAllocator::Handle Id = BlockAllocator::kInvalidHandle;
+        ID3D12Heap* Heap = nullptr;
+        UINT64 Offset = 0;
+        UINT64 Size = 0;
+
+        bool IsValid() const { return Id != BlockAllocator::kInvalidHandle; }
+    };
+
+    // Called for every allocation Defragment() moves: place a new resource at `destination`, copy the old one
+    // into it and retire the old one with the fence value given to Defragment(). `source` stays valid until then.
+    using MoveFunction = std::function<void(const Allocation& source, const Allocation& destination)>;
+
+    static Category GetCategory(const D3D12_RESOURCE_DESC& desc);
+    static const char* GetCategoryName(Category category);
+
+    explicit D3D12HeapAllocator(ID3D12Device* device, UINT64 blockSize = kDefaultBlockSize);
+
+    D3D12HeapAllocator(const D3D12HeapAllocator&) = delete;
+    D3D12HeapAllocator& operator=(const D3D12HeapAllocator&) = delete;
+
+    // Memory for `desc`, whose Alignment is set to the alignment used, so `desc` is what CreatePlacedResource()
+    // has to be called with. Returns an invalid allocation when a new heap can't be created.
+    Allocation Allocate(D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_DESC& desc);
+
+    // Allocate() and CreatePlacedResource() in one, throws on failure.
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc,
+        D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue, Allocation& allocation);
+
+    // The memory can be reused once the GPU has passed `fenceValue`, the resource placed in it has to be
+    // released by then too.
+    void Free(const Allocation& allocation, UINT64 fenceValue);
+    void ReleaseCompleted(UINT64 completedValue);
+
+    // Move up to `maxBytes` per pool out of the emptiest heaps into fuller ones, so they can be released.
+    // Heaps are only released once the fence value passes, by ReleaseCompleted().
+    void Defragment(UINT64 maxBytes, UINT64 fenceValue, const MoveFunction& move);
+
+    BlockAllocator::Statistics GetStatistics(D3D12_HEAP_TYPE heapType, Category category) const;
+
+private:
+    struct Pool
+    {
+        std::unique_ptr<BlockAllocator> Allocator;
+        // Indexed by block
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> Heaps;
+    };
+
+    static UINT GetPoolIndex(D3D12_HEAP_TYPE heapType, Category category);
+    bool CreateHeap(UINT pool, uint32_t block, UINT64 size);
+    Allocation GetAllocation(UINT pool, BlockAllocator::Handle id) const;
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    std::vector<Pool> pools_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,205 @@
+#include "D3D12RenderGraphResources.h"
+
+#include <cassert>
+#include <cstring>
+
+#include <d3dx12.h>
+
+#include "Alignment.h"
+#include "GraphicsUtil.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+namespace
+{
+
+const size_t kNotPlaced = ~size_t(0);
+
+bool IsSameDesc(const D3D12_RESOURCE_DESC& a, const D3D12_RESOURCE_DESC& b)
+{
+    return memcmp(&a, &b, sizeof(D3D12_RESOURCE_DESC)) == 0;
+}
+
+};
+
+D3D12RenderGraphResources::D3D12RenderGraphResources(ID3D12Device* device) :
+    device_(device),
+    heapSize_(0)
+{
+}
+
+void D3D12RenderGraphResources::BeginFrame(RenderGraph& graph)
+{
+    graph.Reset();
+    resources_.clear();
+    descs_.clear();
+    placedIndices_.clear();
+}
+
+RenderGraph::ResourceHandle D3D12RenderGraphResources::Import(RenderGraph& graph, const char* name, ID3D12Resource* resource,
+    const ResourceStateRegistry& registry, D3D12_RESOURCE_STATES finalState)
+{
+    const RenderGraph::ResourceHandle handle = graph.Import(name, registry.GetState(resource), static_cast<ResourceStateMask>(finalState));
+    resources_.resize(graph.GetNumResources(), nullptr);
+    descs_.resize(graph.GetNumResources());
+    resources_[handle] = resource;
+    return handle;
+}
+
+RenderGraph::ResourceHandle D3D12RenderGraphResources::CreateTexture(RenderGraph& graph, const char* name, const D3D12_RESOURCE_DESC& desc)
+{
+    assert((desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0 &&
+        "Transient textures must be render targets or depth stencils");
+
+    const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device_->GetResourceAllocationInfo(0, 1, &desc);
+    const RenderGraph::ResourceHandle handle = graph.CreateTransient(name, allocationInfo.SizeInBytes, allocationInfo.Alignment);
+    resources_.resize(graph.GetNumResources(), nullptr);
+    descs_.resize(graph.GetNumResources());
+    descs_[handle] = desc;
+    return handle;
+}
+
+void D3D12RenderGraphResources::Realize(const RenderGraph& graph, DeferredReleaseQueue<ComPtr<IUnknown>>& releaseQueue, UINT64 fenceValue)
+{
+    // A larger layout needs a new heap, which invalidates every placed resource.
+    if (graph.GetTransientHeapSize() > heapSize_)
+    {
+        for (PlacedTexture& placedTexture : placedTextures_)
+        {
+            releaseQueue.Retire(std::move(placedTexture.Resource), fenceValue);
+        }
+        placedTextures_.clear();
+        if (heap_)
+        {
+            releaseQueue.Retire(std::move(heap_), fenceValue);
+        }
+
+        heapSize_ = AlignUp(graph.GetTransientHeapSize(), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+        CD3DX12_HEAP_DESC heapDesc(heapSize_, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+        ThrowIfFailed(device_->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap_)), "CreateHeap for transient resources");
+    }
+
+    // Reuse the placed resources matching this frame's layout, create the missing ones and retire the rest.
+    std::vector<char> used(placedTextures_.size(), 0);
+    placedIndices_.assign(graph.GetNumResources(), kNotPlaced);
+    for (RenderGraph::ResourceHandle handle = 0; handle < graph.GetNumResources(); handle++)
+    {
+        const UINT64 offset = graph.GetHeapOffset(handle);
+        if (graph.IsImported(handle) || offset == RenderGraph::kInvalidOffset)
+        {
+            continue;
+        }
+
+        size_t index = 0;
+        for (; index < placedTextures_.size(); index++)
+        {
+            if (!used[index] && placedTextures_[index].Offset == offset && IsSameDesc(placedTextures_[index].Desc, descs_[handle]))
+            {
+                break;
+            }
+        }
+
+        if (index == placedTextures_.size())
+        {
+            const D3D12_RESOURCE_STATES initialState = static_cast<D3D12_RESOURCE_STATES>(graph.GetInitialState(handle));
+            PlacedTexture placedTexture = { descs_[handle], offset, nullptr, initialState };
+            ThrowIfFailed(device_->CreatePlacedResource(heap_.Get(), offset, &descs_[handle], initialState, nullptr,
+                IID_PPV_ARGS(&placedTexture.Resource)), "CreatePlacedResource for transient resource");
+            placedTextures_.push_back(std::move(placedTexture));
+            used.push_back(0);
+        }
+
+        used[index] = 1;
+        placedIndices_[handle] = index;
+    }
+
+    for (size_t index = placedTextures_.size(); index-- > 0;)
+    {
+        if (!used[index])
+        {
+            releaseQueue.Retire(std::move(placedTextures_[index].Resource), fenceValue);
+            placedTextures_.erase(placedTextures_.begin() + index);
+            for (size_t& placedIndex : placedIndices_)
+            {
+                if (placedIndex != kNotPlaced && placedIndex > index)
+                {
+                    placedIndex--;
+                }
+            }
+        }
+    }
+
+    for (RenderGraph::ResourceHandle handle = 0; handle < graph.GetNumResources(); handle++)
+    {
+        if (placedIndices_[handle] != kNotPlaced)
+        {
+            resources_[handle] = placedTextures_[placedIndices_[handle]].Resource.Get();
+        }
+    }
+}
+
+ID3D12Resource* D3D12RenderGraphResources::GetResource(RenderGraph::ResourceHandle resource) const
+{
+    return resources_[resource];
+}
+
+void D3D12RenderGraphResources::Execute(const RenderGraph& graph, ID3D12GraphicsCommandList* commandList, D3D12ResourceStateTracker& stateTracker)
+{
+    for (const RenderGraph::CompiledPass& compiledPass : graph.GetCompiledPasses())
+    {
+        barriers_.clear();
+
+        // Memory changing hands first, then the transient transitions, in one call.
+        for (const RenderGraph::Activation& activation : compiledPass.Activations)
+        {
+            ID3D12Resource* previous = activation.Previous != RenderGraph::kInvalidResource ? resources_[activation.Previous] : nullptr;
+            barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(previous, resources_[activation.Resource]));
+        }
+
+        for (const RenderGraph::Access& access : graph.GetPassAccesses(compiledPass.Pass))
+        {
+            const D3D12_RESOURCE_STATES state = static_cast<D3D12_RESOURCE_STATES>(access.State);
+            if (graph.IsImported(access.Resource))
+            {
+                stateTracker.Transition(resources_[access.Resource], state);
+                continue;
+            }
+
+            PlacedTexture& placedTexture = placedTextures_[placedIndices_[access.Resource]];
+            if (placedTexture.State != state)
+            {
+                barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(placedTexture.Resource.Get(), placedTexture.State, state));
+                placedTexture.State = state;
+            }
+        }
+
+        if (!barriers_.empty())
+        {
+            commandList->ResourceBarrier(static_cast<UINT>(barriers_.size()), barriers_.data());
+        }
+        stateTracker.FlushBarriers();
+
+        // Aliased memory holds garbage, render targets and depth stencils must be initialized before use.
+        for (const RenderGraph::Activation& activation : compiledPass.Activations)
+        {
+            const D3D12_RESOURCE_STATES state = placedTextures_[placedIndices_[activation.Resource]].State;
+            if (state == D3D12_RESOURCE_STATE_RENDER_TARGET || state == D3D12_RESOURCE_STATE_DEPTH_WRITE)
+            {
+                commandList->DiscardResource(resources_[activation.Resource], nullptr);
+            }
+        }
+
+        graph.ExecutePass(compiledPass);
+    }
+
+    for (const RenderGraph::Barrier& barrier : graph.GetFinalBarriers())
+    {
+        stateTracker.Transition(resources_[barrier.Resource], static_cast<D3D12_RESOURCE_STATES>(barrier.After));
+    }
+    stateTracker.FlushBarriers();
+}
+
+}; // namespace graphics
@@ -0,0 +1,77 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <vector>
+
+#include "RenderGraph.h"
+#include "DeferredReleaseQueue.h"
+#include "D3D12ResourceStateTracker.h"
+
+namespace graphics
+{
+
+//
+// D3D12 backing of a RenderGraph.
+//
+// Transient textures are placed resources in one heap sized by the compiled graph. The heap and the placed
+// resources are kept from frame to frame and only recreated when the layout changes, the replaced ones go
+// through the deferred release queue. Imported resources are transitioned with the command list's
+// D3D12ResourceStateTracker, transient ones are owned here and get their aliasing and state barriers directly.
+//
+// Transient textures must be render targets or depth stencils, so the heap works on resource heap tier 1.
+//
+class D3D12RenderGraphResources
+{
+public:
+    explicit D3D12RenderGraphResources(ID3D12Device* device);
+
+    D3D12RenderGraphResources(const D3D12RenderGraphResources&) = delete;
+    D3D12RenderGraphResources& operator=(const D3D12RenderGraphResources&) = delete;
+
+    // Reset `graph` and forget the resources of the previous frame.
+    void BeginFrame(RenderGraph& graph);
+
+    RenderGraph::ResourceHandle Import(RenderGraph& graph, const char* name, ID3D12Resource* resource,
+        const ResourceStateRegistry& registry, D3D12_RESOURCE_STATES finalState);
+    RenderGraph::ResourceHandle CreateTexture(RenderGraph& graph, const char* name, const D3D12_RESOURCE_DESC& desc);
+
+    // Create the heap and placed resources for the compiled graph. Replaced objects are retired with `fenceValue`,
+    // the value signaled after the last frame which may use them.
+    void Realize(const RenderGraph& graph, DeferredReleaseQueue<Microsoft::WRL::ComPtr<IUnknown>>& releaseQueue, UINT64 fenceValue);
+
+    // Valid after Realize(), nullptr for culled transients.
+    ID3D12Resource* GetResource(RenderGraph::ResourceHandle resource) const;
+
+    // Record every compiled pass into `commandList`, which `stateTracker` is tracking.
+    void Execute(const RenderGraph& graph, ID3D12GraphicsCommandList* commandList, D3D12ResourceStateTracker& stateTracker);
+
+    UINT64 GetHeapSize() const { return heapSize_; }
+
+private:
+    struct PlacedTexture
+    {
+        D3D12_RESOURCE_DESC Desc;
+        UINT64 Offset;
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        D3D12_RESOURCE_STATES State;
+    };
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    Microsoft::WRL::ComPtr<ID3D12Heap> heap_;
+    UINT64 heapSize_;
+    std::vector<PlacedTexture> placedTextures_;
+
+    // Per frame, indexed by resource handle
+    std::vector<ID3D12Resource*> resources_;
+    std::vector<D3D12_RESOURCE_DESC> descs_;
+    std::vector<size_t> placedIndices_;
+
+    // Scratch storage reused by every pass
+    std::vector<D3D12_RESOURCE_BARRIER> barriers_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,47 @@
+#include "D3D12ResidencyDevice.h"
+
+#include "GraphicsUtil.h"
+
+namespace graphics
+{
+
+D3D12ResidencyDevice::D3D12ResidencyDevice(ID3D12Device* device, IDXGIAdapter3* adapter) :
+    device_(device),
+    adapter_(adapter)
+{
+}
+
+MemoryBudget D3D12ResidencyDevice::QueryBudget() const
+{
+    DXGI_QUERY_VIDEO_MEMORY_INFO info;
+    ThrowIfFailed(adapter_->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info), "QueryVideoMemoryInfo");
+
+    MemoryBudget budget;
+    budget.Budget = info.Budget;
+    budget.Usage = info.CurrentUsage;
+    return budget;
+}
+
+void D3D12ResidencyDevice::MakeResident(const std::vector<ResidencyObject>& objects)
+{
+    // Blocks until the memory is resident, the GPU work which uses it is submitted afterwards.
+    GatherPageables(objects);
+    ThrowIfFailed(device_->MakeResident(static_cast<UINT>(pageables_.size()), pageables_.data()), "MakeResident");
+}
+
+void D3D12ResidencyDevice::Evict(const std::vector<ResidencyObject>& objects)
+{
+    GatherPageables(objects);
+    ThrowIfFailed(device_->Evict(static_cast<UINT>(pageables_.size()), pageables_.data()), "Evict");
+}
+
+void D3D12ResidencyDevice::GatherPageables(const std::vector<ResidencyObject>& objects)
+{
+    pageables_.clear();
+    for (const ResidencyObject& object : objects)
+    {
+        pageables_.push_back(static_cast<ID3D12Pageable*>(object.Object));
+    }
+}
+
+}; // namespace graphics
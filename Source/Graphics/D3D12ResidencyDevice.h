@@ -0,0 +1,38 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+#include <dxgi1_4.h>
+
+#include <vector>
+
+#include "ResidencyManager.h"
+
+namespace graphics
+{
+
+//
+// ResidencyDevice over an ID3D12Device, objects being ID3D12Pageable*.
+// The budget is the local segment group of QueryVideoMemoryInfo(), the video memory of a discrete GPU.
+//
+class D3D12ResidencyDevice : public ResidencyDevice
+{
+public:
+    D3D12ResidencyDevice(ID3D12Device* device, IDXGIAdapter3* adapter);
+
+    virtual MemoryBudget QueryBudget() const override;
+    virtual void MakeResident(const std::vector<ResidencyObject>& objects) override;
+    virtual void Evict(const std::vector<ResidencyObject>& objects) override;
+
+private:
+    void GatherPageables(const std::vector<ResidencyObject>& objects);
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter_;
+
+    std::vector<ID3D12Pageable*> pageables_;
+};
+
+}; // namespace graphics
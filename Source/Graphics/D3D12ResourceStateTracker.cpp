@@ -0,0 +1,84 @@
+#include "D3D12ResourceStateTracker.h"
+
+#include <d3dx12.h>
+
+namespace graphics
+{
+
+namespace
+{
+
+// States a resource can be written in, every other bit is a read state that may be combined with others.
+const ResourceStateMask kWriteStates =
+    D3D12_RESOURCE_STATE_RENDER_TARGET |
+    D3D12_RESOURCE_STATE_UNORDERED_ACCESS |
+    D3D12_RESOURCE_STATE_DEPTH_WRITE |
+    D3D12_RESOURCE_STATE_STREAM_OUT |
+    D3D12_RESOURCE_STATE_COPY_DEST |
+    D3D12_RESOURCE_STATE_RESOLVE_DEST;
+
+};
+
+D3D12ResourceStateTracker::D3D12ResourceStateTracker(ResourceStateRegistry& registry) :
+    registry_(registry),
+    tracker_(kWriteStates),
+    commandList_(nullptr)
+{
+}
+
+void D3D12ResourceStateTracker::Reset(ID3D12GraphicsCommandList* commandList)
+{
+    tracker_.Reset();
+    commandList_ = commandList;
+}
+
+void D3D12ResourceStateTracker::Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter)
+{
+    tracker_.Transition(resource, static_cast<ResourceStateMask>(stateAfter));
+}
+
+void D3D12ResourceStateTracker::FlushBarriers()
+{
+    transitions_.clear();
+    if (tracker_.FlushBarriers(transitions_) > 0)
+    {
+        ToD3D12Barriers(transitions_);
+        commandList_->ResourceBarrier(static_cast<UINT>(barriers_.size()), barriers_.data());
+    }
+}
+
+const std::vector<D3D12_RESOURCE_BARRIER>& D3D12ResourceStateTracker::Resolve()
+{
+    FlushBarriers();
+
+    transitions_.clear();
+    tracker_.Resolve(registry_, transitions_);
+    ToD3D12Barriers(transitions_);
+    commandList_ = nullptr;
+
+    return barriers_;
+}
+
+void D3D12ResourceStateTracker::Register(ResourceStateRegistry& registry, ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+    registry.Register(resource, static_cast<ResourceStateMask>(state));
+}
+
+void D3D12ResourceStateTracker::Unregister(ResourceStateRegistry& registry, ID3D12Resource* resource)
+{
+    registry.Unregister(resource);
+}
+
+void D3D12ResourceStateTracker::ToD3D12Barriers(const std::vector<StateTransition>& transitions)
+{
+    barriers_.clear();
+    for (const StateTransition& transition : transitions)
+    {
+        barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+            static_cast<ID3D12Resource*>(const_cast<void*>(transition.Resource)),
+            static_cast<D3D12_RESOURCE_STATES>(transition.Before),
+            static_cast<D3D12_RESOURCE_STATES>(transition.After)));
+    }
+}
+
+}; // namespace graphics
@@ -0,0 +1,58 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <d3d12.h>
+
+#include <vector>
+
+#include "ResourceStateTracker.h"
+
+namespace graphics
+{
+
+//
+// ResourceStateTracker bound to a D3D12 command list.
+//
+// Transition() only records the requested state, FlushBarriers() emits everything recorded since the previous
+// flush with one ResourceBarrier call, so call it right before the draw, clear or copy that needs the new states.
+// After the list is closed, Resolve() returns the transitions from the global states into the first-use
+// states of this list; record them into a prologue list executed right before it when there are any.
+//
+class D3D12ResourceStateTracker
+{
+public:
+    explicit D3D12ResourceStateTracker(ResourceStateRegistry& registry);
+
+    D3D12ResourceStateTracker(const D3D12ResourceStateTracker&) = delete;
+    D3D12ResourceStateTracker& operator=(const D3D12ResourceStateTracker&) = delete;
+
+    // Start tracking `commandList`, which was just reset.
+    void Reset(ID3D12GraphicsCommandList* commandList);
+
+    void Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter);
+    void FlushBarriers();
+
+    // Resolve the first uses against the registry and commit the final states, call right before execution.
+    // The returned barriers stay valid until the next call.
+    const std::vector<D3D12_RESOURCE_BARRIER>& Resolve();
+
+    const ResourceStateTracker::Statistics& GetStatistics() const { return tracker_.GetStatistics(); }
+
+    // Register a resource with the state it was created in, or remove it before it is released.
+    static void Register(ResourceStateRegistry& registry, ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+    static void Unregister(ResourceStateRegistry& registry, ID3D12Resource* resource);
+
+private:
+    void ToD3D12Barriers(const std::vector<StateTransition>& transitions);
+
+    ResourceStateRegistry& registry_;
+    ResourceStateTracker tracker_;
+    ID3D12GraphicsCommandList* commandList_;
+
+    // Scratch storage reused by every flush
+    std::vector<StateTransition> transitions_;
+    std::vector<D3D12_RESOURCE_BARRIER> barriers_;
+};
+
+}; // namespace graphics
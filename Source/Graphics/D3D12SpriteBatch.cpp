@@ -0,0 +1,27 @@
+#include "D3D12SpriteBatch.h"
+
+namespace graphics
+{
+
+const D3D12_INPUT_ELEMENT_DESC D3D12SpriteBatch::kInputElements[kNumInputElements] =
+{
+    { "CENTER", 0, DXGI_FORMAT_R32G32_FLOAT, SpriteBatch::kStreamCenter, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    { "EXTENT", 0, DXGI_FORMAT_R32G32_FLOAT, SpriteBatch::kStreamExtent, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, SpriteBatch::kStreamColor, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+};
+
+void D3D12SpriteBatch::Record(CommandStream& commands, SpriteBatch& batch, DynamicConstantAllocator& allocator,
+    const SpriteBatch::MaterialFunction& bindMaterial)
+{
+    if (batch.GetNumInstances() == 0)
+    {
+        return;
+    }
+
+    // Read once by this frame's draws, so the streams live in the same per-frame upload memory as the constants.
+    const DynamicConstantAllocator::Allocation allocation = allocator.Allocate(batch.GetPackedSize());
+    batch.Pack(allocation.CpuAddress);
+    batch.Record(commands, allocation.GpuAddress, 0, bindMaterial);
+}
+
+}; // namespace graphics
@@ -0,0 +1,32 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <d3d12.h>
+
+#include "SpriteBatch.h"
+#include "DynamicConstantAllocator.h"
+
+namespace graphics
+{
+
+//
+// D3D12 side of SpriteBatch: the input layout of its instance streams, and the per-frame upload.
+//
+// The vertex shader takes CENTER, EXTENT and COLOR per instance plus SV_VertexID for the corner,
+// no per-vertex buffer is bound.
+//
+class D3D12SpriteBatch
+{
+public:
+    static const UINT kNumInputElements = SpriteBatch::kNumStreams;
+    static const D3D12_INPUT_ELEMENT_DESC kInputElements[kNumInputElements];
+
+    static D3D12_INPUT_LAYOUT_DESC GetInputLayout() { return { kInputElements, kNumInputElements }; }
+
+    // Pack `batch` into this frame's region of `allocator` and record its draws, the streams go to slots 0 to 2.
+    static void Record(CommandStream& commands, SpriteBatch& batch, DynamicConstantAllocator& allocator,
+        const SpriteBatch::MaterialFunction& bindMaterial);
+};
+
+}; // namespace graphics
@@ -0,0 +1,60 @@
+#include "D3D12UploadService.h"
+
+#include "GraphicsUtil.h"
+
+namespace graphics
+{
+
+D3D12UploadService::D3D12UploadService(ID3D12Device* device, ID3D12CommandQueue* consumerQueue, UINT64 ringSize, UINT64 maxBatchSize) :
+    consumerQueue_(consumerQueue),
+    scheduler_(*this, maxBatchSize)
+{
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    ThrowIfFailed(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&copyQueue_)), "CreateCommandQueue for uploads");
+
+    fence_ = std::make_unique<D3D12FenceSource>(device);
+    fenceTimeline_ = std::make_unique<FenceTimeline>(*fence_);
+    uploadRing_ = std::make_unique<UploadRing>(device, copyQueue_.Get(), *fence_, *fenceTimeline_, ringSize);
+}
+
+D3D12UploadService::~D3D12UploadService()
+{
+    // The ring waits for its last submission, before the timeline it waits with goes away.
+    uploadRing_.reset();
+    fenceTimeline_.reset();
+}
+
+uint64_t D3D12UploadService::GetRecordingFenceValue() const
+{
+    // Only the ring signals the fence.
+    return fence_->GetNextValue();
+}
+
+uint64_t D3D12UploadService::GetRecordedSize() const
+{
+    return uploadRing_->GetRecordedSize();
+}
+
+uint64_t D3D12UploadService::SubmitCopies()
+{
+    return uploadRing_->Submit();
+}
+
+uint64_t D3D12UploadService::GetSubmittedValue() const
+{
+    return uploadRing_->GetLastSubmittedFenceValue();
+}
+
+uint64_t D3D12UploadService::GetCompletedValue() const
+{
+    return fence_->GetCompletedValue();
+}
+
+void D3D12UploadService::WaitOnConsumer(uint64_t fenceValue)
+{
+    ThrowIfFailed(consumerQueue_->Wait(fence_->GetFence(), fenceValue), "Wait for uploads");
+}
+
+}; // namespace graphics
@@ -0,0 +1,66 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <memory>
+
+#include "D3D12FenceSource.h"
+#include "FenceTimeline.h"
+#include "UploadRing.h"
+#include "UploadScheduler.h"
+
+namespace graphics
+{
+
+//
+// Uploads on a dedicated D3D12_COMMAND_LIST_TYPE_COPY queue with a fence of its own.
+//
+// Copies are staged through an UploadRing on the copy queue, e.g. by GeometryArena::Write(), and closed with
+// Commit(), which returns the ticket to Require() before a submission on `consumerQueue` that reads the data.
+// PrepareSubmission() then makes `consumerQueue` wait on the copy fence, on the GPU, only as far as needed.
+// See UploadScheduler for the batching.
+//
+class D3D12UploadService : public UploadQueueBackend
+{
+public:
+    using Ticket = UploadScheduler::Ticket;
+
+    D3D12UploadService(ID3D12Device* device, ID3D12CommandQueue* consumerQueue, UINT64 ringSize, UINT64 maxBatchSize);
+    virtual ~D3D12UploadService();
+
+    D3D12UploadService(const D3D12UploadService&) = delete;
+    D3D12UploadService& operator=(const D3D12UploadService&) = delete;
+
+    // Records on the copy queue, destinations are left in D3D12_RESOURCE_STATE_COMMON.
+    UploadRing& GetUploadRing() { return *uploadRing_; }
+
+    Ticket Commit() { return scheduler_.Commit(); }
+    void Require(Ticket ticket) { scheduler_.Require(ticket); }
+    // Right before ExecuteCommandLists() on the consumer queue.
+    void PrepareSubmission() { scheduler_.PrepareConsumerSubmission(); }
+    UINT64 Flush() { return scheduler_.Flush(); }
+    bool IsCompleted(Ticket ticket) const { return scheduler_.IsCompleted(ticket); }
+
+    UploadScheduler::Statistics GetStatistics() const { return scheduler_.GetStatistics(); }
+    FenceTimeline& GetFenceTimeline() { return *fenceTimeline_; }
+
+    virtual uint64_t GetRecordingFenceValue() const override;
+    virtual uint64_t GetRecordedSize() const override;
+    virtual uint64_t SubmitCopies() override;
+    virtual uint64_t GetSubmittedValue() const override;
+    virtual uint64_t GetCompletedValue() const override;
+    virtual void WaitOnConsumer(uint64_t fenceValue) override;
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> consumerQueue_;
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyQueue_;
+    std::unique_ptr<D3D12FenceSource> fence_;
+    std::unique_ptr<FenceTimeline> fenceTimeline_;
+    std::unique_ptr<UploadRing> uploadRing_;
+    UploadScheduler scheduler_;
+};
+
+}; // namespace graphics
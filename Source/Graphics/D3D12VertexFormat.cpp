@@ -0,0 +1,68 @@
+#include "D3D12VertexFormat.h"
+
+#include <stdexcept>
+
+namespace graphics
+{
+
+DXGI_FORMAT D3D12VertexFormat::GetDxgiFormat(VertexAttributeFormat format)
+{
+    switch (format)
+    {
+    case VertexAttributeFormat::Float32x2:
+        return DXGI_FORMAT_R32G32_FLOAT;
+    case VertexAttributeFormat::Float32x3:
+        return DXGI_FORMAT_R32G32B32_FLOAT;
+    case VertexAttributeFormat::Float32x4:
+        return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case VertexAttributeFormat::Float16x2:
+        return DXGI_FORMAT_R16G16_FLOAT;
+    case VertexAttributeFormat::Float16x4:
+        return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case VertexAttributeFormat::Unorm8x4:
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case VertexAttributeFormat::Snorm8x4:
+        return DXGI_FORMAT_R8G8B8A8_SNORM;
+    case VertexAttributeFormat::Unorm16x2:
+        return DXGI_FORMAT_R16G16_UNORM;
+    case VertexAttributeFormat::Snorm16x2:
+        return DXGI_FORMAT_R16G16_SNORM;
+    case VertexAttributeFormat::Unorm16x4:
+        return DXGI_FORMAT_R16G16B16A16_UNORM;
+    case VertexAttributeFormat::Snorm16x4:
+        return DXGI_FORMAT_R16G16B16A16_SNORM;
+    default:
+        throw std::runtime_error("Unknown vertex attribute format");
+    }
+}
+
+D3D12VertexFormat::D3D12VertexFormat(const VertexFormat& format, UINT slot, UINT instanceStepRate)
+{
+    const D3D12_INPUT_CLASSIFICATION classification = instanceStepRate != 0 ?
+        D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA : D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+    for (const VertexFormat::Attribute& attribute : format.GetAttributes())
+    {
+        elements_.push_back({ attribute.Semantic, attribute.SemanticIndex, GetDxgiFormat(attribute.Format), slot,
+            attribute.Offset, classification, instanceStepRate });
+    }
+}
+
+bool D3D12VertexFormat::MatchesSemantics(const D3D12_INPUT_ELEMENT_DESC* elements, UINT numElements) const
+{
+    if (numElements != elements_.size())
+    {
+        return false;
+    }
+    for (UINT index = 0; index < numElements; index++)
+    {
+        // Semantics are case-insensitive.
+        if (_stricmp(elements[index].SemanticName, elements_[index].SemanticName) != 0 ||
+            elements[index].SemanticIndex != elements_[index].SemanticIndex)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}; // namespace graphics
@@ -0,0 +1,38 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <d3d12.h>
+
+#include <vector>
+
+#include "VertexFormat.h"
+
+namespace graphics
+{
+
+//
+// D3D12 side of VertexFormat: the input elements reading its packed vertices.
+//
+// Semantic names point into the VertexFormat's declaration, which has to outlive the pipeline state descs
+// built from GetInputLayout().
+//
+class D3D12VertexFormat
+{
+public:
+    static DXGI_FORMAT GetDxgiFormat(VertexAttributeFormat format);
+
+    // Elements of `format` in input slot `slot`, per vertex, or per instance when `instanceStepRate` isn't 0.
+    explicit D3D12VertexFormat(const VertexFormat& format, UINT slot = 0, UINT instanceStepRate = 0);
+
+    D3D12_INPUT_LAYOUT_DESC GetInputLayout() const { return { elements_.data(), static_cast<UINT>(elements_.size()) }; }
+
+    // Whether the semantics are the ones of `elements` in the same order, e.g. the layout ShaderBindgen
+    // generates from a vertex shader's parameters. Formats aren't compared, the shader reads floats from all.
+    bool MatchesSemantics(const D3D12_INPUT_ELEMENT_DESC* elements, UINT numElements) const;
+
+private:
+    std::vector<D3D12_INPUT_ELEMENT_DESC> elements_;
+};
+
+}; // namespace graphics
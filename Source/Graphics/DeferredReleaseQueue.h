@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <algorithm>
+
+namespace graphics
+{
+
+//
+// Keeps objects (typically ComPtr<>s) alive until the fence value of their last GPU use completes.
+//
+// Replacing a resource no longer needs a queue flush: hand the old reference to Retire() together
+// with the fence value signaled after its last use, and call ReleaseCompleted() once per frame.
+// Entries are released in batches, in fence order. Not thread safe, use it from the render thread.
+//
+template <typename T>
+class DeferredReleaseQueue
+{
+public:
+    ~DeferredReleaseQueue()
+    {
+        ReleaseAll();
+    }
+
+    void Retire(T object, uint64_t fenceValue)
+    {
+        // Fence values are normally monotonic, only an out-of-order retirement needs a sorted insert.
+        if (entries_.empty() || entries_.back().first <= fenceValue)
+        {
+            entries_.emplace_back(fenceValue, std::move(object));
+        }
+        else
+        {
+            auto position = std::upper_bound(entries_.begin(), entries_.end(), fenceValue,
+                [](uint64_t value, const Entry& entry) { return value < entry.first; });
+            entries_.emplace(position, fenceValue, std::move(object));
+        }
+    }
+
+    // Release every object whose fence value has been reached. Returns the number of released objects.
+    size_t ReleaseCompleted(uint64_t completedValue)
+    {
+        size_t numReleased = 0;
+        while (numReleased < entries_.size() && entries_[numReleased].first <= completedValue)
+        {
+            numReleased++;
+        }
+        entries_.erase(entries_.begin(), entries_.begin() + numReleased);
+        return numReleased;
+    }
+
+    // Only valid once the GPU is idle, e.g. after a queue flush on shutdown.
+    void ReleaseAll()
+    {
+        entries_.clear();
+    }
+
+    size_t GetNumPending() const
+    {
+        return entries_.size();
+    }
+
+    // Fence value that has to complete before everything currently pending can be released.
+    uint64_t GetLastFenceValue() const
+    {
+        return entries_.empty() ? 0 : entries_.back().first;
+    }
+
+private:
+    using Entry = std::pair<uint64_t, T>;
+    std::deque<Entry> entries_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,192 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "GraphicsUtil.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+//
+// CpuDescriptorAllocator
+//
+CpuDescriptorAllocator::CpuDescriptorAllocator(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescriptorsPerPage) :
+    device_(device),
+    type_(type),
+    descriptorSize_(device->GetDescriptorHandleIncrementSize(type)),
+    numDescriptorsPerPage_(numDescriptorsPerPage)
+{
+}
+
+DescriptorRange CpuDescriptorAllocator::Allocate(UINT count)
+{
+    // Every page would reject it, and a new page would be created on each call.
+    if (count == 0)
+    {
+        return DescriptorRange();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    UINT pageIndex = 0;
+    UINT64 offset = RangeAllocator::kInvalidOffset;
+    for (; pageIndex < pages_.size(); pageIndex++)
+    {
+        offset = pages_[pageIndex]->Allocator.Allocate(count);
+        if (offset != RangeAllocator::kInvalidOffset)
+        {
+            break;
+        }
+    }
+
+    if (offset == RangeAllocator::kInvalidOffset)
+    {
+        // Grow by one page, large enough for this request.
+        D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+        heapDesc.Type = type_;
+        heapDesc.NumDescriptors = std::max(count, numDescriptorsPerPage_);
+        heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+        ComPtr<ID3D12DescriptorHeap> heap;
+        ThrowIfFailed(device_->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap)), "CreateDescriptorHeap for descriptor page");
+
+        pages_.push_back(std::unique_ptr<Page>(new Page{ heap, heap->GetCPUDescriptorHandleForHeapStart(), RangeAllocator(heapDesc.NumDescriptors) }));
+        pageIndex = static_cast<UINT>(pages_.size() - 1);
+        offset = pages_[pageIndex]->Allocator.Allocate(count);
+    }
+
+    DescriptorRange range;
+    range.Cpu.ptr = pages_[pageIndex]->Start.ptr + static_cast<SIZE_T>(offset) * descriptorSize_;
+    range.Count = count;
+    range.DescriptorSize = descriptorSize_;
+    range.Page = pageIndex;
+    range.Offset = static_cast<UINT>(offset);
+    return range;
+}
+
+void CpuDescriptorAllocator::Free(DescriptorRange& range)
+{
+    if (!range.IsValid())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pages_[range.Page]->Allocator.Free(range.Offset, range.Count);
+    range = DescriptorRange();
+}
+
+size_t CpuDescriptorAllocator::GetNumPages() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pages_.size();
+}
+
+//
+// GpuDescriptorHeap
+//
+GpuDescriptorHeap::GpuDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numStaticDescriptors, UINT numDynamicDescriptors) :
+    device_(device),
+    type_(type),
+    descriptorSize_(device->GetDescriptorHandleIncrementSize(type)),
+    numStaticDescriptors_(numStaticDescriptors),
+    staticAllocator_(numStaticDescriptors),
+    dynamicRing_(numDynamicDescriptors)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = type;
+    heapDesc.NumDescriptors = numStaticDescriptors + numDynamicDescriptors;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    ThrowIfFailed(device_->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap_)), "CreateDescriptorHeap for shader visible descriptors");
+
+    cpuStart_ = heap_->GetCPUDescriptorHandleForHeapStart();
+    gpuStart_ = heap_->GetGPUDescriptorHandleForHeapStart();
+}
+
+DescriptorRange GpuDescriptorHeap::AllocateStatic(UINT count)
+{
+    if (count == 0)
+    {
+        return DescriptorRange();
+    }
+
+    const UINT64 offset = staticAllocator_.Allocate(count);
+    if (offset == RangeAllocator::kInvalidOffset)
+    {
+        throw std::runtime_error("Static region of the shader visible descriptor heap is full");
+    }
+    return MakeRange(static_cast<UINT>(offset), count);
+}
+
+void GpuDescriptorHeap::FreeStatic(DescriptorRange& range, UINT64 fenceValue)
+{
+    if (range.IsValid())
+    {
+        pendingStaticFrees_.emplace_back(fenceValue, range);
+        range = DescriptorRange();
+    }
+}
+
+DescriptorRange GpuDescriptorHeap::AllocateDynamic(UINT count)
+{
+    if (count == 0)
+    {
+        return DescriptorRange();
+    }
+
+    const UINT64 offset = dynamicRing_.Allocate(count, 1);
+    if (offset == RingAllocator::kInvalidOffset)
+    {
+        throw std::runtime_error("Dynamic region of the shader visible descriptor heap is full");
+    }
+    return MakeRange(numStaticDescriptors_ + static_cast<UINT>(offset), count);
+}
+
+DescriptorRange GpuDescriptorHeap::StageDynamic(const D3D12_CPU_DESCRIPTOR_HANDLE* sources, UINT count)
+{
+    if (count == 0)
+    {
+        return DescriptorRange();
+    }
+
+    DescriptorRange range = AllocateDynamic(count);
+    CopyTo(range, 0, sources, count);
+    return range;
+}
+
+void GpuDescriptorHeap::CopyTo(const DescriptorRange& destination, UINT destinationOffset, const D3D12_CPU_DESCRIPTOR_HANDLE* sources, UINT count)
+{
+    // One destination range, `count` source ranges of a single descriptor each.
+    sourceRangeSizes_.assign(count, 1);
+    D3D12_CPU_DESCRIPTOR_HANDLE destinationStart = destination.GetCpu(destinationOffset);
+    device_->CopyDescriptors(1, &destinationStart, &count, count, sources, sourceRangeSizes_.data(), type_);
+}
+
+void GpuDescriptorHeap::EndFrame(UINT64 fenceValue, UINT64 completedValue)
+{
+    dynamicRing_.FinishBatch(fenceValue);
+    dynamicRing_.ReleaseCompleted(completedValue);
+
+    while (!pendingStaticFrees_.empty() && pendingStaticFrees_.front().first <= completedValue)
+    {
+        const DescriptorRange& range = pendingStaticFrees_.front().second;
+        staticAllocator_.Free(range.Offset, range.Count);
+        pendingStaticFrees_.pop_front();
+    }
+}
+
+DescriptorRange GpuDescriptorHeap::MakeRange(UINT offset, UINT count) const
+{
+    DescriptorRange range;
+    range.Cpu.ptr = cpuStart_.ptr + static_cast<SIZE_T>(offset) * descriptorSize_;
+    range.Gpu.ptr = gpuStart_.ptr + static_cast<UINT64>(offset) * descriptorSize_;
+    range.Count = count;
+    range.DescriptorSize = descriptorSize_;
+    range.Offset = offset;
+    return range;
+}
+
+}; // namespace graphics
@@ -0,0 +1,137 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "RangeAllocator.h"
+#include "RingAllocator.h"
+
+namespace graphics
+{
+
+//
+// Contiguous descriptors handed out by CpuDescriptorAllocator or GpuDescriptorHeap.
+// Allocating 0 descriptors returns an invalid, empty range.
+//
+struct DescriptorRange
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE Cpu = {};
+    D3D12_GPU_DESCRIPTOR_HANDLE Gpu = {};
+    UINT Count = 0;
+    UINT DescriptorSize = 0;
+    UINT Page = 0;
+    UINT Offset = 0;
+
+    bool IsValid() const { return Count > 0; }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCpu(UINT index) const
+    {
+        return D3D12_CPU_DESCRIPTOR_HANDLE{ Cpu.ptr + static_cast<SIZE_T>(index) * DescriptorSize };
+    }
+
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGpu(UINT index) const
+    {
+        return D3D12_GPU_DESCRIPTOR_HANDLE{ Gpu.ptr + static_cast<UINT64>(index) * DescriptorSize };
+    }
+};
+
+//
+// Growable allocator of non-shader-visible descriptors (RTV, DSV, or CBV/SRV/UAV staging).
+//
+// Descriptors live in pages of fixed size heaps with free-list allocation inside each page, a new page is
+// created whenever the existing ones are full. Descriptors of these heaps are consumed when commands are
+// recorded or copied, so Free() takes effect immediately.
+//
+class CpuDescriptorAllocator
+{
+public:
+    CpuDescriptorAllocator(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescriptorsPerPage = 256);
+
+    CpuDescriptorAllocator(const CpuDescriptorAllocator&) = delete;
+    CpuDescriptorAllocator& operator=(const CpuDescriptorAllocator&) = delete;
+
+    DescriptorRange Allocate(UINT count = 1);
+    void Free(DescriptorRange& range);
+
+    D3D12_DESCRIPTOR_HEAP_TYPE GetType() const { return type_; }
+    UINT GetDescriptorSize() const { return descriptorSize_; }
+    size_t GetNumPages() const;
+
+private:
+    struct Page
+    {
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Heap;
+        D3D12_CPU_DESCRIPTOR_HANDLE Start;
+        RangeAllocator Allocator;
+    };
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    D3D12_DESCRIPTOR_HEAP_TYPE type_;
+    UINT descriptorSize_;
+    UINT numDescriptorsPerPage_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Page>> pages_;
+};
+
+//
+// The shader-visible CBV/SRV/UAV (or sampler) heap, split into two regions:
+// - A static region with free-list allocation for long lived tables. Frees are deferred until the GPU is done with them.
+// - A dynamic ring for per-frame tables, reclaimed as a whole once the frame's fence value completes.
+//
+// StageDynamic() gathers scattered CPU descriptors into a contiguous table with a single CopyDescriptors call.
+//
+class GpuDescriptorHeap
+{
+public:
+    GpuDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numStaticDescriptors, UINT numDynamicDescriptors);
+
+    GpuDescriptorHeap(const GpuDescriptorHeap&) = delete;
+    GpuDescriptorHeap& operator=(const GpuDescriptorHeap&) = delete;
+
+    ID3D12DescriptorHeap* GetHeap() const { return heap_.Get(); }
+    UINT GetDescriptorSize() const { return descriptorSize_; }
+
+    DescriptorRange AllocateStatic(UINT count);
+    // The range is reused once `fenceValue`, signaled after its last use, has completed.
+    void FreeStatic(DescriptorRange& range, UINT64 fenceValue);
+
+    // Throws when the dynamic ring is exhausted by frames still in flight.
+    DescriptorRange AllocateDynamic(UINT count);
+
+    // Copy `count` CPU descriptors into a fresh dynamic table, in one CopyDescriptors call.
+    DescriptorRange StageDynamic(const D3D12_CPU_DESCRIPTOR_HANDLE* sources, UINT count);
+
+    // Copy CPU descriptors into an already allocated range, in one CopyDescriptors call.
+    void CopyTo(const DescriptorRange& destination, UINT destinationOffset, const D3D12_CPU_DESCRIPTOR_HANDLE* sources, UINT count);
+
+    // Tag the dynamic tables of this frame with `fenceValue`, and reclaim everything the GPU has finished with.
+    void EndFrame(UINT64 fenceValue, UINT64 completedValue);
+
+private:
+    DescriptorRange MakeRange(UINT offset, UINT count) const;
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap_;
+    D3D12_DESCRIPTOR_HEAP_TYPE type_;
+    UINT descriptorSize_;
+    UINT numStaticDescriptors_;
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuStart_;
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuStart_;
+
+    RangeAllocator staticAllocator_;
+    std::deque<std::pair<UINT64, DescriptorRange>> pendingStaticFrees_;
+    RingAllocator dynamicRing_;
+
+    // Scratch storage for CopyDescriptors
+    std::vector<UINT> sourceRangeSizes_;
+};
+
+}; // namespace graphics
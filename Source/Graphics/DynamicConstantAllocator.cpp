@@ -0,0 +1,73 @@
+#include "DynamicConstantAllocator.h"
+
+#include <stdexcept>
+
+#include <d3dx12.h>
+
+#include "GraphicsUtil.h"
+
+namespace graphics
+{
+
+DynamicConstantAllocator::DynamicConstantAllocator(ID3D12Device* device, FenceTimeline& fenceTimeline, UINT numFrames, UINT64 sizePerFrame) :
+    fenceTimeline_(fenceTimeline),
+    cpuAddress_(nullptr),
+    regionFenceValues_(numFrames, 0),
+    regionIndex_(numFrames - 1)
+{
+    sizePerFrame = AlignUp(sizePerFrame, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    for (UINT index = 0; index < numFrames; index++)
+    {
+        regions_.emplace_back(sizePerFrame * index, sizePerFrame);
+    }
+
+    CD3DX12_HEAP_PROPERTIES uploadProperty(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sizePerFrame * numFrames);
+    ThrowIfFailed(device->CreateCommittedResource(&uploadProperty, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&buffer_)), "CreateCommittedResource for dynamic constants");
+
+    // Map and keep it mapped for the lifetime of the resource.
+    CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(buffer_->Map(0, &readRange, reinterpret_cast<void**>(&cpuAddress_)), "Map dynamic constants");
+    gpuAddress_ = buffer_->GetGPUVirtualAddress();
+}
+
+DynamicConstantAllocator::~DynamicConstantAllocator()
+{
+    buffer_->Unmap(0, nullptr);
+}
+
+void DynamicConstantAllocator::BeginFrame()
+{
+    regionIndex_ = (regionIndex_ + 1) % static_cast<UINT>(regions_.size());
+
+    // Normally already passed, the frame loop throttles on the same fence.
+    fenceTimeline_.Wait(regionFenceValues_[regionIndex_]);
+    regions_[regionIndex_].Reset();
+}
+
+void DynamicConstantAllocator::EndFrame(UINT64 fenceValue)
+{
+    regionFenceValues_[regionIndex_] = fenceValue;
+}
+
+DynamicConstantAllocator::Allocation DynamicConstantAllocator::Allocate(UINT64 size)
+{
+    const UINT64 offset = regions_[regionIndex_].Allocate(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    if (offset == LinearAllocator::kInvalidOffset)
+    {
+        throw std::runtime_error("Dynamic constant allocator is out of space for this frame");
+    }
+
+    Allocation allocation;
+    allocation.CpuAddress = cpuAddress_ + offset;
+    allocation.GpuAddress = gpuAddress_ + offset;
+    return allocation;
+}
+
+UINT64 DynamicConstantAllocator::GetUsedSize() const
+{
+    return regions_[regionIndex_].GetUsedSize();
+}
+
+}; // namespace graphics
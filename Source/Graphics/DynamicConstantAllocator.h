@@ -0,0 +1,70 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <cstring>
+#include <vector>
+
+#include "LinearAllocator.h"
+#include "FenceTimeline.h"
+
+namespace graphics
+{
+
+//
+// Per-frame constants without synchronization.
+//
+// One persistently mapped upload buffer is split into `numFrames` linear regions. Every frame writes its
+// constants into fresh 256-byte aligned slices of its own region and binds them as root CBVs, so data still
+// read by earlier frames in flight is never overwritten. A region is reused only after the fence value passed
+// to EndFrame() for it has completed.
+//
+class DynamicConstantAllocator
+{
+public:
+    struct Allocation
+    {
+        UINT8* CpuAddress;
+        D3D12_GPU_VIRTUAL_ADDRESS GpuAddress;
+    };
+
+    DynamicConstantAllocator(ID3D12Device* device, FenceTimeline& fenceTimeline, UINT numFrames, UINT64 sizePerFrame);
+    ~DynamicConstantAllocator();
+
+    DynamicConstantAllocator(const DynamicConstantAllocator&) = delete;
+    DynamicConstantAllocator& operator=(const DynamicConstantAllocator&) = delete;
+
+    // Move on to the next region, blocking only if the GPU still reads it from `numFrames` frames ago.
+    void BeginFrame();
+
+    // `fenceValue` is signaled after the last command list which reads this frame's constants.
+    void EndFrame(UINT64 fenceValue);
+
+    // Throws when the frame's region is exhausted.
+    Allocation Allocate(UINT64 size);
+
+    template <typename T>
+    D3D12_GPU_VIRTUAL_ADDRESS Push(const T& data)
+    {
+        Allocation allocation = Allocate(sizeof(T));
+        memcpy(allocation.CpuAddress, &data, sizeof(T));
+        return allocation.GpuAddress;
+    }
+
+    UINT64 GetUsedSize() const;
+
+private:
+    FenceTimeline& fenceTimeline_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> buffer_;
+    UINT8* cpuAddress_;
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress_;
+
+    std::vector<LinearAllocator> regions_;
+    std::vector<UINT64> regionFenceValues_;
+    UINT regionIndex_;
+};
+
+}; // namespace graphics
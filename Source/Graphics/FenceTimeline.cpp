@@ -0,0 +1,178 @@
+#include "FenceTimeline.h"
+
+#include <memory>
+#include <vector>
+#include <limits>
+
+namespace graphics
+{
+
+//
+// SimulatedFenceSource
+//
+SimulatedFenceSource::SimulatedFenceSource(uint64_t initialValue) :
+    completedValue_(initialValue),
+    interrupted_(false)
+{
+}
+
+void SimulatedFenceSource::Signal(uint64_t value)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (value > completedValue_)
+        {
+            completedValue_ = value;
+        }
+    }
+    condition_.notify_all();
+}
+
+uint64_t SimulatedFenceSource::GetCompletedValue() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return completedValue_;
+}
+
+void SimulatedFenceSource::WaitForValue(uint64_t value)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this, value]() { return completedValue_ >= value || interrupted_; });
+    interrupted_ = false;
+}
+
+void SimulatedFenceSource::Interrupt()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupted_ = true;
+    }
+    condition_.notify_all();
+}
+
+//
+// FenceTimeline
+//
+static const uint64_t kNotWaiting = std::numeric_limits<uint64_t>::max();
+
+FenceTimeline::FenceTimeline(FenceSource& source) :
+    source_(source),
+    waitingValue_(kNotWaiting),
+    quit_(false)
+{
+    waiter_ = std::thread(&FenceTimeline::WaiterThread, this);
+}
+
+FenceTimeline::~FenceTimeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    condition_.notify_all();
+    source_.Interrupt();
+
+    waiter_.join();
+}
+
+uint64_t FenceTimeline::GetCompletedValue() const
+{
+    return source_.GetCompletedValue();
+}
+
+bool FenceTimeline::IsCompleted(uint64_t value) const
+{
+    return source_.GetCompletedValue() >= value;
+}
+
+void FenceTimeline::OnCompletion(uint64_t value, std::function<void()> callback)
+{
+    if (IsCompleted(value))
+    {
+        callback();
+        return;
+    }
+
+    bool interrupt = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.emplace(value, std::move(callback));
+
+        // The waiter is sleeping on a later value, wake it up so that it re-arms on this one.
+        interrupt = waitingValue_ != kNotWaiting && value < waitingValue_;
+    }
+    condition_.notify_one();
+
+    if (interrupt)
+    {
+        source_.Interrupt();
+    }
+}
+
+std::future<void> FenceTimeline::WhenCompleted(uint64_t value)
+{
+    std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+    std::future<void> future = promise->get_future();
+    OnCompletion(value, [promise]() { promise->set_value(); });
+    return future;
+}
+
+void FenceTimeline::Wait(uint64_t value)
+{
+    if (!IsCompleted(value))
+    {
+        WhenCompleted(value).wait();
+    }
+}
+
+size_t FenceTimeline::GetNumPending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+void FenceTimeline::WaiterThread()
+{
+    std::vector<std::function<void()>> completedCallbacks;
+
+    while (true)
+    {
+        uint64_t valueToWaitFor = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return quit_ || !pending_.empty(); });
+            if (quit_)
+            {
+                break;
+            }
+
+            valueToWaitFor = pending_.begin()->first;
+            waitingValue_ = valueToWaitFor;
+        }
+
+        // Returns when the value is reached, or earlier when interrupted by a smaller value or by shutdown.
+        source_.WaitForValue(valueToWaitFor);
+
+        // Collect everything the GPU has passed, in fence order, and dispatch outside of the lock.
+        const uint64_t completedValue = source_.GetCompletedValue();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            waitingValue_ = kNotWaiting;
+
+            auto end = pending_.upper_bound(completedValue);
+            for (auto it = pending_.begin(); it != end; ++it)
+            {
+                completedCallbacks.push_back(std::move(it->second));
+            }
+            pending_.erase(pending_.begin(), end);
+        }
+
+        for (auto& callback : completedCallbacks)
+        {
+            callback();
+        }
+        completedCallbacks.clear();
+    }
+}
+
+}; // namespace graphics
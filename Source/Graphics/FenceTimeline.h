@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace graphics
+{
+
+//
+// Source of GPU progress observed by a FenceTimeline.
+// D3D12FenceSource wraps an ID3D12Fence, SimulatedFenceSource is signaled from the CPU.
+//
+class FenceSource
+{
+public:
+    virtual ~FenceSource() {}
+
+    virtual uint64_t GetCompletedValue() const = 0;
+
+    // Block until the completed value reaches `value` or Interrupt() is called.
+    virtual void WaitForValue(uint64_t value) = 0;
+
+    // Wake up a thread blocked in WaitForValue().
+    virtual void Interrupt() = 0;
+};
+
+class SimulatedFenceSource : public FenceSource
+{
+public:
+    explicit SimulatedFenceSource(uint64_t initialValue = 0);
+
+    // Emulates ID3D12CommandQueue::Signal() reaching the GPU.
+    void Signal(uint64_t value);
+
+    virtual uint64_t GetCompletedValue() const override;
+    virtual void WaitForValue(uint64_t value) override;
+    virtual void Interrupt() override;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    uint64_t completedValue_;
+    bool interrupted_;
+};
+
+//
+// Timeline of fence values with asynchronous completion notification.
+//
+// A single waiter thread sleeps on the smallest pending value and dispatches every
+// callback whose value has been reached. Callbacks run on the waiter thread, so they
+// should be short and must not call back into the timeline's blocking Wait().
+//
+class FenceTimeline
+{
+public:
+    explicit FenceTimeline(FenceSource& source);
+    ~FenceTimeline();
+
+    FenceTimeline(const FenceTimeline&) = delete;
+    FenceTimeline& operator=(const FenceTimeline&) = delete;
+
+    uint64_t GetCompletedValue() const;
+    bool IsCompleted(uint64_t value) const;
+
+    // Invoke `callback` once the fence reaches `value`. Already completed values are dispatched immediately on the caller's thread.
+    void OnCompletion(uint64_t value, std::function<void()> callback);
+
+    // Future which becomes ready once the fence reaches `value`.
+    std::future<void> WhenCompleted(uint64_t value);
+
+    // Block the calling thread until the fence reaches `value`.
+    void Wait(uint64_t value);
+
+    size_t GetNumPending() const;
+
+private:
+    void WaiterThread();
+
+    FenceSource& source_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::multimap<uint64_t, std::function<void()>> pending_;
+    uint64_t waitingValue_;
+    bool quit_;
+    std::thread waiter_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,193 @@
+#include "FileWatcher.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace graphics
+{
+
+#ifdef _WIN32
+
+FileWatcher::FileWatcher(const std::string& directory) :
+    directory_(directory),
+    directoryHandle_(INVALID_HANDLE_VALUE),
+    stopEvent_(nullptr)
+{
+    directoryHandle_ = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (directoryHandle_ == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Can't watch directory " + directory);
+    }
+
+    stopEvent_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (stopEvent_ == nullptr)
+    {
+        CloseHandle(directoryHandle_);
+        throw std::runtime_error("CreateEvent for file watcher failed");
+    }
+
+    thread_ = std::thread(&FileWatcher::WatchThread, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    SetEvent(stopEvent_);
+    thread_.join();
+    CloseHandle(stopEvent_);
+    CloseHandle(directoryHandle_);
+}
+
+void FileWatcher::WatchThread()
+{
+    HANDLE ioEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+    // FILE_NOTIFY_INFORMATION records have to be DWORD aligned.
+    DWORD buffer[16 * 1024];
+
+    for (;;)
+    {
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = ioEvent;
+        if (!ReadDirectoryChangesW(directoryHandle_, buffer, sizeof(buffer), FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, nullptr, &overlapped, nullptr))
+        {
+            break;
+        }
+
+        HANDLE handles[] = { stopEvent_, ioEvent };
+        DWORD bytesReturned = 0;
+        if (WaitForMultipleObjects(_countof(handles), handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+        {
+            // Stopping, the pending read has to finish before the buffer goes away.
+            CancelIoEx(directoryHandle_, &overlapped);
+            GetOverlappedResult(directoryHandle_, &overlapped, &bytesReturned, TRUE);
+            break;
+        }
+
+        if (!GetOverlappedResult(directoryHandle_, &overlapped, &bytesReturned, FALSE))
+        {
+            break;
+        }
+
+        if (bytesReturned == 0)
+        {
+            // The system buffer overflowed and the notifications are lost.
+            AddChange(std::string());
+            continue;
+        }
+
+        const uint8_t* record = reinterpret_cast<const uint8_t*>(buffer);
+        for (;;)
+        {
+            const FILE_NOTIFY_INFORMATION* information = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+            const int nameLength = static_cast<int>(information->FileNameLength / sizeof(WCHAR));
+            const int length = WideCharToMultiByte(CP_UTF8, 0, information->FileName, nameLength, nullptr, 0, nullptr, nullptr);
+            std::string file(static_cast<size_t>(length), '\0');
+            WideCharToMultiByte(CP_UTF8, 0, information->FileName, nameLength, &file[0], length, nullptr, nullptr);
+            AddChange(file);
+
+            if (information->NextEntryOffset == 0)
+            {
+                break;
+            }
+            record += information->NextEntryOffset;
+        }
+    }
+
+    CloseHandle(ioEvent);
+}
+
+#else
+
+FileWatcher::FileWatcher(const std::string& directory) :
+    directory_(directory),
+    inotify_(-1),
+    stopping_(false)
+{
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ < 0)
+    {
+        throw std::runtime_error("inotify_init1 for file watcher failed");
+    }
+
+    if (inotify_add_watch(inotify_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0)
+    {
+        close(inotify_);
+        throw std::runtime_error("Can't watch directory " + directory);
+    }
+
+    thread_ = std::thread(&FileWatcher::WatchThread, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    stopping_ = true;
+    thread_.join();
+    close(inotify_);
+}
+
+void FileWatcher::WatchThread()
+{
+    alignas(inotify_event) char buffer[16 * 1024];
+
+    while (!stopping_)
+    {
+        // Wake up now and then to notice stopping_.
+        pollfd descriptor = { inotify_, POLLIN, 0 };
+        if (poll(&descriptor, 1, 100) <= 0)
+        {
+            continue;
+        }
+
+        ssize_t size = 0;
+        while ((size = read(inotify_, buffer, sizeof(buffer))) > 0)
+        {
+            for (const char* record = buffer; record < buffer + size; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(record);
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    AddChange(std::string());
+                }
+                else if (event->len > 0)
+                {
+                    AddChange(event->name);
+                }
+                record += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+}
+
+#endif
+
+bool FileWatcher::GetChanges(std::vector<std::string>& files)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (changes_.empty())
+    {
+        return false;
+    }
+
+    files.insert(files.end(), changes_.begin(), changes_.end());
+    changes_.clear();
+    return true;
+}
+
+void FileWatcher::AddChange(const std::string& file)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_.insert(file);
+}
+
+}; // namespace graphics
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Reports the files changed in a directory, ReadDirectoryChangesW on Windows and inotify elsewhere.
+//
+// Notifications are collected by a background thread, GetChanges() hands out the names gathered since the previous
+// call without blocking. Editors tend to write a file several times when saving, the names are deduplicated so a
+// burst of writes shows up once. Only the directory itself is watched, not its subdirectories.
+//
+class FileWatcher
+{
+public:
+    // Throws when the directory can't be watched.
+    explicit FileWatcher(const std::string& directory);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Append the names, relative to the directory, of the files changed since the previous call. Returns false if nothing changed.
+    // Notifications lost to an overflow are reported as an empty name, meaning that anything may have changed.
+    bool GetChanges(std::vector<std::string>& files);
+
+    const std::string& GetDirectory() const { return directory_; }
+
+private:
+    void WatchThread();
+    void AddChange(const std::string& file);
+
+    std::string directory_;
+
+    std::mutex mutex_;
+    std::set<std::string> changes_;
+
+#ifdef _WIN32
+    void* directoryHandle_;
+    void* stopEvent_;
+#else
+    int inotify_;
+    std::atomic<bool> stopping_;
+#endif
+
+    // Declared last, started once everything above is initialized.
+    std::thread thread_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,232 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+#include <d3dx12.h>
+
+#include "GraphicsUtil.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+namespace
+{
+
+// The buffer's resting state while drawing, both are read-only so they combine.
+const D3D12_RESOURCE_STATES kGeometryStates = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | D3D12_RESOURCE_STATE_INDEX_BUFFER;
+
+UINT GetIndexSize(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R16_UINT:
+        return 2;
+    case DXGI_FORMAT_R32_UINT:
+        return 4;
+    default:
+        throw std::runtime_error("Index ranges are either DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT");
+    }
+}
+
+};
+
+GeometryArena::GeometryArena(ID3D12Device* device, UINT64 size) :
+    device_(device),
+    allocator_(size)
+{
+    // Views address the buffer with 32-bit sizes.
+    if (size == 0 || size > UINT_MAX)
+    {
+        throw std::runtime_error("Geometry arena size must be within (0, 4GB)");
+    }
+    buffer_ = CreateBuffer();
+}
+
+GeometryArena::Handle GeometryArena::AllocateVertices(UINT numVertices, UINT stride)
+{
+    // Starting at a multiple of the stride, the range is addressed by a base vertex into the shared view.
+    return Allocate(numVertices, stride, stride);
+}
+
+GeometryArena::Handle GeometryArena::AllocateIndices(UINT numIndices, DXGI_FORMAT format)
+{
+    const UINT indexSize = GetIndexSize(format);
+    return Allocate(numIndices, indexSize, indexSize);
+}
+
+GeometryArena::Handle GeometryArena::Allocate(UINT numElements, UINT elementSize, UINT64 alignment)
+{
+    if (numElements == 0 || elementSize == 0)
+    {
+        return kInvalidHandle;
+    }
+
+    const TlsfAllocator::Allocation allocation = allocator_.Allocate(static_cast<UINT64>(numElements) * elementSize, alignment);
+    if (!allocation.IsValid())
+    {
+        return kInvalidHandle;
+    }
+
+    Handle handle;
+    if (!unusedHandles_.empty())
+    {
+        handle = unusedHandles_.back();
+        unusedHandles_.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(ranges_.size());
+        ranges_.emplace_back();
+    }
+    ranges_[handle] = { allocation, elementSize, numElements };
+    return handle;
+}
+
+void GeometryArena::Free(Handle handle, UINT64 fenceValue)
+{
+    if (handle == kInvalidHandle)
+    {
+        return;
+    }
+    pendingFrees_.emplace_back(fenceValue, handle);
+}
+
+void GeometryArena::ReleaseCompleted(UINT64 completedValue)
+{
+    // Frees come from the render thread in fence order.
+    while (!pendingFrees_.empty() && pendingFrees_.front().first <= completedValue)
+    {
+        const Handle handle = pendingFrees_.front().second;
+        pendingFrees_.pop_front();
+
+        allocator_.Free(ranges_[handle].Allocation);
+        ranges_[handle] = {};
+        unusedHandles_.push_back(handle);
+    }
+}
+
+void GeometryArena::Write(Handle handle, const void* data, UploadRing& uploadRing)
+{
+    if (handle >= ranges_.size() || !ranges_[handle].Allocation.IsValid())
+    {
+        throw std::runtime_error("Write to an invalid geometry arena handle");
+    }
+
+    // Left in COPY_DEST by the upload list, from where it decays to COMMON once the list has executed.
+    const Range& range = ranges_[handle];
+    uploadRing.CopyBuffer(buffer_.Get(), range.Allocation.Offset, data, range.Allocation.Size, D3D12_RESOURCE_STATE_COPY_DEST);
+}
+
+D3D12_VERTEX_BUFFER_VIEW GeometryArena::GetVertexBufferView(UINT stride) const
+{
+    D3D12_VERTEX_BUFFER_VIEW view;
+    view.BufferLocation = buffer_->GetGPUVirtualAddress();
+    view.SizeInBytes = static_cast<UINT>(allocator_.GetSize());
+    view.StrideInBytes = stride;
+    return view;
+}
+
+D3D12_INDEX_BUFFER_VIEW GeometryArena::GetIndexBufferView(DXGI_FORMAT format) const
+{
+    D3D12_INDEX_BUFFER_VIEW view;
+    view.BufferLocation = buffer_->GetGPUVirtualAddress();
+    view.SizeInBytes = static_cast<UINT>(allocator_.GetSize());
+    view.Format = format;
+    return view;
+}
+
+UINT GeometryArena::GetFirstElement(Handle handle) const
+{
+    const Range& range = ranges_[handle];
+    return static_cast<UINT>(range.Allocation.Offset / range.ElementSize);
+}
+
+UINT GeometryArena::GetNumElements(Handle handle) const
+{
+    return ranges_[handle].NumElements;
+}
+
+void GeometryArena::Defragment(ID3D12GraphicsCommandList* commandList, DeferredReleaseQueue<ComPtr<IUnknown>>& releaseQueue, UINT64 fenceValue)
+{
+    // Pending frees are only read from the old buffer, which outlives them, so they are dropped right away.
+    ReleaseCompleted(~0ull);
+
+    // Reallocated in address order from the empty allocator, the ranges end up packed at the front of the new buffer,
+    // and runs of neighbouring ranges which stay neighbours are copied at once.
+    std::vector<Handle> handles;
+    for (Handle handle = 0; handle < static_cast<Handle>(ranges_.size()); handle++)
+    {
+        if (ranges_[handle].Allocation.IsValid())
+        {
+            handles.push_back(handle);
+        }
+    }
+    std::sort(handles.begin(), handles.end(),
+        [this](Handle left, Handle right) { return ranges_[left].Allocation.Offset < ranges_[right].Allocation.Offset; });
+
+    ComPtr<ID3D12Resource> buffer = CreateBuffer();
+    allocator_.Reset();
+
+    UINT64 sourceOffset = 0;
+    UINT64 destinationOffset = 0;
+    UINT64 copySize = 0;
+    for (Handle handle : handles)
+    {
+        Range& range = ranges_[handle];
+        const TlsfAllocator::Allocation allocation = allocator_.Allocate(range.Allocation.Size, range.ElementSize);
+        if (!allocation.IsValid())
+        {
+            throw std::runtime_error("Geometry arena ranges don't fit after defragmentation");
+        }
+        if (copySize > 0 && (sourceOffset + copySize != range.Allocation.Offset || destinationOffset + copySize != allocation.Offset))
+        {
+            commandList->CopyBufferRegion(buffer.Get(), destinationOffset, buffer_.Get(), sourceOffset, copySize);
+            copySize = 0;
+        }
+        if (copySize == 0)
+        {
+            sourceOffset = range.Allocation.Offset;
+            destinationOffset = allocation.Offset;
+        }
+        copySize += range.Allocation.Size;
+        range.Allocation = allocation;
+    }
+    if (copySize > 0)
+    {
+        commandList->CopyBufferRegion(buffer.Get(), destinationOffset, buffer_.Get(), sourceOffset, copySize);
+
+        // Promoted to COPY_DEST by the copies above.
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(buffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, kGeometryStates);
+        commandList->ResourceBarrier(1, &barrier);
+    }
+
+    releaseQueue.Retire(std::move(buffer_), fenceValue);
+    buffer_ = std::move(buffer);
+}
+
+GeometryArena::Statistics GeometryArena::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.Size = allocator_.GetSize();
+    statistics.UsedSize = allocator_.GetSize() - allocator_.GetFreeSize();
+    statistics.LargestFreeSize = allocator_.GetLargestFreeSize();
+    statistics.NumRanges = allocator_.GetNumAllocations();
+    statistics.NumFreeRanges = allocator_.GetNumFreeRanges();
+    return statistics;
+}
+
+ComPtr<ID3D12Resource> GeometryArena::CreateBuffer() const
+{
+    ComPtr<ID3D12Resource> buffer;
+    CD3DX12_HEAP_PROPERTIES defaultProperty(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(allocator_.GetSize());
+    ThrowIfFailed(device_->CreateCommittedResource(&defaultProperty, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer)), "CreateCommittedResource for geometry arena");
+    return buffer;
+}
+
+}; // namespace graphics
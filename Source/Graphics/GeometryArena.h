@@ -0,0 +1,99 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <deque>
+#include <vector>
+
+#include "TlsfAllocator.h"
+#include "DeferredReleaseQueue.h"
+#include "UploadRing.h"
+
+namespace graphics
+{
+
+//
+// One default heap buffer holding the vertices and indices of many meshes.
+//
+// Ranges are sub-allocated with a TlsfAllocator. Vertex ranges start at a multiple of their stride, so a single
+// view per stride covers every mesh and a draw selects its mesh with the base vertex; index ranges work the same
+// way with the start index. Meshes are referred to by handles, which stay valid when Defragment() moves them.
+//
+// The buffer is created in D3D12_RESOURCE_STATE_COMMON and relies on the implicit state promotion and decay of
+// buffers: copies promote it to COPY_DEST, draws to the vertex and index buffer states, and it decays back to
+// COMMON at the end of every ExecuteCommandLists(), so neither uploads nor draws need barriers for it.
+//
+class GeometryArena
+{
+public:
+    using Handle = uint32_t;
+    static const Handle kInvalidHandle = ~0u;
+
+    struct Statistics
+    {
+        UINT64 Size;
+        UINT64 UsedSize;
+        UINT64 LargestFreeSize;
+        UINT NumRanges;
+        UINT NumFreeRanges;
+    };
+
+    GeometryArena(ID3D12Device* device, UINT64 size);
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    // Returns kInvalidHandle when the arena is full or too fragmented, see Defragment().
+    Handle AllocateVertices(UINT numVertices, UINT stride);
+    // `format` is DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT.
+    Handle AllocateIndices(UINT numIndices, DXGI_FORMAT format);
+
+    // The range can be reused once the GPU has passed `fenceValue`, see ReleaseCompleted().
+    void Free(Handle handle, UINT64 fenceValue);
+    void ReleaseCompleted(UINT64 completedValue);
+
+    // Stage the whole range through `uploadRing`, `data` holds the number of elements it was allocated with.
+    void Write(Handle handle, const void* data, UploadRing& uploadRing);
+
+    // Views over the whole buffer, valid until the next Defragment().
+    D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView(UINT stride) const;
+    D3D12_INDEX_BUFFER_VIEW GetIndexBufferView(DXGI_FORMAT format) const;
+
+    // StartVertexLocation / BaseVertexLocation of a vertex range, StartIndexLocation of an index range.
+    UINT GetFirstElement(Handle handle) const;
+    UINT GetNumElements(Handle handle) const;
+
+    // Move every range to the front of a new buffer, recording the copies into `commandList`. The new buffer is left
+    // in the vertex and index buffer states, so draws may follow in the same list. The old buffer is retired with
+    // `fenceValue`, which has to be signaled after `commandList`. Views taken before have to be taken again.
+    void Defragment(ID3D12GraphicsCommandList* commandList, DeferredReleaseQueue<Microsoft::WRL::ComPtr<IUnknown>>& releaseQueue, UINT64 fenceValue);
+
+    // Worth a Defragment() when much of the free space is in ranges too small for the next allocation.
+    Statistics GetStatistics() const;
+
+    ID3D12Resource* GetResource() const { return buffer_.Get(); }
+
+private:
+    struct Range
+    {
+        TlsfAllocator::Allocation Allocation;
+        UINT ElementSize;
+        UINT NumElements;
+    };
+
+    Handle Allocate(UINT numElements, UINT elementSize, UINT64 alignment);
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer() const;
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> buffer_;
+    TlsfAllocator allocator_;
+
+    std::vector<Range> ranges_;
+    std::vector<Handle> unusedHandles_;
+    std::deque<std::pair<UINT64, Handle>> pendingFrees_;
+};
+
+}; // namespace graphics
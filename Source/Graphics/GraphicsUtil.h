@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+
+#include <d3d12.h>
+
+namespace graphics
+{
+
+inline std::string HrToString(HRESULT hr, const std::string& context)
+{
+    char str[64] = {};
+    sprintf_s(str, "HRESULT of 0x%08X", static_cast<unsigned int>(hr));
+    std::string result(str);
+    if (context.length() > 0)
+    {
+        result += ": ";
+        result += context;
+    }
+    return result;
+}
+
+// Helper class for COM exceptions
+// https://docs.microsoft.com/en-us/windows/win32/seccrypto/common-hresult-values
+// https://docs.microsoft.com/en-us/windows/win32/direct3ddxgi/dxgi-error
+class HrException : public std::runtime_error
+{
+public:
+    HrException(HRESULT hr, const std::string& context) : std::runtime_error(HrToString(hr, context)), result_(hr) {}
+    HRESULT Error() const { return result_; }
+
+private:
+    const HRESULT result_;
+};
+
+// Helper utility converts D3D API failures into exceptions.
+inline void ThrowIfFailed(HRESULT hr, const std::string& context = "")
+{
+    if (FAILED(hr))
+    {
+        throw HrException(hr, context);
+    }
+}
+
+}; // namespace graphics
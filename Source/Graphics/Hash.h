@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace graphics
+{
+
+//
+// 64-bit FNV-1a, stable across runs, processes and platforms, used for cache keys that are persisted.
+//
+// Only feed it values without padding bytes. Structures with padding have to be appended field by field,
+// their padding is left uninitialized by most desc helpers and would make the hash non-deterministic.
+//
+class Hasher
+{
+public:
+    Hasher& Append(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t index = 0; index < size; index++)
+        {
+            state_ = (state_ ^ bytes[index]) * kPrime;
+        }
+        return *this;
+    }
+
+    template <typename T>
+    Hasher& AppendValue(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be hashed as bytes");
+        return Append(&value, sizeof(T));
+    }
+
+    // The length goes in too, so that consecutive strings can't run into each other.
+    Hasher& AppendString(const char* string)
+    {
+        const uint64_t length = string != nullptr ? strlen(string) : 0;
+        AppendValue(length);
+        return Append(string, static_cast<size_t>(length));
+    }
+
+    uint64_t Get() const { return state_; }
+
+private:
+    static const uint64_t kOffsetBasis = 0xcbf29ce484222325ull;
+    static const uint64_t kPrime = 0x100000001b3ull;
+
+    uint64_t state_ = kOffsetBasis;
+};
+
+inline uint64_t HashBytes(const void* data, size_t size)
+{
+    return Hasher().Append(data, size).Get();
+}
+
+}; // namespace graphics
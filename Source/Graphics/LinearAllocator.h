@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Alignment.h"
+
+namespace graphics
+{
+
+//
+// Bump allocator over the byte range [begin, begin + size), released all at once by Reset().
+//
+class LinearAllocator
+{
+public:
+    static const uint64_t kInvalidOffset = ~0ull;
+
+    LinearAllocator(uint64_t begin = 0, uint64_t size = 0) :
+        begin_(begin),
+        size_(size),
+        head_(0)
+    {
+    }
+
+    // Returns an absolute offset, or kInvalidOffset when the range is exhausted.
+    uint64_t Allocate(uint64_t size, uint64_t alignment)
+    {
+        const uint64_t offset = AlignUp(begin_ + head_, alignment) - begin_;
+        if (offset + size > size_)
+        {
+            return kInvalidOffset;
+        }
+
+        head_ = offset + size;
+        return begin_ + offset;
+    }
+
+    void Reset()
+    {
+        head_ = 0;
+    }
+
+    uint64_t GetBegin() const { return begin_; }
+    uint64_t GetSize() const { return size_; }
+    uint64_t GetUsedSize() const { return head_; }
+
+private:
+    uint64_t begin_;
+    uint64_t size_;
+    uint64_t head_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,130 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace graphics
+{
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() :
+    data_(nullptr),
+    size_(0),
+    mapping_(nullptr)
+{
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The mapping keeps the file open, the file handle isn't needed any more.
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping_ == nullptr)
+    {
+        return false;
+    }
+
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr)
+    {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+        return false;
+    }
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr)
+    {
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapping_ = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile() :
+    data_(nullptr),
+    size_(0)
+{
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    data_ = static_cast<const uint8_t*>(data);
+    size_ = static_cast<size_t>(fileStat.st_size);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+}; // namespace graphics
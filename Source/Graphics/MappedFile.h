@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace graphics
+{
+
+//
+// Read-only memory mapping of a whole file, CreateFileMapping on Windows and mmap elsewhere.
+//
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Fails for missing and empty files.
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return data_ != nullptr; }
+    const uint8_t* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+#ifdef _WIN32
+    void* mapping_;
+#endif
+};
+
+}; // namespace graphics
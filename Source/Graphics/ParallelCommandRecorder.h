@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "CommandListPool.h"
+#include "ThreadPool.h"
+
+namespace graphics
+{
+
+//
+// Records the command lists of a frame on worker threads and executes them in one call.
+//
+// Every Record() call reserves the next slot and records into its own list from the CommandListPool, either
+// on the thread pool or, without one, right away on the calling thread. Execute() waits for the recordings
+// and hands the lists to the backend in slot order, so the submission is the same whichever thread finished
+// first. Recording functions may throw, Execute() rethrows the exception of the first failed slot after
+// discarding the lists of the frame.
+//
+// Begin(), Record() and Execute() are called from one thread, the render thread. `Backend` additionally needs
+//   void Execute(List* const* lists, size_t count);   // One ExecuteCommandLists for all of them.
+//
+template <typename Backend>
+class ParallelCommandRecorder
+{
+public:
+    using List = typename Backend::List;
+    using RecordFunction = std::function<void(List& commandList)>;
+
+    // Without a thread pool every list is recorded inline by Record().
+    ParallelCommandRecorder(CommandListPool<Backend>& pool, ThreadPool* threadPool) :
+        pool_(pool),
+        threadPool_(threadPool),
+        completedValue_(0)
+    {
+    }
+
+    ~ParallelCommandRecorder()
+    {
+        // The pending recordings capture this object.
+        WaitForRecordings();
+    }
+
+    ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+    ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+    // Start a frame. `completedValue` is the fence value the GPU has reached, contexts retired up to it are reused.
+    void Begin(uint64_t completedValue)
+    {
+        if (!slots_.empty())
+        {
+            throw std::runtime_error("The lists recorded for the previous frame haven't been executed");
+        }
+        completedValue_ = completedValue;
+        slots_.clear();
+    }
+
+    // Reserve the next slot and record it with `record`. Returns the slot index, which is its position in the submission.
+    size_t Record(RecordFunction record)
+    {
+        const size_t index = slots_.size();
+        slots_.push_back(std::make_shared<Slot>());
+        std::shared_ptr<Slot> slot = slots_.back();
+
+        auto task = [this, slot, record]()
+            {
+                try
+                {
+                    slot->Context = pool_.Acquire(completedValue_);
+                    record(slot->Context->CommandList);
+                    pool_.GetBackend().Close(slot->Context->CommandList);
+                    slot->Closed = true;
+                }
+                catch (...)
+                {
+                    slot->Error = std::current_exception();
+                }
+                slot->Done.set_value();
+            };
+
+        slot->Finished = slot->Done.get_future();
+        if (threadPool_ != nullptr)
+        {
+            threadPool_->Submit(task);
+        }
+        else
+        {
+            task();
+        }
+        return index;
+    }
+
+    // Execute every list recorded since Begin() in slot order, `fenceValue` is signaled right after them.
+    // Returns the number of executed lists.
+    size_t Execute(uint64_t fenceValue)
+    {
+        WaitForRecordings();
+
+        std::exception_ptr error;
+        for (const std::shared_ptr<Slot>& slot : slots_)
+        {
+            if (slot->Error && !error)
+            {
+                error = slot->Error;
+            }
+        }
+
+        if (error)
+        {
+            for (const std::shared_ptr<Slot>& slot : slots_)
+            {
+                if (slot->Context != nullptr)
+                {
+                    if (slot->Closed)
+                    {
+                        // Closed lists were never executed, they can be reset right away.
+                        pool_.Retire(slot->Context, 0);
+                    }
+                    else
+                    {
+                        // A list whose recording or Close() failed may fail to close again, the first error is
+                        // the one reported and the context is back in the pool either way.
+                        try
+                        {
+                            pool_.Discard(slot->Context);
+                        }
+                        catch (...)
+                        {
+                        }
+                    }
+                }
+            }
+            slots_.clear();
+            std::rethrow_exception(error);
+        }
+
+        lists_.clear();
+        for (const std::shared_ptr<Slot>& slot : slots_)
+        {
+            lists_.push_back(&slot->Context->CommandList);
+        }
+        if (!lists_.empty())
+        {
+            pool_.GetBackend().Execute(lists_.data(), lists_.size());
+        }
+
+        for (const std::shared_ptr<Slot>& slot : slots_)
+        {
+            pool_.Retire(slot->Context, fenceValue);
+        }
+
+        const size_t numLists = slots_.size();
+        slots_.clear();
+        return numLists;
+    }
+
+    size_t GetNumRecorded() const { return slots_.size(); }
+
+private:
+    struct Slot
+    {
+        typename CommandListPool<Backend>::Context* Context = nullptr;
+        bool Closed = false;
+        std::exception_ptr Error;
+        std::promise<void> Done;
+        std::future<void> Finished;
+    };
+
+    void WaitForRecordings()
+    {
+        for (const std::shared_ptr<Slot>& slot : slots_)
+        {
+            if (slot->Finished.valid())
+            {
+                slot->Finished.wait();
+            }
+        }
+    }
+
+    CommandListPool<Backend>& pool_;
+    ThreadPool* threadPool_;
+    uint64_t completedValue_;
+
+    std::vector<std::shared_ptr<Slot>> slots_;
+    std::vector<List*> lists_;
+};
+
+}; // namespace graphics
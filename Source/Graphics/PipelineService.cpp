@@ -0,0 +1,255 @@
+#include "PipelineService.h"
+
+#include <cassert>
+#include <exception>
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+struct PipelineService::ShaderStorage
+{
+    std::vector<uint8_t> Bytecode;
+
+    void Copy(D3D12_SHADER_BYTECODE& shader)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(shader.pShaderBytecode);
+        Bytecode.assign(bytes, bytes + (bytes != nullptr ? shader.BytecodeLength : 0));
+        shader.pShaderBytecode = Bytecode.empty() ? nullptr : Bytecode.data();
+    }
+};
+
+struct PipelineService::GraphicsDescStorage
+{
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC Desc;
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignature;
+    ShaderStorage Shaders[5];
+    std::vector<D3D12_INPUT_ELEMENT_DESC> InputElements;
+    std::vector<std::string> SemanticNames;
+
+    explicit GraphicsDescStorage(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) :
+        Desc(desc),
+        RootSignature(desc.pRootSignature)
+    {
+        assert(desc.StreamOutput.NumEntries == 0 && "Stream output isn't supported by asynchronous requests");
+
+        Shaders[0].Copy(Desc.VS);
+        Shaders[1].Copy(Desc.PS);
+        Shaders[2].Copy(Desc.DS);
+        Shaders[3].Copy(Desc.HS);
+        Shaders[4].Copy(Desc.GS);
+
+        InputElements.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + desc.InputLayout.NumElements);
+        SemanticNames.reserve(InputElements.size());
+        for (D3D12_INPUT_ELEMENT_DESC& element : InputElements)
+        {
+            SemanticNames.push_back(element.SemanticName);
+            element.SemanticName = SemanticNames.back().c_str();
+        }
+        Desc.InputLayout.pInputElementDescs = InputElements.empty() ? nullptr : InputElements.data();
+
+        Desc.CachedPSO = {};
+    }
+};
+
+struct PipelineService::ComputeDescStorage
+{
+    D3D12_COMPUTE_PIPELINE_STATE_DESC Desc;
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignature;
+    ShaderStorage Shader;
+
+    explicit ComputeDescStorage(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc) :
+        Desc(desc),
+        RootSignature(desc.pRootSignature)
+    {
+        Shader.Copy(Desc.CS);
+        Desc.CachedPSO = {};
+    }
+};
+
+PipelineService::PipelineService(PipelineStateCache& cache, size_t numThreads) :
+    cache_(cache),
+    numPending_(0),
+    threadPool_(numThreads)
+{
+}
+
+PipelineService::~PipelineService()
+{
+    threadPool_.WaitIdle();
+}
+
+PipelineService::PipelineHandle PipelineService::RequestGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash,
+    CompletionCallback onCompletion)
+{
+    const PipelineHandle handle = AddPipeline(std::move(onCompletion));
+    auto storage = std::make_shared<GraphicsDescStorage>(desc);
+    threadPool_.Submit([this, handle, storage, rootSignatureHash]()
+        {
+            Complete(handle, 0, [this, &storage, rootSignatureHash]() { return cache_.GetGraphicsPipeline(storage->Desc, rootSignatureHash); });
+        });
+    return handle;
+}
+
+PipelineService::PipelineHandle PipelineService::RequestComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash,
+    CompletionCallback onCompletion)
+{
+    const PipelineHandle handle = AddPipeline(std::move(onCompletion));
+    auto storage = std::make_shared<ComputeDescStorage>(desc);
+    threadPool_.Submit([this, handle, storage, rootSignatureHash]()
+        {
+            Complete(handle, 0, [this, &storage, rootSignatureHash]() { return cache_.GetComputePipeline(storage->Desc, rootSignatureHash); });
+        });
+    return handle;
+}
+
+void PipelineService::ReplaceGraphicsPipeline(PipelineHandle handle, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash,
+    CompletionCallback onCompletion)
+{
+    const uint32_t generation = ReplacePipeline(handle, std::move(onCompletion));
+    auto storage = std::make_shared<GraphicsDescStorage>(desc);
+    threadPool_.Submit([this, handle, generation, storage, rootSignatureHash]()
+        {
+            Complete(handle, generation, [this, &storage, rootSignatureHash]() { return cache_.GetGraphicsPipeline(storage->Desc, rootSignatureHash); });
+        });
+}
+
+void PipelineService::ReplaceComputePipeline(PipelineHandle handle, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash,
+    CompletionCallback onCompletion)
+{
+    const uint32_t generation = ReplacePipeline(handle, std::move(onCompletion));
+    auto storage = std::make_shared<ComputeDescStorage>(desc);
+    threadPool_.Submit([this, handle, generation, storage, rootSignatureHash]()
+        {
+            Complete(handle, generation, [this, &storage, rootSignatureHash]() { return cache_.GetComputePipeline(storage->Desc, rootSignatureHash); });
+        });
+}
+
+size_t PipelineService::Poll(DeferredReleaseQueue<ComPtr<IUnknown>>& releaseQueue, uint64_t fenceValue)
+{
+    return Publish(&releaseQueue, fenceValue);
+}
+
+size_t PipelineService::Poll()
+{
+    return Publish(nullptr, 0);
+}
+
+void PipelineService::WaitIdle()
+{
+    while (numPending_ > 0)
+    {
+        threadPool_.WaitIdle();
+        Poll();
+    }
+}
+
+ID3D12PipelineState* PipelineService::Get(PipelineHandle handle, ID3D12PipelineState* fallback) const
+{
+    const Pipeline& pipeline = pipelines_[handle];
+    return pipeline.State == Status::Ready ? pipeline.PipelineState.Get() : fallback;
+}
+
+bool PipelineService::IsReady(PipelineHandle handle) const
+{
+    return pipelines_[handle].State == Status::Ready;
+}
+
+bool PipelineService::IsFailed(PipelineHandle handle) const
+{
+    return pipelines_[handle].State == Status::Failed;
+}
+
+const std::string& PipelineService::GetError(PipelineHandle handle) const
+{
+    return pipelines_[handle].Error;
+}
+
+size_t PipelineService::GetNumPending() const
+{
+    return numPending_;
+}
+
+PipelineService::PipelineHandle PipelineService::AddPipeline(CompletionCallback onCompletion)
+{
+    pipelines_.push_back({ Status::Pending, nullptr, std::string(), std::move(onCompletion), 0 });
+    numPending_++;
+    return static_cast<PipelineHandle>(pipelines_.size() - 1);
+}
+
+uint32_t PipelineService::ReplacePipeline(PipelineHandle handle, CompletionCallback onCompletion)
+{
+    // A replacement still compiling is superseded, together with its callback.
+    Pipeline& pipeline = pipelines_[handle];
+    pipeline.OnCompletion = std::move(onCompletion);
+    numPending_++;
+    return ++pipeline.Generation;
+}
+
+size_t PipelineService::Publish(DeferredReleaseQueue<ComPtr<IUnknown>>* releaseQueue, uint64_t fenceValue)
+{
+    {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        publishing_.swap(completions_);
+    }
+
+    for (Completion& completion : publishing_)
+    {
+        numPending_--;
+
+        // Requests for one handle may finish out of order on different workers, only the latest one counts.
+        Pipeline& pipeline = pipelines_[completion.Handle];
+        if (completion.Generation != pipeline.Generation)
+        {
+            continue;
+        }
+
+        const bool succeeded = completion.PipelineState != nullptr;
+        if (succeeded)
+        {
+            if (releaseQueue != nullptr && pipeline.PipelineState)
+            {
+                releaseQueue->Retire(std::move(pipeline.PipelineState), fenceValue);
+            }
+            pipeline.State = Status::Ready;
+            pipeline.PipelineState = std::move(completion.PipelineState);
+            pipeline.Error.clear();
+        }
+        else
+        {
+            // A failed replacement keeps the pipeline which was working so far.
+            pipeline.State = pipeline.PipelineState ? Status::Ready : Status::Failed;
+            pipeline.Error = std::move(completion.Error);
+        }
+
+        if (pipeline.OnCompletion)
+        {
+            // Callbacks may request more pipelines, which can reallocate `pipelines_`.
+            CompletionCallback onCompletion = std::move(pipeline.OnCompletion);
+            onCompletion(completion.Handle, succeeded);
+        }
+    }
+
+    const size_t numPublished = publishing_.size();
+    publishing_.clear();
+    return numPublished;
+}
+
+void PipelineService::Complete(PipelineHandle handle, uint32_t generation, const std::function<ComPtr<ID3D12PipelineState>()>& create)
+{
+    Completion completion = { handle, generation, nullptr, std::string() };
+    try
+    {
+        completion.PipelineState = create();
+    }
+    catch (const std::exception& exception)
+    {
+        completion.Error = exception.what();
+    }
+
+    std::lock_guard<std::mutex> lock(completionMutex_);
+    completions_.push_back(std::move(completion));
+}
+
+}; // namespace graphics
@@ -0,0 +1,128 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "DeferredReleaseQueue.h"
+#include "PipelineStateCache.h"
+#include "ThreadPool.h"
+
+namespace graphics
+{
+
+//
+// Creates pipeline state objects on worker threads.
+//
+// Requests return a handle right away, the description is copied so the caller's storage can go. Results
+// are published by Poll(), which the render thread calls once per frame, so a pipeline never becomes
+// available in the middle of recording a frame. Until then Get() returns the fallback, callers either bind
+// a cheaper pipeline or skip the draw. Compilation goes through the PipelineStateCache, which deduplicates
+// and persists the results.
+//
+// ReplaceGraphicsPipeline() rebuilds an existing pipeline, e.g. after its shaders were reloaded. The handle keeps returning the
+// current pipeline until the new one is published, and the replaced one goes to the deferred release queue.
+//
+class PipelineService
+{
+public:
+    using PipelineHandle = uint32_t;
+    using CompletionCallback = std::function<void(PipelineHandle handle, bool succeeded)>;
+
+    static const PipelineHandle kInvalidPipeline = ~0u;
+
+    // 0 threads picks the ThreadPool default.
+    PipelineService(PipelineStateCache& cache, size_t numThreads = 0);
+    ~PipelineService();
+
+    PipelineService(const PipelineService&) = delete;
+    PipelineService& operator=(const PipelineService&) = delete;
+
+    // `onCompletion` runs on the render thread, inside Poll().
+    PipelineHandle RequestGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash,
+        CompletionCallback onCompletion = nullptr);
+    PipelineHandle RequestComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash,
+        CompletionCallback onCompletion = nullptr);
+
+    // Create a new pipeline for `handle` from another description. If that fails the handle keeps its current pipeline.
+    void ReplaceGraphicsPipeline(PipelineHandle handle, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash,
+        CompletionCallback onCompletion = nullptr);
+    void ReplaceComputePipeline(PipelineHandle handle, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash,
+        CompletionCallback onCompletion = nullptr);
+
+    // Publish the pipelines finished since the previous call and run their callbacks. Returns how many were published.
+    // Replaced pipelines are retired to `releaseQueue` with `fenceValue`, which has to follow the last frame that could use them.
+    size_t Poll(DeferredReleaseQueue<Microsoft::WRL::ComPtr<IUnknown>>& releaseQueue, uint64_t fenceValue);
+    // Without a queue replaced pipelines are released right away, only valid when the GPU is idle.
+    size_t Poll();
+
+    // Block until every pending request is finished and published.
+    void WaitIdle();
+
+    ID3D12PipelineState* Get(PipelineHandle handle, ID3D12PipelineState* fallback = nullptr) const;
+    bool IsReady(PipelineHandle handle) const;
+    bool IsFailed(PipelineHandle handle) const;
+    // Why creation failed, empty otherwise.
+    const std::string& GetError(PipelineHandle handle) const;
+
+    size_t GetNumPending() const;
+
+private:
+    enum class Status
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    struct Pipeline
+    {
+        Status State;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineState;
+        std::string Error;
+        CompletionCallback OnCompletion;
+        // Bumped by every replacement, results of superseded requests are dropped.
+        uint32_t Generation;
+    };
+
+    struct Completion
+    {
+        PipelineHandle Handle;
+        uint32_t Generation;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineState;
+        std::string Error;
+    };
+
+    // Copy of a description and everything it points to, owned by the task that compiles it.
+    struct ShaderStorage;
+    struct GraphicsDescStorage;
+    struct ComputeDescStorage;
+
+    PipelineHandle AddPipeline(CompletionCallback onCompletion);
+    uint32_t ReplacePipeline(PipelineHandle handle, CompletionCallback onCompletion);
+    size_t Publish(DeferredReleaseQueue<Microsoft::WRL::ComPtr<IUnknown>>* releaseQueue, uint64_t fenceValue);
+    void Complete(PipelineHandle handle, uint32_t generation, const std::function<Microsoft::WRL::ComPtr<ID3D12PipelineState>()>& create);
+
+    PipelineStateCache& cache_;
+
+    // Only touched by the render thread
+    std::vector<Pipeline> pipelines_;
+    size_t numPending_;
+
+    std::mutex completionMutex_;
+    std::vector<Completion> completions_;
+    std::vector<Completion> publishing_;
+
+    // Declared last, so the workers are joined before the members they use go away.
+    ThreadPool threadPool_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,189 @@
+#include "PipelineStateCache.h"
+
+#include <cwchar>
+
+#include "CacheFile.h"
+#include "GraphicsUtil.h"
+#include "PipelineStateHash.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+namespace
+{
+
+// Bump when the hashing of descriptions changes, so that libraries keyed the old way are dropped.
+const uint64_t kPipelineCacheKey = 1;
+
+std::wstring GetPipelineName(uint64_t hash)
+{
+    wchar_t name[17] = {};
+    swprintf_s(name, L"%016llx", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+};
+
+PipelineStateCache::PipelineStateCache(ID3D12Device* device, const std::string& path) :
+    device_(device),
+    path_(path),
+    numStored_(0)
+{
+    // Pipeline libraries need ID3D12Device1, without it the cache still deduplicates in memory.
+    ComPtr<ID3D12Device1> device1;
+    if (FAILED(device_.As(&device1)))
+    {
+        return;
+    }
+
+    if (!path_.empty() && ReadCacheFile(path_, kPipelineCacheKey, libraryData_))
+    {
+        // Fails with D3D12_ERROR_DRIVER_VERSION_MISMATCH or D3D12_ERROR_ADAPTER_NOT_FOUND when the library is stale.
+        if (FAILED(device1->CreatePipelineLibrary(libraryData_.data(), libraryData_.size(), IID_PPV_ARGS(&library_))))
+        {
+            libraryData_.clear();
+        }
+    }
+
+    if (!library_)
+    {
+        libraryData_.clear();
+        ThrowIfFailed(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library_)), "CreatePipelineLibrary");
+    }
+}
+
+ComPtr<ID3D12PipelineState> PipelineStateCache::GetGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+    return GetPipeline(HashGraphicsPipelineDesc(desc, rootSignatureHash),
+        [this, &desc](const wchar_t* name, ComPtr<ID3D12PipelineState>& pipelineState, bool load)
+        {
+            return load ?
+                library_->LoadGraphicsPipeline(name, &desc, IID_PPV_ARGS(&pipelineState)) :
+                device_->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+        });
+}
+
+ComPtr<ID3D12PipelineState> PipelineStateCache::GetComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+    return GetPipeline(HashComputePipelineDesc(desc, rootSignatureHash),
+        [this, &desc](const wchar_t* name, ComPtr<ID3D12PipelineState>& pipelineState, bool load)
+        {
+            return load ?
+                library_->LoadComputePipeline(name, &desc, IID_PPV_ARGS(&pipelineState)) :
+                device_->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+        });
+}
+
+template <typename CreateFunction>
+ComPtr<ID3D12PipelineState> PipelineStateCache::GetPipeline(uint64_t hash, CreateFunction create)
+{
+    std::promise<ComPtr<ID3D12PipelineState>> promise;
+    PipelineFuture existing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statistics_.NumRequests++;
+
+        auto it = pipelines_.find(hash);
+        if (it != pipelines_.end())
+        {
+            statistics_.NumMemoryHits++;
+            existing = it->second;
+        }
+        else
+        {
+            pipelines_.emplace(hash, promise.get_future().share());
+        }
+    }
+
+    if (existing.valid())
+    {
+        // Blocks only while another thread is still creating the same pipeline
+        return existing.get();
+    }
+
+    try
+    {
+        const std::wstring name = GetPipelineName(hash);
+        ComPtr<ID3D12PipelineState> pipelineState;
+        bool loaded = false;
+        if (library_)
+        {
+            // E_INVALIDARG when the library doesn't have it, or has it for a different description.
+            std::lock_guard<std::mutex> libraryLock(libraryMutex_);
+            loaded = SUCCEEDED(create(name.c_str(), pipelineState, true));
+        }
+
+        if (!loaded)
+        {
+            ThrowIfFailed(create(name.c_str(), pipelineState, false), "Create pipeline state");
+            if (library_)
+            {
+                std::lock_guard<std::mutex> libraryLock(libraryMutex_);
+                if (SUCCEEDED(library_->StorePipeline(name.c_str(), pipelineState.Get())))
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    numStored_++;
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            (loaded ? statistics_.NumLibraryHits : statistics_.NumCompiled)++;
+        }
+        promise.set_value(pipelineState);
+        return pipelineState;
+    }
+    catch (...)
+    {
+        // Let the waiting callers see the failure, and the next request try again.
+        promise.set_exception(std::current_exception());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pipelines_.erase(hash);
+        }
+        throw;
+    }
+}
+
+bool PipelineStateCache::Save()
+{
+    if (!library_ || path_.empty())
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (numStored_ == 0)
+        {
+            return true;
+        }
+    }
+
+    std::vector<uint8_t> data;
+    {
+        std::lock_guard<std::mutex> libraryLock(libraryMutex_);
+        data.resize(library_->GetSerializedSize());
+        ThrowIfFailed(library_->Serialize(data.data(), data.size()), "Serialize pipeline library");
+    }
+
+    if (!WriteCacheFile(path_, kPipelineCacheKey, data.data(), data.size()))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    numStored_ = 0;
+    return true;
+}
+
+PipelineStateCache::Statistics PipelineStateCache::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+}; // namespace graphics
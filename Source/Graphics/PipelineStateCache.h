@@ -0,0 +1,72 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Pipeline state objects keyed by the stable hash of their description.
+//
+// Equal requests share one object, also when they are made concurrently: the first caller compiles and the
+// others wait for its result. Compiled pipelines are stored in an ID3D12PipelineLibrary which Save() writes to
+// disk, so a warm start loads them instead of going through the driver compiler. A library written by another
+// driver or adapter is discarded when it is opened. Thread safe.
+//
+class PipelineStateCache
+{
+public:
+    struct Statistics
+    {
+        size_t NumRequests = 0;
+        size_t NumMemoryHits = 0;
+        size_t NumLibraryHits = 0;
+        size_t NumCompiled = 0;
+    };
+
+    // An empty path keeps the cache in memory only.
+    PipelineStateCache(ID3D12Device* device, const std::string& path);
+
+    PipelineStateCache(const PipelineStateCache&) = delete;
+    PipelineStateCache& operator=(const PipelineStateCache&) = delete;
+
+    // `rootSignatureHash` identifies desc.pRootSignature, see HashGraphicsPipelineDesc().
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> GetGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> GetComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+    // Write the library to disk if pipelines were added since it was loaded or last saved.
+    bool Save();
+
+    Statistics GetStatistics() const;
+
+private:
+    using PipelineFuture = std::shared_future<Microsoft::WRL::ComPtr<ID3D12PipelineState>>;
+
+    template <typename CreateFunction>
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> GetPipeline(uint64_t hash, CreateFunction create);
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> library_;
+    std::string path_;
+    // The library reads from this memory for its whole lifetime.
+    std::vector<uint8_t> libraryData_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, PipelineFuture> pipelines_;
+    size_t numStored_;
+    Statistics statistics_;
+
+    // Loads and stores go one at a time, compilation itself runs in parallel.
+    std::mutex libraryMutex_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,133 @@
+#include "PipelineStateHash.h"
+
+#include "Hash.h"
+
+namespace graphics
+{
+
+namespace
+{
+
+void AppendShader(Hasher& hasher, const D3D12_SHADER_BYTECODE& shader)
+{
+    hasher.AppendValue(static_cast<uint64_t>(shader.BytecodeLength));
+    if (shader.pShaderBytecode != nullptr)
+    {
+        hasher.Append(shader.pShaderBytecode, shader.BytecodeLength);
+    }
+}
+
+// The structures below have padding or pointers, so they go in field by field.
+void AppendStreamOutput(Hasher& hasher, const D3D12_STREAM_OUTPUT_DESC& streamOutput)
+{
+    hasher.AppendValue(streamOutput.NumEntries);
+    for (UINT index = 0; index < streamOutput.NumEntries; index++)
+    {
+        const D3D12_SO_DECLARATION_ENTRY& entry = streamOutput.pSODeclaration[index];
+        hasher.AppendValue(entry.Stream);
+        hasher.AppendString(entry.SemanticName);
+        hasher.AppendValue(entry.SemanticIndex);
+        hasher.AppendValue(entry.StartComponent);
+        hasher.AppendValue(entry.ComponentCount);
+        hasher.AppendValue(entry.OutputSlot);
+    }
+
+    hasher.AppendValue(streamOutput.NumStrides);
+    for (UINT index = 0; index < streamOutput.NumStrides; index++)
+    {
+        hasher.AppendValue(streamOutput.pBufferStrides[index]);
+    }
+    hasher.AppendValue(streamOutput.RasterizedStream);
+}
+
+void AppendBlend(Hasher& hasher, const D3D12_BLEND_DESC& blend)
+{
+    hasher.AppendValue(blend.AlphaToCoverageEnable);
+    hasher.AppendValue(blend.IndependentBlendEnable);
+    for (const D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : blend.RenderTarget)
+    {
+        hasher.AppendValue(renderTarget.BlendEnable);
+        hasher.AppendValue(renderTarget.LogicOpEnable);
+        hasher.AppendValue(renderTarget.SrcBlend);
+        hasher.AppendValue(renderTarget.DestBlend);
+        hasher.AppendValue(renderTarget.BlendOp);
+        hasher.AppendValue(renderTarget.SrcBlendAlpha);
+        hasher.AppendValue(renderTarget.DestBlendAlpha);
+        hasher.AppendValue(renderTarget.BlendOpAlpha);
+        hasher.AppendValue(renderTarget.LogicOp);
+        hasher.AppendValue(renderTarget.RenderTargetWriteMask);
+    }
+}
+
+void AppendDepthStencil(Hasher& hasher, const D3D12_DEPTH_STENCIL_DESC& depthStencil)
+{
+    hasher.AppendValue(depthStencil.DepthEnable);
+    hasher.AppendValue(depthStencil.DepthWriteMask);
+    hasher.AppendValue(depthStencil.DepthFunc);
+    hasher.AppendValue(depthStencil.StencilEnable);
+    hasher.AppendValue(depthStencil.StencilReadMask);
+    hasher.AppendValue(depthStencil.StencilWriteMask);
+    hasher.AppendValue(depthStencil.FrontFace);
+    hasher.AppendValue(depthStencil.BackFace);
+}
+
+void AppendInputLayout(Hasher& hasher, const D3D12_INPUT_LAYOUT_DESC& inputLayout)
+{
+    hasher.AppendValue(inputLayout.NumElements);
+    for (UINT index = 0; index < inputLayout.NumElements; index++)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& element = inputLayout.pInputElementDescs[index];
+        hasher.AppendString(element.SemanticName);
+        hasher.AppendValue(element.SemanticIndex);
+        hasher.AppendValue(element.Format);
+        hasher.AppendValue(element.InputSlot);
+        hasher.AppendValue(element.AlignedByteOffset);
+        hasher.AppendValue(element.InputSlotClass);
+        hasher.AppendValue(element.InstanceDataStepRate);
+    }
+}
+
+};
+
+uint64_t HashGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+    Hasher hasher;
+    hasher.AppendValue(rootSignatureHash);
+
+    AppendShader(hasher, desc.VS);
+    AppendShader(hasher, desc.PS);
+    AppendShader(hasher, desc.DS);
+    AppendShader(hasher, desc.HS);
+    AppendShader(hasher, desc.GS);
+    AppendStreamOutput(hasher, desc.StreamOutput);
+    AppendBlend(hasher, desc.BlendState);
+    hasher.AppendValue(desc.SampleMask);
+    // Only 4-byte fields, no padding
+    hasher.AppendValue(desc.RasterizerState);
+    AppendDepthStencil(hasher, desc.DepthStencilState);
+    AppendInputLayout(hasher, desc.InputLayout);
+    hasher.AppendValue(desc.IBStripCutValue);
+    hasher.AppendValue(desc.PrimitiveTopologyType);
+    hasher.AppendValue(desc.NumRenderTargets);
+    hasher.AppendValue(desc.RTVFormats);
+    hasher.AppendValue(desc.DSVFormat);
+    hasher.AppendValue(desc.SampleDesc);
+    hasher.AppendValue(desc.NodeMask);
+    hasher.AppendValue(desc.Flags);
+
+    return hasher.Get();
+}
+
+uint64_t HashComputePipelineDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+    Hasher hasher;
+    hasher.AppendValue(rootSignatureHash);
+
+    AppendShader(hasher, desc.CS);
+    hasher.AppendValue(desc.NodeMask);
+    hasher.AppendValue(desc.Flags);
+
+    return hasher.Get();
+}
+
+}; // namespace graphics
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+#include <d3d12.h>
+
+namespace graphics
+{
+
+// Stable hash of everything that determines the compiled pipeline: shader bytecode, input layout, stream output,
+// blend, rasterizer and depth stencil state, formats and flags. The root signature is an object and can't be hashed
+// by content, pass the hash of its serialized blob instead. CachedPSO is ignored.
+uint64_t HashGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+uint64_t HashComputePipelineDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+}; // namespace graphics
@@ -0,0 +1,76 @@
+#include "RangeAllocator.h"
+
+#include <cassert>
+#include <iterator>
+
+namespace graphics
+{
+
+RangeAllocator::RangeAllocator(uint64_t size) :
+    size_(size),
+    freeSize_(size)
+{
+    if (size > 0)
+    {
+        freeRanges_.emplace(0, size);
+    }
+}
+
+uint64_t RangeAllocator::Allocate(uint64_t size)
+{
+    if (size == 0 || size > freeSize_)
+    {
+        return kInvalidOffset;
+    }
+
+    for (auto it = freeRanges_.begin(); it != freeRanges_.end(); ++it)
+    {
+        if (it->second >= size)
+        {
+            const uint64_t offset = it->first;
+            const uint64_t remaining = it->second - size;
+            freeRanges_.erase(it);
+            if (remaining > 0)
+            {
+                freeRanges_.emplace(offset + size, remaining);
+            }
+            freeSize_ -= size;
+            return offset;
+        }
+    }
+
+    return kInvalidOffset;
+}
+
+void RangeAllocator::Free(uint64_t offset, uint64_t size)
+{
+    assert(offset + size <= size_);
+    freeSize_ += size;
+
+    auto next = freeRanges_.lower_bound(offset);
+    assert(next == freeRanges_.end() || offset + size <= next->first);
+
+    // Merge with the previous free range if it ends right where this one starts.
+    if (next != freeRanges_.begin())
+    {
+        auto previous = std::prev(next);
+        assert(previous->first + previous->second <= offset);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            freeRanges_.erase(previous);
+        }
+    }
+
+    // Merge with the following free range.
+    if (next != freeRanges_.end() && offset + size == next->first)
+    {
+        size += next->second;
+        freeRanges_.erase(next);
+    }
+
+    freeRanges_.emplace(offset, size);
+}
+
+}; // namespace graphics
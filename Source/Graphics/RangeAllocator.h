@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+
+namespace graphics
+{
+
+//
+// First-fit allocator of contiguous index ranges inside [0, size), with coalescing of freed neighbours.
+// Used for descriptor heaps, where ranges are small and the free list stays short.
+//
+class RangeAllocator
+{
+public:
+    static const uint64_t kInvalidOffset = ~0ull;
+
+    explicit RangeAllocator(uint64_t size);
+
+    // Returns kInvalidOffset when no free range is large enough.
+    uint64_t Allocate(uint64_t size);
+    void Free(uint64_t offset, uint64_t size);
+
+    uint64_t GetSize() const { return size_; }
+    uint64_t GetFreeSize() const { return freeSize_; }
+    size_t GetNumFreeRanges() const { return freeRanges_.size(); }
+
+private:
+    uint64_t size_;
+    uint64_t freeSize_;
+    // offset -> size
+    std::map<uint64_t, uint64_t> freeRanges_;
+};
+
+}; // namespace graphics
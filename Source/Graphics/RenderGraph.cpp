@@ -0,0 +1,269 @@
+#include "RenderGraph.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "Alignment.h"
+
+namespace graphics
+{
+
+//
+// RenderGraph::PassBuilder
+//
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Read(ResourceHandle resource, ResourceStateMask state)
+{
+    graph_.AddAccess(pass_, resource, state, false);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::Write(ResourceHandle resource, ResourceStateMask state)
+{
+    graph_.AddAccess(pass_, resource, state, true);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::SideEffect()
+{
+    graph_.passes_[pass_].SideEffect = true;
+    return *this;
+}
+
+//
+// RenderGraph
+//
+void RenderGraph::Reset()
+{
+    resources_.clear();
+    passes_.clear();
+    compiledPasses_.clear();
+    finalBarriers_.clear();
+    statistics_ = Statistics();
+}
+
+RenderGraph::ResourceHandle RenderGraph::Import(const std::string& name, ResourceStateMask currentState, ResourceStateMask finalState)
+{
+    resources_.push_back({ name, true, currentState, finalState, 0, 0, kInvalidOffset, 0, 0 });
+    return static_cast<ResourceHandle>(resources_.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::CreateTransient(const std::string& name, uint64_t size, uint64_t alignment)
+{
+    assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+    resources_.push_back({ name, false, 0, 0, size, alignment, kInvalidOffset, 0, 0 });
+    return static_cast<ResourceHandle>(resources_.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(const std::string& name, ExecuteFunction execute)
+{
+    passes_.push_back({ name, std::move(execute), {}, false, false });
+    return PassBuilder(*this, static_cast<uint32_t>(passes_.size() - 1));
+}
+
+void RenderGraph::Compile()
+{
+    compiledPasses_.clear();
+    finalBarriers_.clear();
+    statistics_ = Statistics();
+    statistics_.NumPasses = passes_.size();
+
+    CullPasses();
+    ComputeLifetimes();
+    PlaceTransients();
+    ComputeBarriers();
+}
+
+void RenderGraph::ExecutePass(const CompiledPass& compiledPass) const
+{
+    const Pass& pass = passes_[compiledPass.Pass];
+    if (pass.Execute)
+    {
+        pass.Execute();
+    }
+}
+
+void RenderGraph::AddAccess(uint32_t pass, ResourceHandle resource, ResourceStateMask state, bool write)
+{
+    assert(resource < resources_.size() && "Unknown resource");
+
+    // Several uses of one resource by a pass combine into a single access.
+    for (Access& access : passes_[pass].Accesses)
+    {
+        if (access.Resource == resource)
+        {
+            if (!access.Write && !write)
+            {
+                access.State |= state;
+            }
+            else if (access.State != state)
+            {
+                throw std::invalid_argument("Pass " + passes_[pass].Name + " uses " + resources_[resource].Name +
+                    " in conflicting states, a write and another use of a resource must share one state");
+            }
+            access.Read = access.Read || !write;
+            access.Write = access.Write || write;
+            return;
+        }
+    }
+    passes_[pass].Accesses.push_back({ resource, state, !write, write });
+}
+
+void RenderGraph::CullPasses()
+{
+    // Walk backwards from the outputs: a pass is live when it has side effects, writes an imported
+    // resource or writes something a later live pass reads. A plain write ends the interest in the
+    // earlier contents of a resource, a read (also of a read-modify-write) renews it.
+    needed_.assign(resources_.size(), 0);
+    for (size_t index = passes_.size(); index-- > 0;)
+    {
+        Pass& pass = passes_[index];
+
+        bool live = pass.SideEffect;
+        for (const Access& access : pass.Accesses)
+        {
+            if (access.Write && (needed_[access.Resource] || resources_[access.Resource].Imported))
+            {
+                live = true;
+            }
+        }
+        pass.Live = live;
+
+        if (!live)
+        {
+            statistics_.NumCulledPasses++;
+            continue;
+        }
+
+        for (const Access& access : pass.Accesses)
+        {
+            needed_[access.Resource] = access.Read;
+        }
+    }
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+    for (Resource& resource : resources_)
+    {
+        resource.FirstUse = ~0u;
+        resource.LastUse = 0;
+    }
+
+    for (uint32_t index = 0; index < passes_.size(); index++)
+    {
+        if (!passes_[index].Live)
+        {
+            continue;
+        }
+
+        const uint32_t compiledIndex = static_cast<uint32_t>(compiledPasses_.size());
+        compiledPasses_.push_back({ index, {}, {} });
+
+        for (const Access& access : passes_[index].Accesses)
+        {
+            Resource& resource = resources_[access.Resource];
+            if (resource.FirstUse == ~0u)
+            {
+                resource.FirstUse = compiledIndex;
+                if (!resource.Imported)
+                {
+                    resource.InitialState = access.State;
+                }
+            }
+            resource.LastUse = compiledIndex;
+        }
+    }
+}
+
+void RenderGraph::PlaceTransients()
+{
+    // Greedy placement in order of first use: a transient takes the best fitting block whose last
+    // occupant is dead by now, or a new block at the end of the heap.
+    struct Block
+    {
+        uint64_t Offset;
+        uint64_t Size;
+        uint32_t LastUse;
+        ResourceHandle Occupant;
+    };
+    std::vector<Block> blocks;
+
+    for (CompiledPass& compiledPass : compiledPasses_)
+    {
+        const uint32_t compiledIndex = static_cast<uint32_t>(&compiledPass - compiledPasses_.data());
+
+        for (const Access& access : passes_[compiledPass.Pass].Accesses)
+        {
+            Resource& resource = resources_[access.Resource];
+            if (resource.Imported || resource.FirstUse != compiledIndex)
+            {
+                continue;
+            }
+
+            assert(access.Write && !access.Read && "The first use of a transient resource must write it without reading");
+
+            Block* bestBlock = nullptr;
+            for (Block& block : blocks)
+            {
+                if (block.LastUse < compiledIndex && block.Size >= resource.Size && IsAligned(block.Offset, resource.Alignment) &&
+                    (bestBlock == nullptr || block.Size < bestBlock->Size))
+                {
+                    bestBlock = &block;
+                }
+            }
+
+            ResourceHandle previous = kInvalidResource;
+            if (bestBlock != nullptr)
+            {
+                previous = bestBlock->Occupant;
+                bestBlock->LastUse = resource.LastUse;
+                bestBlock->Occupant = access.Resource;
+                resource.HeapOffset = bestBlock->Offset;
+            }
+            else
+            {
+                resource.HeapOffset = AlignUp(statistics_.TransientHeapSize, resource.Alignment);
+                statistics_.TransientHeapSize = resource.HeapOffset + resource.Size;
+                blocks.push_back({ resource.HeapOffset, resource.Size, resource.LastUse, access.Resource });
+            }
+
+            compiledPass.Activations.push_back({ access.Resource, previous });
+            statistics_.TransientSizeWithoutAliasing += resource.Size;
+        }
+    }
+}
+
+void RenderGraph::ComputeBarriers()
+{
+    // Transient resources are created in the state of their first use, imported ones start in their current state.
+    currentStates_.resize(resources_.size());
+    for (size_t index = 0; index < resources_.size(); index++)
+    {
+        currentStates_[index] = resources_[index].InitialState;
+    }
+
+    for (CompiledPass& compiledPass : compiledPasses_)
+    {
+        for (const Access& access : passes_[compiledPass.Pass].Accesses)
+        {
+            if (currentStates_[access.Resource] != access.State)
+            {
+                compiledPass.Barriers.push_back({ access.Resource, currentStates_[access.Resource], access.State });
+                currentStates_[access.Resource] = access.State;
+            }
+        }
+        statistics_.NumBarriers += compiledPass.Barriers.size();
+    }
+
+    for (size_t index = 0; index < resources_.size(); index++)
+    {
+        const Resource& resource = resources_[index];
+        if (resource.Imported && currentStates_[index] != resource.FinalState)
+        {
+            finalBarriers_.push_back({ static_cast<ResourceHandle>(index), currentStates_[index], resource.FinalState });
+        }
+    }
+    statistics_.NumBarriers += finalBarriers_.size();
+}
+
+}; // namespace graphics
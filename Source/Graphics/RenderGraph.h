@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ResourceStateTracker.h"
+
+namespace graphics
+{
+
+//
+// Frame graph of passes which declare the resources they read and write.
+//
+// The graph is rebuilt every frame: import the persistent resources, create the transient ones, add the
+// passes in submission order and Compile(). Compilation is CPU only and
+// - culls the passes whose results never reach an imported resource or a pass with side effects,
+// - computes the state transitions in front of every remaining pass and at the end of the frame,
+// - places transient resources into one heap, resources whose lifetimes don't overlap share memory.
+//
+// A backend walks GetCompiledPasses(), emits the activations and barriers, and calls ExecutePass().
+//
+class RenderGraph
+{
+public:
+    using ResourceHandle = uint32_t;
+    using ExecuteFunction = std::function<void()>;
+
+    static const ResourceHandle kInvalidResource = ~0u;
+    static const uint64_t kInvalidOffset = ~0ull;
+
+    // Every use of one resource by a pass. A read-modify-write is both a read and a write, in one state.
+    struct Access
+    {
+        ResourceHandle Resource;
+        ResourceStateMask State;
+        bool Read;
+        bool Write;
+    };
+
+    struct Barrier
+    {
+        ResourceHandle Resource;
+        ResourceStateMask Before;
+        ResourceStateMask After;
+    };
+
+    // A transient resource starting its lifetime, over the memory of `Previous` when it is valid.
+    struct Activation
+    {
+        ResourceHandle Resource;
+        ResourceHandle Previous;
+    };
+
+    struct CompiledPass
+    {
+        uint32_t Pass;
+        std::vector<Activation> Activations;
+        std::vector<Barrier> Barriers;
+    };
+
+    struct Statistics
+    {
+        size_t NumPasses = 0;
+        size_t NumCulledPasses = 0;
+        size_t NumBarriers = 0;
+        uint64_t TransientHeapSize = 0;
+        uint64_t TransientSizeWithoutAliasing = 0;
+    };
+
+    class PassBuilder
+    {
+    public:
+        PassBuilder(RenderGraph& graph, uint32_t pass) : graph_(graph), pass_(pass) {}
+
+        // Reads of one resource combine their states. Reading and writing it, or writing it twice, has to use
+        // the same state, a resource can't be in a read and a write state at once; std::invalid_argument otherwise.
+        PassBuilder& Read(ResourceHandle resource, ResourceStateMask state);
+        PassBuilder& Write(ResourceHandle resource, ResourceStateMask state);
+
+        // Keep the pass even if nothing consumes what it writes, e.g. readbacks or queries.
+        PassBuilder& SideEffect();
+
+        uint32_t GetPass() const { return pass_; }
+
+    private:
+        RenderGraph& graph_;
+        uint32_t pass_;
+    };
+
+    // Drop every pass and resource, the storage is kept for the next frame.
+    void Reset();
+
+    // A resource living outside the graph, currently in `currentState` and left in `finalState` by the frame.
+    ResourceHandle Import(const std::string& name, ResourceStateMask currentState, ResourceStateMask finalState);
+
+    // A resource living for the passes of this frame that use it, `size` and `alignment` describe its memory.
+    ResourceHandle CreateTransient(const std::string& name, uint64_t size, uint64_t alignment);
+
+    PassBuilder AddPass(const std::string& name, ExecuteFunction execute);
+
+    void Compile();
+
+    const std::vector<CompiledPass>& GetCompiledPasses() const { return compiledPasses_; }
+    // Transitions of imported resources into their final state, after the last pass.
+    const std::vector<Barrier>& GetFinalBarriers() const { return finalBarriers_; }
+    void ExecutePass(const CompiledPass& compiledPass) const;
+
+    const std::string& GetPassName(uint32_t pass) const { return passes_[pass].Name; }
+    const std::vector<Access>& GetPassAccesses(uint32_t pass) const { return passes_[pass].Accesses; }
+    bool IsPassCulled(uint32_t pass) const { return !passes_[pass].Live; }
+
+    size_t GetNumResources() const { return resources_.size(); }
+    const std::string& GetResourceName(ResourceHandle resource) const { return resources_[resource].Name; }
+    bool IsImported(ResourceHandle resource) const { return resources_[resource].Imported; }
+    // Offset of a transient resource in the transient heap, kInvalidOffset when no live pass uses it.
+    uint64_t GetHeapOffset(ResourceHandle resource) const { return resources_[resource].HeapOffset; }
+    // State of a transient resource at its first use, which is the state it is created in.
+    ResourceStateMask GetInitialState(ResourceHandle resource) const { return resources_[resource].InitialState; }
+    uint64_t GetTransientHeapSize() const { return statistics_.TransientHeapSize; }
+
+    const Statistics& GetStatistics() const { return statistics_; }
+
+private:
+    struct Resource
+    {
+        std::string Name;
+        bool Imported;
+        ResourceStateMask InitialState;
+        ResourceStateMask FinalState;
+        uint64_t Size;
+        uint64_t Alignment;
+        uint64_t HeapOffset;
+        uint32_t FirstUse;
+        uint32_t LastUse;
+    };
+
+    struct Pass
+    {
+        std::string Name;
+        ExecuteFunction Execute;
+        std::vector<Access> Accesses;
+        bool SideEffect;
+        bool Live;
+    };
+
+    void AddAccess(uint32_t pass, ResourceHandle resource, ResourceStateMask state, bool write);
+    void CullPasses();
+    void ComputeLifetimes();
+    void PlaceTransients();
+    void ComputeBarriers();
+
+    std::vector<Resource> resources_;
+    std::vector<Pass> passes_;
+    std::vector<CompiledPass> compiledPasses_;
+    std::vector<Barrier> finalBarriers_;
+    Statistics statistics_;
+
+    // Scratch storage reused by every Compile()
+    std::vector<char> needed_;
+    std::vector<ResourceStateMask> currentStates_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,250 @@
+#include "ResidencyManager.h"
+
+#include <cassert>
+
+namespace graphics
+{
+
+SimulatedResidencyDevice::SimulatedResidencyDevice(uint64_t budget) :
+    budget_(budget),
+    usage_(0)
+{
+}
+
+void SimulatedResidencyDevice::SetBudget(uint64_t budget)
+{
+    budget_ = budget;
+}
+
+void SimulatedResidencyDevice::AddUsage(uint64_t size)
+{
+    usage_ += size;
+}
+
+void SimulatedResidencyDevice::RemoveUsage(uint64_t size)
+{
+    assert(size <= usage_);
+    usage_ -= size;
+}
+
+MemoryBudget SimulatedResidencyDevice::QueryBudget() const
+{
+    MemoryBudget budget;
+    budget.Budget = budget_;
+    budget.Usage = usage_;
+    return budget;
+}
+
+void SimulatedResidencyDevice::MakeResident(const std::vector<ResidencyObject>& objects)
+{
+    for (const ResidencyObject& object : objects)
+    {
+        usage_ += object.Size;
+    }
+}
+
+void SimulatedResidencyDevice::Evict(const std::vector<ResidencyObject>& objects)
+{
+    for (const ResidencyObject& object : objects)
+    {
+        RemoveUsage(object.Size);
+    }
+}
+
+ResidencyManager::ResidencyManager(ResidencyDevice& device, std::vector<std::string> categoryNames) :
+    device_(device),
+    categoryNames_(std::move(categoryNames))
+{
+}
+
+ResidencyManager::Handle ResidencyManager::Track(void* object, uint64_t size, uint32_t category)
+{
+    assert(category < categoryNames_.size());
+
+    Handle handle;
+    if (!unusedHandles_.empty())
+    {
+        handle = unusedHandles_.back();
+        unusedHandles_.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(records_.size());
+        records_.emplace_back();
+    }
+    records_[handle] = { object, size, category, 0, true, true, kInvalidHandle, kInvalidHandle };
+
+    // Never used yet, so the least recently used, which keeps the list in last use order.
+    LinkAtFront(handle);
+    return handle;
+}
+
+void ResidencyManager::Untrack(Handle handle)
+{
+    if (handle == kInvalidHandle)
+    {
+        return;
+    }
+    assert(records_[handle].Tracked);
+    Unlink(handle);
+    records_[handle].Tracked = false;
+    unusedHandles_.push_back(handle);
+}
+
+void ResidencyManager::Use(const Handle* handles, size_t numHandles, uint64_t fenceValue, uint64_t completedValue)
+{
+    residentObjects_.clear();
+    uint64_t residentSize = 0;
+    for (size_t index = 0; index < numHandles; index++)
+    {
+        Record& record = records_[handles[index]];
+        assert(record.Tracked);
+        if (fenceValue > record.LastUse)
+        {
+            record.LastUse = fenceValue;
+        }
+        Unlink(handles[index]);
+        LinkAtEnd(handles[index]);
+
+        if (!record.Resident)
+        {
+            residentObjects_.push_back({ record.Object, record.Size });
+            residentSize += record.Size;
+            record.Resident = true;
+        }
+    }
+    if (residentObjects_.empty())
+    {
+        return;
+    }
+
+    // The objects of this submission were used last, after `completedValue`, so none of them is evicted here.
+    budget_ = device_.QueryBudget();
+    if (budget_.Usage + residentSize > budget_.Budget)
+    {
+        EvictCompleted(budget_.Usage + residentSize - budget_.Budget, completedValue);
+    }
+
+    device_.MakeResident(residentObjects_);
+    numMadeResident_ += residentObjects_.size();
+}
+
+void ResidencyManager::Update(uint64_t completedValue)
+{
+    budget_ = device_.QueryBudget();
+    if (budget_.Usage > budget_.Budget)
+    {
+        EvictCompleted(budget_.Usage - budget_.Budget, completedValue);
+    }
+}
+
+ResidencyManager::Statistics ResidencyManager::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.Budget = budget_;
+    statistics.NumEvictions = numEvictions_;
+    statistics.NumMadeResident = numMadeResident_;
+    statistics.Categories.resize(categoryNames_.size());
+    for (const Record& record : records_)
+    {
+        if (!record.Tracked)
+        {
+            continue;
+        }
+        CategoryStatistics& category = statistics.Categories[record.Category];
+        if (record.Resident)
+        {
+            category.NumResident++;
+            category.ResidentSize += record.Size;
+        }
+        else
+        {
+            category.NumEvicted++;
+            category.EvictedSize += record.Size;
+        }
+    }
+    return statistics;
+}
+
+void ResidencyManager::Unlink(Handle handle)
+{
+    Record& record = records_[handle];
+    if (record.Previous != kInvalidHandle)
+    {
+        records_[record.Previous].Next = record.Next;
+    }
+    else
+    {
+        leastRecent_ = record.Next;
+    }
+    if (record.Next != kInvalidHandle)
+    {
+        records_[record.Next].Previous = record.Previous;
+    }
+    else
+    {
+        mostRecent_ = record.Previous;
+    }
+    record.Previous = kInvalidHandle;
+    record.Next = kInvalidHandle;
+}
+
+void ResidencyManager::LinkAtFront(Handle handle)
+{
+    Record& record = records_[handle];
+    record.Previous = kInvalidHandle;
+    record.Next = leastRecent_;
+    if (leastRecent_ != kInvalidHandle)
+    {
+        records_[leastRecent_].Previous = handle;
+    }
+    else
+    {
+        mostRecent_ = handle;
+    }
+    leastRecent_ = handle;
+}
+
+void ResidencyManager::LinkAtEnd(Handle handle)
+{
+    Record& record = records_[handle];
+    record.Previous = mostRecent_;
+    record.Next = kInvalidHandle;
+    if (mostRecent_ != kInvalidHandle)
+    {
+        records_[mostRecent_].Next = handle;
+    }
+    else
+    {
+        leastRecent_ = handle;
+    }
+    mostRecent_ = handle;
+}
+
+void ResidencyManager::EvictCompleted(uint64_t size, uint64_t completedValue)
+{
+    // The list is in last use order, evicted objects stay in it at the place of their last use.
+    evictedObjects_.clear();
+    uint64_t evictedSize = 0;
+    for (Handle handle = leastRecent_; handle != kInvalidHandle && evictedSize < size; handle = records_[handle].Next)
+    {
+        Record& record = records_[handle];
+        if (record.LastUse > completedValue)
+        {
+            break;
+        }
+        if (record.Resident)
+        {
+            evictedObjects_.push_back({ record.Object, record.Size });
+            evictedSize += record.Size;
+            record.Resident = false;
+        }
+    }
+    if (!evictedObjects_.empty())
+    {
+        device_.Evict(evictedObjects_);
+        numEvictions_ += evictedObjects_.size();
+    }
+}
+
+}; // namespace graphics
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace graphics
+{
+
+struct MemoryBudget
+{
+    // Bytes the OS lets the process use before it starts to suffer
+    uint64_t Budget = 0;
+    // Bytes the process uses, managed by a ResidencyManager or not
+    uint64_t Usage = 0;
+};
+
+struct ResidencyObject
+{
+    void* Object;
+    uint64_t Size;
+};
+
+//
+// Memory a ResidencyManager evicts from and makes resident in.
+// D3D12ResidencyDevice queries the adapter's budget, SimulatedResidencyDevice has one set by hand.
+//
+class ResidencyDevice
+{
+public:
+    virtual ~ResidencyDevice() {}
+
+    virtual MemoryBudget QueryBudget() const = 0;
+
+    virtual void MakeResident(const std::vector<ResidencyObject>& objects) = 0;
+    virtual void Evict(const std::vector<ResidencyObject>& objects) = 0;
+};
+
+class SimulatedResidencyDevice : public ResidencyDevice
+{
+public:
+    explicit SimulatedResidencyDevice(uint64_t budget);
+
+    void SetBudget(uint64_t budget);
+
+    // Emulates creating and releasing memory, which is resident while it exists.
+    void AddUsage(uint64_t size);
+    void RemoveUsage(uint64_t size);
+
+    virtual MemoryBudget QueryBudget() const override;
+    virtual void MakeResident(const std::vector<ResidencyObject>& objects) override;
+    virtual void Evict(const std::vector<ResidencyObject>& objects) override;
+
+private:
+    uint64_t budget_;
+    uint64_t usage_;
+};
+
+//
+// Keeps the resident memory of a process within its budget, evicting the least recently used objects.
+//
+// Objects are tracked with their size, a category for the statistics, and the fence value of their last use.
+// Use() is called before submitting command lists with the objects they access: evicted ones are made resident
+// again, after evicting others if the budget requires it. Update() is called once per frame and evicts while
+// the usage exceeds the budget. Only objects whose last use has completed are evicted, oldest use first, so the
+// GPU never accesses evicted memory.
+//
+// Objects are whatever the device understands, ID3D12Pageable* for D3D12ResidencyDevice. Not thread safe.
+//
+class ResidencyManager
+{
+public:
+    using Handle = uint32_t;
+    static const Handle kInvalidHandle = ~0u;
+
+    struct CategoryStatistics
+    {
+        uint32_t NumResident = 0;
+        uint32_t NumEvicted = 0;
+        uint64_t ResidentSize = 0;
+        uint64_t EvictedSize = 0;
+    };
+
+    struct Statistics
+    {
+        // As of the last query
+        MemoryBudget Budget;
+        // Since creation
+        uint64_t NumEvictions = 0;
+        uint64_t NumMadeResident = 0;
+        // Indexed by category
+        std::vector<CategoryStatistics> Categories;
+    };
+
+    // Categories are the indices into `categoryNames`.
+    ResidencyManager(ResidencyDevice& device, std::vector<std::string> categoryNames);
+
+    ResidencyManager(const ResidencyManager&) = delete;
+    ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+    // `object` is resident, as created, until evicted.
+    Handle Track(void* object, uint64_t size, uint32_t category);
+    // Before the object is released, its last use has to have completed.
+    void Untrack(Handle handle);
+
+    // Mark the objects as used by the submission signaling `fenceValue`, and make the evicted ones resident.
+    // `completedValue` tells which objects may be evicted to make room.
+    void Use(const Handle* handles, size_t numHandles, uint64_t fenceValue, uint64_t completedValue);
+
+    // Evict until the usage is within the budget, or no object is left whose last use has completed.
+    void Update(uint64_t completedValue);
+
+    bool IsResident(Handle handle) const { return records_[handle].Resident; }
+
+    Statistics GetStatistics() const;
+    const std::string& GetCategoryName(uint32_t category) const { return categoryNames_[category]; }
+
+private:
+    struct Record
+    {
+        void* Object;
+        uint64_t Size;
+        uint32_t Category;
+        uint64_t LastUse;
+        bool Resident;
+        bool Tracked;
+        // Neighbours in the list from least to most recently used
+        Handle Previous;
+        Handle Next;
+    };
+
+    void Unlink(Handle handle);
+    void LinkAtFront(Handle handle);
+    void LinkAtEnd(Handle handle);
+
+    // Evict least recently used objects until `size` bytes have been evicted, as far as `completedValue` allows.
+    void EvictCompleted(uint64_t size, uint64_t completedValue);
+
+    ResidencyDevice& device_;
+    std::vector<std::string> categoryNames_;
+
+    std::vector<Record> records_;
+    std::vector<Handle> unusedHandles_;
+    Handle leastRecent_ = kInvalidHandle;
+    Handle mostRecent_ = kInvalidHandle;
+
+    MemoryBudget budget_;
+    uint64_t numEvictions_ = 0;
+    uint64_t numMadeResident_ = 0;
+
+    // Scratch storage for the device calls
+    std::vector<ResidencyObject> residentObjects_;
+    std::vector<ResidencyObject> evictedObjects_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,144 @@
+#include "ResourceStateTracker.h"
+
+#include <cassert>
+
+namespace graphics
+{
+
+//
+// ResourceStateRegistry
+//
+void ResourceStateRegistry::Register(ResourceKey resource, ResourceStateMask state)
+{
+    states_[resource] = state;
+}
+
+void ResourceStateRegistry::Unregister(ResourceKey resource)
+{
+    states_.erase(resource);
+}
+
+bool ResourceStateRegistry::IsRegistered(ResourceKey resource) const
+{
+    return states_.find(resource) != states_.end();
+}
+
+ResourceStateMask ResourceStateRegistry::GetState(ResourceKey resource) const
+{
+    auto it = states_.find(resource);
+    assert(it != states_.end() && "Resource is not registered");
+    return it != states_.end() ? it->second : 0;
+}
+
+void ResourceStateRegistry::SetState(ResourceKey resource, ResourceStateMask state)
+{
+    states_[resource] = state;
+}
+
+//
+// ResourceStateTracker
+//
+ResourceStateTracker::ResourceStateTracker(ResourceStateMask writeStateMask) :
+    writeStateMask_(writeStateMask)
+{
+}
+
+void ResourceStateTracker::Reset()
+{
+    firstUses_.clear();
+    currentStates_.clear();
+    pendingBarriers_.clear();
+}
+
+void ResourceStateTracker::Transition(ResourceKey resource, ResourceStateMask stateAfter)
+{
+    statistics_.NumRequested++;
+
+    auto current = currentStates_.find(resource);
+    if (current == currentStates_.end())
+    {
+        // First use in this list, the state before is only known at submit.
+        firstUses_.emplace_back(resource, stateAfter);
+        currentStates_.emplace(resource, stateAfter);
+        return;
+    }
+
+    if (IsRedundant(current->second, stateAfter))
+    {
+        return;
+    }
+
+    // A resource transitioned again before the flush: A->B then B->C becomes A->C, and A->A disappears.
+    for (auto it = pendingBarriers_.begin(); it != pendingBarriers_.end(); ++it)
+    {
+        if (it->Resource == resource)
+        {
+            it->After = stateAfter;
+            if (it->Before == it->After)
+            {
+                pendingBarriers_.erase(it);
+            }
+            current->second = stateAfter;
+            return;
+        }
+    }
+
+    pendingBarriers_.push_back({ resource, current->second, stateAfter });
+    current->second = stateAfter;
+}
+
+size_t ResourceStateTracker::FlushBarriers(std::vector<StateTransition>& barriers)
+{
+    const size_t numBarriers = pendingBarriers_.size();
+    if (numBarriers > 0)
+    {
+        barriers.insert(barriers.end(), pendingBarriers_.begin(), pendingBarriers_.end());
+        pendingBarriers_.clear();
+
+        statistics_.NumEmitted += numBarriers;
+        statistics_.NumFlushes++;
+    }
+    return numBarriers;
+}
+
+size_t ResourceStateTracker::Resolve(ResourceStateRegistry& registry, std::vector<StateTransition>& barriers)
+{
+    assert(pendingBarriers_.empty() && "FlushBarriers() must be called before the command list is closed");
+
+    size_t numBarriers = 0;
+    for (const auto& firstUse : firstUses_)
+    {
+        // Only an exact match is skipped: the state within this list starts at the first-use state, so a broader
+        // read state would leave the barriers recorded after it with the wrong state before.
+        const ResourceStateMask globalState = registry.GetState(firstUse.first);
+        if (globalState != firstUse.second)
+        {
+            barriers.push_back({ firstUse.first, globalState, firstUse.second });
+            numBarriers++;
+        }
+    }
+
+    for (const auto& current : currentStates_)
+    {
+        registry.SetState(current.first, current.second);
+    }
+
+    statistics_.NumEmitted += numBarriers;
+    Reset();
+
+    return numBarriers;
+}
+
+bool ResourceStateTracker::IsRedundant(ResourceStateMask current, ResourceStateMask requested) const
+{
+    if (current == requested)
+    {
+        return true;
+    }
+
+    // Combined read states, e.g. a generic read state already covers a vertex buffer read.
+    const bool bothReadOnly = (current & writeStateMask_) == 0 && (requested & writeStateMask_) == 0;
+    return bothReadOnly && requested != 0 && (current & requested) == requested;
+}
+
+}; // namespace graphics
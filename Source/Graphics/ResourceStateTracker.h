@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace graphics
+{
+
+using ResourceKey = const void*;
+using ResourceStateMask = uint32_t;
+
+struct StateTransition
+{
+    ResourceKey Resource;
+    ResourceStateMask Before;
+    ResourceStateMask After;
+};
+
+//
+// Global state of every tracked resource, as of the end of the last submitted command list.
+//
+class ResourceStateRegistry
+{
+public:
+    void Register(ResourceKey resource, ResourceStateMask state);
+    void Unregister(ResourceKey resource);
+
+    bool IsRegistered(ResourceKey resource) const;
+    ResourceStateMask GetState(ResourceKey resource) const;
+    void SetState(ResourceKey resource, ResourceStateMask state);
+
+private:
+    std::unordered_map<ResourceKey, ResourceStateMask> states_;
+};
+
+//
+// Records the states resources are used in while one command list is recorded.
+//
+// The first use of a resource in the list can't be resolved while recording, because earlier lists may not
+// have been submitted yet. It is remembered and resolved by Resolve() at submit time against the registry,
+// the resulting transitions go into a small prologue list executed right before. Later uses produce
+// transitions locally, which are merged and deduplicated until FlushBarriers() hands them out as one batch.
+//
+// States are opaque bit masks. Within a list, a request is redundant when it equals the current state, or when
+// both are read-only and the current state already contains every requested bit; `writeStateMask` defines which
+// bits are writable. A first use is only resolved as redundant when it equals the global state.
+//
+class ResourceStateTracker
+{
+public:
+    struct Statistics
+    {
+        size_t NumRequested = 0;
+        size_t NumEmitted = 0;
+        size_t NumFlushes = 0;
+    };
+
+    explicit ResourceStateTracker(ResourceStateMask writeStateMask);
+
+    // Start tracking a new command list.
+    void Reset();
+
+    void Transition(ResourceKey resource, ResourceStateMask stateAfter);
+
+    // Move the transitions recorded since the previous flush into `barriers`, returns how many were added.
+    size_t FlushBarriers(std::vector<StateTransition>& barriers);
+
+    // Append the transitions from the global states to the first-use states into `barriers`, and commit
+    // the final states of this list to `registry`. Call once, after the list is closed and right before it is executed.
+    size_t Resolve(ResourceStateRegistry& registry, std::vector<StateTransition>& barriers);
+
+    const Statistics& GetStatistics() const { return statistics_; }
+    void ResetStatistics() { statistics_ = Statistics(); }
+
+private:
+    bool IsRedundant(ResourceStateMask current, ResourceStateMask requested) const;
+
+    ResourceStateMask writeStateMask_;
+
+    // First requested state of each resource in this list, to be resolved at submit
+    std::vector<std::pair<ResourceKey, ResourceStateMask>> firstUses_;
+    // Current state of each resource within this list
+    std::unordered_map<ResourceKey, ResourceStateMask> currentStates_;
+    // Transitions waiting for the next flush
+    std::vector<StateTransition> pendingBarriers_;
+
+    Statistics statistics_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,94 @@
+#include "RingAllocator.h"
+
+namespace graphics
+{
+
+RingAllocator::RingAllocator(uint64_t size) :
+    size_(size),
+    head_(0),
+    tail_(0),
+    usedSize_(0),
+    currentBatchSize_(0)
+{
+}
+
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0 || size > size_)
+    {
+        return kInvalidOffset;
+    }
+
+    // Nothing in flight, start over from the beginning to get the largest contiguous range.
+    if (usedSize_ == 0)
+    {
+        head_ = 0;
+        tail_ = 0;
+    }
+
+    uint64_t offset = kInvalidOffset;
+    uint64_t consumed = 0;
+    if (usedSize_ == 0 || head_ > tail_)
+    {
+        // Free space is [head_, size_) followed by [0, tail_)
+        const uint64_t alignedHead = AlignUp(head_, alignment);
+        if (alignedHead + size <= size_)
+        {
+            offset = alignedHead;
+            consumed = alignedHead - head_ + size;
+        }
+        else if (size <= tail_)
+        {
+            // Wrap around, the remainder of the ring is wasted until this batch is released.
+            offset = 0;
+            consumed = size_ - head_ + size;
+        }
+    }
+    else if (head_ < tail_)
+    {
+        // Free space is [head_, tail_)
+        const uint64_t alignedHead = AlignUp(head_, alignment);
+        if (alignedHead + size <= tail_)
+        {
+            offset = alignedHead;
+            consumed = alignedHead - head_ + size;
+        }
+    }
+    // head_ == tail_ with a non-zero used size means the ring is full
+
+    if (offset != kInvalidOffset)
+    {
+        head_ = offset + size;
+        usedSize_ += consumed;
+        currentBatchSize_ += consumed;
+    }
+    return offset;
+}
+
+void RingAllocator::FinishBatch(uint64_t fenceValue)
+{
+    if (currentBatchSize_ == 0)
+    {
+        return;
+    }
+
+    batches_.push_back({ fenceValue, head_, currentBatchSize_ });
+    currentBatchSize_ = 0;
+}
+
+void RingAllocator::ReleaseCompleted(uint64_t completedValue)
+{
+    while (!batches_.empty() && batches_.front().FenceValue <= completedValue)
+    {
+        tail_ = batches_.front().End;
+        usedSize_ -= batches_.front().Size;
+        batches_.pop_front();
+    }
+}
+
+uint64_t RingAllocator::GetOldestFenceValue() const
+{
+    return batches_.empty() ? 0 : batches_.front().FenceValue;
+}
+
+}; // namespace graphics
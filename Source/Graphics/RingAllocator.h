@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+
+#include "Alignment.h"
+
+namespace graphics
+{
+
+//
+// Offset allocator over a fixed size ring with fence based reclamation.
+//
+// Allocations are grouped into batches. FinishBatch() tags every allocation made since the previous
+// batch with the fence value signaled after the GPU work using them, and ReleaseCompleted() returns
+// whole batches to the ring once their fence value has been reached. Only offsets are managed, so the
+// same allocator backs upload heaps, readback heaps or anything else addressed by byte offset.
+//
+class RingAllocator
+{
+public:
+    static const uint64_t kInvalidOffset = ~0ull;
+
+    explicit RingAllocator(uint64_t size);
+
+    // Returns kInvalidOffset when the ring can't fit the request until earlier batches are released.
+    uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+    // Close the current batch, its allocations can be reclaimed once the fence reaches `fenceValue`.
+    void FinishBatch(uint64_t fenceValue);
+
+    // Reclaim every finished batch whose fence value is not greater than `completedValue`.
+    void ReleaseCompleted(uint64_t completedValue);
+
+    // Fence value of the oldest batch still in flight, 0 if there is none.
+    uint64_t GetOldestFenceValue() const;
+
+    uint64_t GetSize() const { return size_; }
+    uint64_t GetUsedSize() const { return usedSize_; }
+    uint64_t GetCurrentBatchSize() const { return currentBatchSize_; }
+    size_t GetNumBatchesInFlight() const { return batches_.size(); }
+
+private:
+    struct Batch
+    {
+        uint64_t FenceValue;
+        uint64_t End;
+        uint64_t Size;
+    };
+
+    uint64_t size_;
+    uint64_t head_;
+    uint64_t tail_;
+    uint64_t usedSize_;
+    uint64_t currentBatchSize_;
+    std::deque<Batch> batches_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,91 @@
+#include "RootSignatureHash.h"
+
+#include <cstring>
+
+#include "Hash.h"
+
+namespace graphics
+{
+
+uint64_t HashRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC1& desc)
+{
+    Hasher hasher;
+
+    hasher.AppendValue(desc.NumParameters);
+    for (UINT index = 0; index < desc.NumParameters; index++)
+    {
+        const D3D12_ROOT_PARAMETER1& parameter = desc.pParameters[index];
+        hasher.AppendValue(parameter.ParameterType);
+        hasher.AppendValue(parameter.ShaderVisibility);
+
+        switch (parameter.ParameterType)
+        {
+        case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            hasher.AppendValue(parameter.DescriptorTable.NumDescriptorRanges);
+            // D3D12_DESCRIPTOR_RANGE1 only has 4-byte fields
+            hasher.Append(parameter.DescriptorTable.pDescriptorRanges, sizeof(D3D12_DESCRIPTOR_RANGE1) * parameter.DescriptorTable.NumDescriptorRanges);
+            break;
+        case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            hasher.AppendValue(parameter.Constants);
+            break;
+        default:
+            hasher.AppendValue(parameter.Descriptor);
+            break;
+        }
+    }
+
+    // D3D12_STATIC_SAMPLER_DESC only has 4-byte fields
+    hasher.AppendValue(desc.NumStaticSamplers);
+    hasher.Append(desc.pStaticSamplers, sizeof(D3D12_STATIC_SAMPLER_DESC) * desc.NumStaticSamplers);
+
+    hasher.AppendValue(desc.Flags);
+
+    return hasher.Get();
+}
+
+bool RootSignatureDescEquals(const D3D12_ROOT_SIGNATURE_DESC1& a, const D3D12_ROOT_SIGNATURE_DESC1& b)
+{
+    if (a.NumParameters != b.NumParameters || a.NumStaticSamplers != b.NumStaticSamplers || a.Flags != b.Flags)
+    {
+        return false;
+    }
+
+    for (UINT index = 0; index < a.NumParameters; index++)
+    {
+        const D3D12_ROOT_PARAMETER1& parameterA = a.pParameters[index];
+        const D3D12_ROOT_PARAMETER1& parameterB = b.pParameters[index];
+        if (parameterA.ParameterType != parameterB.ParameterType || parameterA.ShaderVisibility != parameterB.ShaderVisibility)
+        {
+            return false;
+        }
+
+        switch (parameterA.ParameterType)
+        {
+        case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            if (parameterA.DescriptorTable.NumDescriptorRanges != parameterB.DescriptorTable.NumDescriptorRanges ||
+                (parameterA.DescriptorTable.NumDescriptorRanges > 0 && memcmp(parameterA.DescriptorTable.pDescriptorRanges, parameterB.DescriptorTable.pDescriptorRanges,
+                    sizeof(D3D12_DESCRIPTOR_RANGE1) * parameterA.DescriptorTable.NumDescriptorRanges) != 0))
+            {
+                return false;
+            }
+            break;
+        case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            if (memcmp(&parameterA.Constants, &parameterB.Constants, sizeof(D3D12_ROOT_CONSTANTS)) != 0)
+            {
+                return false;
+            }
+            break;
+        default:
+            if (memcmp(&parameterA.Descriptor, &parameterB.Descriptor, sizeof(D3D12_ROOT_DESCRIPTOR1)) != 0)
+            {
+                return false;
+            }
+            break;
+        }
+    }
+
+    return a.NumStaticSamplers == 0 ||
+        memcmp(a.pStaticSamplers, b.pStaticSamplers, sizeof(D3D12_STATIC_SAMPLER_DESC) * a.NumStaticSamplers) == 0;
+}
+
+}; // namespace graphics
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+#include <d3d12.h>
+
+namespace graphics
+{
+
+// Stable hash of a version 1.1 root signature description, everything behind its pointers included.
+uint64_t HashRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC1& desc);
+
+// Deep comparison, to tell hash collisions from equal layouts.
+bool RootSignatureDescEquals(const D3D12_ROOT_SIGNATURE_DESC1& a, const D3D12_ROOT_SIGNATURE_DESC1& b);
+
+}; // namespace graphics
@@ -0,0 +1,122 @@
+#include "RootSignatureRegistry.h"
+
+#include <cassert>
+#include <vector>
+
+#include "GraphicsUtil.h"
+#include "RootSignatureHash.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+namespace
+{
+
+// Bump when the hashing of descriptions changes.
+const uint64_t kRootSignatureCacheKey = 1;
+
+ComPtr<ID3D12VersionedRootSignatureDeserializer> Deserialize(const std::vector<uint8_t>& blob)
+{
+    ComPtr<ID3D12VersionedRootSignatureDeserializer> deserializer;
+    if (FAILED(D3D12CreateVersionedRootSignatureDeserializer(blob.data(), blob.size(), IID_PPV_ARGS(&deserializer))))
+    {
+        return nullptr;
+    }
+    return deserializer;
+}
+
+bool Matches(ID3D12VersionedRootSignatureDeserializer* deserializer, const D3D12_ROOT_SIGNATURE_DESC1& desc)
+{
+    const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* deserializedDesc = nullptr;
+    return SUCCEEDED(deserializer->GetRootSignatureDescAtVersion(D3D_ROOT_SIGNATURE_VERSION_1_1, &deserializedDesc)) &&
+        RootSignatureDescEquals(deserializedDesc->Desc_1_1, desc);
+}
+
+};
+
+RootSignatureRegistry::RootSignatureRegistry(ID3D12Device* device, const std::string& path) :
+    device_(device),
+    blobCache_(path, kRootSignatureCacheKey)
+{
+}
+
+ComPtr<ID3D12RootSignature> RootSignatureRegistry::Get(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc, uint64_t* hash)
+{
+    assert(desc.Version == D3D_ROOT_SIGNATURE_VERSION_1_1 && "Only version 1.1 root signatures are supported");
+
+    const uint64_t descHash = HashRootSignatureDesc(desc.Desc_1_1);
+    if (hash != nullptr)
+    {
+        *hash = descHash;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics_.NumRequests++;
+
+    auto range = entries_.equal_range(descHash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (Matches(it->second.Deserializer.Get(), desc.Desc_1_1))
+        {
+            statistics_.NumShared++;
+            return it->second.RootSignature;
+        }
+    }
+
+    // Reuse the blob serialized by an earlier run when it describes the same layout.
+    Entry entry;
+    std::vector<uint8_t> blob;
+    if (blobCache_.Find(descHash, blob))
+    {
+        entry.Deserializer = Deserialize(blob);
+        if (entry.Deserializer && Matches(entry.Deserializer.Get(), desc.Desc_1_1))
+        {
+            statistics_.NumBlobHits++;
+        }
+        else
+        {
+            entry.Deserializer = nullptr;
+        }
+    }
+
+    if (!entry.Deserializer)
+    {
+        ComPtr<ID3DBlob> signature;
+        ComPtr<ID3DBlob> error;
+        const HRESULT hr = D3D12SerializeVersionedRootSignature(&desc, &signature, &error);
+        ThrowIfFailed(hr, error ? static_cast<const char*>(error->GetBufferPointer()) : "D3D12SerializeVersionedRootSignature");
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(signature->GetBufferPointer());
+        blob.assign(bytes, bytes + signature->GetBufferSize());
+        entry.Deserializer = Deserialize(blob);
+        if (!entry.Deserializer)
+        {
+            ThrowIfFailed(E_FAIL, "D3D12CreateVersionedRootSignatureDeserializer");
+        }
+
+        // Two different layouts with the same hash: the newer one takes the file slot.
+        blobCache_.Insert(descHash, blob.data(), blob.size());
+        statistics_.NumSerialized++;
+    }
+
+    ThrowIfFailed(device_->CreateRootSignature(0, blob.data(), blob.size(), IID_PPV_ARGS(&entry.RootSignature)), "CreateRootSignature");
+    ComPtr<ID3D12RootSignature> rootSignature = entry.RootSignature;
+    entries_.emplace(descHash, std::move(entry));
+
+    return rootSignature;
+}
+
+bool RootSignatureRegistry::Save()
+{
+    return blobCache_.Save();
+}
+
+RootSignatureRegistry::Statistics RootSignatureRegistry::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+}; // namespace graphics
@@ -0,0 +1,66 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "BlobCache.h"
+
+namespace graphics
+{
+
+//
+// Shared root signatures keyed by the hash of their version 1.1 description.
+//
+// Equal layouts get the same object. Serialized blobs are kept in a BlobCache, so later runs create the
+// root signature straight from the blob instead of serializing the description again. Cached blobs are
+// deserialized and compared with the request before use, a hash collision or a stale file only costs a
+// serialization. Thread safe.
+//
+class RootSignatureRegistry
+{
+public:
+    struct Statistics
+    {
+        size_t NumRequests = 0;
+        size_t NumShared = 0;
+        size_t NumBlobHits = 0;
+        size_t NumSerialized = 0;
+    };
+
+    // An empty path keeps the serialized blobs in memory only.
+    RootSignatureRegistry(ID3D12Device* device, const std::string& path);
+
+    RootSignatureRegistry(const RootSignatureRegistry&) = delete;
+    RootSignatureRegistry& operator=(const RootSignatureRegistry&) = delete;
+
+    // `desc` must be D3D_ROOT_SIGNATURE_VERSION_1_1. `hash` receives the key to pass to the PipelineStateCache.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> Get(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc, uint64_t* hash = nullptr);
+
+    // Write the blobs serialized since the cache file was loaded.
+    bool Save();
+
+    Statistics GetStatistics() const;
+
+private:
+    struct Entry
+    {
+        // Owns a copy of the description, used to compare later requests.
+        Microsoft::WRL::ComPtr<ID3D12VersionedRootSignatureDeserializer> Deserializer;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignature;
+    };
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    BlobCache blobCache_;
+
+    mutable std::mutex mutex_;
+    std::unordered_multimap<uint64_t, Entry> entries_;
+    Statistics statistics_;
+};
+
+}; // namespace graphics
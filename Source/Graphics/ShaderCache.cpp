@@ -0,0 +1,162 @@
+#include "ShaderCache.h"
+
+#include <d3dcompiler.h>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "GraphicsUtil.h"
+#include "Hash.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+namespace
+{
+
+// Bump when the key layout changes.
+const uint64_t kShaderStoreKey = 1;
+
+bool ReadTextFile(const std::wstring& path, std::string& text)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string ToNarrow(const std::wstring& text)
+{
+    const int length = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+    std::string result(static_cast<size_t>(length), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &result[0], length, nullptr, nullptr);
+    return result;
+}
+
+std::string GetMessages(ID3DBlob* errors, const char* context)
+{
+    std::string message(context);
+    if (errors != nullptr)
+    {
+        message += ":\n";
+        message.append(static_cast<const char*>(errors->GetBufferPointer()), errors->GetBufferSize());
+    }
+    return message;
+}
+
+//
+// Opens includes relative to the directory of the root file, and feeds every file it opens to the key.
+//
+class RecordingInclude : public ID3DInclude
+{
+public:
+    RecordingInclude(const std::wstring& directory, Hasher& hasher) : directory_(directory), hasher_(hasher) {}
+
+    HRESULT __stdcall Open(D3D_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* data, UINT* bytes) override
+    {
+        (void)includeType;
+        (void)parentData;
+
+        const std::string name(fileName);
+        std::string text;
+        if (!ReadTextFile(directory_ + std::wstring(name.begin(), name.end()), text))
+        {
+            return E_FAIL;
+        }
+
+        hasher_.AppendString(fileName);
+        hasher_.AppendString(text.c_str());
+
+        char* copy = new char[text.size()];
+        memcpy(copy, text.data(), text.size());
+        *data = copy;
+        *bytes = static_cast<UINT>(text.size());
+        return S_OK;
+    }
+
+    HRESULT __stdcall Close(LPCVOID data) override
+    {
+        delete[] static_cast<const char*>(data);
+        return S_OK;
+    }
+
+private:
+    std::wstring directory_;
+    Hasher& hasher_;
+};
+
+};
+
+ShaderCache::ShaderCache(const std::string& storePath, uint64_t maxSize) :
+    store_(storePath, kShaderStoreKey, maxSize)
+{
+}
+
+ComPtr<ID3DBlob> ShaderCache::CompileFromFile(const std::wstring& path, const D3D_SHADER_MACRO* defines,
+    const char* entryPoint, const char* target, UINT flags)
+{
+    std::string source;
+    if (!ReadTextFile(path, source))
+    {
+        throw std::runtime_error("Can't read shader " + ToNarrow(path));
+    }
+    const std::string sourceName = ToNarrow(path);
+
+    const size_t separator = path.find_last_of(L"/\\");
+    const std::wstring directory = separator != std::wstring::npos ? path.substr(0, separator + 1) : std::wstring();
+
+    // The include closure, in the order the preprocessor opens the files
+    Hasher includeHasher;
+    RecordingInclude include(directory, includeHasher);
+
+    ComPtr<ID3DBlob> preprocessed;
+    ComPtr<ID3DBlob> errors;
+    if (FAILED(D3DPreprocess(source.data(), source.size(), sourceName.c_str(), defines, &include, &preprocessed, &errors)))
+    {
+        throw std::runtime_error(GetMessages(errors.Get(), ("Preprocessing " + sourceName + " failed").c_str()));
+    }
+
+    Hasher hasher;
+    hasher.Append(preprocessed->GetBufferPointer(), preprocessed->GetBufferSize());
+    hasher.AppendValue(includeHasher.Get());
+    hasher.AppendString(entryPoint);
+    hasher.AppendString(target);
+    for (const D3D_SHADER_MACRO* define = defines; define != nullptr && define->Name != nullptr; define++)
+    {
+        hasher.AppendString(define->Name);
+        hasher.AppendString(define->Definition);
+    }
+    hasher.AppendValue(flags);
+    hasher.AppendValue(static_cast<uint32_t>(D3D_COMPILER_VERSION));
+    const uint64_t key = hasher.Get();
+
+    ComPtr<ID3DBlob> bytecode;
+    std::vector<uint8_t> cached;
+    if (store_.Find(key, cached))
+    {
+        ThrowIfFailed(D3DCreateBlob(cached.size(), &bytecode), "D3DCreateBlob");
+        memcpy(bytecode->GetBufferPointer(), cached.data(), cached.size());
+        return bytecode;
+    }
+
+    // The defines and includes are already applied by the preprocessor.
+    errors.Reset();
+    if (FAILED(D3DCompile(preprocessed->GetBufferPointer(), preprocessed->GetBufferSize(), sourceName.c_str(), nullptr, nullptr,
+        entryPoint, target, flags, 0, &bytecode, &errors)))
+    {
+        throw std::runtime_error(GetMessages(errors.Get(), ("Compiling " + sourceName + " " + entryPoint + " failed").c_str()));
+    }
+
+    store_.Insert(key, bytecode->GetBufferPointer(), bytecode->GetBufferSize());
+    return bytecode;
+}
+
+}; // namespace graphics
@@ -0,0 +1,45 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3dcommon.h>
+
+#include <string>
+
+#include "ShaderStore.h"
+
+namespace graphics
+{
+
+//
+// Runtime HLSL compilation through a content addressed ShaderStore.
+//
+// The source is preprocessed first, and the key hashes the preprocessed text, the include closure, the entry point,
+// the target profile, the defines, the flags and the compiler version. An unchanged shader costs a preprocess and a
+// lookup in the memory mapped store, only a miss goes through D3DCompile.
+//
+class ShaderCache
+{
+public:
+    static const uint64_t kDefaultMaxSize = 64 * 1024 * 1024;
+
+    // An empty path keeps the compiled shaders in memory only.
+    explicit ShaderCache(const std::string& storePath, uint64_t maxSize = kDefaultMaxSize);
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    // Includes are resolved relative to the directory of `path`. Throws with the compiler messages on failure.
+    Microsoft::WRL::ComPtr<ID3DBlob> CompileFromFile(const std::wstring& path, const D3D_SHADER_MACRO* defines,
+        const char* entryPoint, const char* target, UINT flags);
+
+    bool Save() { return store_.Save(); }
+
+    ShaderStore::Statistics GetStatistics() const { return store_.GetStatistics(); }
+
+private:
+    ShaderStore store_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,161 @@
+#include "ShaderReloader.h"
+
+#include <exception>
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+namespace
+{
+
+std::wstring GetDirectory(const std::wstring& path)
+{
+    const size_t separator = path.find_last_of(L"/\\");
+    return separator != std::wstring::npos ? path.substr(0, separator) : std::wstring(L".");
+}
+
+std::string ToNarrow(const std::wstring& text)
+{
+    const int length = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+    std::string result(static_cast<size_t>(length), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &result[0], length, nullptr, nullptr);
+    return result;
+}
+
+};
+
+ShaderReloader::ShaderReloader(ShaderCache& cache) :
+    cache_(cache),
+    numCompiling_(0),
+    // One worker is plenty for edits made by hand, and keeps the compiles of one program in order.
+    threadPool_(1)
+{
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    threadPool_.WaitIdle();
+}
+
+ShaderReloader::ProgramHandle ShaderReloader::AddProgram(std::vector<ShaderSource> sources, ReloadCallback onReload)
+{
+    const ProgramHandle handle = static_cast<ProgramHandle>(programs_.size());
+
+    for (const ShaderSource& source : sources)
+    {
+        const std::wstring directory = GetDirectory(source.Path);
+        Watch* watch = nullptr;
+        for (Watch& existing : watches_)
+        {
+            if (existing.Directory == directory)
+            {
+                watch = &existing;
+                break;
+            }
+        }
+        if (watch == nullptr)
+        {
+            watches_.push_back({ directory, std::make_unique<FileWatcher>(ToNarrow(directory)), {} });
+            watch = &watches_.back();
+        }
+        if (watch->Programs.empty() || watch->Programs.back() != handle)
+        {
+            watch->Programs.push_back(handle);
+        }
+    }
+
+    programs_.push_back({ std::move(sources), std::move(onReload), false, false });
+    return handle;
+}
+
+size_t ShaderReloader::Poll()
+{
+    for (Watch& watch : watches_)
+    {
+        changedFiles_.clear();
+        if (!watch.Watcher->GetChanges(changedFiles_))
+        {
+            continue;
+        }
+
+        for (ProgramHandle handle : watch.Programs)
+        {
+            Program& program = programs_[handle];
+            if (program.Compiling)
+            {
+                program.Stale = true;
+            }
+            else
+            {
+                Compile(handle);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        publishing_.swap(completions_);
+    }
+
+    for (Completion& completion : publishing_)
+    {
+        Program& program = programs_[completion.Handle];
+        program.Compiling = false;
+        numCompiling_--;
+
+        if (program.Stale)
+        {
+            // The result is already outdated, skip it and start over.
+            program.Stale = false;
+            Compile(completion.Handle);
+            continue;
+        }
+
+        program.OnReload(completion.Handle, completion.Shaders, completion.Error);
+    }
+
+    const size_t numPublished = publishing_.size();
+    publishing_.clear();
+    return numPublished;
+}
+
+void ShaderReloader::Compile(ProgramHandle handle)
+{
+    Program& program = programs_[handle];
+    program.Compiling = true;
+    numCompiling_++;
+
+    // The sources never change after AddProgram(), but `programs_` may be reallocated meanwhile.
+    std::vector<ShaderSource> sources = program.Sources;
+    threadPool_.Submit([this, handle, sources]()
+        {
+            Completion completion = { handle, {}, std::string() };
+            try
+            {
+                for (const ShaderSource& source : sources)
+                {
+                    std::vector<D3D_SHADER_MACRO> defines;
+                    for (const auto& define : source.Defines)
+                    {
+                        defines.push_back({ define.first.c_str(), define.second.c_str() });
+                    }
+                    defines.push_back({ nullptr, nullptr });
+
+                    completion.Shaders.push_back(cache_.CompileFromFile(source.Path, defines.data(),
+                        source.EntryPoint.c_str(), source.Target.c_str(), source.Flags));
+                }
+            }
+            catch (const std::exception& exception)
+            {
+                completion.Shaders.clear();
+                completion.Error = exception.what();
+            }
+
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            completions_.push_back(std::move(completion));
+        });
+}
+
+}; // namespace graphics
@@ -0,0 +1,106 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3dcommon.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FileWatcher.h"
+#include "ShaderCache.h"
+#include "ThreadPool.h"
+
+namespace graphics
+{
+
+//
+// Recompiles shaders on a worker thread when their source files change.
+//
+// A program is a set of shaders which are always replaced together, e.g. the VS and PS of one pipeline. Each
+// directory holding a program source is watched, and any change in it recompiles the programs of that directory,
+// which also covers includes living next to the source. Results are published by Poll(), which the render thread
+// calls at frame boundaries, so the callback can swap pipelines without racing with command recording. A program
+// that fails to compile keeps its previous shaders, the callback gets the compiler messages instead.
+//
+class ShaderReloader
+{
+public:
+    struct ShaderSource
+    {
+        std::wstring Path;
+        std::string EntryPoint;
+        std::string Target;
+        std::vector<std::pair<std::string, std::string>> Defines;
+        UINT Flags = 0;
+    };
+
+    using ProgramHandle = uint32_t;
+    // `shaders` is in the order of the program's sources, empty when compilation failed.
+    using ReloadCallback = std::function<void(ProgramHandle handle, const std::vector<Microsoft::WRL::ComPtr<ID3DBlob>>& shaders,
+        const std::string& error)>;
+
+    explicit ShaderReloader(ShaderCache& cache);
+    ~ShaderReloader();
+
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    // Nothing is compiled right away, `onReload` runs on the render thread inside Poll() after a change.
+    ProgramHandle AddProgram(std::vector<ShaderSource> sources, ReloadCallback onReload);
+
+    // Start recompiling the programs whose directories changed, and publish the programs finished since the previous call.
+    // Never blocks on a compilation. Returns how many programs were published.
+    size_t Poll();
+
+    size_t GetNumCompiling() const { return numCompiling_; }
+
+private:
+    struct Program
+    {
+        std::vector<ShaderSource> Sources;
+        ReloadCallback OnReload;
+        bool Compiling;
+        // Changed again while compiling, compile once more when the current result is in.
+        bool Stale;
+    };
+
+    struct Watch
+    {
+        std::wstring Directory;
+        std::unique_ptr<FileWatcher> Watcher;
+        std::vector<ProgramHandle> Programs;
+    };
+
+    struct Completion
+    {
+        ProgramHandle Handle;
+        std::vector<Microsoft::WRL::ComPtr<ID3DBlob>> Shaders;
+        std::string Error;
+    };
+
+    void Compile(ProgramHandle handle);
+
+    ShaderCache& cache_;
+
+    // Only touched by the render thread
+    std::vector<Program> programs_;
+    std::vector<Watch> watches_;
+    size_t numCompiling_;
+    std::vector<std::string> changedFiles_;
+
+    std::mutex completionMutex_;
+    std::vector<Completion> completions_;
+    std::vector<Completion> publishing_;
+
+    // Declared last, so the worker is joined before the members it uses go away.
+    ThreadPool threadPool_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,255 @@
+#include "ShaderStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "CacheFile.h"
+#include "Hash.h"
+
+namespace graphics
+{
+
+namespace
+{
+
+const uint32_t kMagic = 0x54535347; // "GSST"
+const uint32_t kFormatVersion = 1;
+
+struct Header
+{
+    uint32_t Magic;
+    uint32_t FormatVersion;
+    uint64_t Key;
+    uint64_t Generation;
+    uint64_t NumEntries;
+};
+
+struct IndexEntry
+{
+    uint64_t Hash;
+    uint64_t Offset;
+    uint64_t Size;
+    uint64_t Checksum;
+    uint64_t LastUse;
+};
+
+};
+
+ShaderStore::ShaderStore(const std::string& path, uint64_t key, uint64_t maxSize) :
+    path_(path),
+    key_(key),
+    maxSize_(maxSize),
+    generation_(1),
+    totalSize_(0),
+    dirty_(false)
+{
+    Load();
+
+    // This run is a new generation, Save() evicts by the generation of the last use.
+    generation_++;
+}
+
+bool ShaderStore::Find(uint64_t hash, std::vector<uint8_t>& bytecode)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(hash);
+    if (it == entries_.end())
+    {
+        statistics_.NumMisses++;
+        return false;
+    }
+
+    Entry& entry = it->second;
+    if (HashBytes(entry.Data, static_cast<size_t>(entry.Size)) != entry.Checksum)
+    {
+        // Corrupted on disk, drop it and let the caller compile again.
+        totalSize_ -= entry.Size;
+        entries_.erase(it);
+        dirty_ = true;
+        statistics_.NumMisses++;
+        return false;
+    }
+
+    bytecode.assign(entry.Data, entry.Data + entry.Size);
+    if (entry.LastUse != generation_)
+    {
+        entry.LastUse = generation_;
+        dirty_ = true;
+    }
+    statistics_.NumHits++;
+    return true;
+}
+
+void ShaderStore::Insert(uint64_t hash, const void* bytecode, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(bytecode);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Entry& entry = entries_[hash];
+    totalSize_ -= entry.Size;
+    entry.Owned.assign(bytes, bytes + size);
+    entry.Data = entry.Owned.data();
+    entry.Size = size;
+    entry.Checksum = HashBytes(bytecode, size);
+    entry.LastUse = generation_;
+    totalSize_ += size;
+    dirty_ = true;
+}
+
+bool ShaderStore::Save()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty())
+    {
+        return false;
+    }
+    if (!dirty_)
+    {
+        return true;
+    }
+
+    // Most recently used first, whatever doesn't fit into the budget is evicted.
+    std::vector<std::pair<uint64_t, const Entry*>> kept;
+    kept.reserve(entries_.size());
+    for (const auto& entry : entries_)
+    {
+        kept.emplace_back(entry.first, &entry.second);
+    }
+    std::sort(kept.begin(), kept.end(), [](const std::pair<uint64_t, const Entry*>& a, const std::pair<uint64_t, const Entry*>& b)
+        {
+            return a.second->LastUse != b.second->LastUse ? a.second->LastUse > b.second->LastUse : a.first < b.first;
+        });
+
+    uint64_t keptSize = 0;
+    size_t numKept = 0;
+    for (size_t index = 0; index < kept.size(); index++)
+    {
+        // An entry larger than the whole budget never fits, it mustn't push out everything older.
+        const uint64_t size = kept[index].second->Size;
+        if (size > maxSize_)
+        {
+            continue;
+        }
+        if (keptSize + size > maxSize_)
+        {
+            break;
+        }
+        kept[numKept++] = kept[index];
+        keptSize += size;
+    }
+    const size_t numEvicted = kept.size() - numKept;
+    kept.resize(numKept);
+
+    const uint64_t dataOffset = sizeof(Header) + sizeof(IndexEntry) * numKept;
+    std::vector<uint8_t> data(static_cast<size_t>(dataOffset + keptSize));
+
+    const Header header = { kMagic, kFormatVersion, key_, generation_, numKept };
+    memcpy(data.data(), &header, sizeof(header));
+
+    uint64_t offset = dataOffset;
+    for (size_t index = 0; index < numKept; index++)
+    {
+        const Entry& entry = *kept[index].second;
+        const IndexEntry indexEntry = { kept[index].first, offset, entry.Size, entry.Checksum, entry.LastUse };
+        memcpy(data.data() + sizeof(Header) + sizeof(IndexEntry) * index, &indexEntry, sizeof(indexEntry));
+        if (entry.Size > 0)
+        {
+            memcpy(data.data() + offset, entry.Data, static_cast<size_t>(entry.Size));
+        }
+        offset += entry.Size;
+    }
+
+    // The mapping has to go before the file can be replaced on Windows. Entries still pointing into it take a
+    // copy first, so that a failed write loses nothing and the next Save() tries again.
+    for (auto& entry : entries_)
+    {
+        if (entry.second.Data != entry.second.Owned.data())
+        {
+            entry.second.Owned.assign(entry.second.Data, entry.second.Data + entry.second.Size);
+            entry.second.Data = entry.second.Owned.data();
+        }
+    }
+    file_.Close();
+    if (!WriteFileAtomic(path_, data.data(), data.size()))
+    {
+        return false;
+    }
+    statistics_.NumEvicted += numEvicted;
+
+    // Map the new file, which drops the evicted entries and the copies.
+    const uint64_t generation = generation_;
+    Load();
+    generation_ = generation;
+    dirty_ = false;
+
+    return true;
+}
+
+size_t ShaderStore::GetNumEntries() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+uint64_t ShaderStore::GetTotalSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalSize_;
+}
+
+ShaderStore::Statistics ShaderStore::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+void ShaderStore::Load()
+{
+    entries_.clear();
+    totalSize_ = 0;
+
+    if (path_.empty() || !file_.Open(path_))
+    {
+        return;
+    }
+
+    const uint8_t* data = file_.GetData();
+    const size_t size = file_.GetSize();
+
+    Header header = {};
+    if (size < sizeof(header))
+    {
+        file_.Close();
+        return;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.Magic != kMagic || header.FormatVersion != kFormatVersion || header.Key != key_ ||
+        header.NumEntries > (size - sizeof(header)) / sizeof(IndexEntry))
+    {
+        file_.Close();
+        return;
+    }
+
+    for (uint64_t index = 0; index < header.NumEntries; index++)
+    {
+        IndexEntry indexEntry;
+        memcpy(&indexEntry, data + sizeof(Header) + sizeof(IndexEntry) * index, sizeof(indexEntry));
+        if (indexEntry.Offset > size || indexEntry.Size > size - indexEntry.Offset)
+        {
+            continue;
+        }
+
+        Entry& entry = entries_[indexEntry.Hash];
+        entry.Data = data + indexEntry.Offset;
+        entry.Size = indexEntry.Size;
+        entry.Checksum = indexEntry.Checksum;
+        entry.LastUse = indexEntry.LastUse;
+        totalSize_ += indexEntry.Size;
+    }
+
+    generation_ = header.Generation;
+}
+
+}; // namespace graphics
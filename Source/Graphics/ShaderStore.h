@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace graphics
+{
+
+//
+// On-disk store of compiled shaders keyed by a content hash.
+//
+// The store file is memory mapped when it is opened and only its index is parsed, a lookup copies the bytecode
+// out of the mapping and checks it against the checksum recorded with it. New entries stay in memory until Save()
+// rewrites the file. Every open starts a new generation, entries remember the last generation that used them and
+// Save() evicts the least recently used ones until the store fits into `maxSize`. Thread safe.
+//
+class ShaderStore
+{
+public:
+    struct Statistics
+    {
+        size_t NumHits = 0;
+        size_t NumMisses = 0;
+        size_t NumEvicted = 0;
+    };
+
+    // `key` versions the content, a file written with another key is ignored.
+    ShaderStore(const std::string& path, uint64_t key, uint64_t maxSize);
+
+    ShaderStore(const ShaderStore&) = delete;
+    ShaderStore& operator=(const ShaderStore&) = delete;
+
+    bool Find(uint64_t hash, std::vector<uint8_t>& bytecode);
+    void Insert(uint64_t hash, const void* bytecode, size_t size);
+
+    // Write the store back if anything changed, evicting the least recently used entries beyond `maxSize`.
+    // A failed write returns false and keeps every entry in memory.
+    bool Save();
+
+    size_t GetNumEntries() const;
+    uint64_t GetTotalSize() const;
+    uint64_t GetGeneration() const { return generation_; }
+    Statistics GetStatistics() const;
+
+private:
+    struct Entry
+    {
+        // Either points into the mapping or into `Owned` for entries added since the store was opened.
+        const uint8_t* Data;
+        std::vector<uint8_t> Owned;
+        uint64_t Size;
+        uint64_t Checksum;
+        uint64_t LastUse;
+    };
+
+    void Load();
+
+    std::string path_;
+    uint64_t key_;
+    uint64_t maxSize_;
+    uint64_t generation_;
+
+    mutable std::mutex mutex_;
+    MappedFile file_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    uint64_t totalSize_;
+    bool dirty_;
+    Statistics statistics_;
+};
+
+}; // namespace graphics
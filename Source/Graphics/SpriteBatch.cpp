@@ -0,0 +1,148 @@
+#include "SpriteBatch.h"
+
+#include <cstring>
+
+#include "Alignment.h"
+
+namespace graphics
+{
+
+const uint32_t SpriteBatch::kStreamStrides[kNumStreams] = { sizeof(Float2), sizeof(Float2), sizeof(uint32_t) };
+
+void SpriteBatch::Reserve(size_t numInstances)
+{
+    materials_.reserve(numInstances);
+    centers_.reserve(numInstances);
+    extents_.reserve(numInstances);
+    colors_.reserve(numInstances);
+    order_.reserve(numInstances);
+}
+
+void SpriteBatch::Clear()
+{
+    materials_.clear();
+    centers_.clear();
+    extents_.clear();
+    colors_.clear();
+    lastMaterial_ = 0;
+    sorted_ = true;
+}
+
+uint64_t SpriteBatch::GetPackedSize() const
+{
+    return GetStreamOffset(kNumStreams);
+}
+
+uint64_t SpriteBatch::GetStreamOffset(Stream stream) const
+{
+    uint64_t offset = 0;
+    for (uint32_t index = 0; index < stream; index++)
+    {
+        offset = AlignUp(offset + GetNumInstances() * kStreamStrides[index], kStreamAlignment);
+    }
+    return offset;
+}
+
+const std::vector<SpriteBatch::MaterialRange>& SpriteBatch::Pack(void* destination)
+{
+    ranges_.clear();
+    const uint32_t numInstances = static_cast<uint32_t>(GetNumInstances());
+    if (numInstances == 0)
+    {
+        return ranges_;
+    }
+
+    uint8_t* bytes = static_cast<uint8_t*>(destination);
+    if (sorted_)
+    {
+        // Already grouped, the ranges are the runs of equal materials.
+        for (uint32_t index = 0; index < numInstances; index++)
+        {
+            if (ranges_.empty() || ranges_.back().Material != materials_[index])
+            {
+                ranges_.push_back({ materials_[index], index, 0 });
+            }
+            ranges_.back().NumInstances++;
+        }
+
+        memcpy(bytes + GetStreamOffset(kStreamCenter), centers_.data(), numInstances * sizeof(Float2));
+        memcpy(bytes + GetStreamOffset(kStreamExtent), extents_.data(), numInstances * sizeof(Float2));
+        memcpy(bytes + GetStreamOffset(kStreamColor), colors_.data(), numInstances * sizeof(uint32_t));
+        return ranges_;
+    }
+
+    // Counting sort, stable so that instances of one material keep the order they were added in.
+    counts_.clear();
+    for (uint32_t material : materials_)
+    {
+        if (material >= counts_.size())
+        {
+            counts_.resize(material + 1, 0);
+        }
+        counts_[material]++;
+    }
+
+    // The counts turn into the first output index of each material.
+    uint32_t first = 0;
+    for (uint32_t material = 0; material < static_cast<uint32_t>(counts_.size()); material++)
+    {
+        const uint32_t count = counts_[material];
+        if (count > 0)
+        {
+            ranges_.push_back({ material, first, count });
+        }
+        counts_[material] = first;
+        first += count;
+    }
+
+    // The permutation is built once and shared by all streams. Each stream is then gathered, so the scattered
+    // accesses are reads from cached memory and the writes to the destination stay sequential.
+    order_.resize(numInstances);
+    for (uint32_t index = 0; index < numInstances; index++)
+    {
+        order_[counts_[materials_[index]]++] = index;
+    }
+
+    Gather(centers_, bytes + GetStreamOffset(kStreamCenter));
+    Gather(extents_, bytes + GetStreamOffset(kStreamExtent));
+    Gather(colors_, bytes + GetStreamOffset(kStreamColor));
+    return ranges_;
+}
+
+template <typename T>
+void SpriteBatch::Gather(const std::vector<T>& source, void* destination) const
+{
+    T* output = static_cast<T*>(destination);
+    const T* input = source.data();
+    const size_t numInstances = order_.size();
+    for (size_t index = 0; index < numInstances; index++)
+    {
+        output[index] = input[order_[index]];
+    }
+}
+
+void SpriteBatch::Record(CommandStream& commands, uint64_t gpuAddress, uint32_t firstSlot, const MaterialFunction& bindMaterial) const
+{
+    if (ranges_.empty())
+    {
+        return;
+    }
+
+    // The same views serve every draw, StartInstanceLocation selects the material's instances.
+    commands::VertexBufferView views[kNumStreams];
+    for (uint32_t stream = 0; stream < kNumStreams; stream++)
+    {
+        views[stream].BufferLocation = gpuAddress + GetStreamOffset(static_cast<Stream>(stream));
+        views[stream].SizeInBytes = static_cast<uint32_t>(GetNumInstances() * kStreamStrides[stream]);
+        views[stream].StrideInBytes = kStreamStrides[stream];
+    }
+    commands.SetVertexBuffers(firstSlot, kNumStreams, views);
+
+    for (const MaterialRange& range : ranges_)
+    {
+        bindMaterial(commands, range.Material);
+        commands.Draw(4, range.NumInstances, 0, range.FirstInstance);
+    }
+}
+
+}; // namespace graphics
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "CommandStream.h"
+
+namespace graphics
+{
+
+//
+// Instanced quads, one draw per material.
+//
+// Instances are kept in a structure of arrays, one array per attribute, and every array becomes a
+// per-instance vertex stream of its own. Pack() groups the instances by material while copying the
+// streams into upload memory, after which Record() binds the streams once and issues one 4-vertex
+// triangle strip draw per material, the quad corners coming from SV_VertexID.
+//
+// Materials are small dense indices into a table owned by the caller, e.g. one entry per pipeline and
+// constant set. Instances added in non-decreasing material order are packed with plain copies.
+//
+class SpriteBatch
+{
+public:
+    struct Float2
+    {
+        float X;
+        float Y;
+    };
+
+    enum Stream : uint32_t
+    {
+        kStreamCenter,      // Float2
+        kStreamExtent,      // Float2, half of the quad's width and height
+        kStreamColor,       // RGBA8, red in the lowest byte
+        kNumStreams
+    };
+
+    struct MaterialRange
+    {
+        uint32_t Material;
+        uint32_t FirstInstance;
+        uint32_t NumInstances;
+    };
+
+    // Binds whatever `material` needs before its draw: pipeline, root signature, constants.
+    using MaterialFunction = std::function<void(CommandStream& commands, uint32_t material)>;
+
+    static const uint32_t kStreamStrides[kNumStreams];
+    static const uint64_t kStreamAlignment = 16;
+
+    void Reserve(size_t numInstances);
+
+    // Drop the instances of the previous frame, capacity is kept.
+    void Clear();
+
+    void Add(uint32_t material, float centerX, float centerY, float halfWidth, float halfHeight, uint32_t color)
+    {
+        sorted_ = sorted_ && material >= lastMaterial_;
+        lastMaterial_ = material;
+        materials_.push_back(material);
+        centers_.push_back({ centerX, centerY });
+        extents_.push_back({ halfWidth, halfHeight });
+        colors_.push_back(color);
+    }
+
+    size_t GetNumInstances() const { return materials_.size(); }
+
+    // Bytes Pack() writes, every stream starts at a kStreamAlignment boundary.
+    uint64_t GetPackedSize() const;
+    uint64_t GetStreamOffset(Stream stream) const;
+
+    // Write the streams grouped by material to `destination`, GetPackedSize() bytes aligned to kStreamAlignment.
+    // Writes are sequential, so `destination` may be write-combined upload memory.
+    // Returns the instances of each material in ascending material order, relative to the start of the streams.
+    const std::vector<MaterialRange>& Pack(void* destination);
+
+    // Bind the streams packed at `gpuAddress` to slots [firstSlot, firstSlot + kNumStreams), and record the draws of
+    // the last Pack(). The caller sets the topology independent state, `bindMaterial` runs before each draw.
+    void Record(CommandStream& commands, uint64_t gpuAddress, uint32_t firstSlot, const MaterialFunction& bindMaterial) const;
+
+    const std::vector<MaterialRange>& GetMaterialRanges() const { return ranges_; }
+
+private:
+    template <typename T>
+    void Gather(const std::vector<T>& source, void* destination) const;
+
+    std::vector<uint32_t> materials_;
+    std::vector<Float2> centers_;
+    std::vector<Float2> extents_;
+    std::vector<uint32_t> colors_;
+    uint32_t lastMaterial_ = 0;
+    bool sorted_ = true;
+
+    // Scratch of Pack(), kept to avoid allocating every frame.
+    std::vector<uint32_t> counts_;
+    std::vector<uint32_t> order_;
+    std::vector<MaterialRange> ranges_;
+};
+
+}; // namespace graphics
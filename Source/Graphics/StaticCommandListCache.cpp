@@ -0,0 +1,69 @@
+#include "StaticCommandListCache.h"
+
+#include "GraphicsUtil.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+StaticCommandListCache::StaticCommandListCache(ID3D12Device* device, UINT numSlots, D3D12_COMMAND_LIST_TYPE type) :
+    device_(device),
+    type_(type),
+    slots_(numSlots)
+{
+}
+
+ID3D12GraphicsCommandList* StaticCommandListCache::Get(UINT slot, uint64_t inputsHash, const RecordFunction& record)
+{
+    Slot& entry = slots_.at(slot);
+    if (entry.Recorded && entry.InputsHash == inputsHash)
+    {
+        statistics_.NumReused++;
+        return entry.CommandList.Get();
+    }
+
+    if (entry.CommandList)
+    {
+        ThrowIfFailed(entry.Allocator->Reset(), "Reset static command allocator");
+        ThrowIfFailed(entry.CommandList->Reset(entry.Allocator.Get(), nullptr), "Reset static command list");
+    }
+    else
+    {
+        ThrowIfFailed(device_->CreateCommandAllocator(type_, IID_PPV_ARGS(&entry.Allocator)), "CreateCommandAllocator for static command list");
+        ThrowIfFailed(device_->CreateCommandList(0, type_, entry.Allocator.Get(), nullptr, IID_PPV_ARGS(&entry.CommandList)), "CreateCommandList for static command list");
+    }
+
+    // A failed recording leaves the slot stale, the next Get() records it again. The list is closed for the
+    // Reset() of that call, or dropped if it can't be closed.
+    entry.Recorded = false;
+    try
+    {
+        record(entry.CommandList.Get(), slot);
+    }
+    catch (...)
+    {
+        if (FAILED(entry.CommandList->Close()))
+        {
+            entry.CommandList.Reset();
+            entry.Allocator.Reset();
+        }
+        throw;
+    }
+    ThrowIfFailed(entry.CommandList->Close(), "Close static command list");
+
+    entry.InputsHash = inputsHash;
+    entry.Recorded = true;
+    statistics_.NumRecorded++;
+    return entry.CommandList.Get();
+}
+
+void StaticCommandListCache::Invalidate()
+{
+    for (Slot& slot : slots_)
+    {
+        slot.Recorded = false;
+    }
+}
+
+}; // namespace graphics
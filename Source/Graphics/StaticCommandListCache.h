@@ -0,0 +1,67 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Command lists recorded once per slot, typically one per back buffer, and executed again every frame
+// while the inputs they were recorded from don't change.
+//
+// The caller hashes whatever the recording depends on (viewport size, pipeline state, bound resources and
+// views, the back buffer) into `inputsHash`. Get() returns the closed list of the slot, re-recorded only
+// when that hash differs from the one it was recorded with or after Invalidate(). A static scene therefore
+// costs one ExecuteCommandLists per frame, without allocator and list resets.
+//
+// Constant data read through a bound address may change freely, the list only holds the address. Re-recording
+// resets the slot's allocator, so the previous execution of the slot must have completed, the same rule as for
+// per-frame allocators. A list must not be executed again while an earlier execution of it is still running.
+//
+class StaticCommandListCache
+{
+public:
+    using RecordFunction = std::function<void(ID3D12GraphicsCommandList* commandList, UINT slot)>;
+
+    struct Statistics
+    {
+        size_t NumRecorded = 0;
+        size_t NumReused = 0;
+    };
+
+    StaticCommandListCache(ID3D12Device* device, UINT numSlots, D3D12_COMMAND_LIST_TYPE type = D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    StaticCommandListCache(const StaticCommandListCache&) = delete;
+    StaticCommandListCache& operator=(const StaticCommandListCache&) = delete;
+
+    // The closed list of `slot`. `record` gets an open list without pipeline state and must not close it.
+    ID3D12GraphicsCommandList* Get(UINT slot, uint64_t inputsHash, const RecordFunction& record);
+
+    // Re-record every slot on its next use, e.g. after the swap chain was resized.
+    void Invalidate();
+
+    const Statistics& GetStatistics() const { return statistics_; }
+
+private:
+    struct Slot
+    {
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> Allocator;
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> CommandList;
+        uint64_t InputsHash = 0;
+        bool Recorded = false;
+    };
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    D3D12_COMMAND_LIST_TYPE type_;
+    std::vector<Slot> slots_;
+    Statistics statistics_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,81 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace graphics
+{
+
+ThreadPool::ThreadPool(size_t numThreads) :
+    numRunning_(0),
+    stopping_(false)
+{
+    if (numThreads == 0)
+    {
+        const size_t numHardwareThreads = std::thread::hardware_concurrency();
+        numThreads = std::max<size_t>(numHardwareThreads > 1 ? numHardwareThreads - 1 : 1, 1);
+    }
+
+    for (size_t index = 0; index < numThreads; index++)
+    {
+        threads_.emplace_back(&ThreadPool::WorkerThread, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    taskCondition_.notify_all();
+
+    for (std::thread& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    taskCondition_.notify_one();
+}
+
+void ThreadPool::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idleCondition_.wait(lock, [this]() { return tasks_.empty() && numRunning_ == 0; });
+}
+
+void ThreadPool::WorkerThread()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        taskCondition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty())
+        {
+            // Stopping, and every queued task is done.
+            return;
+        }
+
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        numRunning_++;
+
+        lock.unlock();
+        task();
+        lock.lock();
+
+        numRunning_--;
+        if (tasks_.empty() && numRunning_ == 0)
+        {
+            idleCondition_.notify_all();
+        }
+    }
+}
+
+}; // namespace graphics
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Fixed set of worker threads running tasks in submission order.
+//
+// Tasks must not throw, catch inside the task and report the failure through its own result.
+// The destructor finishes the queued tasks before joining the workers.
+//
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // 0 picks one thread less than the number of hardware threads, at least one.
+    explicit ThreadPool(size_t numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(Task task);
+
+    // Block until every submitted task has finished.
+    void WaitIdle();
+
+    size_t GetNumThreads() const { return threads_.size(); }
+
+private:
+    void WorkerThread();
+
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable taskCondition_;
+    std::condition_variable idleCondition_;
+    std::deque<Task> tasks_;
+    size_t numRunning_;
+    bool stopping_;
+};
+
+}; // namespace graphics
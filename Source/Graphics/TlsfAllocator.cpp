@@ -0,0 +1,374 @@
+#include "TlsfAllocator.h"
+
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace graphics
+{
+
+namespace
+{
+
+// Index of the highest set bit, `value` must not be 0.
+uint32_t FindLastSet(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+// Index of the lowest set bit, `value` must not be 0.
+uint32_t FindFirstSet(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+};
+
+TlsfAllocator::TlsfAllocator(uint64_t size) :
+    size_(size)
+{
+    Reset();
+}
+
+void TlsfAllocator::Reset()
+{
+    freeSize_ = size_;
+    numAllocations_ = 0;
+    numFreeRanges_ = 0;
+    firstLevelBitmap_ = 0;
+    for (uint32_t firstLevel = 0; firstLevel < kNumFirstLevels; firstLevel++)
+    {
+        secondLevelBitmaps_[firstLevel] = 0;
+        for (uint32_t secondLevel = 0; secondLevel < kNumSecondLevels; secondLevel++)
+        {
+            freeLists_[firstLevel][secondLevel] = kInvalidNode;
+        }
+    }
+    nodes_.clear();
+    unusedNodes_.clear();
+
+    if (size_ > 0)
+    {
+        InsertFree(CreateNode(0, size_));
+    }
+}
+
+void TlsfAllocator::GetListIndices(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+    // Sizes below kNumSecondLevels have a list each, above that the lists of a power of two are linear steps.
+    if (size < kNumSecondLevels)
+    {
+        firstLevel = 0;
+        secondLevel = static_cast<uint32_t>(size);
+        return;
+    }
+    const uint32_t lastSet = FindLastSet(size);
+    firstLevel = lastSet - kNumSecondLevelBits + 1;
+    secondLevel = static_cast<uint32_t>(size >> (lastSet - kNumSecondLevelBits)) ^ kNumSecondLevels;
+}
+
+bool TlsfAllocator::FindFreeList(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const
+{
+    // Round up to the next list boundary, every range in that list and the ones above it is large enough.
+    if (size >= kNumSecondLevels)
+    {
+        size += (1ull << (FindLastSet(size) - kNumSecondLevelBits)) - 1;
+    }
+    GetListIndices(size, firstLevel, secondLevel);
+    if (firstLevel >= kNumFirstLevels)
+    {
+        return false;
+    }
+
+    uint32_t secondLevelBitmap = secondLevelBitmaps_[firstLevel] & (~0u << secondLevel);
+    if (secondLevelBitmap == 0)
+    {
+        const uint64_t firstLevelBitmap = firstLevel + 1 < 64 ? firstLevelBitmap_ & (~0ull << (firstLevel + 1)) : 0;
+        if (firstLevelBitmap == 0)
+        {
+            return false;
+        }
+        firstLevel = FindFirstSet(firstLevelBitmap);
+        secondLevelBitmap = secondLevelBitmaps_[firstLevel];
+    }
+    secondLevel = FindFirstSet(secondLevelBitmap);
+    return true;
+}
+
+TlsfAllocator::Allocation TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment > 0);
+    Allocation allocation;
+
+    // Any range of `size + alignment - 1` bytes contains an aligned range of `size` bytes.
+    if (size == 0 || size > freeSize_)
+    {
+        return allocation;
+    }
+
+    // Any range of `size + alignment - 1` bytes contains an aligned range of `size` bytes. Smaller ranges may hold
+    // the request too when their offset happens to be aligned, e.g. equal sizes and alignments filling a heap;
+    // only when the bitmaps find nothing are their lists walked.
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    uint32_t node = kInvalidNode;
+    if (alignment - 1 <= freeSize_ - size && FindFreeList(size + alignment - 1, firstLevel, secondLevel))
+    {
+        node = freeLists_[firstLevel][secondLevel];
+    }
+    else
+    {
+        node = FindAlignedFit(size, alignment);
+        if (node == kInvalidNode)
+        {
+            return allocation;
+        }
+    }
+    RemoveFree(node);
+
+    // The padding in front goes back to the free lists. The range before a free node is always in use,
+    // so the padding has no free neighbour to merge with.
+    const uint64_t offset = nodes_[node].Offset;
+    const uint64_t alignedOffset = offset + GetPadding(offset, alignment);
+    if (alignedOffset > offset)
+    {
+        const uint32_t padding = node;
+        node = CreateNode(alignedOffset, nodes_[padding].Size - (alignedOffset - offset));
+        nodes_[padding].Size = alignedOffset - offset;
+
+        nodes_[node].PreviousPhysical = padding;
+        nodes_[node].NextPhysical = nodes_[padding].NextPhysical;
+        if (nodes_[node].NextPhysical != kInvalidNode)
+        {
+            nodes_[nodes_[node].NextPhysical].PreviousPhysical = node;
+        }
+        nodes_[padding].NextPhysical = node;
+        InsertFree(padding);
+    }
+
+    if (nodes_[node].Size > size)
+    {
+        SplitFree(node, size);
+    }
+
+    nodes_[node].Free = false;
+    freeSize_ -= size;
+    numAllocations_++;
+
+    allocation.Offset = nodes_[node].Offset;
+    allocation.Size = size;
+    allocation.Node = node;
+    return allocation;
+}
+
+void TlsfAllocator::Free(const Allocation& allocation)
+{
+    if (!allocation.IsValid())
+    {
+        return;
+    }
+
+    uint32_t node = allocation.Node;
+    assert(node < nodes_.size() && !nodes_[node].Free && nodes_[node].Offset == allocation.Offset);
+    freeSize_ += nodes_[node].Size;
+    numAllocations_--;
+
+    // Merge with the free neighbours, which leaves their lists.
+    const uint32_t previous = nodes_[node].PreviousPhysical;
+    if (previous != kInvalidNode && nodes_[previous].Free)
+    {
+        RemoveFree(previous);
+        nodes_[previous].Size += nodes_[node].Size;
+        nodes_[previous].NextPhysical = nodes_[node].NextPhysical;
+        if (nodes_[previous].NextPhysical != kInvalidNode)
+        {
+            nodes_[nodes_[previous].NextPhysical].PreviousPhysical = previous;
+        }
+        DestroyNode(node);
+        node = previous;
+    }
+
+    const uint32_t next = nodes_[node].NextPhysical;
+    if (next != kInvalidNode && nodes_[next].Free)
+    {
+        RemoveFree(next);
+        nodes_[node].Size += nodes_[next].Size;
+        nodes_[node].NextPhysical = nodes_[next].NextPhysical;
+        if (nodes_[node].NextPhysical != kInvalidNode)
+        {
+            nodes_[nodes_[node].NextPhysical].PreviousPhysical = node;
+        }
+        DestroyNode(next);
+    }
+
+    InsertFree(node);
+}
+
+uint64_t TlsfAllocator::GetLargestFreeSize() const
+{
+    if (firstLevelBitmap_ == 0)
+    {
+        return 0;
+    }
+
+    // Only the highest non-empty list needs a walk, its ranges differ by less than one step.
+    const uint32_t firstLevel = FindLastSet(firstLevelBitmap_);
+    const uint32_t secondLevel = FindLastSet(secondLevelBitmaps_[firstLevel]);
+    uint64_t largest = 0;
+    for (uint32_t node = freeLists_[firstLevel][secondLevel]; node != kInvalidNode; node = nodes_[node].NextFree)
+    {
+        if (nodes_[node].Size > largest)
+        {
+            largest = nodes_[node].Size;
+        }
+    }
+    return largest;
+}
+
+uint64_t TlsfAllocator::GetPadding(uint64_t offset, uint64_t alignment)
+{
+    const uint64_t remainder = offset % alignment;
+    return remainder > 0 ? alignment - remainder : 0;
+}
+
+uint32_t TlsfAllocator::FindAlignedFit(uint64_t size, uint64_t alignment) const
+{
+    // Lists below the one of `size` only hold smaller ranges, lists above the one of the padded size or of the
+    // free size, whichever is smaller, were searched by FindFreeList() or are empty.
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    uint32_t lastFirstLevel = 0;
+    uint32_t lastSecondLevel = 0;
+    GetListIndices(size, firstLevel, secondLevel);
+    GetListIndices(alignment - 1 <= freeSize_ - size ? size + alignment - 1 : freeSize_, lastFirstLevel, lastSecondLevel);
+
+    for (; firstLevel <= lastFirstLevel; firstLevel++, secondLevel = 0)
+    {
+        uint32_t secondLevelBitmap = secondLevelBitmaps_[firstLevel] & (~0u << secondLevel);
+        if (firstLevel == lastFirstLevel && lastSecondLevel + 1 < kNumSecondLevels)
+        {
+            secondLevelBitmap &= (1u << (lastSecondLevel + 1)) - 1;
+        }
+        for (; secondLevelBitmap != 0; secondLevelBitmap &= secondLevelBitmap - 1)
+        {
+            for (uint32_t node = freeLists_[firstLevel][FindFirstSet(secondLevelBitmap)]; node != kInvalidNode; node = nodes_[node].NextFree)
+            {
+                const uint64_t padding = GetPadding(nodes_[node].Offset, alignment);
+                if (padding <= nodes_[node].Size && nodes_[node].Size - padding >= size)
+                {
+                    return node;
+                }
+            }
+        }
+    }
+    return kInvalidNode;
+}
+
+uint32_t TlsfAllocator::CreateNode(uint64_t offset, uint64_t size)
+{
+    uint32_t node;
+    if (!unusedNodes_.empty())
+    {
+        node = unusedNodes_.back();
+        unusedNodes_.pop_back();
+    }
+    else
+    {
+        node = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    nodes_[node] = { offset, size, kInvalidNode, kInvalidNode, kInvalidNode, kInvalidNode, false };
+    return node;
+}
+
+void TlsfAllocator::DestroyNode(uint32_t node)
+{
+    unusedNodes_.push_back(node);
+}
+
+void TlsfAllocator::InsertFree(uint32_t node)
+{
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    GetListIndices(nodes_[node].Size, firstLevel, secondLevel);
+
+    const uint32_t head = freeLists_[firstLevel][secondLevel];
+    nodes_[node].Free = true;
+    nodes_[node].PreviousFree = kInvalidNode;
+    nodes_[node].NextFree = head;
+    if (head != kInvalidNode)
+    {
+        nodes_[head].PreviousFree = node;
+    }
+    freeLists_[firstLevel][secondLevel] = node;
+
+    firstLevelBitmap_ |= 1ull << firstLevel;
+    secondLevelBitmaps_[firstLevel] |= 1u << secondLevel;
+    numFreeRanges_++;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t node)
+{
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    GetListIndices(nodes_[node].Size, firstLevel, secondLevel);
+
+    const uint32_t previous = nodes_[node].PreviousFree;
+    const uint32_t next = nodes_[node].NextFree;
+    if (previous != kInvalidNode)
+    {
+        nodes_[previous].NextFree = next;
+    }
+    else
+    {
+        freeLists_[firstLevel][secondLevel] = next;
+    }
+    if (next != kInvalidNode)
+    {
+        nodes_[next].PreviousFree = previous;
+    }
+
+    if (freeLists_[firstLevel][secondLevel] == kInvalidNode)
+    {
+        secondLevelBitmaps_[firstLevel] &= ~(1u << secondLevel);
+        if (secondLevelBitmaps_[firstLevel] == 0)
+        {
+            firstLevelBitmap_ &= ~(1ull << firstLevel);
+        }
+    }
+
+    nodes_[node].Free = false;
+    numFreeRanges_--;
+}
+
+void TlsfAllocator::SplitFree(uint32_t node, uint64_t size)
+{
+    // The range after a free node is always in use, so the remainder has no free neighbour to merge with.
+    const uint32_t remainder = CreateNode(nodes_[node].Offset + size, nodes_[node].Size - size);
+    nodes_[node].Size = size;
+
+    nodes_[remainder].PreviousPhysical = node;
+    nodes_[remainder].NextPhysical = nodes_[node].NextPhysical;
+    if (nodes_[remainder].NextPhysical != kInvalidNode)
+    {
+        nodes_[nodes_[remainder].NextPhysical].PreviousPhysical = remainder;
+    }
+    nodes_[node].NextPhysical = remainder;
+    InsertFree(remainder);
+}
+
+}; // namespace graphics
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Two-level segregated fit allocator of ranges inside [0, size), constant time allocation and free.
+//
+// Free ranges are kept in lists bucketed by size: the first level is the power of two, the second level
+// splits every power of two into kNumSecondLevels linear steps, and two bitmaps tell which lists are not
+// empty. Allocation rounds the request up to the next bucket, so the head of any non-empty list found by
+// the bitmaps fits without walking the list. Only when those lists are empty are the lists between the request
+// and its worst case padding walked, so a request succeeds whenever a free range holds it at its alignment.
+// Freed ranges merge with free neighbours right away.
+//
+// Only offsets are managed, the memory itself lives elsewhere: a GPU buffer, a heap, a descriptor range.
+//
+class TlsfAllocator
+{
+public:
+    static const uint64_t kInvalidOffset = ~0ull;
+    static const uint32_t kInvalidNode = ~0u;
+
+    struct Allocation
+    {
+        uint64_t Offset = kInvalidOffset;
+        uint64_t Size = 0;
+        // Identifies the allocation in Free()
+        uint32_t Node = kInvalidNode;
+
+        bool IsValid() const { return Node != kInvalidNode; }
+    };
+
+    explicit TlsfAllocator(uint64_t size);
+
+    // `alignment` may be any positive value, not only powers of two, e.g. a vertex stride.
+    // Returns an invalid allocation when no free range can hold the request.
+    Allocation Allocate(uint64_t size, uint64_t alignment = 1);
+    void Free(const Allocation& allocation);
+
+    // Forget every allocation, the whole range is free again.
+    void Reset();
+
+    uint64_t GetSize() const { return size_; }
+    uint64_t GetFreeSize() const { return freeSize_; }
+    uint64_t GetLargestFreeSize() const;
+    uint32_t GetNumAllocations() const { return numAllocations_; }
+    uint32_t GetNumFreeRanges() const { return numFreeRanges_; }
+
+    static const uint32_t kNumSecondLevelBits = 5;
+    static const uint32_t kNumSecondLevels = 1u << kNumSecondLevelBits;
+    static const uint32_t kNumFirstLevels = 64 - kNumSecondLevelBits + 1;
+
+private:
+    struct Node
+    {
+        uint64_t Offset;
+        uint64_t Size;
+        // Neighbours in address order, for merging
+        uint32_t PreviousPhysical;
+        uint32_t NextPhysical;
+        // Links of the free list the node is in
+        uint32_t PreviousFree;
+        uint32_t NextFree;
+        bool Free;
+    };
+
+    static void GetListIndices(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+    bool FindFreeList(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const;
+    // Walk the lists which may hold a range with room for `size` bytes at `alignment`, the slow path of Allocate().
+    uint32_t FindAlignedFit(uint64_t size, uint64_t alignment) const;
+    // Bytes from `offset` to the next multiple of `alignment`.
+    static uint64_t GetPadding(uint64_t offset, uint64_t alignment);
+
+    uint32_t CreateNode(uint64_t offset, uint64_t size);
+    void DestroyNode(uint32_t node);
+    void InsertFree(uint32_t node);
+    void RemoveFree(uint32_t node);
+
+    // Cut [offset + size, end) of `node` off into a new free node.
+    void SplitFree(uint32_t node, uint64_t size);
+
+    uint64_t size_;
+    uint64_t freeSize_;
+    uint32_t numAllocations_;
+    uint32_t numFreeRanges_;
+
+    uint64_t firstLevelBitmap_;
+    uint32_t secondLevelBitmaps_[kNumFirstLevels];
+    uint32_t freeLists_[kNumFirstLevels][kNumSecondLevels];
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> unusedNodes_;
+};
+
+}; // namespace graphics
@@ -0,0 +1,224 @@
+#include "UploadRing.h"
+
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include <d3dx12.h>
+
+#include "GraphicsUtil.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace graphics
+{
+
+UploadRing::UploadRing(ID3D12Device* device, ID3D12CommandQueue* commandQueue, D3D12FenceSource& fence, FenceTimeline& fenceTimeline, UINT64 size) :
+    device_(device),
+    commandQueue_(commandQueue),
+    fence_(fence),
+    fenceTimeline_(fenceTimeline),
+    commandListType_(commandQueue->GetDesc().Type),
+    cpuAddress_(nullptr),
+    ring_(size),
+    recording_(false),
+    lastSubmittedFenceValue_(0)
+{
+    CD3DX12_HEAP_PROPERTIES uploadProperty(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    ThrowIfFailed(device_->CreateCommittedResource(&uploadProperty, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&buffer_)), "CreateCommittedResource for upload ring");
+
+    // Keeping things mapped for the lifetime of the resource is okay.
+    CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+    ThrowIfFailed(buffer_->Map(0, &readRange, reinterpret_cast<void**>(&cpuAddress_)), "Map upload ring");
+}
+
+UploadRing::~UploadRing()
+{
+    // The GPU may still be copying from the ring.
+    fenceTimeline_.Wait(lastSubmittedFenceValue_);
+    buffer_->Unmap(0, nullptr);
+}
+
+UploadRing::Allocation UploadRing::Allocate(UINT64 size, UINT64 alignment)
+{
+    if (size > ring_.GetSize())
+    {
+        throw std::runtime_error("Upload of " + std::to_string(size) + " bytes doesn't fit into the upload ring");
+    }
+
+    ring_.ReleaseCompleted(fence_.GetCompletedValue());
+    UINT64 offset = ring_.Allocate(size, alignment);
+    while (offset == RingAllocator::kInvalidOffset)
+    {
+        // Out of space, push the pending copies to the GPU and wait for the oldest batch to retire.
+        if (recording_)
+        {
+            Submit();
+        }
+        else if (ring_.GetCurrentBatchSize() > 0)
+        {
+            // Only ranges without a copy recorded here, consumed by work the caller submitted to this queue.
+            lastSubmittedFenceValue_ = fence_.Signal(commandQueue_.Get());
+            ring_.FinishBatch(lastSubmittedFenceValue_);
+        }
+
+        const UINT64 oldestFenceValue = ring_.GetOldestFenceValue();
+        if (oldestFenceValue == 0)
+        {
+            throw std::runtime_error("Upload of " + std::to_string(size) + " bytes doesn't fit into the empty upload ring");
+        }
+        fenceTimeline_.Wait(oldestFenceValue);
+        ring_.ReleaseCompleted(fence_.GetCompletedValue());
+        offset = ring_.Allocate(size, alignment);
+    }
+
+    Allocation allocation;
+    allocation.Resource = buffer_.Get();
+    allocation.Offset = offset;
+    allocation.CpuAddress = cpuAddress_ + offset;
+    allocation.GpuAddress = buffer_->GetGPUVirtualAddress() + offset;
+    return allocation;
+}
+
+void UploadRing::CopyBuffer(ID3D12Resource* destination, UINT64 destinationOffset, const void* data, UINT64 size, D3D12_RESOURCE_STATES stateAfter)
+{
+    Allocation allocation = Allocate(size);
+    memcpy(allocation.CpuAddress, data, static_cast<size_t>(size));
+
+    GetCommandList()->CopyBufferRegion(destination, destinationOffset, buffer_.Get(), allocation.Offset, size);
+    AddPostCopyBarrier(destination, stateAfter);
+}
+
+void UploadRing::CopyTextureSubresource(ID3D12Resource* destination, UINT subresource, const D3D12_SUBRESOURCE_DATA& data, D3D12_RESOURCE_STATES stateAfter)
+{
+    D3D12_RESOURCE_DESC desc = destination->GetDesc();
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+    UINT numRows = 0;
+    UINT64 rowSize = 0;
+    UINT64 totalSize = 0;
+    device_->GetCopyableFootprints(&desc, subresource, 1, 0, &footprint, &numRows, &rowSize, &totalSize);
+
+    Allocation allocation = Allocate(totalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+    // Source rows are tightly packed as described by `data`, staging rows are padded to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT.
+    const UINT8* source = static_cast<const UINT8*>(data.pData);
+    for (UINT z = 0; z < footprint.Footprint.Depth; z++)
+    {
+        for (UINT row = 0; row < numRows; row++)
+        {
+            UINT8* stagingRow = allocation.CpuAddress + footprint.Footprint.RowPitch * (z * numRows + row);
+            const UINT8* sourceRow = source + data.SlicePitch * z + data.RowPitch * row;
+            memcpy(stagingRow, sourceRow, static_cast<size_t>(rowSize));
+        }
+    }
+
+    footprint.Offset = allocation.Offset;
+    CD3DX12_TEXTURE_COPY_LOCATION destinationLocation(destination, subresource);
+    CD3DX12_TEXTURE_COPY_LOCATION sourceLocation(buffer_.Get(), footprint);
+    GetCommandList()->CopyTextureRegion(&destinationLocation, 0, 0, 0, &sourceLocation, nullptr);
+
+    AddPostCopyBarrier(destination, stateAfter, subresource);
+}
+
+UINT64 UploadRing::Submit()
+{
+    if (!recording_)
+    {
+        return 0;
+    }
+
+    // All the state transitions of this batch in a single call.
+    if (!postCopyBarriers_.empty())
+    {
+        commandList_->ResourceBarrier(static_cast<UINT>(postCopyBarriers_.size()), postCopyBarriers_.data());
+        postCopyBarriers_.clear();
+    }
+
+    ThrowIfFailed(commandList_->Close(), "Close upload command list");
+    ID3D12CommandList* commandLists[] = { commandList_.Get() };
+    commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+    const UINT64 fenceValue = fence_.Signal(commandQueue_.Get());
+    ring_.FinishBatch(fenceValue);
+    retiredAllocators_.emplace_back(fenceValue, std::move(commandAllocator_));
+    recording_ = false;
+    lastSubmittedFenceValue_ = fenceValue;
+
+    return fenceValue;
+}
+
+UINT64 UploadRing::GetLastSubmittedFenceValue() const
+{
+    return lastSubmittedFenceValue_;
+}
+
+UINT64 UploadRing::GetSize() const
+{
+    return ring_.GetSize();
+}
+
+UINT64 UploadRing::GetUsedSize() const
+{
+    return ring_.GetUsedSize();
+}
+
+UINT64 UploadRing::GetRecordedSize() const
+{
+    return ring_.GetCurrentBatchSize();
+}
+
+ID3D12GraphicsCommandList* UploadRing::GetCommandList()
+{
+    if (recording_)
+    {
+        return commandList_.Get();
+    }
+
+    // Command list allocators can only be reset when the associated command lists have finished execution on the GPU.
+    const UINT64 completedValue = fence_.GetCompletedValue();
+    if (!retiredAllocators_.empty() && retiredAllocators_.front().first <= completedValue)
+    {
+        commandAllocator_ = std::move(retiredAllocators_.front().second);
+        retiredAllocators_.pop_front();
+        ThrowIfFailed(commandAllocator_->Reset(), "Reset upload command allocator");
+    }
+    else
+    {
+        ThrowIfFailed(device_->CreateCommandAllocator(commandListType_, IID_PPV_ARGS(&commandAllocator_)), "CreateCommandAllocator for upload");
+    }
+
+    if (commandList_)
+    {
+        ThrowIfFailed(commandList_->Reset(commandAllocator_.Get(), nullptr), "Reset upload command list");
+    }
+    else
+    {
+        ThrowIfFailed(device_->CreateCommandList(0, commandListType_, commandAllocator_.Get(), nullptr, IID_PPV_ARGS(&commandList_)), "CreateCommandList for upload");
+    }
+    recording_ = true;
+
+    return commandList_.Get();
+}
+
+void UploadRing::AddPostCopyBarrier(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter, UINT subresource)
+{
+    // Copy lists leave the destination to decay to COMMON instead.
+    if (stateAfter == D3D12_RESOURCE_STATE_COPY_DEST || commandListType_ == D3D12_COMMAND_LIST_TYPE_COPY)
+    {
+        return;
+    }
+
+    // Several copies into the same destination share one transition.
+    for (const D3D12_RESOURCE_BARRIER& barrier : postCopyBarriers_)
+    {
+        if (barrier.Transition.pResource == resource && barrier.Transition.Subresource == subresource)
+        {
+            return;
+        }
+    }
+    postCopyBarriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, D3D12_RESOURCE_STATE_COPY_DEST, stateAfter, subresource));
+}
+
+}; // namespace graphics
@@ -0,0 +1,96 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <d3d12.h>
+
+#include <deque>
+#include <vector>
+
+#include "RingAllocator.h"
+#include "D3D12FenceSource.h"
+#include "FenceTimeline.h"
+
+namespace graphics
+{
+
+//
+// Persistently mapped upload heap shared by every staging copy.
+//
+// Data is written into sub-allocated ranges of one upload buffer and the copies are recorded into a single
+// command list, which Submit() executes in one go. Ranges are reclaimed once the fence signaled by Submit()
+// is reached, so any number of uploads per frame costs one allocation and one GPU round trip.
+//
+// The command lists are of the type of `commandQueue`. Copy lists can't transition resources to states other than
+// COMMON, COPY_DEST and COPY_SOURCE, so on a D3D12_COMMAND_LIST_TYPE_COPY queue `stateAfter` is ignored: destinations
+// decay to COMMON at the end of the submission, from where the consuming queue promotes buffers to any state and
+// textures to the shader resource states.
+//
+class UploadRing
+{
+public:
+    struct Allocation
+    {
+        ID3D12Resource* Resource;
+        UINT64 Offset;
+        UINT8* CpuAddress;
+        D3D12_GPU_VIRTUAL_ADDRESS GpuAddress;
+    };
+
+    UploadRing(ID3D12Device* device, ID3D12CommandQueue* commandQueue, D3D12FenceSource& fence, FenceTimeline& fenceTimeline, UINT64 size);
+    ~UploadRing();
+
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+
+    // Sub-allocate a staging range. When the ring is full, pending copies are submitted and the oldest batch is waited for.
+    // A range used by the caller's own copies has to be consumed by work submitted to the ring's queue: without copies
+    // recorded here, the batch is closed with a fence signaled on that queue.
+    Allocation Allocate(UINT64 size, UINT64 alignment = kDefaultAlignment);
+
+    // Stage `data` and record a copy into `destination`, which is expected to be in D3D12_RESOURCE_STATE_COPY_DEST,
+    // or COMMON on a copy queue.
+    // `stateAfter` is applied with the other post-copy barriers of this batch.
+    void CopyBuffer(ID3D12Resource* destination, UINT64 destinationOffset, const void* data, UINT64 size, D3D12_RESOURCE_STATES stateAfter);
+
+    // Stage one texture subresource honoring the placement and row pitch alignment rules, and record the copy.
+    void CopyTextureSubresource(ID3D12Resource* destination, UINT subresource, const D3D12_SUBRESOURCE_DATA& data, D3D12_RESOURCE_STATES stateAfter);
+
+    // Execute every copy recorded since the last submission. Returns the fence value signaled after them, 0 if there was nothing to submit.
+    UINT64 Submit();
+
+    // Fence value of the latest submission, wait for it before consuming the uploaded data on another queue.
+    UINT64 GetLastSubmittedFenceValue() const;
+
+    UINT64 GetSize() const;
+    UINT64 GetUsedSize() const;
+    // Staging memory of the copies recorded since the last submission.
+    UINT64 GetRecordedSize() const;
+
+    static const UINT64 kDefaultAlignment = 16;
+
+private:
+    ID3D12GraphicsCommandList* GetCommandList();
+    void AddPostCopyBarrier(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter, UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue_;
+    D3D12FenceSource& fence_;
+    FenceTimeline& fenceTimeline_;
+    D3D12_COMMAND_LIST_TYPE commandListType_;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> buffer_;
+    UINT8* cpuAddress_;
+    RingAllocator ring_;
+
+    // Command allocators are recycled once the submission that used them has completed.
+    std::deque<std::pair<UINT64, Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>> retiredAllocators_;
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator_;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList_;
+    bool recording_;
+    std::vector<D3D12_RESOURCE_BARRIER> postCopyBarriers_;
+    UINT64 lastSubmittedFenceValue_;
+};
+
+}; // namespace graphics
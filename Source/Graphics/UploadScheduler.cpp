@@ -0,0 +1,128 @@
+#include "UploadScheduler.h"
+
+#include <cassert>
+
+namespace graphics
+{
+
+//
+// SimulatedUploadQueueBackend
+//
+void SimulatedUploadQueueBackend::RecordCopy(uint64_t size)
+{
+    recordedSize_ += size;
+}
+
+void SimulatedUploadQueueBackend::Complete(uint64_t value)
+{
+    assert(value <= submittedValue_);
+    if (value > completedValue_)
+    {
+        completedValue_ = value;
+    }
+}
+
+uint64_t SimulatedUploadQueueBackend::GetRecordingFenceValue() const
+{
+    return submittedValue_ + 1;
+}
+
+uint64_t SimulatedUploadQueueBackend::GetRecordedSize() const
+{
+    return recordedSize_;
+}
+
+uint64_t SimulatedUploadQueueBackend::SubmitCopies()
+{
+    if (recordedSize_ == 0)
+    {
+        return 0;
+    }
+    recordedSize_ = 0;
+    return ++submittedValue_;
+}
+
+uint64_t SimulatedUploadQueueBackend::GetSubmittedValue() const
+{
+    return submittedValue_;
+}
+
+uint64_t SimulatedUploadQueueBackend::GetCompletedValue() const
+{
+    return completedValue_;
+}
+
+void SimulatedUploadQueueBackend::WaitOnConsumer(uint64_t fenceValue)
+{
+    consumerWaits_.push_back(fenceValue);
+}
+
+//
+// UploadScheduler
+//
+UploadScheduler::UploadScheduler(UploadQueueBackend& backend, uint64_t maxBatchSize) :
+    backend_(backend),
+    maxBatchSize_(maxBatchSize)
+{
+}
+
+UploadScheduler::Ticket UploadScheduler::Commit()
+{
+    // Read before submitting, the copies belong to the batch being recorded.
+    const Ticket ticket = backend_.GetRecordingFenceValue();
+    if (backend_.GetRecordedSize() >= maxBatchSize_)
+    {
+        Flush();
+    }
+    return ticket;
+}
+
+void UploadScheduler::Require(Ticket ticket)
+{
+    if (ticket > requiredTicket_)
+    {
+        requiredTicket_ = ticket;
+    }
+}
+
+void UploadScheduler::PrepareConsumerSubmission()
+{
+    if (requiredTicket_ > backend_.GetSubmittedValue())
+    {
+        Flush();
+    }
+
+    // A ticket of a batch which ended up empty, because the backend submitted its copies earlier when it ran out of
+    // staging memory, is covered by the last submission.
+    Ticket ticket = requiredTicket_;
+    if (ticket > backend_.GetSubmittedValue())
+    {
+        ticket = backend_.GetSubmittedValue();
+    }
+    requiredTicket_ = 0;
+
+    // Waits of earlier submissions still hold, queues execute in order.
+    if (ticket > waitedValue_ && ticket > backend_.GetCompletedValue())
+    {
+        backend_.WaitOnConsumer(ticket);
+        waitedValue_ = ticket;
+        statistics_.NumConsumerWaits++;
+    }
+}
+
+uint64_t UploadScheduler::Flush()
+{
+    const uint64_t fenceValue = backend_.SubmitCopies();
+    if (fenceValue != 0)
+    {
+        statistics_.NumSubmissions++;
+    }
+    return fenceValue;
+}
+
+bool UploadScheduler::IsCompleted(Ticket ticket) const
+{
+    return ticket <= backend_.GetCompletedValue();
+}
+
+}; // namespace graphics
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Copy queue an UploadScheduler submits to, and the queue consuming the uploads.
+// D3D12UploadService runs on a D3D12_COMMAND_LIST_TYPE_COPY queue, SimulatedUploadQueueBackend is driven from the CPU.
+//
+class UploadQueueBackend
+{
+public:
+    virtual ~UploadQueueBackend() {}
+
+    // Copy fence value which the copies being recorded will be signaled with.
+    virtual uint64_t GetRecordingFenceValue() const = 0;
+    // Bytes staged by the copies being recorded.
+    virtual uint64_t GetRecordedSize() const = 0;
+
+    // Execute the recorded copies and signal their fence value. Returns 0 when nothing was recorded.
+    virtual uint64_t SubmitCopies() = 0;
+    virtual uint64_t GetSubmittedValue() const = 0;
+    virtual uint64_t GetCompletedValue() const = 0;
+
+    // Make the consumer queue wait on the GPU until the copy fence reaches `fenceValue`, ahead of its next submission.
+    virtual void WaitOnConsumer(uint64_t fenceValue) = 0;
+};
+
+class SimulatedUploadQueueBackend : public UploadQueueBackend
+{
+public:
+    // Emulates staging a copy of `size` bytes.
+    void RecordCopy(uint64_t size);
+
+    // Emulates the copy queue reaching the signal of `value`.
+    void Complete(uint64_t value);
+
+    // Every WaitOnConsumer() so far, in order.
+    const std::vector<uint64_t>& GetConsumerWaits() const { return consumerWaits_; }
+
+    virtual uint64_t GetRecordingFenceValue() const override;
+    virtual uint64_t GetRecordedSize() const override;
+    virtual uint64_t SubmitCopies() override;
+    virtual uint64_t GetSubmittedValue() const override;
+    virtual uint64_t GetCompletedValue() const override;
+    virtual void WaitOnConsumer(uint64_t fenceValue) override;
+
+private:
+    uint64_t recordedSize_ = 0;
+    uint64_t submittedValue_ = 0;
+    uint64_t completedValue_ = 0;
+    std::vector<uint64_t> consumerWaits_;
+};
+
+//
+// Decides when copies go to the copy queue and what the consumer queue waits for.
+//
+// Copies are recorded into the backend and closed with Commit(), which hands out a ticket, the copy fence value
+// of their batch. Batches are submitted once they reach `maxBatchSize` bytes, when a consumer needs them, or on
+// Flush(). A submission of the consumer queue declares the tickets it reads with Require(), and
+// PrepareConsumerSubmission() then issues a single GPU wait on the newest of them, unless the copy queue is
+// already past it or an earlier wait covers it. Submissions which need no new data never wait, so streaming
+// doesn't stall rendering. Not thread safe.
+//
+class UploadScheduler
+{
+public:
+    using Ticket = uint64_t;
+
+    struct Statistics
+    {
+        uint64_t NumSubmissions = 0;
+        uint64_t NumConsumerWaits = 0;
+    };
+
+    UploadScheduler(UploadQueueBackend& backend, uint64_t maxBatchSize);
+
+    UploadScheduler(const UploadScheduler&) = delete;
+    UploadScheduler& operator=(const UploadScheduler&) = delete;
+
+    // Close the copies recorded since the previous Commit(), submitting the batch if it is full.
+    Ticket Commit();
+
+    // The next consumer submission reads the data of `ticket`.
+    void Require(Ticket ticket);
+
+    // Called right before the consumer's submission: submits the batch if it holds required copies, and makes the
+    // consumer wait for the required ones which haven't completed.
+    void PrepareConsumerSubmission();
+
+    // Submit whatever has been recorded, once per frame keeps uploads flowing without consumers asking for them.
+    uint64_t Flush();
+
+    bool IsCompleted(Ticket ticket) const;
+
+    Statistics GetStatistics() const { return statistics_; }
+
+private:
+    UploadQueueBackend& backend_;
+    uint64_t maxBatchSize_;
+
+    Ticket requiredTicket_ = 0;
+    uint64_t waitedValue_ = 0;
+    Statistics statistics_;
+};
+
+}; // namespace graphics
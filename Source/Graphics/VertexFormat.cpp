@@ -0,0 +1,370 @@
+#include "VertexFormat.h"
+
+#include <cmath>
+#include <cstring>
+
+// VERTEX_FORMAT_NO_SSE2 keeps the scalar path on SSE2 targets, the tests build it that way too to compare both.
+#if (defined(_M_X64) || defined(__SSE2__)) && !defined(VERTEX_FORMAT_NO_SSE2)
+#define VERTEX_FORMAT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace graphics
+{
+
+namespace
+{
+
+enum class ComponentType : uint32_t
+{
+    Float,
+    Half,
+    Unorm,
+    Snorm,
+};
+
+struct FormatInfo
+{
+    uint32_t NumComponents;
+    uint32_t ComponentSize;
+    ComponentType Type;
+};
+
+// In the order of VertexAttributeFormat.
+constexpr FormatInfo kFormatInfos[] =
+{
+    { 2, 4, ComponentType::Float },
+    { 3, 4, ComponentType::Float },
+    { 4, 4, ComponentType::Float },
+    { 2, 2, ComponentType::Half },
+    { 4, 2, ComponentType::Half },
+    { 4, 1, ComponentType::Unorm },
+    { 4, 1, ComponentType::Snorm },
+    { 2, 2, ComponentType::Unorm },
+    { 2, 2, ComponentType::Snorm },
+    { 4, 2, ComponentType::Unorm },
+    { 4, 2, ComponentType::Snorm },
+};
+static_assert(sizeof(kFormatInfos) / sizeof(kFormatInfos[0]) == static_cast<size_t>(VertexAttributeFormat::Snorm16x4) + 1,
+    "kFormatInfos doesn't match VertexAttributeFormat");
+
+// Packed vertices are encoded into a stack buffer of this size and copied out with one sequential write.
+const uint32_t kChunkSize = 4096;
+
+constexpr const FormatInfo& GetFormatInfo(VertexAttributeFormat format)
+{
+    return kFormatInfos[static_cast<uint32_t>(format)];
+}
+
+// Largest encoded value of a normalized component, which 1.0 maps to.
+constexpr float GetNormalizedScale(const FormatInfo& info)
+{
+    return static_cast<float>((1u << (info.ComponentSize * 8 - (info.Type == ComponentType::Snorm ? 1 : 0))) - 1);
+}
+
+// Round to nearest even, overflow to infinity, NaN stays NaN.
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7fffffff;
+
+    if (bits >= 0x7f800000)
+    {
+        return sign | 0x7c00 | (bits > 0x7f800000 ? 0x0200 : 0);
+    }
+    // 65520 and above round to infinity.
+    if (bits >= 0x477ff000)
+    {
+        return sign | 0x7c00;
+    }
+    // Below the smallest normal half: adding 0.5 lines the half's denormal mantissa up with the float's low bits,
+    // and the FPU does the rounding.
+    if (bits < 0x38800000)
+    {
+        float magnitude;
+        std::memcpy(&magnitude, &bits, sizeof(magnitude));
+        magnitude += 0.5f;
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        return sign | static_cast<uint16_t>(bits - 0x3f000000);
+    }
+
+    const uint32_t mantissaOdd = (bits >> 13) & 1;
+    bits -= (127 - 15) << 23;
+    bits += 0x0fff + mantissaOdd;
+    return sign | static_cast<uint16_t>(bits >> 13);
+}
+
+float HalfToFloat(uint16_t half)
+{
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1f;
+    const uint32_t mantissa = half & 0x03ff;
+
+    uint32_t bits;
+    if (exponent == 0)
+    {
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        bits |= sign;
+    }
+    else if (exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#if defined(VERTEX_FORMAT_SSE2)
+template <uint32_t kNumComponents>
+__m128 LoadComponents(const uint8_t* source)
+{
+    // The unused lanes are zero, nothing past the attribute is read.
+    if constexpr (kNumComponents == 4)
+    {
+        return _mm_loadu_ps(reinterpret_cast<const float*>(source));
+    }
+    else
+    {
+        const __m128 low = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source)));
+        if constexpr (kNumComponents == 2)
+        {
+            return low;
+        }
+        else
+        {
+            return _mm_movelh_ps(low, _mm_load_ss(reinterpret_cast<const float*>(source) + 2));
+        }
+    }
+}
+
+template <uint32_t kSize>
+void StorePacked(uint8_t* destination, __m128i packed)
+{
+    if constexpr (kSize == 4)
+    {
+        const int32_t bits = _mm_cvtsi128_si32(packed);
+        std::memcpy(destination, &bits, sizeof(bits));
+    }
+    else
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination), packed);
+    }
+}
+#endif
+
+template <VertexAttributeFormat kFormat>
+void EncodeNormalized(const uint8_t* source, uint8_t* destination)
+{
+    constexpr FormatInfo info = GetFormatInfo(kFormat);
+    constexpr float lower = info.Type == ComponentType::Snorm ? -1.0f : 0.0f;
+    constexpr float scale = GetNormalizedScale(info);
+
+#if defined(VERTEX_FORMAT_SSE2)
+    // maxps returns its second operand for NaN, which makes it the lower bound like the scalar path.
+    __m128 clamped = _mm_max_ps(LoadComponents<info.NumComponents>(source), _mm_set1_ps(lower));
+    clamped = _mm_min_ps(clamped, _mm_set1_ps(1.0f));
+    const __m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(scale)));
+
+    __m128i packed;
+    if constexpr (info.ComponentSize == 1)
+    {
+        const __m128i words = _mm_packs_epi32(quantized, quantized);
+        packed = info.Type == ComponentType::Unorm ? _mm_packus_epi16(words, words) : _mm_packs_epi16(words, words);
+    }
+    else if constexpr (info.Type == ComponentType::Unorm)
+    {
+        // No unsigned saturation from 32 to 16 bits before SSE4.1, the range is moved to signed and back instead.
+        const __m128i biased = _mm_sub_epi32(quantized, _mm_set1_epi32(0x8000));
+        packed = _mm_xor_si128(_mm_packs_epi32(biased, biased), _mm_set1_epi16(static_cast<short>(0x8000)));
+    }
+    else
+    {
+        packed = _mm_packs_epi32(quantized, quantized);
+    }
+    StorePacked<info.NumComponents * info.ComponentSize>(destination, packed);
+#else
+    for (uint32_t component = 0; component < info.NumComponents; component++)
+    {
+        float value;
+        std::memcpy(&value, source + component * sizeof(float), sizeof(value));
+        value = !(value > lower) ? lower : (value < 1.0f ? value : 1.0f);
+        // Nearest even under the default rounding mode, as cvtps2dq.
+        const int32_t quantized = static_cast<int32_t>(std::lrint(value * scale));
+
+        uint8_t* target = destination + component * info.ComponentSize;
+        if constexpr (info.ComponentSize == 1)
+        {
+            const uint8_t byte = static_cast<uint8_t>(quantized);
+            std::memcpy(target, &byte, sizeof(byte));
+        }
+        else
+        {
+            const uint16_t word = static_cast<uint16_t>(quantized);
+            std::memcpy(target, &word, sizeof(word));
+        }
+    }
+#endif
+}
+
+// Encode one attribute of `numVertices` vertices, specialized per format so the inner loop has no dispatch.
+template <VertexAttributeFormat kFormat>
+void EncodeAttribute(const uint8_t* source, uint32_t sourceStride, uint8_t* destination, uint32_t destinationStride, size_t numVertices)
+{
+    constexpr FormatInfo info = GetFormatInfo(kFormat);
+    for (size_t vertex = 0; vertex < numVertices; vertex++, source += sourceStride, destination += destinationStride)
+    {
+        if constexpr (info.Type == ComponentType::Float)
+        {
+            std::memcpy(destination, source, info.NumComponents * sizeof(float));
+        }
+        else if constexpr (info.Type == ComponentType::Half)
+        {
+            for (uint32_t component = 0; component < info.NumComponents; component++)
+            {
+                float value;
+                std::memcpy(&value, source + component * sizeof(float), sizeof(value));
+                const uint16_t half = FloatToHalf(value);
+                std::memcpy(destination + component * sizeof(half), &half, sizeof(half));
+            }
+        }
+        else
+        {
+            EncodeNormalized<kFormat>(source, destination);
+        }
+    }
+}
+
+using EncodeAttributeFunction = void (*)(const uint8_t* source, uint32_t sourceStride, uint8_t* destination, uint32_t destinationStride, size_t numVertices);
+
+// In the order of VertexAttributeFormat.
+const EncodeAttributeFunction kEncodeAttributeFunctions[] =
+{
+    EncodeAttribute<VertexAttributeFormat::Float32x2>,
+    EncodeAttribute<VertexAttributeFormat::Float32x3>,
+    EncodeAttribute<VertexAttributeFormat::Float32x4>,
+    EncodeAttribute<VertexAttributeFormat::Float16x2>,
+    EncodeAttribute<VertexAttributeFormat::Float16x4>,
+    EncodeAttribute<VertexAttributeFormat::Unorm8x4>,
+    EncodeAttribute<VertexAttributeFormat::Snorm8x4>,
+    EncodeAttribute<VertexAttributeFormat::Unorm16x2>,
+    EncodeAttribute<VertexAttributeFormat::Snorm16x2>,
+    EncodeAttribute<VertexAttributeFormat::Unorm16x4>,
+    EncodeAttribute<VertexAttributeFormat::Snorm16x4>,
+};
+static_assert(sizeof(kEncodeAttributeFunctions) / sizeof(kEncodeAttributeFunctions[0]) == sizeof(kFormatInfos) / sizeof(kFormatInfos[0]),
+    "kEncodeAttributeFunctions doesn't match VertexAttributeFormat");
+
+float DecodeNormalized(const FormatInfo& info, const uint8_t* source)
+{
+    int32_t value;
+    if (info.ComponentSize == 1)
+    {
+        value = info.Type == ComponentType::Snorm ? static_cast<int8_t>(source[0]) : source[0];
+    }
+    else
+    {
+        uint16_t word;
+        std::memcpy(&word, source, sizeof(word));
+        value = info.Type == ComponentType::Snorm ? static_cast<int16_t>(word) : word;
+    }
+
+    // The most negative SNORM value is -1 as well.
+    const float decoded = static_cast<float>(value) / GetNormalizedScale(info);
+    return decoded < -1.0f ? -1.0f : decoded;
+}
+
+};
+
+uint32_t GetNumComponents(VertexAttributeFormat format)
+{
+    return GetFormatInfo(format).NumComponents;
+}
+
+uint32_t GetFormatSize(VertexAttributeFormat format)
+{
+    const FormatInfo& info = GetFormatInfo(format);
+    return info.NumComponents * info.ComponentSize;
+}
+
+VertexFormat& VertexFormat::Add(const char* semantic, uint32_t semanticIndex, VertexAttributeFormat format, uint32_t sourceOffset)
+{
+    attributes_.push_back({ semantic, semanticIndex, format, sourceOffset, stride_ });
+    stride_ += GetFormatSize(format);
+    return *this;
+}
+
+void VertexFormat::Encode(const void* source, uint32_t sourceStride, size_t numVertices, void* destination) const
+{
+    if (stride_ == 0)
+    {
+        return;
+    }
+
+    // Attribute by attribute over a chunk of vertices small enough for L1, so each loop runs one format.
+    // Vertices too large for a chunk go straight to the destination.
+    uint8_t chunk[kChunkSize];
+    const size_t numChunkVertices = stride_ <= kChunkSize ? kChunkSize / stride_ : 1;
+
+    const uint8_t* sourceVertices = static_cast<const uint8_t*>(source);
+    uint8_t* packedVertices = static_cast<uint8_t*>(destination);
+    for (size_t first = 0; first < numVertices; first += numChunkVertices)
+    {
+        const size_t count = numVertices - first < numChunkVertices ? numVertices - first : numChunkVertices;
+        uint8_t* target = stride_ <= kChunkSize ? chunk : packedVertices + first * stride_;
+        for (const Attribute& attribute : attributes_)
+        {
+            kEncodeAttributeFunctions[static_cast<uint32_t>(attribute.Format)](
+                sourceVertices + first * sourceStride + attribute.SourceOffset, sourceStride, target + attribute.Offset, stride_, count);
+        }
+        if (target == chunk)
+        {
+            std::memcpy(packedVertices + first * stride_, chunk, count * stride_);
+        }
+    }
+}
+
+void VertexFormat::Decode(const void* packed, size_t numVertices, void* destination, uint32_t destinationStride) const
+{
+    const uint8_t* packedVertex = static_cast<const uint8_t*>(packed);
+    uint8_t* destinationVertex = static_cast<uint8_t*>(destination);
+    for (size_t vertex = 0; vertex < numVertices; vertex++, packedVertex += stride_, destinationVertex += destinationStride)
+    {
+        for (const Attribute& attribute : attributes_)
+        {
+            const FormatInfo& info = GetFormatInfo(attribute.Format);
+            for (uint32_t component = 0; component < info.NumComponents; component++)
+            {
+                const uint8_t* encoded = packedVertex + attribute.Offset + component * info.ComponentSize;
+                float value;
+                switch (info.Type)
+                {
+                case ComponentType::Float:
+                    std::memcpy(&value, encoded, sizeof(value));
+                    break;
+                case ComponentType::Half:
+                {
+                    uint16_t half;
+                    std::memcpy(&half, encoded, sizeof(half));
+                    value = HalfToFloat(half);
+                    break;
+                }
+                default:
+                    value = DecodeNormalized(info, encoded);
+                    break;
+                }
+                std::memcpy(destinationVertex + attribute.SourceOffset + component * sizeof(float), &value, sizeof(value));
+            }
+        }
+    }
+}
+
+}; // namespace graphics
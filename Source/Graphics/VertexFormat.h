@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace graphics
+{
+
+//
+// Packed formats a float vertex attribute can be quantized to. The shader reads floats from all of them:
+// UNORM as [0, 1], SNORM as [-1, 1], half floats widened, so only the input layout changes.
+//
+enum class VertexAttributeFormat : uint32_t
+{
+    Float32x2,
+    Float32x3,
+    Float32x4,
+    Float16x2,
+    Float16x4,
+    Unorm8x4,       // e.g. colors, red in the lowest byte
+    Snorm8x4,       // e.g. normals and tangents of low precision
+    Unorm16x2,      // e.g. texture coordinates within [0, 1]
+    Snorm16x2,
+    Unorm16x4,
+    Snorm16x4,
+};
+
+uint32_t GetNumComponents(VertexAttributeFormat format);
+uint32_t GetFormatSize(VertexAttributeFormat format);
+
+//
+// Declarative layout of a packed vertex, and the encoder from a float source vertex to it.
+//
+// Every attribute names the float components of the source vertex it is read from and the format it is stored in,
+// attributes follow each other in declaration order. All formats are multiples of 4 bytes, so the offsets stay
+// aligned the way input layouts require. D3D12VertexFormat turns the declaration into input elements.
+//
+// Encode() rounds to nearest and clamps to the range of the normalized formats, NaN becomes the lower bound.
+// On SSE2 targets the conversions of the normalized formats run on one vector per attribute.
+//
+class VertexFormat
+{
+public:
+    struct Attribute
+    {
+        // Not copied, usually a string literal.
+        const char* Semantic;
+        uint32_t SemanticIndex;
+        VertexAttributeFormat Format;
+        // Byte offset of the first float component in the source vertex.
+        uint32_t SourceOffset;
+        // Byte offset in the packed vertex.
+        uint32_t Offset;
+    };
+
+    // Declare the next attribute, GetNumComponents(format) floats at `sourceOffset` of the source vertex.
+    VertexFormat& Add(const char* semantic, uint32_t semanticIndex, VertexAttributeFormat format, uint32_t sourceOffset);
+
+    const std::vector<Attribute>& GetAttributes() const { return attributes_; }
+    uint32_t GetStride() const { return stride_; }
+
+    // Pack `numVertices` source vertices, `sourceStride` bytes apart, into GetStride() * numVertices bytes.
+    // Writes are sequential, so `destination` may be write-combined upload memory.
+    void Encode(const void* source, uint32_t sourceStride, size_t numVertices, void* destination) const;
+
+    // Unpack into source vertices `destinationStride` bytes apart, only the attributes' components are written.
+    // The inverse of Encode() up to its quantization error, as the GPU would read them.
+    void Decode(const void* packed, size_t numVertices, void* destination, uint32_t destinationStride) const;
+
+private:
+    std::vector<Attribute> attributes_;
+    uint32_t stride_ = 0;
+};
+
+}; // namespace graphics
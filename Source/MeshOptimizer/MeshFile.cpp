@@ -0,0 +1,147 @@
+#include "MeshFile.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace meshoptimizer
+{
+
+namespace
+{
+
+const uint32_t kMagic = 0x4853454d; // "MESH"
+const uint32_t kVersion = 1;
+const size_t kMaxSemanticLength = 15;
+
+struct Header
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t Stride;
+    uint32_t NumAttributes;
+    uint32_t NumVertices;
+    uint32_t NumIndices;
+    uint32_t IndexSize;
+    uint32_t Reserved;
+};
+
+struct AttributeRecord
+{
+    char Semantic[kMaxSemanticLength + 1];
+    uint32_t SemanticIndex;
+    uint32_t NumFloats;
+    uint32_t Offset;
+    uint32_t Reserved;
+};
+
+template <typename T>
+bool Read(std::ifstream& file, T* data, size_t count)
+{
+    file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+    return static_cast<bool>(file);
+}
+
+template <typename T>
+void Write(std::ofstream& file, const T* data, size_t count)
+{
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+};
+
+bool ReadMeshFile(const std::string& path, Mesh& mesh, std::vector<MeshAttribute>& attributes)
+{
+    std::ifstream file(path, std::ios::binary);
+    Header header;
+    if (!file || !Read(file, &header, 1) || header.Magic != kMagic || header.Version != kVersion ||
+        (header.IndexSize != 2 && header.IndexSize != 4) || header.Stride == 0)
+    {
+        return false;
+    }
+
+    attributes.resize(header.NumAttributes);
+    for (MeshAttribute& attribute : attributes)
+    {
+        AttributeRecord record;
+        if (!Read(file, &record, 1))
+        {
+            return false;
+        }
+        record.Semantic[kMaxSemanticLength] = '\0';
+        attribute.Semantic = record.Semantic;
+        attribute.SemanticIndex = record.SemanticIndex;
+        attribute.NumFloats = record.NumFloats;
+        attribute.Offset = record.Offset;
+    }
+
+    mesh.Stride = header.Stride;
+    mesh.Vertices.resize(static_cast<size_t>(header.NumVertices) * header.Stride);
+    mesh.Indices.resize(header.NumIndices);
+    if (!Read(file, mesh.Vertices.data(), mesh.Vertices.size()))
+    {
+        return false;
+    }
+
+    if (header.IndexSize == 4)
+    {
+        return Read(file, mesh.Indices.data(), mesh.Indices.size());
+    }
+    std::vector<uint16_t> indices(header.NumIndices);
+    if (!Read(file, indices.data(), indices.size()))
+    {
+        return false;
+    }
+    mesh.Indices.assign(indices.begin(), indices.end());
+    return true;
+}
+
+bool WriteMeshFile(const std::string& path, const Mesh& mesh, const std::vector<MeshAttribute>& attributes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+
+    Header header = {};
+    header.Magic = kMagic;
+    header.Version = kVersion;
+    header.Stride = mesh.Stride;
+    header.NumAttributes = static_cast<uint32_t>(attributes.size());
+    header.NumVertices = static_cast<uint32_t>(mesh.GetNumVertices());
+    header.NumIndices = static_cast<uint32_t>(mesh.Indices.size());
+    header.IndexSize = mesh.GetNumVertices() <= 0x10000 ? 2 : 4;
+    Write(file, &header, 1);
+
+    for (const MeshAttribute& attribute : attributes)
+    {
+        if (attribute.Semantic.size() > kMaxSemanticLength)
+        {
+            return false;
+        }
+        AttributeRecord record = {};
+        memcpy(record.Semantic, attribute.Semantic.data(), attribute.Semantic.size());
+        record.SemanticIndex = attribute.SemanticIndex;
+        record.NumFloats = attribute.NumFloats;
+        record.Offset = attribute.Offset;
+        Write(file, &record, 1);
+    }
+
+    Write(file, mesh.Vertices.data(), mesh.Vertices.size());
+    if (header.IndexSize == 4)
+    {
+        Write(file, mesh.Indices.data(), mesh.Indices.size());
+    }
+    else
+    {
+        std::vector<uint16_t> indices(mesh.Indices.size());
+        for (size_t index = 0; index < indices.size(); index++)
+        {
+            indices[index] = static_cast<uint16_t>(mesh.Indices[index]);
+        }
+        Write(file, indices.data(), indices.size());
+    }
+    return static_cast<bool>(file);
+}
+
+}; // namespace meshoptimizer
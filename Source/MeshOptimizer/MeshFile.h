@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+
+namespace meshoptimizer
+{
+
+//
+// Float vertex attribute, e.g. POSITION with 3 floats at offset 0.
+//
+struct MeshAttribute
+{
+    std::string Semantic;
+    uint32_t SemanticIndex = 0;
+    uint32_t NumFloats = 0;
+    uint32_t Offset = 0;
+};
+
+//
+// Binary mesh produced by the MeshOpt tool: a header, the attribute layout, the vertices and the indices.
+//
+// Indices are stored as 16-bit when every vertex can be addressed with them, and widened to 32-bit on read,
+// Mesh::Indices is always 32-bit. Files written by another version read as failures.
+//
+bool ReadMeshFile(const std::string& path, Mesh& mesh, std::vector<MeshAttribute>& attributes);
+bool WriteMeshFile(const std::string& path, const Mesh& mesh, const std::vector<MeshAttribute>& attributes);
+
+}; // namespace meshoptimizer
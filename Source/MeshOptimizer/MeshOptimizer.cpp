@@ -0,0 +1,444 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace meshoptimizer
+{
+
+namespace
+{
+
+const uint32_t kInvalidIndex = ~0u;
+
+uint64_t HashBytes(const uint8_t* bytes, size_t size)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t index = 0; index < size; index++)
+    {
+        hash = (hash ^ bytes[index]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+//
+// FIFO post-transform cache, the model most hardware is closest to. A vertex is in the cache when fewer than
+// `cacheSize` misses happened since its own miss, so no queue needs to be kept.
+//
+class FifoCache
+{
+public:
+    FifoCache(size_t numVertices, uint32_t cacheSize) :
+        timestamps_(numVertices, 0),
+        cacheSize_(cacheSize),
+        timestamp_(cacheSize + 1)
+    {
+    }
+
+    // Returns true on a miss.
+    bool Access(uint32_t vertex)
+    {
+        if (timestamp_ - timestamps_[vertex] > cacheSize_)
+        {
+            timestamps_[vertex] = timestamp_++;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<uint32_t> timestamps_;
+    uint32_t cacheSize_;
+    uint32_t timestamp_;
+};
+
+//
+// Scores of "Linear-Speed Vertex Cache Optimisation", Tom Forsyth, 2006.
+//
+const float kCacheDecayPower = 1.5f;
+const float kLastTriangleScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+float GetVertexScore(int cachePosition, uint32_t remainingValence, uint32_t cacheSize)
+{
+    if (remainingValence == 0)
+    {
+        // Not used by any remaining triangle
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+        {
+            // Used by the last triangle, a fixed score so that the next triangle doesn't just reuse its edge and
+            // form a strip, which would be worse for caches of any reasonable size.
+            score = kLastTriangleScore;
+        }
+        else
+        {
+            const float scaler = 1.0f / static_cast<float>(cacheSize - 3);
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scaler, kCacheDecayPower);
+        }
+    }
+
+    // Vertices with few triangles left get a boost, so that lone triangles are finished instead of left behind.
+    score += kValenceBoostScale * std::pow(static_cast<float>(remainingValence), -kValenceBoostPower);
+    return score;
+}
+
+struct Vector3
+{
+    float X;
+    float Y;
+    float Z;
+};
+
+Vector3 operator-(const Vector3& left, const Vector3& right)
+{
+    return { left.X - right.X, left.Y - right.Y, left.Z - right.Z };
+}
+
+Vector3 Cross(const Vector3& left, const Vector3& right)
+{
+    return { left.Y * right.Z - left.Z * right.Y, left.Z * right.X - left.X * right.Z, left.X * right.Y - left.Y * right.X };
+}
+
+Vector3 GetPosition(const Mesh& mesh, uint32_t vertex, uint32_t positionOffset)
+{
+    Vector3 position;
+    memcpy(&position, mesh.Vertices.data() + static_cast<size_t>(vertex) * mesh.Stride + positionOffset, sizeof(position));
+    return position;
+}
+
+};
+
+Mesh WeldVertices(const void* vertices, size_t numVertices, uint32_t stride)
+{
+    Mesh mesh;
+    mesh.Stride = stride;
+    mesh.Indices.reserve(numVertices);
+
+    // Open addressing table of indices into mesh.Vertices, at most half full.
+    size_t tableSize = 1;
+    while (tableSize < numVertices * 2)
+    {
+        tableSize *= 2;
+    }
+    std::vector<uint32_t> table(tableSize, kInvalidIndex);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+    uint32_t numUniqueVertices = 0;
+    for (size_t vertex = 0; vertex < numVertices; vertex++)
+    {
+        const uint8_t* data = bytes + vertex * stride;
+        size_t slot = static_cast<size_t>(HashBytes(data, stride)) & (tableSize - 1);
+        while (table[slot] != kInvalidIndex && memcmp(mesh.Vertices.data() + static_cast<size_t>(table[slot]) * stride, data, stride) != 0)
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] == kInvalidIndex)
+        {
+            table[slot] = numUniqueVertices++;
+            mesh.Vertices.insert(mesh.Vertices.end(), data, data + stride);
+        }
+        mesh.Indices.push_back(table[slot]);
+    }
+
+    return mesh;
+}
+
+void OptimizeVertexCache(Mesh& mesh, uint32_t cacheSize)
+{
+    const size_t numVertices = mesh.GetNumVertices();
+    const size_t numTriangles = mesh.GetNumTriangles();
+    if (numTriangles == 0 || cacheSize <= 3)
+    {
+        return;
+    }
+
+    // Triangles of each vertex, the remaining ones are kept at the front of each vertex's list.
+    std::vector<uint32_t> valences(numVertices, 0);
+    for (uint32_t index : mesh.Indices)
+    {
+        valences[index]++;
+    }
+    std::vector<uint32_t> firstTriangles(numVertices + 1, 0);
+    for (size_t vertex = 0; vertex < numVertices; vertex++)
+    {
+        firstTriangles[vertex + 1] = firstTriangles[vertex] + valences[vertex];
+    }
+    std::vector<uint32_t> adjacency(mesh.Indices.size());
+    std::fill(valences.begin(), valences.end(), 0);
+    for (size_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t vertex = mesh.Indices[triangle * 3 + corner];
+            adjacency[firstTriangles[vertex] + valences[vertex]++] = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    std::vector<int> cachePositions(numVertices, -1);
+    std::vector<float> vertexScores(numVertices);
+    for (size_t vertex = 0; vertex < numVertices; vertex++)
+    {
+        vertexScores[vertex] = GetVertexScore(-1, valences[vertex], cacheSize);
+    }
+
+    std::vector<float> triangleScores(numTriangles);
+    std::vector<bool> emitted(numTriangles, false);
+    uint32_t bestTriangle = 0;
+    for (size_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        const uint32_t* corners = &mesh.Indices[triangle * 3];
+        triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+        if (triangleScores[triangle] > triangleScores[bestTriangle])
+        {
+            bestTriangle = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    // LRU order, with room for the three vertices pushed in before the overflow is evicted.
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    cache.reserve(cacheSize + 3);
+    nextCache.reserve(cacheSize + 3);
+
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.Indices.size());
+    size_t scanCursor = 0;
+
+    while (bestTriangle != kInvalidIndex)
+    {
+        emitted[bestTriangle] = true;
+        const uint32_t corners[3] = { mesh.Indices[bestTriangle * 3], mesh.Indices[bestTriangle * 3 + 1], mesh.Indices[bestTriangle * 3 + 2] };
+        indices.insert(indices.end(), corners, corners + 3);
+
+        // The triangle is no longer remaining for its vertices.
+        for (uint32_t vertex : corners)
+        {
+            uint32_t* triangles = &adjacency[firstTriangles[vertex]];
+            for (uint32_t index = 0; index < valences[vertex]; index++)
+            {
+                if (triangles[index] == bestTriangle)
+                {
+                    std::swap(triangles[index], triangles[valences[vertex] - 1]);
+                    valences[vertex]--;
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the cache.
+        nextCache.assign(corners, corners + 3);
+        for (uint32_t vertex : cache)
+        {
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+            {
+                nextCache.push_back(vertex);
+            }
+        }
+        std::swap(cache, nextCache);
+
+        // Rescore the vertices which moved, including the ones falling out of the cache.
+        for (size_t position = 0; position < cache.size(); position++)
+        {
+            const uint32_t vertex = cache[position];
+            cachePositions[vertex] = position < cacheSize ? static_cast<int>(position) : -1;
+            vertexScores[vertex] = GetVertexScore(cachePositions[vertex], valences[vertex], cacheSize);
+        }
+
+        // Only the triangles of cached vertices changed score, the best of them comes next.
+        bestTriangle = kInvalidIndex;
+        float bestScore = -1.0f;
+        for (uint32_t vertex : cache)
+        {
+            const uint32_t* triangles = &adjacency[firstTriangles[vertex]];
+            for (uint32_t index = 0; index < valences[vertex]; index++)
+            {
+                const uint32_t triangle = triangles[index];
+                const uint32_t* triangleCorners = &mesh.Indices[triangle * 3];
+                const float score = vertexScores[triangleCorners[0]] + vertexScores[triangleCorners[1]] + vertexScores[triangleCorners[2]];
+                triangleScores[triangle] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = triangle;
+                }
+            }
+        }
+        if (cache.size() > cacheSize)
+        {
+            cache.resize(cacheSize);
+        }
+
+        // Nothing left around the cache, continue with the next triangle in input order. Scores outside the cache
+        // only depend on valences, a full search for the best one would make the whole thing quadratic.
+        if (bestTriangle == kInvalidIndex)
+        {
+            while (scanCursor < numTriangles && emitted[scanCursor])
+            {
+                scanCursor++;
+            }
+            if (scanCursor < numTriangles)
+            {
+                bestTriangle = static_cast<uint32_t>(scanCursor);
+            }
+        }
+    }
+
+    mesh.Indices = std::move(indices);
+}
+
+void OptimizeOverdraw(Mesh& mesh, uint32_t positionOffset, uint32_t cacheSize)
+{
+    const size_t numTriangles = mesh.GetNumTriangles();
+    if (numTriangles == 0)
+    {
+        return;
+    }
+
+    // Cluster boundaries, where the cache is cold anyway and reordering costs little.
+    std::vector<size_t> clusterStarts;
+    FifoCache cache(mesh.GetNumVertices(), cacheSize);
+    for (size_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        const uint32_t* corners = &mesh.Indices[triangle * 3];
+        const bool miss0 = cache.Access(corners[0]);
+        const bool miss1 = cache.Access(corners[1]);
+        const bool miss2 = cache.Access(corners[2]);
+        if (triangle == 0 || (miss0 && miss1 && miss2))
+        {
+            clusterStarts.push_back(triangle);
+        }
+    }
+    clusterStarts.push_back(numTriangles);
+
+    // Area weighted centroid of the mesh, and of every cluster with its summed normal.
+    struct Cluster
+    {
+        size_t FirstTriangle;
+        size_t NumTriangles;
+        float SortKey;
+    };
+    std::vector<Cluster> clusters;
+    std::vector<Vector3> centroids;
+    std::vector<Vector3> normals;
+    Vector3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+
+    for (size_t cluster = 0; cluster + 1 < clusterStarts.size(); cluster++)
+    {
+        Vector3 centroid = { 0.0f, 0.0f, 0.0f };
+        Vector3 normal = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++)
+        {
+            const Vector3 p0 = GetPosition(mesh, mesh.Indices[triangle * 3], positionOffset);
+            const Vector3 p1 = GetPosition(mesh, mesh.Indices[triangle * 3 + 1], positionOffset);
+            const Vector3 p2 = GetPosition(mesh, mesh.Indices[triangle * 3 + 2], positionOffset);
+            const Vector3 cross = Cross(p1 - p0, p2 - p0);
+            const float triangleArea = std::sqrt(cross.X * cross.X + cross.Y * cross.Y + cross.Z * cross.Z);
+
+            centroid.X += (p0.X + p1.X + p2.X) * triangleArea / 3.0f;
+            centroid.Y += (p0.Y + p1.Y + p2.Y) * triangleArea / 3.0f;
+            centroid.Z += (p0.Z + p1.Z + p2.Z) * triangleArea / 3.0f;
+            normal.X += cross.X;
+            normal.Y += cross.Y;
+            normal.Z += cross.Z;
+            area += triangleArea;
+        }
+
+        meshCentroid.X += centroid.X;
+        meshCentroid.Y += centroid.Y;
+        meshCentroid.Z += centroid.Z;
+        meshArea += area;
+
+        if (area > 0.0f)
+        {
+            centroid.X /= area;
+            centroid.Y /= area;
+            centroid.Z /= area;
+        }
+        clusters.push_back({ clusterStarts[cluster], clusterStarts[cluster + 1] - clusterStarts[cluster], 0.0f });
+        centroids.push_back(centroid);
+        normals.push_back(normal);
+    }
+
+    if (meshArea > 0.0f)
+    {
+        meshCentroid.X /= meshArea;
+        meshCentroid.Y /= meshArea;
+        meshCentroid.Z /= meshArea;
+    }
+
+    // Clusters far out along their normal are likely in front of the rest from the directions they're seen from.
+    for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+    {
+        const Vector3 direction = centroids[cluster] - meshCentroid;
+        const Vector3& normal = normals[cluster];
+        const float length = std::sqrt(normal.X * normal.X + normal.Y * normal.Y + normal.Z * normal.Z);
+        clusters[cluster].SortKey = length > 0.0f ? (direction.X * normal.X + direction.Y * normal.Y + direction.Z * normal.Z) / length : 0.0f;
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& left, const Cluster& right) { return left.SortKey > right.SortKey; });
+
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.Indices.size());
+    for (const Cluster& cluster : clusters)
+    {
+        const auto first = mesh.Indices.begin() + cluster.FirstTriangle * 3;
+        indices.insert(indices.end(), first, first + cluster.NumTriangles * 3);
+    }
+    mesh.Indices = std::move(indices);
+}
+
+void OptimizeVertexFetch(Mesh& mesh)
+{
+    std::vector<uint32_t> remap(mesh.GetNumVertices(), kInvalidIndex);
+    std::vector<uint8_t> vertices;
+    vertices.reserve(mesh.Vertices.size());
+
+    uint32_t numVertices = 0;
+    for (uint32_t& index : mesh.Indices)
+    {
+        if (remap[index] == kInvalidIndex)
+        {
+            remap[index] = numVertices++;
+            const auto source = mesh.Vertices.begin() + static_cast<size_t>(index) * mesh.Stride;
+            vertices.insert(vertices.end(), source, source + mesh.Stride);
+        }
+        index = remap[index];
+    }
+    mesh.Vertices = std::move(vertices);
+}
+
+CacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t numIndices, size_t numVertices, uint32_t cacheSize)
+{
+    CacheStatistics statistics;
+    FifoCache cache(numVertices, cacheSize);
+    for (size_t index = 0; index < numIndices; index++)
+    {
+        if (cache.Access(indices[index]))
+        {
+            statistics.NumMisses++;
+        }
+    }
+
+    if (numIndices >= 3)
+    {
+        statistics.Acmr = static_cast<float>(statistics.NumMisses) / static_cast<float>(numIndices / 3);
+    }
+    if (numVertices > 0)
+    {
+        statistics.Atvr = static_cast<float>(statistics.NumMisses) / static_cast<float>(numVertices);
+    }
+    return statistics;
+}
+
+}; // namespace meshoptimizer
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace meshoptimizer
+{
+
+//
+// Indexed triangle list with vertices of any layout, `Stride` bytes each.
+//
+struct Mesh
+{
+    uint32_t Stride = 0;
+    std::vector<uint8_t> Vertices;
+    std::vector<uint32_t> Indices;
+
+    size_t GetNumVertices() const { return Stride > 0 ? Vertices.size() / Stride : 0; }
+    size_t GetNumTriangles() const { return Indices.size() / 3; }
+};
+
+//
+// Post-transform cache statistics of an index order, from a FIFO cache simulation.
+//
+struct CacheStatistics
+{
+    uint32_t NumMisses = 0;
+    // Average cache miss ratio, vertex shader invocations per triangle: 3 without reuse, 0.5 at best on large grids.
+    float Acmr = 0.0f;
+    // Average transformed vertex ratio, vertex shader invocations per vertex: 1 is optimal.
+    float Atvr = 0.0f;
+};
+
+const uint32_t kDefaultCacheSize = 16;
+
+// Build an indexed mesh from a non-indexed triangle list, vertices with identical bytes are merged.
+// Vertices are kept in order of first appearance.
+Mesh WeldVertices(const void* vertices, size_t numVertices, uint32_t stride);
+
+// Reorder triangles for post-transform cache hits, with Forsyth's linear-speed vertex cache optimization.
+// The order doesn't depend much on the cache size of the hardware, `cacheSize` only shapes the scoring.
+void OptimizeVertexCache(Mesh& mesh, uint32_t cacheSize = 32);
+
+// Reorder the clusters of a cache optimized mesh so that triangles facing outwards are drawn first, which lets
+// early depth rejection skip more of the hidden ones. Clusters start where the cache simulation of `cacheSize`
+// restarts, all three vertices of a triangle missing, so their internal order and most of the hit rate stay.
+// `positionOffset` locates the float3 position in a vertex.
+void OptimizeOverdraw(Mesh& mesh, uint32_t positionOffset, uint32_t cacheSize = kDefaultCacheSize);
+
+// Reorder vertices in the order the indices first use them, so vertex fetches walk the buffer forward.
+// Unreferenced vertices are dropped.
+void OptimizeVertexFetch(Mesh& mesh);
+
+CacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t numIndices, size_t numVertices, uint32_t cacheSize = kDefaultCacheSize);
+
+}; // namespace meshoptimizer
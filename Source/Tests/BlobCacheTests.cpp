@@ -0,0 +1,215 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "BlobCache.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+const uint64_t kKey = 7;
+
+std::vector<uint8_t> MakeBlob(uint64_t hash, size_t size)
+{
+    std::vector<uint8_t> blob(size);
+    for (size_t index = 0; index < size; index++)
+    {
+        blob[index] = static_cast<uint8_t>(hash * 31 + index);
+    }
+    return blob;
+}
+
+std::vector<uint8_t> ReadFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+bool FileExists(const std::string& path)
+{
+    return std::ifstream(path).good();
+}
+
+void TestMemoryOnly()
+{
+    BlobCache cache("", kKey);
+    const std::vector<uint8_t> blob = MakeBlob(1, 100);
+    cache.Insert(1, blob.data(), blob.size());
+
+    std::vector<uint8_t> found;
+    CHECK(cache.Find(1, found) && found == blob);
+    CHECK(!cache.Find(2, found));
+
+    // Inserting again replaces the blob.
+    const std::vector<uint8_t> replacement = MakeBlob(2, 10);
+    cache.Insert(1, replacement.data(), replacement.size());
+    CHECK(cache.Find(1, found) && found == replacement);
+    CHECK(cache.GetNumBlobs() == 1);
+
+    cache.Erase(1);
+    CHECK(!cache.Find(1, found));
+    CHECK(cache.GetNumBlobs() == 0);
+    CHECK(!cache.Save());
+}
+
+void TestRoundTrip()
+{
+    tests::TemporaryFile file("BlobCacheTests.roundtrip");
+    {
+        BlobCache cache(file.GetPath(), kKey);
+        CHECK(cache.GetNumBlobs() == 0);
+        for (uint64_t hash = 0; hash < 50; hash++)
+        {
+            // Sizes include an empty blob and ones not a multiple of the record header.
+            const std::vector<uint8_t> blob = MakeBlob(hash, static_cast<size_t>(hash * 37 % 1000));
+            cache.Insert(hash, blob.data(), blob.size());
+        }
+        cache.Erase(10);
+        CHECK(cache.Save());
+        CHECK(!FileExists(file.GetPath() + ".tmp"));
+    }
+
+    BlobCache cache(file.GetPath(), kKey);
+    CHECK(cache.GetNumBlobs() == 49);
+    std::vector<uint8_t> found;
+    for (uint64_t hash = 0; hash < 50; hash++)
+    {
+        if (hash == 10)
+        {
+            CHECK(!cache.Find(hash, found));
+            continue;
+        }
+        CHECK(cache.Find(hash, found));
+        CHECK(found == MakeBlob(hash, static_cast<size_t>(hash * 37 % 1000)));
+    }
+}
+
+// Only changes are written: a loaded cache with nothing inserted or erased leaves the file alone.
+void TestSaveOnlyWhenDirty()
+{
+    tests::TemporaryFile file("BlobCacheTests.dirty");
+    const std::vector<uint8_t> blob = MakeBlob(3, 64);
+    {
+        BlobCache cache(file.GetPath(), kKey);
+        cache.Insert(3, blob.data(), blob.size());
+        CHECK(cache.Save());
+    }
+
+    BlobCache cache(file.GetPath(), kKey);
+    std::remove(file.GetPath().c_str());
+    CHECK(cache.Save());
+    CHECK(!FileExists(file.GetPath()));
+
+    // Erasing something missing changes nothing either, erasing a blob does.
+    cache.Erase(4);
+    CHECK(cache.Save());
+    CHECK(!FileExists(file.GetPath()));
+    cache.Erase(3);
+    CHECK(cache.Save());
+    CHECK(FileExists(file.GetPath()));
+    CHECK(BlobCache(file.GetPath(), kKey).GetNumBlobs() == 0);
+}
+
+void TestStaleAndCorruptedFiles()
+{
+    tests::TemporaryFile file("BlobCacheTests.corrupted");
+    {
+        BlobCache cache(file.GetPath(), kKey);
+        for (uint64_t hash = 0; hash < 8; hash++)
+        {
+            const std::vector<uint8_t> blob = MakeBlob(hash, 256);
+            cache.Insert(hash, blob.data(), blob.size());
+        }
+        CHECK(cache.Save());
+    }
+    CHECK(BlobCache(file.GetPath(), kKey).GetNumBlobs() == 8);
+
+    // A different key is a different producer of the blobs.
+    CHECK(BlobCache(file.GetPath(), kKey + 1).GetNumBlobs() == 0);
+
+    const std::vector<uint8_t> original = ReadFile(file.GetPath());
+    std::vector<uint8_t> corrupted = original;
+    corrupted[corrupted.size() / 2] ^= 0x40;
+    WriteFile(file.GetPath(), corrupted);
+    CHECK(BlobCache(file.GetPath(), kKey).GetNumBlobs() == 0);
+
+    std::vector<uint8_t> truncated(original.begin(), original.end() - 100);
+    WriteFile(file.GetPath(), truncated);
+    CHECK(BlobCache(file.GetPath(), kKey).GetNumBlobs() == 0);
+
+    WriteFile(file.GetPath(), std::vector<uint8_t>(4, 0));
+    CHECK(BlobCache(file.GetPath(), kKey).GetNumBlobs() == 0);
+}
+
+// A failed write is reported and keeps the blobs in memory.
+void TestFailedSave()
+{
+    BlobCache cache("BlobCacheTests.missing/cache", kKey);
+    const std::vector<uint8_t> blob = MakeBlob(5, 32);
+    cache.Insert(5, blob.data(), blob.size());
+    CHECK(!cache.Save());
+    CHECK(!cache.Save());
+
+    std::vector<uint8_t> found;
+    CHECK(cache.Find(5, found) && found == blob);
+}
+
+void TestConcurrentAccess()
+{
+    const int kNumThreads = 4;
+    const int kBlobsPerThread = 500;
+    tests::TemporaryFile file("BlobCacheTests.concurrent");
+    BlobCache cache(file.GetPath(), kKey);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kNumThreads; thread++)
+    {
+        threads.emplace_back([&cache, thread]()
+            {
+                std::vector<uint8_t> found;
+                for (int index = 0; index < kBlobsPerThread; index++)
+                {
+                    const uint64_t hash = static_cast<uint64_t>(thread * kBlobsPerThread + index);
+                    const std::vector<uint8_t> blob = MakeBlob(hash, static_cast<size_t>(index % 64));
+                    cache.Insert(hash, blob.data(), blob.size());
+                    CHECK(cache.Find(hash, found) && found == blob);
+                    if (index % 100 == 0)
+                    {
+                        CHECK(cache.Save());
+                    }
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(cache.GetNumBlobs() == kNumThreads * kBlobsPerThread);
+    CHECK(cache.Save());
+    CHECK(BlobCache(file.GetPath(), kKey).GetNumBlobs() == kNumThreads * kBlobsPerThread);
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestMemoryOnly);
+    RUN_TEST(TestRoundTrip);
+    RUN_TEST(TestSaveOnlyWhenDirty);
+    RUN_TEST(TestStaleAndCorruptedFiles);
+    RUN_TEST(TestFailedSave);
+    RUN_TEST(TestConcurrentAccess);
+    return 0;
+}
@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "BlockAllocator.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+using Handle = BlockAllocator::Handle;
+
+//
+// The owner of the blocks, as D3D12HeapAllocator with its heaps: checks that a block is created only in a free
+// slot and destroyed once, and fails a given number of creations.
+//
+class Owner
+{
+public:
+    BlockAllocator::CreateBlockFunction GetCreateFunction()
+    {
+        return [this](uint32_t block, uint64_t size)
+            {
+                lastCreateFailed_ = failures_ > 0;
+                if (lastCreateFailed_)
+                {
+                    failures_--;
+                    return false;
+                }
+                CHECK(blocks_.emplace(block, size).second);
+                numCreated_++;
+                return true;
+            };
+    }
+
+    BlockAllocator::DestroyBlockFunction GetDestroyFunction()
+    {
+        return [this](uint32_t block) { CHECK(blocks_.erase(block) == 1); };
+    }
+
+    void FailCreations(int count) { failures_ = count; }
+    // Clears the state of the last creation, to tell apart allocations that needed none.
+    bool TakeLastCreateFailed()
+    {
+        const bool failed = lastCreateFailed_;
+        lastCreateFailed_ = false;
+        return failed;
+    }
+
+    const std::map<uint32_t, uint64_t>& GetBlocks() const { return blocks_; }
+    int GetNumCreated() const { return numCreated_; }
+
+private:
+    std::map<uint32_t, uint64_t> blocks_;
+    int failures_ = 0;
+    int numCreated_ = 0;
+    bool lastCreateFailed_ = false;
+};
+
+//
+// What the allocator must have: the live allocations by handle and the ranges waiting for their fence.
+// Check() compares the placement and the statistics with it.
+//
+class Shadow
+{
+public:
+    struct Range
+    {
+        uint32_t Block;
+        uint64_t Offset;
+        uint64_t Size;
+    };
+
+    struct Allocation
+    {
+        Range Place;
+        uint64_t Alignment;
+    };
+
+    struct PendingFree
+    {
+        uint64_t FenceValue;
+        Range Place;
+    };
+
+    void Allocate(const BlockAllocator& allocator, Handle handle, uint64_t size, uint64_t alignment)
+    {
+        const Range place = { allocator.GetBlock(handle), allocator.GetOffset(handle), allocator.GetSize(handle) };
+        CHECK(place.Size == size);
+        CHECK(place.Offset % alignment == 0);
+        CHECK(live_.emplace(handle, Allocation{ place, alignment }).second);
+    }
+
+    void Free(Handle handle, uint64_t fenceValue)
+    {
+        const auto allocation = live_.find(handle);
+        CHECK(allocation != live_.end());
+        pending_.push_back({ fenceValue, allocation->second.Place });
+        live_.erase(allocation);
+    }
+
+    void ReleaseCompleted(uint64_t completedValue)
+    {
+        pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+            [completedValue](const PendingFree& pendingFree) { return pendingFree.FenceValue <= completedValue; }), pending_.end());
+    }
+
+    // Defragment() keeps the allocation's size and alignment, the old range is pending until `fenceValue`.
+    void Move(const BlockAllocator& allocator, const BlockAllocator::Move& move, uint64_t fenceValue)
+    {
+        Allocation& allocation = live_.at(move.Allocation);
+        CHECK(allocation.Place.Block == move.SourceBlock && allocation.Place.Offset == move.SourceOffset);
+        CHECK(allocator.GetBlock(move.Allocation) != move.SourceBlock);
+        CHECK(allocator.GetSize(move.Allocation) == allocation.Place.Size);
+        CHECK(allocator.GetOffset(move.Allocation) % allocation.Alignment == 0);
+        pending_.push_back({ fenceValue, allocation.Place });
+        allocation.Place.Block = allocator.GetBlock(move.Allocation);
+        allocation.Place.Offset = allocator.GetOffset(move.Allocation);
+    }
+
+    // A block was created for an allocation, possibly in the slot of a destroyed one.
+    void AddBlock(uint32_t block, bool dedicated)
+    {
+        if (dedicated)
+        {
+            dedicated_.insert(block);
+        }
+        else
+        {
+            dedicated_.erase(block);
+        }
+    }
+
+    void Check(const BlockAllocator& allocator, const Owner& owner)
+    {
+        // No overlap among live and pending ranges, every one inside a block of the owner.
+        std::map<uint32_t, std::vector<Range>> ranges;
+        for (const auto& entry : live_)
+        {
+            ranges[entry.second.Place.Block].push_back(entry.second.Place);
+        }
+        for (const PendingFree& pendingFree : pending_)
+        {
+            ranges[pendingFree.Place.Block].push_back(pendingFree.Place);
+        }
+
+        uint64_t usedSize = 0;
+        for (auto& entry : ranges)
+        {
+            const auto block = owner.GetBlocks().find(entry.first);
+            CHECK(block != owner.GetBlocks().end());
+            std::sort(entry.second.begin(), entry.second.end(), [](const Range& a, const Range& b) { return a.Offset < b.Offset; });
+            uint64_t end = 0;
+            for (const Range& range : entry.second)
+            {
+                CHECK(range.Offset >= end);
+                end = range.Offset + range.Size;
+                usedSize += range.Size;
+            }
+            CHECK(end <= block->second);
+        }
+
+        // Blocks the owner created and no range is in: empty dedicated blocks go right away, at most one regular
+        // block is kept.
+        uint32_t numEmptyRegular = 0;
+        uint64_t reservedSize = 0;
+        for (const auto& block : owner.GetBlocks())
+        {
+            reservedSize += block.second;
+            if (ranges.count(block.first) == 0)
+            {
+                CHECK(dedicated_.count(block.first) == 0);
+                numEmptyRegular += dedicated_.count(block.first) == 0 ? 1 : 0;
+            }
+        }
+        CHECK(numEmptyRegular <= 1);
+
+        uint64_t pendingFreeSize = 0;
+        for (const PendingFree& pendingFree : pending_)
+        {
+            pendingFreeSize += pendingFree.Place.Size;
+        }
+
+        const BlockAllocator::Statistics statistics = allocator.GetStatistics();
+        CHECK(statistics.NumBlocks == owner.GetBlocks().size());
+        CHECK(statistics.NumAllocations == live_.size());
+        CHECK(statistics.ReservedSize == reservedSize);
+        CHECK(statistics.UsedSize == usedSize);
+        CHECK(statistics.PendingFreeSize == pendingFreeSize);
+        CHECK(statistics.LargestFreeSize <= allocator.GetBlockSize());
+    }
+
+private:
+    std::map<Handle, Allocation> live_;
+    std::vector<PendingFree> pending_;
+    std::set<uint32_t> dedicated_;
+};
+
+// Whether BlockAllocator has to give the request a block of its own.
+bool NeedsDedicatedBlock(const BlockAllocator& allocator, uint64_t size, uint64_t alignment)
+{
+    return alignment - 1 > allocator.GetBlockSize() || size > allocator.GetBlockSize() - (alignment - 1);
+}
+
+void TestBlocks()
+{
+    Owner owner;
+    BlockAllocator allocator(1000, 256, owner.GetCreateFunction(), owner.GetDestroyFunction());
+    CHECK(allocator.GetBlockSize() == 1024);
+
+    // Both fit the first block, the third needs a second one.
+    const Handle a = allocator.Allocate(512, 1);
+    const Handle b = allocator.Allocate(256, 256);
+    const Handle c = allocator.Allocate(512, 1);
+    CHECK(allocator.GetBlock(a) == allocator.GetBlock(b));
+    CHECK(allocator.GetBlock(c) != allocator.GetBlock(a));
+    CHECK(owner.GetBlocks().size() == 2);
+
+    // Larger than a block: a dedicated block rounded up to the block alignment, at offset 0 whatever the alignment.
+    const Handle large = allocator.Allocate(2000, 4096);
+    CHECK(owner.GetBlocks().at(allocator.GetBlock(large)) == 2048);
+    CHECK(allocator.GetOffset(large) == 0);
+    CHECK(allocator.GetStatistics().LargestFreeSize == 512);
+
+    // Nothing is given back before the fence completes.
+    allocator.Free(large, 1);
+    allocator.Free(c, 1);
+    allocator.ReleaseCompleted(0);
+    CHECK(owner.GetBlocks().size() == 3);
+    CHECK(allocator.GetStatistics().PendingFreeSize == 2512);
+
+    // The dedicated block goes, the empty regular one stays for the next allocations.
+    allocator.ReleaseCompleted(1);
+    CHECK(owner.GetBlocks().size() == 2);
+    CHECK(allocator.GetStatistics().NumAllocations == 2);
+    CHECK(allocator.GetStatistics().PendingFreeSize == 0);
+
+    allocator.Free(a, 2);
+    allocator.Free(b, 2);
+    allocator.ReleaseCompleted(2);
+    CHECK(owner.GetBlocks().size() == 1);
+    CHECK(allocator.GetStatistics().UsedSize == 0);
+}
+
+// A block the owner can't create fails the allocation and leaves no trace.
+void TestCreateFailure()
+{
+    Owner owner;
+    BlockAllocator allocator(1024, 1, owner.GetCreateFunction(), owner.GetDestroyFunction());
+
+    owner.FailCreations(1);
+    CHECK(allocator.Allocate(100, 1) == BlockAllocator::kInvalidHandle);
+    CHECK(allocator.GetStatistics().NumBlocks == 0);
+    const Handle handle = allocator.Allocate(100, 1);
+    CHECK(handle != BlockAllocator::kInvalidHandle);
+
+    owner.FailCreations(1);
+    CHECK(allocator.Allocate(5000, 1) == BlockAllocator::kInvalidHandle);
+    CHECK(allocator.Allocate(2000, 1) != BlockAllocator::kInvalidHandle);
+    CHECK(allocator.GetStatistics().NumBlocks == 2);
+    CHECK(allocator.GetStatistics().NumAllocations == 2);
+}
+
+// Defragment() empties the emptier block into the fuller one, which is handed back after the copy's fence.
+void TestDefragment()
+{
+    Owner owner;
+    BlockAllocator allocator(1024, 1, owner.GetCreateFunction(), owner.GetDestroyFunction());
+    std::vector<Handle> handles;
+    for (int index = 0; index < 8; index++)
+    {
+        handles.push_back(allocator.Allocate(256, 16));
+    }
+    CHECK(owner.GetBlocks().size() == 2);
+    const uint32_t emptied = allocator.GetBlock(handles[0]);
+    const uint32_t fuller = allocator.GetBlock(handles[7]);
+
+    // Three quarters of the first block are freed and one quarter of the second.
+    for (int index : { 0, 1, 2, 7 })
+    {
+        allocator.Free(handles[index], 1);
+    }
+    allocator.ReleaseCompleted(1);
+
+    const std::vector<BlockAllocator::Move> moves = allocator.Defragment(~0ull, 2);
+    CHECK(moves.size() == 1);
+    CHECK(moves[0].Allocation == handles[3] && moves[0].SourceBlock == emptied);
+    CHECK(allocator.GetBlock(handles[3]) == fuller);
+    CHECK(owner.GetBlocks().size() == 2);
+
+    // The source range stays reserved for the copy.
+    CHECK(allocator.GetStatistics().PendingFreeSize == 256);
+    allocator.ReleaseCompleted(2);
+    CHECK(allocator.GetStatistics().PendingFreeSize == 0);
+    // The emptied block is the one kept.
+    CHECK(owner.GetBlocks().size() == 2);
+
+    // A budget of zero moves nothing.
+    CHECK(allocator.Defragment(0, 3).empty());
+}
+
+// Random allocations, frees, releases and defragmentations against the shadow, with block creations failing.
+void TestStress()
+{
+    const int kNumSeeds = 40;
+    const int kNumSteps = 5000;
+    const uint64_t kBlockSize = 1 << 16;
+    const uint64_t kAlignments[] = { 1, 4, 16, 256, 4096, 65536 };
+
+    for (int seed = 1; seed <= kNumSeeds; seed++)
+    {
+        std::mt19937 random(seed);
+        Owner owner;
+        BlockAllocator allocator(kBlockSize, 4096, owner.GetCreateFunction(), owner.GetDestroyFunction());
+        Shadow shadow;
+        std::vector<Handle> live;
+        uint64_t fenceValue = 1;
+        uint64_t completedValue = 0;
+
+        for (int step = 0; step < kNumSteps; step++)
+        {
+            const uint32_t action = random() % 100;
+            if (action < 42 || live.empty())
+            {
+                // Mostly small ranges, a few larger than a block.
+                const uint64_t size = random() % 50 == 0 ? kBlockSize + random() % kBlockSize : (random() % (1ull << (random() % 15))) + 1;
+                const uint64_t alignment = kAlignments[random() % (sizeof(kAlignments) / sizeof(kAlignments[0]))];
+                if (random() % 20 == 0)
+                {
+                    owner.FailCreations(1);
+                }
+
+                const BlockAllocator::Statistics before = allocator.GetStatistics();
+                const int numCreated = owner.GetNumCreated();
+                const Handle handle = allocator.Allocate(size, alignment);
+                const bool createFailed = owner.TakeLastCreateFailed();
+                owner.FailCreations(0);
+                if (handle == BlockAllocator::kInvalidHandle)
+                {
+                    // Only a failed creation fails an allocation, and it changes nothing.
+                    CHECK(createFailed);
+                    CHECK(allocator.GetStatistics().UsedSize == before.UsedSize);
+                    CHECK(allocator.GetStatistics().NumBlocks == before.NumBlocks);
+                }
+                else
+                {
+                    shadow.Allocate(allocator, handle, size, alignment);
+                    live.push_back(handle);
+                    const bool dedicated = NeedsDedicatedBlock(allocator, size, alignment);
+                    const int numNewBlocks = owner.GetNumCreated() - numCreated;
+                    // A dedicated request always gets a new block, any other at most one.
+                    CHECK(dedicated ? numNewBlocks == 1 : numNewBlocks <= 1);
+                    if (numNewBlocks > 0)
+                    {
+                        shadow.AddBlock(allocator.GetBlock(handle), dedicated);
+                    }
+                }
+            }
+            else if (action < 85)
+            {
+                const size_t index = random() % live.size();
+                allocator.Free(live[index], fenceValue);
+                shadow.Free(live[index], fenceValue);
+                live[index] = live.back();
+                live.pop_back();
+            }
+            else if (action < 97)
+            {
+                // A frame ends; the GPU is one or two frames behind.
+                fenceValue++;
+                const uint64_t completed = fenceValue - 1 - random() % 2;
+                completedValue = completed > completedValue ? completed : completedValue;
+                allocator.ReleaseCompleted(completedValue);
+                shadow.ReleaseCompleted(completedValue);
+            }
+            else
+            {
+                const uint64_t maxBytes = random() % (2 * kBlockSize);
+                const int numCreated = owner.GetNumCreated();
+                const std::vector<BlockAllocator::Move> moves = allocator.Defragment(maxBytes, fenceValue);
+                CHECK(owner.GetNumCreated() == numCreated);
+                uint64_t movedBytes = 0;
+                for (const BlockAllocator::Move& move : moves)
+                {
+                    // The budget is checked before every move.
+                    CHECK(movedBytes < maxBytes);
+                    movedBytes += allocator.GetSize(move.Allocation);
+                    shadow.Move(allocator, move, fenceValue);
+                }
+            }
+            // A wrong placement stays until its range is released, checking every few steps finds it as well.
+            if (step % 4 == 0)
+            {
+                shadow.Check(allocator, owner);
+            }
+        }
+
+        // Everything released, one empty block is left.
+        for (Handle handle : live)
+        {
+            allocator.Free(handle, fenceValue);
+        }
+        allocator.ReleaseCompleted(fenceValue);
+        CHECK(owner.GetBlocks().size() <= 1);
+        CHECK(allocator.GetStatistics().UsedSize == 0);
+    }
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestBlocks);
+    RUN_TEST(TestCreateFailure);
+    RUN_TEST(TestDefragment);
+    RUN_TEST(TestStress);
+    return 0;
+}
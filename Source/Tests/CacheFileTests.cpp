@@ -0,0 +1,114 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "CacheFile.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+const uint64_t kKey = 0x1234;
+// Offset of the payload size in the header: magic, format version, key.
+const size_t kPayloadSizeOffset = 16;
+
+std::vector<uint8_t> ReadBytes(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteBytes(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::vector<uint8_t> CreatePayload(size_t size)
+{
+    std::vector<uint8_t> payload(size);
+    for (size_t index = 0; index < size; index++)
+    {
+        payload[index] = static_cast<uint8_t>(index * 31 + 7);
+    }
+    return payload;
+}
+
+void TestRoundTrip()
+{
+    tests::TemporaryFile file("CacheFileTests.bin");
+    for (size_t size : { 0, 1, 1000 })
+    {
+        const std::vector<uint8_t> payload = CreatePayload(size);
+        CHECK(WriteCacheFile(file.GetPath(), kKey, payload.data(), payload.size()));
+        std::vector<uint8_t> read = { 1, 2, 3 };
+        CHECK(ReadCacheFile(file.GetPath(), kKey, read));
+        CHECK(read == payload);
+    }
+}
+
+void TestMisses()
+{
+    tests::TemporaryFile file("CacheFileTests.bin");
+    std::vector<uint8_t> read;
+    CHECK(!ReadCacheFile(file.GetPath(), kKey, read));
+
+    const std::vector<uint8_t> payload = CreatePayload(100);
+    CHECK(WriteCacheFile(file.GetPath(), kKey, payload.data(), payload.size()));
+    CHECK(!ReadCacheFile(file.GetPath(), kKey + 1, read));
+
+    // A flipped payload byte fails the hash.
+    const std::vector<uint8_t> bytes = ReadBytes(file.GetPath());
+    std::vector<uint8_t> corrupted = bytes;
+    corrupted.back() ^= 0x40;
+    WriteBytes(file.GetPath(), corrupted);
+    CHECK(!ReadCacheFile(file.GetPath(), kKey, read));
+    CHECK(read.empty());
+
+    // Truncated files, in the header and in the payload.
+    for (size_t size : { size_t(8), bytes.size() - 1 })
+    {
+        WriteBytes(file.GetPath(), std::vector<uint8_t>(bytes.begin(), bytes.begin() + size));
+        CHECK(!ReadCacheFile(file.GetPath(), kKey, read));
+    }
+}
+
+// A payload size past the end of the file reads as a miss, without allocating it first.
+void TestOversizedPayloadSize()
+{
+    tests::TemporaryFile file("CacheFileTests.bin");
+    const std::vector<uint8_t> payload = CreatePayload(100);
+    CHECK(WriteCacheFile(file.GetPath(), kKey, payload.data(), payload.size()));
+    const std::vector<uint8_t> bytes = ReadBytes(file.GetPath());
+
+    for (uint64_t payloadSize : { uint64_t(101), uint64_t(1) << 40, ~uint64_t(0) })
+    {
+        std::vector<uint8_t> corrupted = bytes;
+        memcpy(corrupted.data() + kPayloadSizeOffset, &payloadSize, sizeof(payloadSize));
+        WriteBytes(file.GetPath(), corrupted);
+        std::vector<uint8_t> read;
+        CHECK(!ReadCacheFile(file.GetPath(), kKey, read));
+    }
+
+    // A smaller size reads fewer bytes, which then fail the hash.
+    std::vector<uint8_t> corrupted = bytes;
+    const uint64_t payloadSize = 99;
+    memcpy(corrupted.data() + kPayloadSizeOffset, &payloadSize, sizeof(payloadSize));
+    WriteBytes(file.GetPath(), corrupted);
+    std::vector<uint8_t> read;
+    CHECK(!ReadCacheFile(file.GetPath(), kKey, read));
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestRoundTrip);
+    RUN_TEST(TestMisses);
+    RUN_TEST(TestOversizedPayloadSize);
+    return 0;
+}
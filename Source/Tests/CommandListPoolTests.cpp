@@ -0,0 +1,378 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommandListPool.h"
+#include "ParallelCommandRecorder.h"
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+//
+// Stand-in for the device and the queue, enforcing the rules D3D12 has for allocators and lists:
+// an allocator is reset only once the GPU is done with its commands, lists record while open and are
+// executed closed. Every call can be made to fail a given number of times.
+//
+class MockBackend
+{
+public:
+    struct MockAllocator
+    {
+        uint64_t LastFenceValue = 0;
+    };
+
+    struct MockList
+    {
+        MockAllocator* CommandAllocator = nullptr;
+        bool Open = false;
+        std::vector<int> Commands;
+    };
+
+    using Allocator = std::shared_ptr<MockAllocator>;
+    using List = std::shared_ptr<MockList>;
+
+    Allocator CreateAllocator()
+    {
+        MaybeFail(failCreateAllocator_, "CreateAllocator");
+        numAllocators_++;
+        return std::make_shared<MockAllocator>();
+    }
+
+    List CreateList(Allocator& allocator)
+    {
+        MaybeFail(failCreateList_, "CreateList");
+        List list = std::make_shared<MockList>();
+        list->CommandAllocator = allocator.get();
+        list->Open = true;
+        return list;
+    }
+
+    void Reset(Allocator& allocator, List& list)
+    {
+        MaybeFail(failReset_, "Reset");
+        CHECK(allocator->LastFenceValue <= completedValue_);
+        CHECK(!list->Open);
+        list->CommandAllocator = allocator.get();
+        list->Open = true;
+        list->Commands.clear();
+        numResets_++;
+    }
+
+    // A failing Close() leaves the list closed in an error state, as D3D12 does; closing it again fails.
+    void Close(List& list)
+    {
+        if (!list->Open)
+        {
+            throw std::runtime_error("Close of a closed list");
+        }
+        list->Open = false;
+        MaybeFail(failClose_, "Close");
+    }
+
+    void Execute(List* const* lists, size_t count)
+    {
+        std::vector<std::vector<int>> batch;
+        for (size_t index = 0; index < count; index++)
+        {
+            const List& list = *lists[index];
+            CHECK(!list->Open);
+            list->CommandAllocator->LastFenceValue = submissionFenceValue_;
+            batch.push_back(list->Commands);
+        }
+        batches_.push_back(batch);
+    }
+
+    // The fence value signaled after the next Execute().
+    void SetSubmissionFenceValue(uint64_t value) { submissionFenceValue_ = value; }
+    void SetCompletedValue(uint64_t value) { completedValue_ = value; }
+    // A list handed to the queue without Execute(), for tests of the pool alone.
+    void MarkExecuted(const List& list, uint64_t fenceValue) { list->CommandAllocator->LastFenceValue = fenceValue; }
+
+    void FailCreateAllocator(int count) { failCreateAllocator_ = count; }
+    void FailCreateList(int count) { failCreateList_ = count; }
+    void FailReset(int count) { failReset_ = count; }
+    void FailClose(int count) { failClose_ = count; }
+
+    const std::vector<std::vector<std::vector<int>>>& GetBatches() const { return batches_; }
+    int GetNumAllocators() const { return numAllocators_; }
+    int GetNumResets() const { return numResets_; }
+
+private:
+    static void MaybeFail(std::atomic<int>& counter, const char* call)
+    {
+        int remaining = counter.load();
+        while (remaining > 0)
+        {
+            if (counter.compare_exchange_weak(remaining, remaining - 1))
+            {
+                throw std::runtime_error(std::string("Injected failure of ") + call);
+            }
+        }
+    }
+
+    std::atomic<uint64_t> completedValue_{ 0 };
+    uint64_t submissionFenceValue_ = 0;
+    std::atomic<int> failCreateAllocator_{ 0 };
+    std::atomic<int> failCreateList_{ 0 };
+    std::atomic<int> failReset_{ 0 };
+    std::atomic<int> failClose_{ 0 };
+    std::atomic<int> numAllocators_{ 0 };
+    std::atomic<int> numResets_{ 0 };
+    std::vector<std::vector<std::vector<int>>> batches_;
+};
+
+using Pool = CommandListPool<MockBackend>;
+using Recorder = ParallelCommandRecorder<MockBackend>;
+
+template <typename Function>
+bool Throws(Function&& function)
+{
+    try
+    {
+        function();
+    }
+    catch (const std::runtime_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+void Submit(MockBackend& backend, Pool& pool, Pool::Context* context, uint64_t fenceValue)
+{
+    backend.Close(context->CommandList);
+    backend.MarkExecuted(context->CommandList, fenceValue);
+    pool.Retire(context, fenceValue);
+}
+
+void TestReuseByFence()
+{
+    MockBackend backend;
+    Pool pool(backend);
+
+    Pool::Context* first = pool.Acquire(0);
+    Pool::Context* second = pool.Acquire(0);
+    CHECK(first != second);
+    CHECK(first->CommandList->Open && second->CommandList->Open);
+    Submit(backend, pool, first, 1);
+    Submit(backend, pool, second, 2);
+    CHECK(pool.GetNumRetired() == 2);
+
+    // Nothing has completed yet, a third context is created.
+    Pool::Context* third = pool.Acquire(0);
+    CHECK(third != first && third != second);
+    CHECK(pool.GetNumContexts() == 3);
+
+    // Both complete; the most recently retired one comes back first.
+    backend.SetCompletedValue(2);
+    CHECK(pool.Acquire(2) == second);
+    CHECK(pool.Acquire(2) == first);
+    CHECK(pool.GetNumRetired() == 0);
+    CHECK(pool.GetNumContexts() == 3);
+    CHECK(backend.GetNumResets() == 2);
+    CHECK(first->CommandList->Open && first->CommandList->Commands.empty());
+}
+
+// Lists executed on another queue retire out of order, each context waits for its own value.
+void TestOutOfOrderRetire()
+{
+    MockBackend backend;
+    Pool pool(backend);
+
+    Pool::Context* late = pool.Acquire(0);
+    Pool::Context* early = pool.Acquire(0);
+    Submit(backend, pool, late, 5);
+    Submit(backend, pool, early, 3);
+
+    backend.SetCompletedValue(3);
+    CHECK(pool.Acquire(3) == early);
+    CHECK(pool.Acquire(3) != late);
+    backend.SetCompletedValue(5);
+    CHECK(pool.Acquire(5) == late);
+}
+
+void TestDiscard()
+{
+    MockBackend backend;
+    Pool pool(backend);
+
+    Pool::Context* context = pool.Acquire(0);
+    context->CommandList->Commands.push_back(1);
+    pool.Discard(context);
+    CHECK(!context->CommandList->Open);
+    CHECK(pool.Acquire(0) == context);
+    CHECK(context->CommandList->Commands.empty());
+}
+
+// A context whose creation or reset throws goes back to the pool instead of being lost.
+void TestAcquireFailureKeepsContext()
+{
+    MockBackend backend;
+    Pool pool(backend);
+
+    backend.FailCreateList(1);
+    CHECK(Throws([&]() { pool.Acquire(0); }));
+    CHECK(pool.GetNumContexts() == 1);
+    Pool::Context* context = pool.Acquire(0);
+    CHECK(pool.GetNumContexts() == 1);
+    CHECK(context->CommandList && context->CommandList->Open);
+
+    backend.FailCreateAllocator(1);
+    CHECK(Throws([&]() { pool.Acquire(0); }));
+    Pool::Context* other = pool.Acquire(0);
+    CHECK(pool.GetNumContexts() == 2);
+
+    Submit(backend, pool, context, 1);
+    Submit(backend, pool, other, 2);
+    backend.SetCompletedValue(2);
+
+    // The failed context becomes the last choice, the healthy one is handed out next.
+    backend.FailReset(1);
+    CHECK(Throws([&]() { pool.Acquire(2); }));
+    CHECK(pool.Acquire(2) == context);
+    CHECK(pool.Acquire(2) == other);
+    CHECK(pool.GetNumContexts() == 2);
+
+    // Discard gives the context back even when closing fails.
+    backend.FailClose(1);
+    CHECK(Throws([&]() { pool.Discard(other); }));
+    CHECK(pool.Acquire(2) == other);
+    CHECK(other->CommandList->Open);
+}
+
+// Frames of lists recorded on worker threads in random order, submitted in slot order, two frames in flight.
+void RunFrames(ThreadPool* threadPool)
+{
+    const int kNumFrames = 40;
+    const int kListsPerFrame = 16;
+    const uint64_t kFramesInFlight = 2;
+
+    MockBackend backend;
+    Pool pool(backend);
+    Recorder recorder(pool, threadPool);
+
+    for (int frame = 1; frame <= kNumFrames; frame++)
+    {
+        const uint64_t completed = frame > static_cast<int>(kFramesInFlight) ? frame - kFramesInFlight : 0;
+        backend.SetCompletedValue(completed);
+        recorder.Begin(completed);
+
+        for (int slot = 0; slot < kListsPerFrame; slot++)
+        {
+            const size_t index = recorder.Record([frame, slot](MockBackend::List& list)
+                {
+                    CHECK(list->Open);
+                    std::mt19937 random(frame * 1000 + slot);
+                    std::this_thread::sleep_for(std::chrono::microseconds(random() % 200));
+                    list->Commands = { frame, slot };
+                });
+            CHECK(index == static_cast<size_t>(slot));
+        }
+
+        backend.SetSubmissionFenceValue(frame);
+        CHECK(recorder.Execute(frame) == kListsPerFrame);
+
+        const std::vector<std::vector<int>>& batch = backend.GetBatches().back();
+        CHECK(batch.size() == kListsPerFrame);
+        for (int slot = 0; slot < kListsPerFrame; slot++)
+        {
+            CHECK((batch[slot] == std::vector<int>{ frame, slot }));
+        }
+    }
+
+    CHECK(backend.GetBatches().size() == kNumFrames);
+    // The frames in flight and the one recording, never more.
+    CHECK(pool.GetNumContexts() <= kListsPerFrame * (kFramesInFlight + 1));
+    CHECK(backend.GetNumAllocators() == static_cast<int>(pool.GetNumContexts()));
+}
+
+void TestRecorderOnThreadPool()
+{
+    ThreadPool threadPool(4);
+    RunFrames(&threadPool);
+}
+
+void TestRecorderInline()
+{
+    RunFrames(nullptr);
+}
+
+// A failed recording, Close() or Acquire() fails the frame; nothing is executed and every context returns.
+void TestRecorderFailures()
+{
+    const int kListsPerFrame = 8;
+    ThreadPool threadPool(4);
+    MockBackend backend;
+    Pool pool(backend);
+    Recorder recorder(pool, &threadPool);
+
+    auto recordFrame = [&](uint64_t frame, int failingSlot)
+        {
+            recorder.Begin(frame - 1);
+            for (int slot = 0; slot < kListsPerFrame; slot++)
+            {
+                recorder.Record([slot, failingSlot](MockBackend::List& list)
+                    {
+                        if (slot == failingSlot)
+                        {
+                            throw std::runtime_error("Recording failed");
+                        }
+                        list->Commands = { slot };
+                    });
+            }
+            backend.SetSubmissionFenceValue(frame);
+            return recorder.Execute(frame);
+        };
+
+    CHECK(recordFrame(1, -1) == kListsPerFrame);
+    backend.SetCompletedValue(1);
+
+    bool thrown = false;
+    try
+    {
+        recordFrame(2, 3);
+    }
+    catch (const std::runtime_error& error)
+    {
+        thrown = std::string(error.what()) == "Recording failed";
+    }
+    CHECK(thrown);
+    CHECK(backend.GetBatches().size() == 1);
+    CHECK(recorder.GetNumRecorded() == 0);
+
+    // Closing fails once: that list is discarded, closing it again fails too and is ignored.
+    backend.FailClose(1);
+    CHECK(Throws([&]() { recordFrame(3, -1); }));
+    backend.FailReset(1);
+    CHECK(Throws([&]() { recordFrame(4, -1); }));
+    CHECK(backend.GetBatches().size() == 1);
+
+    // No context was lost on the way: the next frame runs on the same contexts.
+    CHECK(recordFrame(5, -1) == kListsPerFrame);
+    CHECK(backend.GetBatches().size() == 2);
+    CHECK(pool.GetNumContexts() == kListsPerFrame);
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestReuseByFence);
+    RUN_TEST(TestOutOfOrderRetire);
+    RUN_TEST(TestDiscard);
+    RUN_TEST(TestAcquireFailureKeepsContext);
+    RUN_TEST(TestRecorderOnThreadPool);
+    RUN_TEST(TestRecorderInline);
+    RUN_TEST(TestRecorderFailures);
+    return 0;
+}
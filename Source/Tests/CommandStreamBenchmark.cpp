@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "CommandStream.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+size_t numAllocations = 0;
+
+};
+
+// Counting every allocation of the process, the recording loops below must not add any.
+void* operator new(size_t size)
+{
+    numAllocations++;
+    if (void* memory = std::malloc(size > 0 ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+//
+// Recording a frame of draws into a CommandStream which is Reset() every frame, and replaying it into a
+// NullCommandSink. Once the first frame has grown the buffer, recording and replaying allocate nothing.
+//
+namespace
+{
+
+const uint32_t kNumDrawsPerFrame = 2000;
+
+int objects[4];
+
+void RecordFrame(CommandStream& stream, uint32_t frame)
+{
+    const CommandObject heaps[] = { &objects[0] };
+    const uint64_t renderTarget = 0x1000 + frame % 3;
+    const float color[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    stream.Barrier(&objects[1], 0x0, 0x4);
+    stream.SetDescriptorHeaps(1, heaps);
+    stream.SetGraphicsRootSignature(&objects[2]);
+    stream.SetRenderTargets(1, &renderTarget, 0x2000);
+    stream.ClearRenderTarget(renderTarget, color);
+    stream.SetViewport(0.0f, 0.0f, 1920.0f, 1080.0f);
+    stream.SetScissorRect(0, 0, 1920, 1080);
+    stream.SetPrimitiveTopology(4);
+    for (uint32_t draw = 0; draw < kNumDrawsPerFrame; draw++)
+    {
+        const commands::VertexBufferView view = { 0x100000 + draw * 4096ull, 4096, 32 };
+        if (draw % 16 == 0)
+        {
+            stream.SetPipelineState(&objects[3]);
+        }
+        stream.SetGraphicsRootConstantBufferView(0, 0x200000 + draw * 256ull);
+        stream.SetGraphicsRootDescriptorTable(1, 0x3000 + draw);
+        stream.SetVertexBuffers(0, 1, &view);
+        stream.SetIndexBuffer(0x400000, 65536, 42);
+        stream.DrawIndexed(36 + draw % 8, 1, 0, 0, 0);
+    }
+    stream.Barrier(&objects[1], 0x4, 0x0);
+}
+
+void BenchmarkRecording(int frames)
+{
+    CommandStream stream;
+    NullCommandSink sink;
+    RecordFrame(stream, 0);
+    const size_t frameSize = stream.GetSize();
+
+    double recordMilliseconds = 0.0;
+    double replayMilliseconds = 0.0;
+    const size_t allocationsBefore = numAllocations;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        recordMilliseconds += tests::MeasureMilliseconds([&]() {
+            stream.Reset();
+            RecordFrame(stream, static_cast<uint32_t>(frame));
+        });
+        replayMilliseconds += tests::MeasureMilliseconds([&]() { stream.Replay(sink); });
+    }
+    CHECK(numAllocations == allocationsBefore);
+
+    CHECK(stream.GetSize() == frameSize);
+    CHECK(sink.GetStatistics().NumCommands[static_cast<size_t>(CommandType::DrawIndexed)] == static_cast<size_t>(frames) * kNumDrawsPerFrame);
+    std::printf("%u draws, %zu commands, %zu bytes: %.3f ms record, %.3f ms replay per frame\n", kNumDrawsPerFrame,
+        stream.GetNumCommands(), frameSize, recordMilliseconds / frames, replayMilliseconds / frames);
+}
+
+}; // namespace
+
+int main(int argc, char** argv)
+{
+    BenchmarkRecording(tests::GetIterations(argc, argv, 1000));
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include <vector>
+
+#include "CommandStream.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+int objects[4];
+
+// Counts like NullCommandSink, and keeps the order of the packets and the elements behind them.
+class RecordingSink : public NullCommandSink
+{
+public:
+    virtual void SetDescriptorHeaps(const commands::SetDescriptorHeaps& command, const CommandObject* heaps) override
+    {
+        NullCommandSink::SetDescriptorHeaps(command, heaps);
+        heaps_.assign(heaps, heaps + command.Count);
+        types_.push_back(command.Header.Type);
+    }
+
+    virtual void SetRenderTargets(const commands::SetRenderTargets& command, const uint64_t* renderTargets) override
+    {
+        NullCommandSink::SetRenderTargets(command, renderTargets);
+        renderTargets_.assign(renderTargets, renderTargets + command.Count);
+        depthStencil_ = command.DepthStencil;
+        types_.push_back(command.Header.Type);
+    }
+
+    virtual void SetVertexBuffers(const commands::SetVertexBuffers& command, const commands::VertexBufferView* views) override
+    {
+        NullCommandSink::SetVertexBuffers(command, views);
+        views_.assign(views, views + command.Count);
+        startSlot_ = command.StartSlot;
+        types_.push_back(command.Header.Type);
+    }
+
+    virtual void Draw(const commands::Draw& command) override
+    {
+        NullCommandSink::Draw(command);
+        types_.push_back(command.Header.Type);
+    }
+
+    virtual void Finish() override { numFinished_++; }
+
+    std::vector<CommandType> types_;
+    std::vector<CommandObject> heaps_;
+    std::vector<uint64_t> renderTargets_;
+    uint64_t depthStencil_ = 0;
+    std::vector<commands::VertexBufferView> views_;
+    uint32_t startSlot_ = 0;
+    int numFinished_ = 0;
+};
+
+size_t GetCount(const NullCommandSink& sink, CommandType type)
+{
+    return sink.GetStatistics().NumCommands[static_cast<size_t>(type)];
+}
+
+// One packet of every type, the ones with trailing elements also empty.
+void RecordEveryType(CommandStream& stream)
+{
+    const CommandObject heaps[] = { &objects[0], &objects[1] };
+    const uint64_t renderTargets[] = { 0x1000, 0x2000, 0x3000 };
+    const commands::VertexBufferView views[] = { { 0x10000, 256, 16 }, { 0x20000, 128, 8 } };
+    const float color[4] = { 0.0f, 0.25f, 0.5f, 1.0f };
+
+    stream.Barrier(&objects[2], 0x4, 0x80);
+    stream.SetPipelineState(&objects[3]);
+    stream.SetGraphicsRootSignature(&objects[0]);
+    stream.SetDescriptorHeaps(2, heaps);
+    stream.SetDescriptorHeaps(0, nullptr);
+    stream.SetGraphicsRootConstantBufferView(0, 0x30000);
+    stream.SetGraphicsRootDescriptorTable(1, 0x4000);
+    stream.SetViewport(0.0f, 0.0f, 1280.0f, 720.0f);
+    stream.SetScissorRect(0, 0, 1280, 720);
+    stream.SetRenderTargets(3, renderTargets, 0x5000);
+    stream.SetRenderTargets(0, nullptr, 0x5000);
+    stream.ClearRenderTarget(0x1000, color);
+    stream.SetPrimitiveTopology(4);
+    stream.SetVertexBuffers(1, 2, views);
+    stream.SetVertexBuffers(0, 0, nullptr);
+    stream.SetIndexBuffer(0x40000, 1024, 57);
+    stream.Draw(3, 2, 0, 0);
+    stream.DrawIndexed(36, 4, 0, 0, 0);
+    stream.CopyBufferRegion(&objects[0], 0, &objects[1], 64, 4096);
+    stream.CopyBufferRegion(&objects[0], 4096, &objects[1], 0, 100);
+    stream.CopyResource(&objects[2], &objects[3]);
+}
+
+void TestReplay()
+{
+    CommandStream stream;
+    CHECK(stream.IsEmpty());
+    RecordEveryType(stream);
+    CHECK(stream.GetNumCommands() == 21);
+    CHECK(stream.GetSize() % 8 == 0);
+
+    NullCommandSink sink;
+    stream.Replay(sink);
+    const size_t expectedCounts[] = { 1, 1, 1, 2, 1, 1, 1, 1, 2, 1, 1, 2, 1, 1, 1, 2, 1 };
+    static_assert(sizeof(expectedCounts) / sizeof(expectedCounts[0]) == static_cast<size_t>(CommandType::kCount), "A count per type");
+    for (size_t type = 0; type < static_cast<size_t>(CommandType::kCount); type++)
+    {
+        CHECK(GetCount(sink, static_cast<CommandType>(type)) == expectedCounts[type]);
+    }
+    CHECK(sink.GetStatistics().NumVertices == 3 * 2 + 36 * 4);
+    CHECK(sink.GetStatistics().NumInstances == 2 + 4);
+    CHECK(sink.GetStatistics().NumCopiedBytes == 4096 + 100);
+
+    // Replays don't consume the stream.
+    stream.Replay(sink);
+    CHECK(GetCount(sink, CommandType::Draw) == 2);
+    sink.ResetStatistics();
+    CHECK(GetCount(sink, CommandType::Draw) == 0);
+}
+
+// Elements behind a packet come back as recorded, and empty arrays don't shift the packets after them.
+void TestTrailingElements()
+{
+    CommandStream stream;
+    const CommandObject heaps[] = { &objects[0], &objects[1], &objects[2] };
+    const uint64_t renderTargets[] = { 0x1000, 0x2000, 0x3000 };
+    const commands::VertexBufferView views[] = { { 0x10000, 256, 16 }, { 0x20000, 128, 8 } };
+
+    RecordingSink sink;
+    stream.SetDescriptorHeaps(3, heaps);
+    stream.SetRenderTargets(3, renderTargets, 0x5000);
+    stream.SetVertexBuffers(2, 2, views);
+    stream.Replay(sink);
+    CHECK((sink.heaps_ == std::vector<CommandObject>{ &objects[0], &objects[1], &objects[2] }));
+    CHECK((sink.renderTargets_ == std::vector<uint64_t>{ 0x1000, 0x2000, 0x3000 }));
+    CHECK(sink.depthStencil_ == 0x5000);
+    CHECK(sink.startSlot_ == 2 && sink.views_.size() == 2);
+    CHECK(sink.views_[1].BufferLocation == 0x20000 && sink.views_[1].SizeInBytes == 128 && sink.views_[1].StrideInBytes == 8);
+    CHECK(sink.numFinished_ == 1);
+
+    stream.Reset();
+    CHECK(stream.IsEmpty() && stream.GetSize() == 0);
+    stream.SetDescriptorHeaps(0, nullptr);
+    stream.Draw(3, 1, 0, 0);
+    stream.SetRenderTargets(0, nullptr);
+    stream.Draw(6, 1, 0, 0);
+    stream.SetVertexBuffers(0, 0, nullptr);
+    stream.Draw(9, 1, 0, 0);
+    sink = RecordingSink();
+    stream.Replay(sink);
+    CHECK((sink.types_ == std::vector<CommandType>{ CommandType::SetDescriptorHeaps, CommandType::Draw, CommandType::SetRenderTargets,
+        CommandType::Draw, CommandType::SetVertexBuffers, CommandType::Draw }));
+    CHECK(sink.heaps_.empty() && sink.renderTargets_.empty() && sink.views_.empty());
+    CHECK(sink.depthStencil_ == 0);
+    CHECK(sink.GetStatistics().NumVertices == 18);
+}
+
+void TestComparison()
+{
+    CommandStream a;
+    CommandStream b;
+    CHECK(a == b);
+    CHECK(a.GetHash() == b.GetHash());
+    CHECK(CommandStream::FindFirstDifference(a, b) == CommandStream::kNoDifference);
+
+    // A reused buffer records the same bytes as a fresh one.
+    b.SetViewport(1.0f, 2.0f, 3.0f, 4.0f);
+    b.SetScissorRect(-1, -2, 3, 4);
+    b.Reset();
+    RecordEveryType(a);
+    RecordEveryType(b);
+    CHECK(a == b);
+    CHECK(a.GetHash() == b.GetHash());
+    CHECK(CommandStream::FindFirstDifference(a, b) == CommandStream::kNoDifference);
+
+    // Diverging in one field of the 6th command.
+    CommandStream c;
+    const uint64_t renderTarget = 0x1000;
+    const float color[4] = { 0.0f, 0.25f, 0.5f, 1.0f };
+    for (CommandStream* stream : { &a, &c })
+    {
+        stream->Reset();
+        stream->SetPipelineState(&objects[0]);
+        stream->SetRenderTargets(1, &renderTarget);
+        stream->ClearRenderTarget(renderTarget, color);
+        stream->SetPrimitiveTopology(4);
+        stream->SetIndexBuffer(0x40000, 1024, 57);
+    }
+    a.DrawIndexed(36, 1, 0, 0, 0);
+    c.DrawIndexed(36, 1, 0, 1, 0);
+    CHECK(a != c);
+    CHECK(a.GetHash() != c.GetHash());
+    CHECK(CommandStream::FindFirstDifference(a, c) == 5);
+    CHECK(CommandStream::FindFirstDifference(c, a) == 5);
+
+    // Same trailing size, different elements.
+    const uint64_t first[] = { 0x1000, 0x2000 };
+    const uint64_t second[] = { 0x1000, 0x3000 };
+    a.Reset();
+    c.Reset();
+    a.SetRenderTargets(2, first);
+    c.SetRenderTargets(2, second);
+    CHECK(a != c);
+    CHECK(CommandStream::FindFirstDifference(a, c) == 0);
+
+    // A prefix differs at the first command the other has in addition.
+    a.Reset();
+    c.Reset();
+    RecordEveryType(a);
+    RecordEveryType(c);
+    c.Draw(3, 1, 0, 0);
+    CHECK(a != c);
+    CHECK(a.GetHash() != c.GetHash());
+    CHECK(CommandStream::FindFirstDifference(a, c) == 21);
+    CHECK(CommandStream::FindFirstDifference(c, a) == 21);
+    CHECK(CommandStream::FindFirstDifference(CommandStream(), a) == 0);
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestReplay);
+    RUN_TEST(TestTrailingElements);
+    RUN_TEST(TestComparison);
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "RangeAllocator.h"
+#include "RingAllocator.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+//
+// Allocation cores of the descriptor heaps, without a device:
+// - RangeAllocator behind the CPU descriptor pages and the static region of the shader visible heap,
+// - RingAllocator behind its per-frame dynamic region.
+// Each scenario runs once checking every range against a shadow occupancy map, then once timed without it.
+//
+namespace
+{
+
+// Occupancy of every descriptor, to catch overlapping or out of bounds ranges. Empty when not validating.
+class Shadow
+{
+public:
+    Shadow(uint64_t size, bool validate) : used_(validate ? static_cast<size_t>(size) : 0, false) {}
+
+    void Mark(uint64_t offset, uint64_t count, bool used)
+    {
+        if (used_.empty())
+        {
+            return;
+        }
+        CHECK(offset + count <= used_.size());
+        for (uint64_t index = offset; index < offset + count; index++)
+        {
+            CHECK(used_[static_cast<size_t>(index)] != used);
+            used_[static_cast<size_t>(index)] = used;
+        }
+    }
+
+private:
+    std::vector<bool> used_;
+};
+
+// Random churn of a 256 descriptor CPU page: descriptors of one to eight views are created and
+// released out of order, as render targets and staging views come and go.
+void BenchmarkCpuPage(int iterations, bool validate)
+{
+    const uint64_t kPageSize = 256;
+    RangeAllocator allocator(kPageSize);
+    Shadow shadow(kPageSize, validate);
+    std::vector<std::pair<uint64_t, uint64_t>> live;
+    std::mt19937 random(1);
+    std::uniform_int_distribution<uint64_t> counts(1, 8);
+
+    uint64_t numAllocations = 0;
+    uint64_t numFailures = 0;
+    size_t maxFreeRanges = 0;
+    const double milliseconds = tests::MeasureMilliseconds([&]()
+        {
+            for (int i = 0; i < iterations; i++)
+            {
+                // Keep the page around three quarters full.
+                if (allocator.GetFreeSize() > kPageSize / 4 || live.empty())
+                {
+                    const uint64_t count = counts(random);
+                    const uint64_t offset = allocator.Allocate(count);
+                    if (offset == RangeAllocator::kInvalidOffset)
+                    {
+                        numFailures++;
+                        continue;
+                    }
+                    shadow.Mark(offset, count, true);
+                    live.emplace_back(offset, count);
+                    numAllocations++;
+                }
+                else
+                {
+                    const size_t index = random() % live.size();
+                    shadow.Mark(live[index].first, live[index].second, false);
+                    allocator.Free(live[index].first, live[index].second);
+                    live[index] = live.back();
+                    live.pop_back();
+                }
+                if (allocator.GetNumFreeRanges() > maxFreeRanges)
+                {
+                    maxFreeRanges = allocator.GetNumFreeRanges();
+                }
+            }
+        });
+
+    for (const auto& range : live)
+    {
+        allocator.Free(range.first, range.second);
+    }
+    // Everything coalesces back into the whole page.
+    CHECK(allocator.GetFreeSize() == kPageSize);
+    CHECK(allocator.GetNumFreeRanges() == 1);
+
+    if (!validate)
+    {
+        std::printf("CPU page churn: %d operations, %.1f ns per operation, %llu allocations, %llu fragmentation failures, at most %zu free ranges\n",
+            iterations, milliseconds * 1e6 / iterations, static_cast<unsigned long long>(numAllocations),
+            static_cast<unsigned long long>(numFailures), maxFreeRanges);
+    }
+}
+
+// Static region of the shader visible heap: long-lived tables of one to sixteen descriptors, each freed
+// once the fence of its last use completes, two frames later.
+void BenchmarkStaticRegion(int iterations, bool validate)
+{
+    const uint64_t kRegionSize = 4096;
+    const uint64_t kFramesInFlight = 2;
+    RangeAllocator allocator(kRegionSize);
+    Shadow shadow(kRegionSize, validate);
+    std::vector<std::pair<uint64_t, uint64_t>> live;
+    std::deque<std::pair<uint64_t, std::pair<uint64_t, uint64_t>>> pendingFrees;
+    std::mt19937 random(2);
+    std::uniform_int_distribution<uint64_t> counts(1, 16);
+
+    uint64_t frame = 0;
+    uint64_t numFailures = 0;
+    const double milliseconds = tests::MeasureMilliseconds([&]()
+        {
+            for (int i = 0; i < iterations; i++)
+            {
+                if (i % 64 == 0)
+                {
+                    frame++;
+                    while (!pendingFrees.empty() && pendingFrees.front().first + kFramesInFlight <= frame)
+                    {
+                        const std::pair<uint64_t, uint64_t> range = pendingFrees.front().second;
+                        shadow.Mark(range.first, range.second, false);
+                        allocator.Free(range.first, range.second);
+                        pendingFrees.pop_front();
+                    }
+                }
+
+                if (allocator.GetFreeSize() > kRegionSize / 2 || live.empty())
+                {
+                    const uint64_t count = counts(random);
+                    const uint64_t offset = allocator.Allocate(count);
+                    if (offset == RangeAllocator::kInvalidOffset)
+                    {
+                        numFailures++;
+                        continue;
+                    }
+                    shadow.Mark(offset, count, true);
+                    live.emplace_back(offset, count);
+                }
+                else
+                {
+                    const size_t index = random() % live.size();
+                    pendingFrees.emplace_back(frame, live[index]);
+                    live[index] = live.back();
+                    live.pop_back();
+                }
+            }
+        });
+
+    if (!validate)
+    {
+        std::printf("Static region with fenced frees: %d operations, %.1f ns per operation, %llu fragmentation failures, %zu free ranges\n",
+            iterations, milliseconds * 1e6 / iterations, static_cast<unsigned long long>(numFailures), allocator.GetNumFreeRanges());
+    }
+}
+
+// Dynamic region: every frame stages a few hundred tables into the ring, which is reclaimed by fence
+// once the frame two submissions back has completed.
+void BenchmarkDynamicRing(int iterations, bool validate)
+{
+    const uint64_t kRingSize = 65536;
+    const uint64_t kFramesInFlight = 2;
+    const int kTablesPerFrame = 256;
+    RingAllocator ring(kRingSize);
+    Shadow shadow(kRingSize, validate);
+    std::deque<std::vector<std::pair<uint64_t, uint64_t>>> frames;
+    std::mt19937 random(3);
+    std::uniform_int_distribution<uint64_t> counts(1, 16);
+
+    const int numFrames = iterations / kTablesPerFrame + 1;
+    uint64_t numTables = 0;
+    const double milliseconds = tests::MeasureMilliseconds([&]()
+        {
+            for (int frame = 1; frame <= numFrames; frame++)
+            {
+                frames.emplace_back();
+                for (int table = 0; table < kTablesPerFrame; table++)
+                {
+                    const uint64_t count = counts(random);
+                    const uint64_t offset = ring.Allocate(count, 1);
+                    CHECK(offset != RingAllocator::kInvalidOffset);
+                    shadow.Mark(offset, count, true);
+                    frames.back().emplace_back(offset, count);
+                    numTables++;
+                }
+
+                ring.FinishBatch(frame);
+                const uint64_t completed = frame > static_cast<int>(kFramesInFlight) ? frame - kFramesInFlight : 0;
+                const size_t numInFlight = ring.GetNumBatchesInFlight();
+                ring.ReleaseCompleted(completed);
+                for (size_t released = ring.GetNumBatchesInFlight(); released < numInFlight; released++)
+                {
+                    for (const auto& range : frames.front())
+                    {
+                        shadow.Mark(range.first, range.second, false);
+                    }
+                    frames.pop_front();
+                }
+            }
+        });
+
+    CHECK(ring.GetNumBatchesInFlight() == kFramesInFlight);
+    if (!validate)
+    {
+        std::printf("Dynamic ring: %d frames of %d tables, %.1f ns per table\n",
+            numFrames, kTablesPerFrame, milliseconds * 1e6 / static_cast<double>(numTables));
+    }
+}
+
+}; // namespace
+
+int main(int argc, char** argv)
+{
+    const int iterations = tests::GetIterations(argc, argv, 2000000);
+    const int validatedIterations = iterations < 200000 ? iterations : 200000;
+    BenchmarkCpuPage(validatedIterations, true);
+    BenchmarkStaticRegion(validatedIterations, true);
+    BenchmarkDynamicRing(validatedIterations, true);
+
+    BenchmarkCpuPage(iterations, false);
+    BenchmarkStaticRegion(iterations, false);
+    BenchmarkDynamicRing(iterations, false);
+    return 0;
+}
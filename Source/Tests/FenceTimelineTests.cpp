@@ -0,0 +1,217 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "FenceTimeline.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+const std::chrono::seconds kTimeout(10);
+
+bool IsReady(std::future<void>& future)
+{
+    return future.wait_for(kTimeout) == std::future_status::ready;
+}
+
+void TestCompletedValueDispatchesOnCaller()
+{
+    SimulatedFenceSource source(5);
+    FenceTimeline timeline(source);
+
+    std::thread::id callbackThread;
+    timeline.OnCompletion(3, [&callbackThread]() { callbackThread = std::this_thread::get_id(); });
+    CHECK(callbackThread == std::this_thread::get_id());
+    CHECK(timeline.GetNumPending() == 0);
+    CHECK(timeline.IsCompleted(5));
+    CHECK(!timeline.IsCompleted(6));
+}
+
+void TestCallbacksRunOnWaiterInFenceOrder()
+{
+    // Declared first, so that the timeline joins its waiter before they go away.
+    std::mutex mutex;
+    std::vector<uint64_t> order;
+    std::thread::id callbackThread;
+
+    SimulatedFenceSource source;
+    FenceTimeline timeline(source);
+    for (uint64_t value : { 3, 1, 2, 5 })
+    {
+        timeline.OnCompletion(value, [&, value]()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(value);
+                callbackThread = std::this_thread::get_id();
+            });
+    }
+    std::future<void> third = timeline.WhenCompleted(3);
+    CHECK(timeline.GetNumPending() == 5);
+
+    // Reaching 3 dispatches everything up to it in one go, 5 stays pending.
+    source.Signal(3);
+    CHECK(IsReady(third));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        CHECK((order == std::vector<uint64_t>{ 1, 2, 3 }));
+        CHECK(callbackThread != std::this_thread::get_id());
+    }
+    CHECK(timeline.GetNumPending() == 1);
+
+    source.Signal(5);
+    timeline.Wait(5);
+    std::future<void> fifth = timeline.WhenCompleted(5);
+    CHECK(IsReady(fifth));
+}
+
+void TestEarlierValueRearmsWaiter()
+{
+    SimulatedFenceSource source;
+    FenceTimeline timeline(source);
+
+    std::future<void> later = timeline.WhenCompleted(10);
+    // Let the waiter go to sleep on 10 before a smaller value arrives.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::future<void> earlier = timeline.WhenCompleted(4);
+
+    source.Signal(4);
+    CHECK(IsReady(earlier));
+    CHECK(later.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout);
+
+    source.Signal(10);
+    CHECK(IsReady(later));
+}
+
+void TestWaitFromOtherThreads()
+{
+    SimulatedFenceSource source;
+    FenceTimeline timeline(source);
+
+    std::vector<std::thread> waiters;
+    std::atomic<int> numReturned(0);
+    for (uint64_t value = 1; value <= 4; value++)
+    {
+        waiters.emplace_back([&, value]()
+            {
+                timeline.Wait(value);
+                CHECK(source.GetCompletedValue() >= value);
+                numReturned++;
+            });
+    }
+
+    for (uint64_t value = 1; value <= 4; value++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        source.Signal(value);
+    }
+    for (std::thread& waiter : waiters)
+    {
+        waiter.join();
+    }
+    CHECK(numReturned == 4);
+}
+
+void TestShutdownWithPendingCallbacks()
+{
+    SimulatedFenceSource source;
+    bool called = false;
+    {
+        FenceTimeline timeline(source);
+        timeline.OnCompletion(100, [&called]() { called = true; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // The destructor interrupts the waiter sleeping on 100 and drops the callback.
+    }
+    CHECK(!called);
+}
+
+// Producers register random values while the fence advances; every callback runs exactly once and never before its value.
+void TestConcurrentRegistrationAndSignal()
+{
+    const int kNumProducers = 4;
+    const int kCallbacksPerProducer = 2000;
+    const uint64_t kLastValue = 500;
+
+    SimulatedFenceSource source;
+    FenceTimeline timeline(source);
+
+    std::atomic<int> numEarly(0);
+    std::atomic<int> numCalls(0);
+    std::vector<std::atomic<int>> calls(kNumProducers * kCallbacksPerProducer);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kNumProducers; producer++)
+    {
+        producers.emplace_back([&, producer]()
+            {
+                std::mt19937 random(producer);
+                std::uniform_int_distribution<uint64_t> values(1, kLastValue);
+                for (int i = 0; i < kCallbacksPerProducer; i++)
+                {
+                    const uint64_t value = values(random);
+                    const int index = producer * kCallbacksPerProducer + i;
+                    timeline.OnCompletion(value, [&, value, index]()
+                        {
+                            if (source.GetCompletedValue() < value)
+                            {
+                                numEarly++;
+                            }
+                            calls[index]++;
+                            numCalls++;
+                        });
+                }
+            });
+    }
+
+    std::thread signaler([&]()
+        {
+            for (uint64_t value = 1; value <= kLastValue; value++)
+            {
+                source.Signal(value);
+                if (value % 50 == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        });
+
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    signaler.join();
+
+    // The waiter may still be dispatching the last batch after the fence is reached.
+    const int numCallbacks = kNumProducers * kCallbacksPerProducer;
+    const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+    while (numCalls < numCallbacks && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    CHECK(numEarly == 0);
+    CHECK(timeline.GetNumPending() == 0);
+    for (std::atomic<int>& count : calls)
+    {
+        CHECK(count == 1);
+    }
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestCompletedValueDispatchesOnCaller);
+    RUN_TEST(TestCallbacksRunOnWaiterInFenceOrder);
+    RUN_TEST(TestEarlierValueRearmsWaiter);
+    RUN_TEST(TestWaitFromOtherThreads);
+    RUN_TEST(TestShutdownWithPendingCallbacks);
+    RUN_TEST(TestConcurrentRegistrationAndSignal);
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Fixture of ShaderBindgenTests: cbuffer members around 16-byte register boundaries and a vertex input of mixed sizes.
+
+cbuffer LightConstants : register(b0)
+{
+    float3 Direction;   // 0, the float fills the rest of the register
+    float Intensity;    // 12
+    float2 Offset;      // 16
+    float3 Color;       // would straddle 24..36, moves to 32
+    float2 Scale;       // would straddle 44..52, moves to 48
+    float Time;         // 56
+    float4x4 Transform; // matrices start a register, 64
+    float4 Tints[2];    // 128
+    uint Flags;         // 160, the size rounds up to 176
+};
+
+cbuffer ObjectConstants : register(b1, space1)
+{
+    float Scalar;
+    float4 Vector;      // doesn't fit after the float, 16
+};
+
+Texture2D Albedo : register(t0);
+SamplerState LinearSampler : register(s0);
+
+struct VSInput
+{
+    float3 Position : POSITION;
+    float3 Normal : NORMAL;
+    float2 Uv : TEXCOORD0;
+    float2 Uv1 : TEXCOORD1;
+    uint Id : SV_VertexID;
+};
+
+struct PSInput
+{
+    float4 Position : SV_POSITION;
+    float2 Uv : TEXCOORD0;
+};
+
+PSInput VSMain(VSInput input)
+{
+    PSInput result;
+    result.Position = mul(float4(input.Position * Scalar + Direction * Intensity, 1), Transform);
+    result.Uv = input.Uv * Scale + Offset;
+    return result;
+}
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+    return Albedo.Sample(LinearSampler, input.Uv) * float4(Color, 1) * Tints[Flags & 1];
+}
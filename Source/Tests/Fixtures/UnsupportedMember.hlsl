@@ -0,0 +1,11 @@
+// Fixture of ShaderBindgenTests: HLSL pads every element of a scalar array to 16 bytes, which C++ can't express.
+
+cbuffer Weights : register(b0)
+{
+    float Values[4];
+};
+
+float4 PSMain() : SV_TARGET
+{
+    return Values[0];
+}
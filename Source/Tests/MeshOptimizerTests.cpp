@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "TestUtil.h"
+
+using namespace meshoptimizer;
+
+//
+// The MeshOpt pipeline on generated meshes: welding a non-indexed triangle list, then the cache, overdraw and
+// fetch optimizations. Each step may reorder triangles and vertices, but must draw the same triangles with the
+// same winding.
+//
+namespace
+{
+
+struct Vertex
+{
+    float Position[3];
+    float TexCoord[2];
+};
+
+const uint32_t kStride = sizeof(Vertex);
+
+// Non-indexed triangles of a `size` x `size` quad grid over a bump, in a shuffled order.
+std::vector<Vertex> MakeGrid(uint32_t size, uint32_t seed)
+{
+    auto makeVertex = [size](uint32_t x, uint32_t y) {
+        const float u = static_cast<float>(x) / size;
+        const float v = static_cast<float>(y) / size;
+        return Vertex{ { u, v, 0.25f - (u - 0.5f) * (u - 0.5f) - (v - 0.5f) * (v - 0.5f) }, { u, v } };
+    };
+
+    std::vector<std::array<Vertex, 3>> triangles;
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            triangles.push_back({ makeVertex(x, y), makeVertex(x + 1, y), makeVertex(x + 1, y + 1) });
+            triangles.push_back({ makeVertex(x, y), makeVertex(x + 1, y + 1), makeVertex(x, y + 1) });
+        }
+    }
+    std::mt19937 random(seed);
+    std::shuffle(triangles.begin(), triangles.end(), random);
+
+    std::vector<Vertex> vertices;
+    for (const auto& triangle : triangles)
+    {
+        vertices.insert(vertices.end(), triangle.begin(), triangle.end());
+    }
+    return vertices;
+}
+
+// Triangles as the bytes of their corners, rotated to start at the smallest corner so the winding is kept, and sorted.
+using Triangle = std::array<std::string, 3>;
+
+std::vector<Triangle> GetTriangles(const uint8_t* vertices, const uint32_t* indices, size_t numIndices, uint32_t stride)
+{
+    std::vector<Triangle> triangles;
+    for (size_t index = 0; index + 2 < numIndices; index += 3)
+    {
+        Triangle triangle;
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            const uint8_t* vertex = vertices + static_cast<size_t>(indices[index + corner]) * stride;
+            triangle[corner] = std::string(reinterpret_cast<const char*>(vertex), stride);
+        }
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+std::vector<Triangle> GetTriangles(const Mesh& mesh)
+{
+    return GetTriangles(mesh.Vertices.data(), mesh.Indices.data(), mesh.Indices.size(), mesh.Stride);
+}
+
+std::vector<Triangle> GetTriangles(const std::vector<Vertex>& vertices)
+{
+    std::vector<uint32_t> indices(vertices.size());
+    for (size_t index = 0; index < indices.size(); index++)
+    {
+        indices[index] = static_cast<uint32_t>(index);
+    }
+    return GetTriangles(reinterpret_cast<const uint8_t*>(vertices.data()), indices.data(), indices.size(), kStride);
+}
+
+float GetAcmr(const Mesh& mesh)
+{
+    return AnalyzeVertexCache(mesh.Indices.data(), mesh.Indices.size(), mesh.GetNumVertices()).Acmr;
+}
+
+void TestWeld()
+{
+    const uint32_t size = 8;
+    const std::vector<Vertex> vertices = MakeGrid(size, 1);
+    const Mesh mesh = WeldVertices(vertices.data(), vertices.size(), kStride);
+    CHECK(mesh.Stride == kStride);
+    CHECK(mesh.GetNumVertices() == (size + 1) * (size + 1));
+    CHECK(mesh.GetNumTriangles() == 2 * size * size);
+    CHECK(GetTriangles(mesh) == GetTriangles(vertices));
+
+    // In order of first appearance.
+    CHECK(mesh.Indices[0] == 0 && mesh.Indices[1] == 1 && mesh.Indices[2] == 2);
+    uint32_t maxIndex = 0;
+    for (uint32_t index : mesh.Indices)
+    {
+        CHECK(index <= maxIndex + 1);
+        maxIndex = std::max(maxIndex, index);
+    }
+
+    // Vertices differing in any attribute stay apart.
+    std::vector<Vertex> seams = vertices;
+    seams.insert(seams.end(), vertices.begin(), vertices.begin() + 3);
+    seams.back().TexCoord[0] += 1.0f;
+    CHECK(WeldVertices(seams.data(), seams.size(), kStride).GetNumVertices() == mesh.GetNumVertices() + 1);
+}
+
+void TestOptimize()
+{
+    for (uint32_t seed = 1; seed <= 4; seed++)
+    {
+        const std::vector<Vertex> vertices = MakeGrid(64, seed);
+        const std::vector<Triangle> triangles = GetTriangles(vertices);
+        Mesh mesh = WeldVertices(vertices.data(), vertices.size(), kStride);
+        const size_t numVertices = mesh.GetNumVertices();
+        const float weldedAcmr = GetAcmr(mesh);
+        CHECK(weldedAcmr > 2.0f);
+
+        OptimizeVertexCache(mesh);
+        const float cacheAcmr = GetAcmr(mesh);
+        CHECK(cacheAcmr < 0.8f);
+        CHECK(GetTriangles(mesh) == triangles);
+
+        // Clusters keep most of the hit rate.
+        OptimizeOverdraw(mesh, offsetof(Vertex, Position));
+        const float overdrawAcmr = GetAcmr(mesh);
+        CHECK(overdrawAcmr < cacheAcmr * 1.1f);
+        CHECK(GetTriangles(mesh) == triangles);
+
+        // Indices use the vertices in buffer order, which doesn't change the cache behavior.
+        OptimizeVertexFetch(mesh);
+        CHECK(mesh.GetNumVertices() == numVertices);
+        CHECK(GetAcmr(mesh) == overdrawAcmr);
+        CHECK(GetTriangles(mesh) == triangles);
+        uint32_t maxIndex = 0;
+        for (uint32_t index : mesh.Indices)
+        {
+            CHECK(index <= maxIndex + 1);
+            maxIndex = std::max(maxIndex, index);
+        }
+    }
+}
+
+void TestEmpty()
+{
+    Mesh mesh = WeldVertices(nullptr, 0, kStride);
+    CHECK(mesh.GetNumVertices() == 0 && mesh.GetNumTriangles() == 0);
+    OptimizeVertexCache(mesh);
+    OptimizeOverdraw(mesh, 0);
+    OptimizeVertexFetch(mesh);
+    CHECK(mesh.Vertices.empty() && mesh.Indices.empty());
+
+    const CacheStatistics statistics = AnalyzeVertexCache(nullptr, 0, 0);
+    CHECK(statistics.NumMisses == 0 && statistics.Acmr == 0.0f && statistics.Atvr == 0.0f);
+}
+
+void TestDegenerate()
+{
+    // A single triangle, triangles with repeated corners, a zero area one, and an unreferenced vertex.
+    const Vertex a = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } };
+    const Vertex b = { { 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } };
+    const Vertex c = { { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f } };
+    const Vertex d = { { 2.0f, 0.0f, 0.0f }, { 2.0f, 0.0f } };
+    const std::vector<Vertex> single = { a, b, c };
+    Mesh mesh = WeldVertices(single.data(), single.size(), kStride);
+    OptimizeVertexCache(mesh);
+    OptimizeOverdraw(mesh, offsetof(Vertex, Position));
+    OptimizeVertexFetch(mesh);
+    CHECK((mesh.Indices == std::vector<uint32_t>{ 0, 1, 2 }));
+    CHECK(GetTriangles(mesh) == GetTriangles(single));
+
+    const std::vector<Vertex> degenerate = { a, a, b, c, c, c, a, b, d, b, c, a, a, b, c };
+    const std::vector<Triangle> triangles = GetTriangles(degenerate);
+    mesh = WeldVertices(degenerate.data(), degenerate.size(), kStride);
+    CHECK(mesh.GetNumVertices() == 4 && mesh.GetNumTriangles() == 5);
+    mesh.Vertices.insert(mesh.Vertices.end(), kStride, 0xff);
+    OptimizeVertexCache(mesh);
+    CHECK(GetTriangles(mesh) == triangles);
+    OptimizeOverdraw(mesh, offsetof(Vertex, Position));
+    CHECK(GetTriangles(mesh) == triangles);
+    OptimizeVertexFetch(mesh);
+    CHECK(mesh.GetNumVertices() == 4);
+    CHECK(GetTriangles(mesh) == triangles);
+
+    // Caches of up to 3 vertices can't keep anything beyond the triangle, the order stays.
+    mesh = WeldVertices(degenerate.data(), degenerate.size(), kStride);
+    const std::vector<uint32_t> indices = mesh.Indices;
+    OptimizeVertexCache(mesh, 3);
+    CHECK(mesh.Indices == indices);
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestWeld);
+    RUN_TEST(TestOptimize);
+    RUN_TEST(TestEmpty);
+    RUN_TEST(TestDegenerate);
+    return 0;
+}
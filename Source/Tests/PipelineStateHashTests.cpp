@@ -0,0 +1,229 @@
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "PipelineStateHash.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+const uint64_t kRootSignatureHash = 0x5151;
+
+//
+// A graphics pipeline description with its own storage: vertex and pixel shaders, a two element input layout,
+// stream output, alpha blending and a depth buffer.
+//
+struct Pipeline
+{
+    Pipeline()
+    {
+        vertexShader = { 0x44, 0x58, 0x42, 0x43, 1, 2, 3, 4 };
+        pixelShader = { 0x44, 0x58, 0x42, 0x43, 5, 6, 7, 8, 9 };
+        desc.VS = { vertexShader.data(), vertexShader.size() };
+        desc.PS = { pixelShader.data(), pixelShader.size() };
+
+        inputElements[0] = { position, 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+        inputElements[1] = { texcoord, 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+        desc.InputLayout = { inputElements, 2 };
+
+        streamOutputEntry = { 0, position, 0, 0, 4, 0 };
+        streamOutputStride = 16;
+        desc.StreamOutput = { &streamOutputEntry, 1, &streamOutputStride, 1, 0 };
+
+        D3D12_RENDER_TARGET_BLEND_DESC& blend = desc.BlendState.RenderTarget[0];
+        blend.BlendEnable = TRUE;
+        blend.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        blend.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        blend.BlendOp = D3D12_BLEND_OP_ADD;
+        blend.SrcBlendAlpha = D3D12_BLEND_ONE;
+        blend.DestBlendAlpha = D3D12_BLEND_ZERO;
+        blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+        blend.LogicOp = D3D12_LOGIC_OP_NOOP;
+        blend.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+        desc.SampleMask = 0xffffffff;
+
+        desc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+        desc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+        desc.RasterizerState.DepthClipEnable = TRUE;
+
+        desc.DepthStencilState.DepthEnable = TRUE;
+        desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+        desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+        desc.DepthStencilState.StencilReadMask = 0xff;
+        desc.DepthStencilState.StencilWriteMask = 0xff;
+        desc.DepthStencilState.FrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+        desc.DepthStencilState.BackFace = desc.DepthStencilState.FrontFace;
+
+        desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        desc.NumRenderTargets = 1;
+        desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+        desc.SampleDesc = { 1, 0 };
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    uint64_t GetHash() const { return HashGraphicsPipelineDesc(desc, kRootSignatureHash); }
+
+    std::vector<uint8_t> vertexShader;
+    std::vector<uint8_t> pixelShader;
+    // Semantic names in the storage of each pipeline, hashed by their contents.
+    char position[16] = "POSITION";
+    char texcoord[16] = "TEXCOORD";
+    D3D12_INPUT_ELEMENT_DESC inputElements[2] = {};
+    D3D12_SO_DECLARATION_ENTRY streamOutputEntry = {};
+    UINT streamOutputStride = 0;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+};
+
+// Equal descriptions in different storage hash equal. The root signature object and the cached blob don't matter.
+void TestEqualDescs()
+{
+    const Pipeline a;
+    Pipeline b;
+    CHECK(a.desc.VS.pShaderBytecode != b.desc.VS.pShaderBytecode);
+    CHECK(a.desc.InputLayout.pInputElementDescs[0].SemanticName != b.desc.InputLayout.pInputElementDescs[0].SemanticName);
+    CHECK(a.GetHash() == b.GetHash());
+
+    b.desc.pRootSignature = reinterpret_cast<ID3D12RootSignature*>(&b);
+    const uint8_t blob[4] = { 1, 2, 3, 4 };
+    b.desc.CachedPSO = { blob, sizeof(blob) };
+    CHECK(a.GetHash() == b.GetHash());
+
+    // The hash of the root signature stands in for the object.
+    CHECK(HashGraphicsPipelineDesc(a.desc, kRootSignatureHash + 1) != a.GetHash());
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC empty = {};
+    CHECK(HashGraphicsPipelineDesc(empty, 0) == HashGraphicsPipelineDesc(empty, 0));
+    CHECK(HashGraphicsPipelineDesc(empty, 0) != a.GetHash());
+}
+
+// Every field, behind the pointers too, takes part in the hash.
+void TestEveryFieldMatters()
+{
+    const std::vector<std::function<void(Pipeline&)>> changes =
+    {
+        [](Pipeline& pipeline) { pipeline.vertexShader[4] ^= 1; },
+        [](Pipeline& pipeline) { pipeline.pixelShader[8] ^= 1; },
+        [](Pipeline& pipeline) { pipeline.desc.PS.BytecodeLength--; },
+        [](Pipeline& pipeline) { pipeline.desc.DS = pipeline.desc.PS; },
+        [](Pipeline& pipeline) { pipeline.desc.HS = pipeline.desc.PS; },
+        [](Pipeline& pipeline) { pipeline.desc.GS = pipeline.desc.PS; },
+        [](Pipeline& pipeline) { pipeline.desc.StreamOutput.NumEntries = 0; },
+        [](Pipeline& pipeline) { pipeline.streamOutputEntry.ComponentCount = 3; },
+        [](Pipeline& pipeline) { pipeline.streamOutputEntry.OutputSlot = 1; },
+        [](Pipeline& pipeline) { pipeline.streamOutputStride = 12; },
+        [](Pipeline& pipeline) { pipeline.desc.StreamOutput.RasterizedStream = 1; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.AlphaToCoverageEnable = TRUE; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.IndependentBlendEnable = TRUE; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].BlendEnable = FALSE; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].LogicOpEnable = TRUE; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_ONE; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].DestBlend = D3D12_BLEND_ONE; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].BlendOp = D3D12_BLEND_OP_SUBTRACT; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ZERO; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ONE; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_SUBTRACT; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_CLEAR; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_RED; },
+        [](Pipeline& pipeline) { pipeline.desc.BlendState.RenderTarget[7].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_RED; },
+        [](Pipeline& pipeline) { pipeline.desc.SampleMask = 1; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.FrontCounterClockwise = TRUE; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.DepthBias = 1; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.DepthBiasClamp = 0.5f; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.SlopeScaledDepthBias = 0.5f; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.DepthClipEnable = FALSE; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.MultisampleEnable = TRUE; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.AntialiasedLineEnable = TRUE; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.ForcedSampleCount = 4; },
+        [](Pipeline& pipeline) { pipeline.desc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON; },
+        [](Pipeline& pipeline) { pipeline.desc.DepthStencilState.DepthEnable = FALSE; },
+        [](Pipeline& pipeline) { pipeline.desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO; },
+        [](Pipeline& pipeline) { pipeline.desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL; },
+        [](Pipeline& pipeline) { pipeline.desc.DepthStencilState.StencilEnable = TRUE; },
+        [](Pipeline& pipeline) { pipeline.desc.DepthStencilState.StencilReadMask = 0x0f; },
+        [](Pipeline& pipeline) { pipeline.desc.DepthStencilState.StencilWriteMask = 0x0f; },
+        [](Pipeline& pipeline) { pipeline.desc.DepthStencilState.FrontFace.StencilPassOp = D3D12_STENCIL_OP_REPLACE; },
+        [](Pipeline& pipeline) { pipeline.desc.DepthStencilState.BackFace.StencilFunc = D3D12_COMPARISON_FUNC_NEVER; },
+        [](Pipeline& pipeline) { pipeline.desc.InputLayout.NumElements = 1; },
+        [](Pipeline& pipeline) { pipeline.texcoord[0] = 'X'; },
+        [](Pipeline& pipeline) { pipeline.inputElements[1].SemanticIndex = 1; },
+        [](Pipeline& pipeline) { pipeline.inputElements[1].Format = DXGI_FORMAT_R16G16_FLOAT; },
+        [](Pipeline& pipeline) { pipeline.inputElements[1].InputSlot = 1; },
+        [](Pipeline& pipeline) { pipeline.inputElements[1].AlignedByteOffset = 16; },
+        [](Pipeline& pipeline) { pipeline.inputElements[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA; },
+        [](Pipeline& pipeline) { pipeline.inputElements[1].InstanceDataStepRate = 1; },
+        [](Pipeline& pipeline) { pipeline.desc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF; },
+        [](Pipeline& pipeline) { pipeline.desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; },
+        [](Pipeline& pipeline) { pipeline.desc.NumRenderTargets = 2; },
+        [](Pipeline& pipeline) { pipeline.desc.RTVFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT; },
+        [](Pipeline& pipeline) { pipeline.desc.RTVFormats[7] = DXGI_FORMAT_R8G8B8A8_UNORM; },
+        [](Pipeline& pipeline) { pipeline.desc.DSVFormat = DXGI_FORMAT_UNKNOWN; },
+        [](Pipeline& pipeline) { pipeline.desc.SampleDesc.Count = 4; },
+        [](Pipeline& pipeline) { pipeline.desc.SampleDesc.Quality = 1; },
+        [](Pipeline& pipeline) { pipeline.desc.NodeMask = 1; },
+        [](Pipeline& pipeline) { pipeline.desc.Flags = D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG; },
+    };
+
+    const Pipeline reference;
+    const uint64_t referenceHash = reference.GetHash();
+    std::vector<uint64_t> hashes;
+    for (const auto& change : changes)
+    {
+        Pipeline pipeline;
+        change(pipeline);
+        const uint64_t hash = pipeline.GetHash();
+        CHECK(hash != referenceHash);
+        hashes.push_back(hash);
+    }
+
+    // The changed descriptions differ from each other too.
+    for (size_t index = 0; index < hashes.size(); index++)
+    {
+        for (size_t other = 0; other < index; other++)
+        {
+            CHECK(hashes[index] != hashes[other]);
+        }
+    }
+}
+
+void TestComputeDesc()
+{
+    std::vector<uint8_t> shader = { 0x44, 0x58, 0x42, 0x43, 1, 2, 3 };
+    std::vector<uint8_t> copy = shader;
+    D3D12_COMPUTE_PIPELINE_STATE_DESC a = {};
+    a.CS = { shader.data(), shader.size() };
+    D3D12_COMPUTE_PIPELINE_STATE_DESC b = a;
+    b.CS.pShaderBytecode = copy.data();
+    const uint64_t hash = HashComputePipelineDesc(a, kRootSignatureHash);
+    CHECK(HashComputePipelineDesc(b, kRootSignatureHash) == hash);
+    CHECK(HashComputePipelineDesc(a, kRootSignatureHash + 1) != hash);
+
+    copy[6] ^= 1;
+    CHECK(HashComputePipelineDesc(b, kRootSignatureHash) != hash);
+    b = a;
+    b.CS.BytecodeLength--;
+    CHECK(HashComputePipelineDesc(b, kRootSignatureHash) != hash);
+    b = a;
+    b.NodeMask = 1;
+    CHECK(HashComputePipelineDesc(b, kRootSignatureHash) != hash);
+    b = a;
+    b.Flags = D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG;
+    CHECK(HashComputePipelineDesc(b, kRootSignatureHash) != hash);
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestEqualDescs);
+    RUN_TEST(TestEveryFieldMatters);
+    RUN_TEST(TestComputeDesc);
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include <stdexcept>
+#include <vector>
+
+#include "RenderGraph.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+// Values of D3D12_RESOURCE_STATES
+const ResourceStateMask kStateCommon = 0;
+const ResourceStateMask kStateRenderTarget = 0x4;
+const ResourceStateMask kStateUnorderedAccess = 0x8;
+const ResourceStateMask kStateNonPixelShaderResource = 0x40;
+const ResourceStateMask kStatePixelShaderResource = 0x80;
+const ResourceStateMask kStateCopySource = 0x800;
+
+const uint64_t kSize = 1 << 20;
+const uint64_t kAlignment = 1 << 16;
+
+const RenderGraph::Access* FindAccess(const RenderGraph& graph, uint32_t pass, RenderGraph::ResourceHandle resource)
+{
+    for (const RenderGraph::Access& access : graph.GetPassAccesses(pass))
+    {
+        if (access.Resource == resource)
+        {
+            return &access;
+        }
+    }
+    return nullptr;
+}
+
+// A writes a transient, B reads and writes it and then writes the back buffer: B needs the contents A wrote.
+void TestReadModifyWriteKeepsProducer()
+{
+    RenderGraph graph;
+    const auto backBuffer = graph.Import("BackBuffer", kStateCommon, kStateCommon);
+    const auto transient = graph.CreateTransient("Accumulation", kSize, kAlignment);
+
+    const uint32_t a = graph.AddPass("A", nullptr).Write(transient, kStateUnorderedAccess).GetPass();
+    const uint32_t b = graph.AddPass("B", nullptr)
+        .Read(transient, kStateUnorderedAccess)
+        .Write(transient, kStateUnorderedAccess)
+        .Write(backBuffer, kStateRenderTarget)
+        .GetPass();
+
+    const RenderGraph::Access* access = FindAccess(graph, b, transient);
+    CHECK(access != nullptr && access->Read && access->Write && access->State == kStateUnorderedAccess);
+
+    graph.Compile();
+    CHECK(!graph.IsPassCulled(a));
+    CHECK(!graph.IsPassCulled(b));
+    CHECK(graph.GetCompiledPasses().size() == 2);
+    CHECK(graph.GetCompiledPasses()[0].Activations.size() == 1);
+    CHECK(graph.GetInitialState(transient) == kStateUnorderedAccess);
+}
+
+// The write first and the read second declare the same read-modify-write.
+void TestWriteThenReadIsReadModifyWrite()
+{
+    RenderGraph graph;
+    const auto output = graph.Import("Output", kStateCommon, kStateCommon);
+    const auto transient = graph.CreateTransient("Transient", kSize, kAlignment);
+
+    const uint32_t a = graph.AddPass("A", nullptr).Write(transient, kStateUnorderedAccess).GetPass();
+    graph.AddPass("B", nullptr)
+        .Write(transient, kStateUnorderedAccess)
+        .Read(transient, kStateUnorderedAccess)
+        .Write(output, kStateUnorderedAccess);
+
+    graph.Compile();
+    CHECK(!graph.IsPassCulled(a));
+}
+
+void TestConflictingStatesAreRejected()
+{
+    RenderGraph graph;
+    const auto texture = graph.CreateTransient("Texture", kSize, kAlignment);
+    const auto other = graph.CreateTransient("Other", kSize, kAlignment);
+
+    // Reads combine into one read state.
+    const uint32_t reader = graph.AddPass("Reader", nullptr)
+        .Read(texture, kStatePixelShaderResource)
+        .Read(texture, kStateNonPixelShaderResource)
+        .GetPass();
+    const RenderGraph::Access* access = FindAccess(graph, reader, texture);
+    CHECK(access->Read && !access->Write);
+    CHECK(access->State == (kStatePixelShaderResource | kStateNonPixelShaderResource));
+
+    // A read and a write state can't be held at once, in either order, nor two write states.
+    bool thrown = false;
+    try
+    {
+        graph.AddPass("ReadThenWrite", nullptr).Read(texture, kStatePixelShaderResource).Write(texture, kStateRenderTarget);
+    }
+    catch (const std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    thrown = false;
+    try
+    {
+        graph.AddPass("WriteThenRead", nullptr).Write(other, kStateRenderTarget).Read(other, kStatePixelShaderResource);
+    }
+    catch (const std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    thrown = false;
+    try
+    {
+        graph.AddPass("TwoWrites", nullptr).Write(other, kStateRenderTarget).Write(other, kStateUnorderedAccess);
+    }
+    catch (const std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+void TestCulling()
+{
+    RenderGraph graph;
+    const auto backBuffer = graph.Import("BackBuffer", kStateCommon, kStateCommon);
+    const auto readback = graph.CreateTransient("Readback", kSize, kAlignment);
+    const auto unused = graph.CreateTransient("Unused", kSize, kAlignment);
+    const auto chain = graph.CreateTransient("Chain", kSize, kAlignment);
+    const auto lighting = graph.CreateTransient("Lighting", kSize, kAlignment);
+
+    // A chain of passes nobody consumes goes away as a whole.
+    const uint32_t unusedProducer = graph.AddPass("UnusedProducer", nullptr).Write(unused, kStateRenderTarget).GetPass();
+    const uint32_t unusedConsumer = graph.AddPass("UnusedConsumer", nullptr)
+        .Read(unused, kStatePixelShaderResource)
+        .Write(chain, kStateRenderTarget)
+        .GetPass();
+    // A plain write hides the earlier contents, the first lighting pass is overwritten before anyone reads it.
+    const uint32_t overwritten = graph.AddPass("Overwritten", nullptr).Write(lighting, kStateRenderTarget).GetPass();
+    const uint32_t lightingPass = graph.AddPass("Lighting", nullptr).Write(lighting, kStateRenderTarget).GetPass();
+    const uint32_t composite = graph.AddPass("Composite", nullptr)
+        .Read(lighting, kStatePixelShaderResource)
+        .Write(backBuffer, kStateRenderTarget)
+        .GetPass();
+    const uint32_t query = graph.AddPass("Query", nullptr).Write(readback, kStateUnorderedAccess).SideEffect().GetPass();
+
+    graph.Compile();
+    CHECK(graph.IsPassCulled(unusedProducer));
+    CHECK(graph.IsPassCulled(unusedConsumer));
+    CHECK(graph.IsPassCulled(overwritten));
+    CHECK(!graph.IsPassCulled(lightingPass));
+    CHECK(!graph.IsPassCulled(composite));
+    CHECK(!graph.IsPassCulled(query));
+    CHECK(graph.GetStatistics().NumCulledPasses == 3);
+    CHECK(graph.GetHeapOffset(unused) == RenderGraph::kInvalidOffset);
+    CHECK(graph.GetHeapOffset(chain) == RenderGraph::kInvalidOffset);
+}
+
+void TestAliasing()
+{
+    RenderGraph graph;
+    const auto backBuffer = graph.Import("BackBuffer", kStateCommon, kStateCommon);
+    const auto first = graph.CreateTransient("First", kSize, kAlignment);
+    const auto second = graph.CreateTransient("Second", kSize, kAlignment);
+    const auto third = graph.CreateTransient("Third", kSize / 2, kAlignment);
+
+    // first: [0, 1], second: [1, 2], third: [2, 3]; only first and third can share memory.
+    graph.AddPass("WriteFirst", nullptr).Write(first, kStateRenderTarget);
+    graph.AddPass("FirstToSecond", nullptr).Read(first, kStatePixelShaderResource).Write(second, kStateRenderTarget);
+    graph.AddPass("SecondToThird", nullptr).Read(second, kStatePixelShaderResource).Write(third, kStateUnorderedAccess);
+    graph.AddPass("Present", nullptr).Read(third, kStateNonPixelShaderResource).Write(backBuffer, kStateRenderTarget);
+
+    graph.Compile();
+    const RenderGraph::Statistics& statistics = graph.GetStatistics();
+    CHECK(statistics.TransientSizeWithoutAliasing == 2 * kSize + kSize / 2);
+    CHECK(statistics.TransientHeapSize == 2 * kSize);
+    CHECK(graph.GetHeapOffset(first) != graph.GetHeapOffset(second));
+    CHECK(graph.GetHeapOffset(third) == graph.GetHeapOffset(first));
+
+    const std::vector<RenderGraph::CompiledPass>& passes = graph.GetCompiledPasses();
+    CHECK(passes[2].Activations.size() == 1);
+    CHECK(passes[2].Activations[0].Resource == third);
+    CHECK(passes[2].Activations[0].Previous == first);
+    CHECK(passes[1].Activations[0].Previous == RenderGraph::kInvalidResource);
+}
+
+void TestBarriers()
+{
+    RenderGraph graph;
+    const auto history = graph.Import("History", kStatePixelShaderResource, kStatePixelShaderResource);
+    const auto target = graph.CreateTransient("Target", kSize, kAlignment);
+
+    graph.AddPass("Draw", nullptr).Write(target, kStateRenderTarget);
+    graph.AddPass("Blur", nullptr).Read(target, kStateUnorderedAccess).Write(target, kStateUnorderedAccess);
+    graph.AddPass("Resolve", nullptr).Read(target, kStateCopySource).Write(history, kStateUnorderedAccess);
+
+    graph.Compile();
+    const std::vector<RenderGraph::CompiledPass>& passes = graph.GetCompiledPasses();
+    CHECK(passes.size() == 3);
+    // The transient is created in its first state, the read-modify-write takes a single transition.
+    CHECK(passes[0].Barriers.empty());
+    CHECK(passes[1].Barriers.size() == 1);
+    CHECK(passes[1].Barriers[0].Before == kStateRenderTarget && passes[1].Barriers[0].After == kStateUnorderedAccess);
+    CHECK(passes[2].Barriers.size() == 2);
+
+    const std::vector<RenderGraph::Barrier>& finalBarriers = graph.GetFinalBarriers();
+    CHECK(finalBarriers.size() == 1);
+    CHECK(finalBarriers[0].Resource == history);
+    CHECK(finalBarriers[0].Before == kStateUnorderedAccess && finalBarriers[0].After == kStatePixelShaderResource);
+    CHECK(graph.GetStatistics().NumBarriers == 4);
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestReadModifyWriteKeepsProducer);
+    RUN_TEST(TestWriteThenReadIsReadModifyWrite);
+    RUN_TEST(TestConflictingStatesAreRejected);
+    RUN_TEST(TestCulling);
+    RUN_TEST(TestAliasing);
+    RUN_TEST(TestBarriers);
+    return 0;
+}
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "ResidencyManager.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+using Handle = ResidencyManager::Handle;
+
+// Keeps the objects of every Evict() and MakeResident() call, in call order.
+class RecordingDevice : public SimulatedResidencyDevice
+{
+public:
+    explicit RecordingDevice(uint64_t budget) : SimulatedResidencyDevice(budget) {}
+
+    virtual void MakeResident(const std::vector<ResidencyObject>& objects) override
+    {
+        for (const ResidencyObject& object : objects)
+        {
+            madeResident_.push_back(object.Object);
+        }
+        SimulatedResidencyDevice::MakeResident(objects);
+    }
+
+    virtual void Evict(const std::vector<ResidencyObject>& objects) override
+    {
+        for (const ResidencyObject& object : objects)
+        {
+            evicted_.push_back(object.Object);
+        }
+        SimulatedResidencyDevice::Evict(objects);
+    }
+
+    // The objects evicted since the last call.
+    std::vector<void*> TakeEvicted() { return std::move(evicted_); }
+    std::vector<void*> TakeMadeResident() { return std::move(madeResident_); }
+
+private:
+    std::vector<void*> evicted_;
+    std::vector<void*> madeResident_;
+};
+
+// Objects are identified by addresses of a static array.
+int objects[8];
+
+Handle Track(RecordingDevice& device, ResidencyManager& manager, int index, uint64_t size)
+{
+    device.AddUsage(size);
+    return manager.Track(&objects[index], size, 0);
+}
+
+void Use(ResidencyManager& manager, std::vector<Handle> handles, uint64_t fenceValue, uint64_t completedValue)
+{
+    manager.Use(handles.data(), handles.size(), fenceValue, completedValue);
+}
+
+// Least recently used first, never an object the GPU may still access.
+void TestEvictionOrder()
+{
+    RecordingDevice device(100);
+    ResidencyManager manager(device, { "Buffers" });
+    const Handle a = Track(device, manager, 0, 30);
+    const Handle b = Track(device, manager, 1, 30);
+    const Handle c = Track(device, manager, 2, 30);
+    Use(manager, { a }, 1, 0);
+    Use(manager, { b }, 2, 0);
+    Use(manager, { c }, 3, 0);
+    manager.Update(0);
+    CHECK(device.TakeEvicted().empty());
+
+    // A new object was never used, so it goes first.
+    const Handle d = Track(device, manager, 3, 30);
+    manager.Update(1);
+    CHECK((device.TakeEvicted() == std::vector<void*>{ &objects[3] }));
+    CHECK(!manager.IsResident(d));
+
+    // Making it resident again needs room, the oldest completed use goes.
+    Use(manager, { d }, 4, 1);
+    CHECK((device.TakeEvicted() == std::vector<void*>{ &objects[0] }));
+    CHECK((device.TakeMadeResident() == std::vector<void*>{ &objects[3] }));
+    CHECK(manager.IsResident(d) && !manager.IsResident(a));
+    CHECK(device.QueryBudget().Usage == 90);
+
+    // A smaller budget: C's use hasn't completed yet, it stays over budget until it has.
+    device.SetBudget(50);
+    manager.Update(2);
+    CHECK((device.TakeEvicted() == std::vector<void*>{ &objects[1] }));
+    CHECK(device.QueryBudget().Usage == 60);
+    manager.Update(3);
+    CHECK((device.TakeEvicted() == std::vector<void*>{ &objects[2] }));
+    CHECK(device.QueryBudget().Usage == 30);
+
+    // Already resident objects make no device call.
+    Use(manager, { d }, 5, 3);
+    CHECK(device.TakeMadeResident().empty());
+
+    // Two objects back at once; D is in flight and stays, so the usage ends above the budget.
+    Use(manager, { a, b }, 6, 4);
+    CHECK(device.TakeEvicted().empty());
+    CHECK((device.TakeMadeResident() == std::vector<void*>{ &objects[0], &objects[1] }));
+    CHECK(device.QueryBudget().Usage == 90);
+    manager.Update(5);
+    CHECK((device.TakeEvicted() == std::vector<void*>{ &objects[3] }));
+
+    const ResidencyManager::Statistics statistics = manager.GetStatistics();
+    CHECK(statistics.NumEvictions == 5);
+    CHECK(statistics.NumMadeResident == 3);
+    CHECK(statistics.Categories[0].NumResident == 2 && statistics.Categories[0].ResidentSize == 60);
+    CHECK(statistics.Categories[0].NumEvicted == 2 && statistics.Categories[0].EvictedSize == 60);
+    CHECK(statistics.Budget.Budget == 50 && statistics.Budget.Usage == 90);
+
+    // Untracked objects are no longer candidates.
+    manager.Untrack(a);
+    device.RemoveUsage(30);
+    device.SetBudget(0);
+    manager.Update(6);
+    CHECK((device.TakeEvicted() == std::vector<void*>{ &objects[1] }));
+}
+
+//
+// The LRU policy as the documentation of ResidencyManager describes it: objects in last use order, new ones
+// first, and evictions walking that order up to the first object whose last use hasn't completed.
+//
+class Model
+{
+public:
+    struct Object
+    {
+        uint64_t Size;
+        uint32_t Category;
+        uint64_t LastUse;
+        bool Resident;
+    };
+
+    void Track(Handle handle, uint64_t size, uint32_t category)
+    {
+        objects_[handle] = { size, category, 0, true };
+        order_.insert(order_.begin(), handle);
+    }
+
+    void Untrack(Handle handle)
+    {
+        objects_.erase(handle);
+        order_.erase(std::find(order_.begin(), order_.end(), handle));
+    }
+
+    void Use(const std::vector<Handle>& handles, uint64_t fenceValue, uint64_t completedValue, uint64_t budget)
+    {
+        const uint64_t usage = GetUsage();
+        uint64_t residentSize = 0;
+        for (Handle handle : handles)
+        {
+            Object& object = objects_.at(handle);
+            object.LastUse = std::max(object.LastUse, fenceValue);
+            order_.erase(std::find(order_.begin(), order_.end(), handle));
+            order_.push_back(handle);
+            if (!object.Resident)
+            {
+                residentSize += object.Size;
+                object.Resident = true;
+            }
+        }
+        if (residentSize > 0 && usage + residentSize > budget)
+        {
+            Evict(usage + residentSize - budget, completedValue);
+        }
+    }
+
+    void Update(uint64_t completedValue, uint64_t budget)
+    {
+        if (GetUsage() > budget)
+        {
+            Evict(GetUsage() - budget, completedValue);
+        }
+    }
+
+    uint64_t GetUsage() const
+    {
+        uint64_t usage = 0;
+        for (const auto& entry : objects_)
+        {
+            usage += entry.second.Resident ? entry.second.Size : 0;
+        }
+        return usage;
+    }
+
+    const std::map<Handle, Object>& GetObjects() const { return objects_; }
+
+private:
+    void Evict(uint64_t size, uint64_t completedValue)
+    {
+        uint64_t evictedSize = 0;
+        for (size_t index = 0; index < order_.size() && evictedSize < size; index++)
+        {
+            Object& object = objects_.at(order_[index]);
+            if (object.LastUse > completedValue)
+            {
+                break;
+            }
+            if (object.Resident)
+            {
+                evictedSize += object.Size;
+                object.Resident = false;
+            }
+        }
+    }
+
+    std::map<Handle, Object> objects_;
+    std::vector<Handle> order_;
+};
+
+// Random tracking, uses, frame ends and budget changes against the model.
+void TestRandomSteps()
+{
+    const int kNumSeeds = 100;
+    const int kNumSteps = 1000;
+    const uint32_t kNumCategories = 3;
+
+    for (int seed = 1; seed <= kNumSeeds; seed++)
+    {
+        std::mt19937 random(seed);
+        SimulatedResidencyDevice device(1000);
+        ResidencyManager manager(device, { "Buffers", "Textures", "Render targets" });
+        Model model;
+        std::vector<Handle> handles;
+        uint64_t budget = 1000;
+        uint64_t fenceValue = 0;
+        uint64_t completedValue = 0;
+
+        for (int step = 0; step < kNumSteps; step++)
+        {
+            std::map<Handle, bool> wasResident;
+            for (const auto& entry : model.GetObjects())
+            {
+                wasResident.emplace_hint(wasResident.end(), entry.first, entry.second.Resident);
+            }
+            const uint32_t action = random() % 100;
+            if (action < 12 || handles.empty())
+            {
+                const uint64_t size = 10 + random() % 200;
+                const uint32_t category = random() % kNumCategories;
+                device.AddUsage(size);
+                const Handle handle = manager.Track(reinterpret_cast<void*>(static_cast<uintptr_t>(step + 1)), size, category);
+                model.Track(handle, size, category);
+                handles.push_back(handle);
+            }
+            else if (action < 25)
+            {
+                // Only objects whose last use has completed may be released.
+                const size_t index = random() % handles.size();
+                const Model::Object& object = model.GetObjects().at(handles[index]);
+                if (object.LastUse <= completedValue)
+                {
+                    if (object.Resident)
+                    {
+                        device.RemoveUsage(object.Size);
+                    }
+                    manager.Untrack(handles[index]);
+                    model.Untrack(handles[index]);
+                    handles[index] = handles.back();
+                    handles.pop_back();
+                }
+            }
+            else if (action < 75)
+            {
+                // A submission of a few objects, duplicates included.
+                std::vector<Handle> used(1 + random() % 4);
+                for (Handle& handle : used)
+                {
+                    handle = handles[random() % handles.size()];
+                }
+                fenceValue++;
+                manager.Use(used.data(), used.size(), fenceValue, completedValue);
+                model.Use(used, fenceValue, completedValue, budget);
+            }
+            else if (action < 95)
+            {
+                // A frame ends, the GPU is up to a few submissions behind.
+                const uint64_t lag = random() % 4;
+                completedValue = std::max(completedValue, fenceValue > lag ? fenceValue - lag : 0);
+                manager.Update(completedValue);
+                model.Update(completedValue, budget);
+            }
+            else
+            {
+                budget = 200 + random() % 2000;
+                device.SetBudget(budget);
+            }
+
+            // Same residency as the model, and never an object evicted the GPU may still access.
+            for (const auto& entry : model.GetObjects())
+            {
+                CHECK(manager.IsResident(entry.first) == entry.second.Resident);
+                const auto previous = wasResident.find(entry.first);
+                if (previous != wasResident.end() && previous->second && !entry.second.Resident)
+                {
+                    CHECK(entry.second.LastUse <= completedValue);
+                }
+            }
+            CHECK(device.QueryBudget().Usage == model.GetUsage());
+
+            // Over budget only when nothing left is evictable.
+            if (action >= 75 && action < 95 && model.GetUsage() > budget)
+            {
+                for (const auto& entry : model.GetObjects())
+                {
+                    CHECK(!entry.second.Resident || entry.second.LastUse > completedValue);
+                }
+            }
+
+            const ResidencyManager::Statistics statistics = manager.GetStatistics();
+            std::vector<ResidencyManager::CategoryStatistics> expected(kNumCategories);
+            for (const auto& entry : model.GetObjects())
+            {
+                ResidencyManager::CategoryStatistics& category = expected[entry.second.Category];
+                (entry.second.Resident ? category.NumResident : category.NumEvicted)++;
+                (entry.second.Resident ? category.ResidentSize : category.EvictedSize) += entry.second.Size;
+            }
+            for (uint32_t category = 0; category < kNumCategories; category++)
+            {
+                CHECK(statistics.Categories[category].NumResident == expected[category].NumResident);
+                CHECK(statistics.Categories[category].NumEvicted == expected[category].NumEvicted);
+                CHECK(statistics.Categories[category].ResidentSize == expected[category].ResidentSize);
+                CHECK(statistics.Categories[category].EvictedSize == expected[category].EvictedSize);
+            }
+        }
+    }
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestEvictionOrder);
+    RUN_TEST(TestRandomSteps);
+    return 0;
+}
@@ -0,0 +1,488 @@
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "ResourceStateTracker.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+// Values of D3D12_RESOURCE_STATES
+const ResourceStateMask kStateCommon = 0;
+const ResourceStateMask kStatePresent = 0;
+const ResourceStateMask kStateVertexAndConstantBuffer = 0x1;
+const ResourceStateMask kStateIndexBuffer = 0x2;
+const ResourceStateMask kStateRenderTarget = 0x4;
+const ResourceStateMask kStateUnorderedAccess = 0x8;
+const ResourceStateMask kStateDepthWrite = 0x10;
+const ResourceStateMask kStateDepthRead = 0x20;
+const ResourceStateMask kStateNonPixelShaderResource = 0x40;
+const ResourceStateMask kStatePixelShaderResource = 0x80;
+const ResourceStateMask kStateCopyDest = 0x400;
+const ResourceStateMask kStateCopySource = 0x800;
+const ResourceStateMask kStateGenericRead = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800;
+
+// The write states D3D12ResourceStateTracker passes
+const ResourceStateMask kWriteStates = kStateRenderTarget | kStateUnorderedAccess | kStateDepthWrite | 0x100 | kStateCopyDest | 0x1000;
+
+bool Satisfies(ResourceStateMask actual, ResourceStateMask requested)
+{
+    if (actual == requested)
+    {
+        return true;
+    }
+    const bool bothReadOnly = (actual & kWriteStates) == 0 && (requested & kWriteStates) == 0;
+    return bothReadOnly && requested != 0 && (actual & requested) == requested;
+}
+
+//
+// Stand-in for a command list, recording the ResourceBarrier calls and the draws, copies or clears using resources.
+//
+class MockCommandList
+{
+public:
+    struct Command
+    {
+        std::vector<StateTransition> Barriers;
+        ResourceKey Resource;
+        ResourceStateMask State;
+    };
+
+    void ResourceBarrier(const std::vector<StateTransition>& barriers)
+    {
+        commands_.push_back({ barriers, nullptr, 0 });
+        numBarrierCalls_++;
+        numBarriers_ += barriers.size();
+    }
+
+    void Use(ResourceKey resource, ResourceStateMask state)
+    {
+        commands_.push_back({ {}, resource, state });
+    }
+
+    const std::vector<Command>& GetCommands() const { return commands_; }
+    size_t GetNumBarrierCalls() const { return numBarrierCalls_; }
+    size_t GetNumBarriers() const { return numBarriers_; }
+
+private:
+    std::vector<Command> commands_;
+    size_t numBarrierCalls_ = 0;
+    size_t numBarriers_ = 0;
+};
+
+//
+// The tracker bound to a mock list the way D3D12ResourceStateTracker binds it to an ID3D12GraphicsCommandList.
+//
+class MockRecorder
+{
+public:
+    MockRecorder() : tracker_(kWriteStates) {}
+
+    void Transition(ResourceKey resource, ResourceStateMask state)
+    {
+        tracker_.Transition(resource, state);
+    }
+
+    void FlushBarriers()
+    {
+        transitions_.clear();
+        if (tracker_.FlushBarriers(transitions_) > 0)
+        {
+            list_.ResourceBarrier(transitions_);
+        }
+    }
+
+    // Declare the state, flush, and use the resource, as a draw preceded by its transitions.
+    void Use(ResourceKey resource, ResourceStateMask state)
+    {
+        Transition(resource, state);
+        FlushBarriers();
+        list_.Use(resource, state);
+    }
+
+    // Close the list: returns the prologue barriers resolved against `registry`.
+    std::vector<StateTransition> Resolve(ResourceStateRegistry& registry)
+    {
+        FlushBarriers();
+        std::vector<StateTransition> prologue;
+        tracker_.Resolve(registry, prologue);
+        return prologue;
+    }
+
+    MockCommandList& GetList() { return list_; }
+    const ResourceStateTracker& GetTracker() const { return tracker_; }
+
+private:
+    ResourceStateTracker tracker_;
+    MockCommandList list_;
+    std::vector<StateTransition> transitions_;
+};
+
+//
+// Executes mock lists against the actual state of every resource, as the debug layer validates them: the state
+// before of each barrier has to match, and every use has to find the resource in its state.
+//
+class MockQueue
+{
+public:
+    void Create(ResourceKey resource, ResourceStateMask state, ResourceStateRegistry& registry)
+    {
+        states_[resource] = state;
+        registry.Register(resource, state);
+    }
+
+    void Execute(const std::vector<StateTransition>& prologue, const MockCommandList& list)
+    {
+        Apply(prologue);
+        for (const MockCommandList::Command& command : list.GetCommands())
+        {
+            if (command.Resource == nullptr)
+            {
+                Apply(command.Barriers);
+            }
+            else
+            {
+                CHECK(Satisfies(states_.at(command.Resource), command.State));
+            }
+        }
+    }
+
+    ResourceStateMask GetState(ResourceKey resource) const { return states_.at(resource); }
+
+private:
+    void Apply(const std::vector<StateTransition>& barriers)
+    {
+        for (const StateTransition& barrier : barriers)
+        {
+            CHECK(states_.at(barrier.Resource) == barrier.Before);
+            CHECK(barrier.Before != barrier.After);
+            states_[barrier.Resource] = barrier.After;
+        }
+    }
+
+    std::unordered_map<ResourceKey, ResourceStateMask> states_;
+};
+
+// Distinct keys standing for resources
+int gResources[16];
+
+ResourceKey GetResource(int index)
+{
+    return &gResources[index];
+}
+
+void TestFirstUseResolvedAtSubmit()
+{
+    ResourceStateRegistry registry;
+    MockQueue queue;
+    ResourceKey texture = GetResource(0);
+    queue.Create(texture, kStateRenderTarget, registry);
+
+    MockRecorder recorder;
+    recorder.Use(texture, kStatePixelShaderResource);
+    // The first use isn't known to need a barrier while recording.
+    CHECK(recorder.GetList().GetNumBarrierCalls() == 0);
+
+    std::vector<StateTransition> prologue = recorder.Resolve(registry);
+    CHECK(prologue.size() == 1);
+    CHECK(prologue[0].Before == kStateRenderTarget && prologue[0].After == kStatePixelShaderResource);
+    CHECK(registry.GetState(texture) == kStatePixelShaderResource);
+    queue.Execute(prologue, recorder.GetList());
+
+    // Already in the state for the next list, no prologue at all.
+    MockRecorder next;
+    next.Use(texture, kStatePixelShaderResource);
+    CHECK(next.Resolve(registry).empty());
+}
+
+void TestRedundantAndMergedTransitions()
+{
+    ResourceStateRegistry registry;
+    MockQueue queue;
+    ResourceKey target = GetResource(0);
+    queue.Create(target, kStateCommon, registry);
+
+    MockRecorder recorder;
+    recorder.Use(target, kStateRenderTarget);
+    recorder.Use(target, kStateRenderTarget);
+    CHECK(recorder.GetList().GetNumBarriers() == 0);
+
+    // RT -> SRV -> COPY_SOURCE before a flush is a single RT -> COPY_SOURCE barrier.
+    recorder.Transition(target, kStatePixelShaderResource);
+    recorder.Transition(target, kStateCopySource);
+    recorder.FlushBarriers();
+    CHECK(recorder.GetList().GetNumBarriers() == 1);
+
+    // There and back again before a flush cancels out.
+    recorder.Transition(target, kStateCopyDest);
+    recorder.Transition(target, kStateCopySource);
+    recorder.FlushBarriers();
+    CHECK(recorder.GetList().GetNumBarriers() == 1);
+
+    queue.Execute(recorder.Resolve(registry), recorder.GetList());
+    CHECK(queue.GetState(target) == kStateCopySource);
+}
+
+void TestOneBarrierCallPerFlush()
+{
+    ResourceStateRegistry registry;
+    MockQueue queue;
+    for (int index = 0; index < 3; index++)
+    {
+        queue.Create(GetResource(index), kStateCommon, registry);
+    }
+
+    MockRecorder recorder;
+    for (int index = 0; index < 3; index++)
+    {
+        recorder.Use(GetResource(index), kStateRenderTarget);
+    }
+    for (int index = 0; index < 3; index++)
+    {
+        recorder.Transition(GetResource(index), kStatePixelShaderResource);
+    }
+    recorder.FlushBarriers();
+    CHECK(recorder.GetList().GetNumBarrierCalls() == 1);
+    CHECK(recorder.GetList().GetNumBarriers() == 3);
+
+    queue.Execute(recorder.Resolve(registry), recorder.GetList());
+}
+
+void TestCoveredReadStates()
+{
+    ResourceStateRegistry registry;
+    MockQueue queue;
+    ResourceKey buffer = GetResource(0);
+    queue.Create(buffer, kStateCopyDest, registry);
+
+    // Within a list a read already covered by the current read states needs no barrier.
+    MockRecorder recorder;
+    recorder.Use(buffer, kStateGenericRead);
+    recorder.Use(buffer, kStateVertexAndConstantBuffer);
+    recorder.Use(buffer, kStateIndexBuffer);
+    CHECK(recorder.GetList().GetNumBarriers() == 0);
+    queue.Execute(recorder.Resolve(registry), recorder.GetList());
+    CHECK(registry.GetState(buffer) == kStateGenericRead);
+
+    // A later list which starts with a narrower read and then writes must transition from the state
+    // the resource is actually in.
+    MockRecorder next;
+    next.Use(buffer, kStateVertexAndConstantBuffer);
+    next.Use(buffer, kStateCopyDest);
+    queue.Execute(next.Resolve(registry), next.GetList());
+    CHECK(queue.GetState(buffer) == kStateCopyDest);
+    CHECK(registry.GetState(buffer) == kStateCopyDest);
+}
+
+// Lists recorded before the previous ones are submitted only learn their starting states at submit.
+void TestListsRecordedAheadOfSubmission()
+{
+    ResourceStateRegistry registry;
+    MockQueue queue;
+    ResourceKey texture = GetResource(0);
+    queue.Create(texture, kStateCommon, registry);
+
+    MockRecorder first;
+    MockRecorder second;
+    first.Use(texture, kStateRenderTarget);
+    second.Use(texture, kStatePixelShaderResource);
+    first.Use(texture, kStateUnorderedAccess);
+
+    // Resolved in submission order, regardless of the recording order.
+    std::vector<StateTransition> firstPrologue = first.Resolve(registry);
+    queue.Execute(firstPrologue, first.GetList());
+    std::vector<StateTransition> secondPrologue = second.Resolve(registry);
+    CHECK(secondPrologue.size() == 1);
+    CHECK(secondPrologue[0].Before == kStateUnorderedAccess);
+    queue.Execute(secondPrologue, second.GetList());
+}
+
+// Random lists over a handful of resources and every kind of state; the mock queue validates each barrier and use.
+void TestRandomLists()
+{
+    const ResourceStateMask kStates[] =
+    {
+        kStateCommon, kStateVertexAndConstantBuffer, kStateIndexBuffer, kStateRenderTarget, kStateUnorderedAccess,
+        kStateDepthWrite, kStateDepthRead, kStateNonPixelShaderResource, kStatePixelShaderResource,
+        kStateNonPixelShaderResource | kStatePixelShaderResource, kStateCopyDest, kStateCopySource, kStateGenericRead
+    };
+    const size_t kNumStates = sizeof(kStates) / sizeof(kStates[0]);
+    const int kNumResources = 8;
+
+    for (unsigned seed = 0; seed < 200; seed++)
+    {
+        std::mt19937 random(seed);
+        ResourceStateRegistry registry;
+        MockQueue queue;
+        for (int index = 0; index < kNumResources; index++)
+        {
+            queue.Create(GetResource(index), kStates[random() % kNumStates], registry);
+        }
+
+        // Up to three lists recorded at once, submitted in order.
+        for (int round = 0; round < 20; round++)
+        {
+            const int numLists = 1 + random() % 3;
+            std::vector<MockRecorder> recorders(numLists);
+            for (int use = 0; use < 40; use++)
+            {
+                MockRecorder& recorder = recorders[random() % numLists];
+                ResourceKey resource = GetResource(random() % kNumResources);
+                const ResourceStateMask state = kStates[random() % kNumStates];
+                if (random() % 4 == 0)
+                {
+                    recorder.Transition(resource, state);
+                }
+                else
+                {
+                    recorder.Use(resource, state);
+                }
+            }
+            for (MockRecorder& recorder : recorders)
+            {
+                queue.Execute(recorder.Resolve(registry), recorder.GetList());
+            }
+            for (int index = 0; index < kNumResources; index++)
+            {
+                CHECK(registry.GetState(GetResource(index)) == queue.GetState(GetResource(index)));
+            }
+        }
+    }
+}
+
+//
+// A frame of a multi-pass sketch: shadow map, G-buffer, lighting, post processing and present, over ten resources.
+// The hand-written version transitions each resource into the pass's state and back to where it rests,
+// one ResourceBarrier call per transition, as the samples did.
+//
+struct PassUse
+{
+    int Resource;
+    ResourceStateMask State;
+};
+
+enum FrameResource
+{
+    kShadowMap,
+    kAlbedo,
+    kNormals,
+    kDepth,
+    kLighting,
+    kPost,
+    kBackBuffer,
+    kVertices,
+    kIndices,
+    kMaterials,
+    kNumFrameResources
+};
+
+const std::vector<std::vector<PassUse>>& GetFramePasses()
+{
+    static const std::vector<std::vector<PassUse>> passes =
+    {
+        // Shadow map
+        { { kShadowMap, kStateDepthWrite }, { kVertices, kStateVertexAndConstantBuffer }, { kIndices, kStateIndexBuffer } },
+        // G-buffer
+        { { kAlbedo, kStateRenderTarget }, { kNormals, kStateRenderTarget }, { kDepth, kStateDepthWrite },
+          { kVertices, kStateVertexAndConstantBuffer }, { kIndices, kStateIndexBuffer }, { kMaterials, kStatePixelShaderResource } },
+        // Lighting
+        { { kLighting, kStateRenderTarget }, { kAlbedo, kStatePixelShaderResource }, { kNormals, kStatePixelShaderResource },
+          { kDepth, kStatePixelShaderResource }, { kShadowMap, kStatePixelShaderResource } },
+        // Bloom, reading the lighting from a compute pass
+        { { kPost, kStateUnorderedAccess }, { kLighting, kStateNonPixelShaderResource } },
+        // Composite into the back buffer
+        { { kBackBuffer, kStateRenderTarget }, { kLighting, kStatePixelShaderResource }, { kPost, kStatePixelShaderResource } },
+        // Present
+        { { kBackBuffer, kStatePresent } },
+    };
+    return passes;
+}
+
+const ResourceStateMask kRestingStates[kNumFrameResources] =
+{
+    kStatePixelShaderResource, kStatePixelShaderResource, kStatePixelShaderResource, kStateDepthWrite,
+    kStatePixelShaderResource, kStatePixelShaderResource, kStatePresent,
+    kStateVertexAndConstantBuffer, kStateIndexBuffer, kStatePixelShaderResource
+};
+
+void TestMultiPassBarrierCount()
+{
+    const int kNumFrames = 3;
+
+    // Hand-written: into the pass state before each pass, back to the resting state after it.
+    MockCommandList handWritten;
+    for (int frame = 0; frame < kNumFrames; frame++)
+    {
+        for (const std::vector<PassUse>& pass : GetFramePasses())
+        {
+            for (const PassUse& use : pass)
+            {
+                if (kRestingStates[use.Resource] != use.State)
+                {
+                    handWritten.ResourceBarrier({ { GetResource(use.Resource), kRestingStates[use.Resource], use.State } });
+                }
+            }
+            for (const PassUse& use : pass)
+            {
+                if (kRestingStates[use.Resource] != use.State)
+                {
+                    handWritten.ResourceBarrier({ { GetResource(use.Resource), use.State, kRestingStates[use.Resource] } });
+                }
+            }
+        }
+    }
+
+    // Tracked: declare the states of a pass, one flush per pass, prologues resolved at submit.
+    ResourceStateRegistry registry;
+    MockQueue queue;
+    for (int index = 0; index < kNumFrameResources; index++)
+    {
+        queue.Create(GetResource(index), kRestingStates[index], registry);
+    }
+    size_t numTrackedCalls = 0;
+    size_t numTrackedBarriers = 0;
+    for (int frame = 0; frame < kNumFrames; frame++)
+    {
+        MockRecorder recorder;
+        for (const std::vector<PassUse>& pass : GetFramePasses())
+        {
+            for (const PassUse& use : pass)
+            {
+                recorder.Transition(GetResource(use.Resource), use.State);
+            }
+            recorder.FlushBarriers();
+            for (const PassUse& use : pass)
+            {
+                recorder.GetList().Use(GetResource(use.Resource), use.State);
+            }
+        }
+        std::vector<StateTransition> prologue = recorder.Resolve(registry);
+        queue.Execute(prologue, recorder.GetList());
+
+        numTrackedCalls += recorder.GetList().GetNumBarrierCalls() + (prologue.empty() ? 0 : 1);
+        numTrackedBarriers += recorder.GetList().GetNumBarriers() + prologue.size();
+    }
+
+    std::printf("Multi-pass frame x%d: hand-written %zu barriers in %zu calls, tracked %zu barriers in %zu calls\n",
+        kNumFrames, handWritten.GetNumBarriers(), handWritten.GetNumBarrierCalls(), numTrackedBarriers, numTrackedCalls);
+    CHECK(numTrackedBarriers < handWritten.GetNumBarriers());
+    CHECK(numTrackedCalls < handWritten.GetNumBarrierCalls());
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestFirstUseResolvedAtSubmit);
+    RUN_TEST(TestRedundantAndMergedTransitions);
+    RUN_TEST(TestOneBarrierCallPerFlush);
+    RUN_TEST(TestCoveredReadStates);
+    RUN_TEST(TestListsRecordedAheadOfSubmission);
+    RUN_TEST(TestRandomLists);
+    RUN_TEST(TestMultiPassBarrierCount);
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "RingAllocator.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+const uint64_t kInvalidOffset = RingAllocator::kInvalidOffset;
+
+void TestAlignedAllocation()
+{
+    RingAllocator ring(256);
+    CHECK(ring.Allocate(10, 1) == 0);
+    // The padding up to the alignment counts as used.
+    CHECK(ring.Allocate(16, 16) == 16);
+    CHECK(ring.GetUsedSize() == 32);
+    CHECK(ring.Allocate(4, 4) == 32);
+    CHECK(ring.GetUsedSize() == 36);
+    CHECK(ring.GetCurrentBatchSize() == 36);
+    // The aligned offset is past the end, and nothing is free before the head.
+    CHECK(ring.Allocate(1, 256) == kInvalidOffset);
+    CHECK(ring.GetUsedSize() == 36);
+}
+
+void TestWrapAround()
+{
+    RingAllocator ring(256);
+    CHECK(ring.Allocate(100, 1) == 0);
+    ring.FinishBatch(1);
+    CHECK(ring.Allocate(100, 1) == 100);
+    ring.FinishBatch(2);
+    ring.ReleaseCompleted(1);
+    CHECK(ring.GetUsedSize() == 100);
+
+    // 56 bytes left at the end are too small, the allocation wraps and the tail is used until its batch is released.
+    CHECK(ring.Allocate(100, 1) == 0);
+    CHECK(ring.GetUsedSize() == 256);
+    CHECK(ring.Allocate(1, 1) == kInvalidOffset);
+    ring.FinishBatch(3);
+
+    ring.ReleaseCompleted(2);
+    CHECK(ring.GetUsedSize() == 156);
+    CHECK(ring.Allocate(100, 1) == 100);
+    CHECK(ring.Allocate(1, 1) == kInvalidOffset);
+    ring.FinishBatch(4);
+
+    // The padding at the end goes with the batch which wrapped.
+    ring.ReleaseCompleted(3);
+    CHECK(ring.GetUsedSize() == 100);
+    ring.ReleaseCompleted(4);
+    CHECK(ring.GetUsedSize() == 0);
+}
+
+void TestBatchRelease()
+{
+    RingAllocator ring(1024);
+    CHECK(ring.GetOldestFenceValue() == 0);
+
+    // An empty batch isn't kept.
+    ring.FinishBatch(1);
+    CHECK(ring.GetNumBatchesInFlight() == 0);
+
+    CHECK(ring.Allocate(100, 1) == 0);
+    CHECK(ring.Allocate(100, 1) == 100);
+    ring.FinishBatch(2);
+    CHECK(ring.GetCurrentBatchSize() == 0);
+    CHECK(ring.Allocate(50, 1) == 200);
+    ring.FinishBatch(3);
+    CHECK(ring.Allocate(50, 1) == 250);
+    ring.FinishBatch(5);
+    CHECK(ring.GetNumBatchesInFlight() == 3);
+    CHECK(ring.GetOldestFenceValue() == 2);
+
+    ring.ReleaseCompleted(1);
+    CHECK(ring.GetNumBatchesInFlight() == 3);
+    ring.ReleaseCompleted(4);
+    CHECK(ring.GetNumBatchesInFlight() == 1);
+    CHECK(ring.GetOldestFenceValue() == 5);
+    CHECK(ring.GetUsedSize() == 50);
+    ring.ReleaseCompleted(5);
+    CHECK(ring.GetUsedSize() == 0);
+
+    // Nothing in flight, allocations start over at 0.
+    CHECK(ring.Allocate(1024, 1) == 0);
+}
+
+void TestFull()
+{
+    RingAllocator ring(256);
+    CHECK(ring.Allocate(0, 1) == kInvalidOffset);
+    CHECK(ring.Allocate(257, 1) == kInvalidOffset);
+
+    // A full ring with its batch still open has nothing to wait for: UploadRing closes the batch itself instead of
+    // waiting on a fence value of 0.
+    CHECK(ring.Allocate(200, 1) == 0);
+    CHECK(ring.Allocate(56, 1) == 200);
+    CHECK(ring.Allocate(1, 1) == kInvalidOffset);
+    CHECK(ring.GetOldestFenceValue() == 0);
+    CHECK(ring.GetCurrentBatchSize() == 256);
+
+    ring.FinishBatch(1);
+    CHECK(ring.GetOldestFenceValue() == 1);
+    ring.ReleaseCompleted(0);
+    CHECK(ring.Allocate(1, 1) == kInvalidOffset);
+    ring.ReleaseCompleted(1);
+    CHECK(ring.Allocate(256, 1) == 0);
+}
+
+// Random allocations, batches and releases, checking the ranges against the ones still in flight.
+void TestRandomSteps()
+{
+    const int kNumSeeds = 100;
+    const int kNumSteps = 5000;
+    const uint64_t kSize = 4096;
+
+    for (int seed = 1; seed <= kNumSeeds; seed++)
+    {
+        std::mt19937 random(seed);
+        RingAllocator ring(kSize);
+        // End of every live range by offset, and the fence value of each range.
+        std::map<uint64_t, uint64_t> live;
+        std::multimap<uint64_t, uint64_t> fenceValues;
+        std::vector<uint64_t> currentBatch;
+        uint64_t fenceValue = 0;
+        uint64_t completedValue = 0;
+
+        for (int step = 0; step < kNumSteps; step++)
+        {
+            const uint32_t action = random() % 100;
+            if (action < 60)
+            {
+                const uint64_t size = 1 + random() % 600;
+                const uint64_t alignment = 1ull << (random() % 9);
+                const bool empty = ring.GetUsedSize() == 0;
+                const uint64_t offset = ring.Allocate(size, alignment);
+                if (offset == kInvalidOffset)
+                {
+                    CHECK(!empty);
+                    continue;
+                }
+                CHECK(IsAligned(offset, alignment));
+                CHECK(offset + size <= kSize);
+                const auto next = live.lower_bound(offset);
+                CHECK(next == live.end() || next->first >= offset + size);
+                CHECK(next == live.begin() || std::prev(next)->second <= offset);
+                live.emplace(offset, offset + size);
+                currentBatch.push_back(offset);
+            }
+            else if (action < 80)
+            {
+                fenceValue++;
+                ring.FinishBatch(fenceValue);
+                for (uint64_t offset : currentBatch)
+                {
+                    fenceValues.emplace(fenceValue, offset);
+                }
+                currentBatch.clear();
+            }
+            else
+            {
+                completedValue += random() % (fenceValue - completedValue + 1);
+                ring.ReleaseCompleted(completedValue);
+                while (!fenceValues.empty() && fenceValues.begin()->first <= completedValue)
+                {
+                    live.erase(fenceValues.begin()->second);
+                    fenceValues.erase(fenceValues.begin());
+                }
+            }
+
+            uint64_t liveSize = 0;
+            for (const auto& range : live)
+            {
+                liveSize += range.second - range.first;
+            }
+            CHECK(liveSize <= ring.GetUsedSize() && ring.GetUsedSize() <= kSize);
+            CHECK((ring.GetUsedSize() == 0) == live.empty());
+        }
+    }
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestAlignedAllocation);
+    RUN_TEST(TestWrapAround);
+    RUN_TEST(TestBatchRelease);
+    RUN_TEST(TestFull);
+    RUN_TEST(TestRandomSteps);
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "RootSignatureHash.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+//
+// A root signature description with its own storage: a root CBV, root constants, a table of SRVs and UAVs,
+// a sampler table and a static sampler, as the samples use them.
+//
+struct Layout
+{
+    // `garbage` fills the storage first, the unused bytes of the parameter unions must not matter.
+    explicit Layout(uint8_t garbage)
+    {
+        ranges.resize(3);
+        memset(ranges.data(), garbage, sizeof(D3D12_DESCRIPTOR_RANGE1) * ranges.size());
+        ranges[0] = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 4, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND };
+        ranges[1] = { D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND };
+        ranges[2] = { D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 2, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 0 };
+
+        parameters.resize(4);
+        memset(parameters.data(), garbage, sizeof(D3D12_ROOT_PARAMETER1) * parameters.size());
+        parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+        parameters[0].Descriptor = { 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC };
+        parameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+        parameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        parameters[1].Constants = { 1, 0, 4 };
+        parameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+        parameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        parameters[2].DescriptorTable = { 2, ranges.data() };
+        parameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+        parameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        parameters[3].DescriptorTable = { 1, ranges.data() + 2 };
+        parameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+        D3D12_STATIC_SAMPLER_DESC sampler = {};
+        sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+        sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+        sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+        sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        sampler.MaxAnisotropy = 1;
+        sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+        sampler.BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+        sampler.MaxLOD = 1000.0f;
+        sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+        samplers.push_back(sampler);
+
+        desc.NumParameters = static_cast<UINT>(parameters.size());
+        desc.pParameters = parameters.data();
+        desc.NumStaticSamplers = static_cast<UINT>(samplers.size());
+        desc.pStaticSamplers = samplers.data();
+        desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+    }
+
+    Layout(const Layout&) = delete;
+    Layout& operator=(const Layout&) = delete;
+
+    std::vector<D3D12_DESCRIPTOR_RANGE1> ranges;
+    std::vector<D3D12_ROOT_PARAMETER1> parameters;
+    std::vector<D3D12_STATIC_SAMPLER_DESC> samplers;
+    D3D12_ROOT_SIGNATURE_DESC1 desc = {};
+};
+
+// Equal layouts in different storage hash and compare equal, whatever was in the memory before.
+void TestEqualLayouts()
+{
+    const Layout a(0x00);
+    const Layout b(0xcd);
+    CHECK(a.desc.pParameters != b.desc.pParameters);
+    CHECK(HashRootSignatureDesc(a.desc) == HashRootSignatureDesc(b.desc));
+    CHECK(RootSignatureDescEquals(a.desc, b.desc));
+    CHECK(RootSignatureDescEquals(b.desc, a.desc));
+
+    // Hashing is a pure function of the description.
+    CHECK(HashRootSignatureDesc(a.desc) == HashRootSignatureDesc(a.desc));
+}
+
+void TestEmptyLayout()
+{
+    D3D12_ROOT_SIGNATURE_DESC1 a = {};
+    D3D12_ROOT_SIGNATURE_DESC1 b = {};
+    CHECK(HashRootSignatureDesc(a) == HashRootSignatureDesc(b));
+    CHECK(RootSignatureDescEquals(a, b));
+
+    b.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+    CHECK(HashRootSignatureDesc(a) != HashRootSignatureDesc(b));
+    CHECK(!RootSignatureDescEquals(a, b));
+}
+
+// Every field, behind the pointers too, takes part in the hash and the comparison.
+void TestEveryFieldMatters()
+{
+    const std::vector<std::function<void(Layout&)>> changes =
+    {
+        [](Layout& layout) { layout.desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE; },
+        [](Layout& layout) { layout.desc.NumParameters--; },
+        [](Layout& layout) { layout.desc.NumStaticSamplers = 0; },
+        [](Layout& layout) { layout.parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV; },
+        [](Layout& layout) { layout.parameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; },
+        [](Layout& layout) { layout.parameters[0].Descriptor.ShaderRegister = 1; },
+        [](Layout& layout) { layout.parameters[0].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE; },
+        [](Layout& layout) { layout.parameters[1].Constants.Num32BitValues = 8; },
+        [](Layout& layout) { layout.parameters[1].Constants.RegisterSpace = 1; },
+        [](Layout& layout) { layout.parameters[2].DescriptorTable.NumDescriptorRanges = 1; },
+        [](Layout& layout) { layout.ranges[0].NumDescriptors = 5; },
+        [](Layout& layout) { layout.ranges[1].Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE; },
+        [](Layout& layout) { layout.ranges[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV; },
+        [](Layout& layout) { layout.ranges[2].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND; },
+        [](Layout& layout) { layout.samplers[0].Filter = D3D12_FILTER_MIN_MAG_MIP_POINT; },
+        [](Layout& layout) { layout.samplers[0].MaxLOD = 0.0f; },
+        [](Layout& layout) { layout.samplers[0].ShaderRegister = 1; },
+    };
+
+    const Layout reference(0x00);
+    const uint64_t referenceHash = HashRootSignatureDesc(reference.desc);
+    std::vector<uint64_t> hashes;
+    for (const auto& change : changes)
+    {
+        Layout layout(0x00);
+        change(layout);
+        const uint64_t hash = HashRootSignatureDesc(layout.desc);
+        CHECK(hash != referenceHash);
+        CHECK(!RootSignatureDescEquals(layout.desc, reference.desc));
+        CHECK(!RootSignatureDescEquals(reference.desc, layout.desc));
+        hashes.push_back(hash);
+    }
+
+    // The changed layouts differ from each other too.
+    for (size_t index = 0; index < hashes.size(); index++)
+    {
+        for (size_t other = 0; other < index; other++)
+        {
+            CHECK(hashes[index] != hashes[other]);
+        }
+    }
+}
+
+// Moving a range between tables keeps the bytes of the range array but is a different layout.
+void TestTableBoundaries()
+{
+    Layout a(0x00);
+    Layout b(0x00);
+    b.parameters[2].DescriptorTable = { 1, b.ranges.data() };
+    b.parameters[3].DescriptorTable = { 2, b.ranges.data() + 1 };
+
+    CHECK(HashRootSignatureDesc(a.desc) != HashRootSignatureDesc(b.desc));
+    CHECK(!RootSignatureDescEquals(a.desc, b.desc));
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestEqualLayouts);
+    RUN_TEST(TestEmptyLayout);
+    RUN_TEST(TestEveryFieldMatters);
+    RUN_TEST(TestTableBoundaries);
+    return 0;
+}
@@ -0,0 +1,163 @@
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl/client.h>
+#include <dxgi1_4.h>
+#include <d3d12.h>
+
+#include <cstdio>
+#include <vector>
+
+#include "BlobCache.h"
+#include "RootSignatureHash.h"
+#include "RootSignatureRegistry.h"
+#include "TestUtil.h"
+
+using Microsoft::WRL::ComPtr;
+using namespace graphics;
+
+namespace
+{
+
+// kRootSignatureCacheKey of RootSignatureRegistry.cpp
+const uint64_t kCacheKey = 1;
+
+ComPtr<ID3D12Device> warpDevice;
+
+// The software rasterizer, so that the test runs on machines without a GPU.
+ComPtr<ID3D12Device> CreateWarpDevice()
+{
+    ComPtr<IDXGIFactory4> factory;
+    ComPtr<IDXGIAdapter> adapter;
+    ComPtr<ID3D12Device> device;
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))) ||
+        FAILED(factory->EnumWarpAdapter(IID_PPV_ARGS(&adapter))) ||
+        FAILED(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+    {
+        return nullptr;
+    }
+    return device;
+}
+
+// A root CBV and a table of `numTextures` SRVs.
+struct Layout
+{
+    explicit Layout(UINT numTextures)
+    {
+        range = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, numTextures, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 0 };
+
+        parameters[0] = {};
+        parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+        parameters[0].Descriptor = { 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE };
+        parameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+        parameters[1] = {};
+        parameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        parameters[1].DescriptorTable = { 1, &range };
+        parameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+        desc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+        desc.Desc_1_1 = { 2, parameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT };
+    }
+
+    Layout(const Layout&) = delete;
+    Layout& operator=(const Layout&) = delete;
+
+    D3D12_DESCRIPTOR_RANGE1 range;
+    D3D12_ROOT_PARAMETER1 parameters[2];
+    D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc = {};
+};
+
+std::vector<uint8_t> Serialize(const Layout& layout)
+{
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    CHECK(SUCCEEDED(D3D12SerializeVersionedRootSignature(&layout.desc, &signature, &error)));
+    const uint8_t* bytes = static_cast<const uint8_t*>(signature->GetBufferPointer());
+    return std::vector<uint8_t>(bytes, bytes + signature->GetBufferSize());
+}
+
+void TestEqualLayoutsShareRootSignature()
+{
+    RootSignatureRegistry registry(warpDevice.Get(), "");
+    const Layout a(4);
+    const Layout b(4);
+    const Layout other(8);
+
+    uint64_t hashA = 0;
+    uint64_t hashB = 0;
+    ComPtr<ID3D12RootSignature> rootSignatureA = registry.Get(a.desc, &hashA);
+    ComPtr<ID3D12RootSignature> rootSignatureB = registry.Get(b.desc, &hashB);
+    ComPtr<ID3D12RootSignature> otherRootSignature = registry.Get(other.desc);
+    CHECK(rootSignatureA && rootSignatureA == rootSignatureB);
+    CHECK(otherRootSignature && otherRootSignature != rootSignatureA);
+    CHECK(hashA == hashB && hashA == HashRootSignatureDesc(a.desc.Desc_1_1));
+
+    const RootSignatureRegistry::Statistics statistics = registry.GetStatistics();
+    CHECK(statistics.NumRequests == 3);
+    CHECK(statistics.NumShared == 1);
+    CHECK(statistics.NumSerialized == 2);
+    CHECK(statistics.NumBlobHits == 0);
+    CHECK(!registry.Save());
+}
+
+// A later run creates the root signature from the saved blob without serializing.
+void TestBlobsPersist()
+{
+    tests::TemporaryFile file("RootSignatureRegistryTests.persist");
+    const Layout layout(4);
+    {
+        RootSignatureRegistry registry(warpDevice.Get(), file.GetPath());
+        CHECK(registry.Get(layout.desc));
+        CHECK(registry.Save());
+    }
+
+    RootSignatureRegistry registry(warpDevice.Get(), file.GetPath());
+    CHECK(registry.Get(layout.desc));
+    const RootSignatureRegistry::Statistics statistics = registry.GetStatistics();
+    CHECK(statistics.NumBlobHits == 1);
+    CHECK(statistics.NumSerialized == 0);
+}
+
+// A blob describing another layout under the requested hash, as after a collision, is serialized again.
+void TestMismatchingBlobIsReplaced()
+{
+    tests::TemporaryFile file("RootSignatureRegistryTests.collision");
+    const Layout requested(4);
+    const Layout stored(8);
+    const uint64_t hash = HashRootSignatureDesc(requested.desc.Desc_1_1);
+    {
+        BlobCache cache(file.GetPath(), kCacheKey);
+        const std::vector<uint8_t> blob = Serialize(stored);
+        cache.Insert(hash, blob.data(), blob.size());
+        CHECK(cache.Save());
+    }
+
+    {
+        RootSignatureRegistry registry(warpDevice.Get(), file.GetPath());
+        CHECK(registry.Get(requested.desc));
+        const RootSignatureRegistry::Statistics statistics = registry.GetStatistics();
+        CHECK(statistics.NumBlobHits == 0);
+        CHECK(statistics.NumSerialized == 1);
+        CHECK(registry.Save());
+    }
+
+    std::vector<uint8_t> blob;
+    CHECK(BlobCache(file.GetPath(), kCacheKey).Find(hash, blob));
+    CHECK(blob == Serialize(requested));
+}
+
+}; // namespace
+
+int main()
+{
+    warpDevice = CreateWarpDevice();
+    if (!warpDevice)
+    {
+        std::printf("No D3D12 WARP device, skipped\n");
+        return 0;
+    }
+
+    RUN_TEST(TestEqualLayoutsShareRootSignature);
+    RUN_TEST(TestBlobsPersist);
+    RUN_TEST(TestMismatchingBlobIsReplaced);
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "BindingsWriter.h"
+#include "HlslParser.h"
+#include "TestUtil.h"
+
+using namespace shaderbindgen;
+
+//
+// ShaderBindgen on the HLSL files of Fixtures, whose directory is the first argument: the cbuffer packing around
+// register boundaries, the vertex input layout, and the members without a C++ equivalent.
+//
+namespace
+{
+
+std::string fixtureDirectory;
+
+std::string ReadFixture(const std::string& name)
+{
+    std::ifstream file(fixtureDirectory + "/" + name, std::ios::binary);
+    CHECK(file);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::string Generate(const std::string& source, const std::string& name)
+{
+    BindingsOptions options;
+    options.Name = name;
+    options.SourceName = name + ".hlsl";
+    return WriteBindings(ParseHlsl(source), options);
+}
+
+// The message of the error generating the bindings of `source`, empty if there is none.
+std::string GetError(const std::string& source)
+{
+    try
+    {
+        Generate(source, "Error");
+    }
+    catch (const std::runtime_error& error)
+    {
+        return error.what();
+    }
+    return "";
+}
+
+bool Contains(const std::string& text, const std::string& part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+bool HasOffset(const std::string& bindings, const std::string& constantBuffer, const std::string& member, uint32_t offset)
+{
+    return Contains(bindings, "static_assert(offsetof(" + constantBuffer + ", " + member + ") == " + std::to_string(offset) + ",");
+}
+
+void TestConstantBufferPacking()
+{
+    const std::string bindings = Generate(ReadFixture("Lighting.hlsl"), "Lighting");
+
+    // A float after a float3 shares its register, vectors which would straddle one move to the next.
+    CHECK(HasOffset(bindings, "LightConstants", "Direction", 0));
+    CHECK(HasOffset(bindings, "LightConstants", "Intensity", 12));
+    CHECK(HasOffset(bindings, "LightConstants", "Offset", 16));
+    CHECK(HasOffset(bindings, "LightConstants", "Color", 32));
+    CHECK(HasOffset(bindings, "LightConstants", "Scale", 48));
+    CHECK(HasOffset(bindings, "LightConstants", "Time", 56));
+    CHECK(HasOffset(bindings, "LightConstants", "Transform", 64));
+    CHECK(HasOffset(bindings, "LightConstants", "Tints", 128));
+    CHECK(HasOffset(bindings, "LightConstants", "Flags", 160));
+    CHECK(Contains(bindings, "static_assert(sizeof(LightConstants) == 176,"));
+
+    // The padding takes the C++ members to the same offsets.
+    CHECK(Contains(bindings, "    DirectX::XMFLOAT2 Offset;\n    uint32_t padding0[2];\n    DirectX::XMFLOAT3 Color;\n    uint32_t padding1[1];\n"));
+    CHECK(Contains(bindings, "    uint32_t Flags;\n    uint32_t padding3[3];\n};"));
+
+    CHECK(HasOffset(bindings, "ObjectConstants", "Vector", 16));
+    CHECK(Contains(bindings, "static_assert(sizeof(ObjectConstants) == 32,"));
+    CHECK(Contains(bindings, "// cbuffer ObjectConstants : register(b1, space1)"));
+}
+
+void TestInputLayout()
+{
+    const std::string bindings = Generate(ReadFixture("Lighting.hlsl"), "Lighting");
+    CHECK(Contains(bindings, "{ \"POSITION\", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },"));
+    CHECK(Contains(bindings, "{ \"NORMAL\", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },"));
+    CHECK(Contains(bindings, "{ \"TEXCOORD\", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },"));
+    CHECK(Contains(bindings, "{ \"TEXCOORD\", 1, DXGI_FORMAT_R32G32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }\n"));
+    // System values aren't vertex data.
+    CHECK(!Contains(bindings, "SV_VertexID"));
+    CHECK(Contains(bindings, "const UINT VSMainVertexStride = 40;"));
+    CHECK(Contains(bindings, "D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT"));
+}
+
+void TestUnsupportedMembers()
+{
+    CHECK(Contains(GetError(ReadFixture("UnsupportedMember.hlsl")), "Weights::Values: every element of an HLSL array starts a new register"));
+
+    const std::string prefix = "cbuffer Constants : register(b0)\n{\n";
+    CHECK(Contains(GetError(prefix + "float3x3 Rotation;\n};\n"), "Constants::Rotation: 'float3x3' has no C++ equivalent"));
+    CHECK(Contains(GetError(prefix + "bool2 Mask;\n};\n"), "Constants::Mask: 'bool2' has no C++ equivalent"));
+    CHECK(Contains(GetError("struct Light { float3 Color; };\n" + prefix + "Light Sun;\n};\n"), "Constants::Sun: struct members"));
+    CHECK(Contains(GetError(prefix + "float4 Color : packoffset(c0);\n};\n"), "packoffset() isn't supported"));
+
+    // Arrays of 4-component vectors are fine.
+    CHECK(GetError(prefix + "float4 Colors[3];\n};\n").empty());
+}
+
+}; // namespace
+
+int main(int argc, char** argv)
+{
+    fixtureDirectory = argc > 1 ? argv[1] : "Fixtures";
+    RUN_TEST(TestConstantBufferPacking);
+    RUN_TEST(TestInputLayout);
+    RUN_TEST(TestUnsupportedMembers);
+    return 0;
+}
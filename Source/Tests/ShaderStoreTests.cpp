@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Hash.h"
+#include "ShaderStore.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+const uint64_t kKey = 3;
+const uint64_t kUnlimited = ~0ull;
+
+// The file layout of ShaderStore.cpp: a header, the index sorted by last use and the bytecode.
+struct Header
+{
+    uint32_t Magic;
+    uint32_t FormatVersion;
+    uint64_t Key;
+    uint64_t Generation;
+    uint64_t NumEntries;
+};
+
+struct IndexEntry
+{
+    uint64_t Hash;
+    uint64_t Offset;
+    uint64_t Size;
+    uint64_t Checksum;
+    uint64_t LastUse;
+};
+
+std::vector<uint8_t> MakeBytecode(uint64_t hash, size_t size)
+{
+    std::vector<uint8_t> bytecode(size);
+    for (size_t index = 0; index < size; index++)
+    {
+        bytecode[index] = static_cast<uint8_t>(hash * 17 + index * 3);
+    }
+    return bytecode;
+}
+
+void Insert(ShaderStore& store, uint64_t hash, size_t size)
+{
+    const std::vector<uint8_t> bytecode = MakeBytecode(hash, size);
+    store.Insert(hash, bytecode.data(), bytecode.size());
+}
+
+bool Contains(ShaderStore& store, uint64_t hash, size_t size)
+{
+    std::vector<uint8_t> bytecode;
+    return store.Find(hash, bytecode) && bytecode == MakeBytecode(hash, size);
+}
+
+std::vector<uint8_t> ReadFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+IndexEntry ReadIndexEntry(const std::vector<uint8_t>& data, size_t index)
+{
+    IndexEntry entry;
+    memcpy(&entry, data.data() + sizeof(Header) + sizeof(IndexEntry) * index, sizeof(entry));
+    return entry;
+}
+
+void TestFormat()
+{
+    tests::TemporaryFile file("ShaderStoreTests.format");
+    {
+        ShaderStore store(file.GetPath(), kKey, kUnlimited);
+        CHECK(store.GetNumEntries() == 0);
+        CHECK(store.GetGeneration() == 2);
+        Insert(store, 10, 100);
+        Insert(store, 20, 33);
+        Insert(store, 30, 0);
+        CHECK(store.GetTotalSize() == 133);
+        CHECK(store.Save());
+    }
+    {
+        // Used in the next generation, 10 moves to the front of the index.
+        ShaderStore store(file.GetPath(), kKey, kUnlimited);
+        CHECK(store.GetGeneration() == 3);
+        CHECK(Contains(store, 10, 100));
+        CHECK(store.Save());
+    }
+
+    const std::vector<uint8_t> data = ReadFile(file.GetPath());
+    Header header;
+    CHECK(data.size() >= sizeof(header));
+    memcpy(&header, data.data(), sizeof(header));
+    CHECK(memcmp(&header.Magic, "GSST", 4) == 0);
+    CHECK(header.FormatVersion == 1);
+    CHECK(header.Key == kKey);
+    CHECK(header.Generation == 3);
+    CHECK(header.NumEntries == 3);
+
+    const uint64_t expectedHashes[] = { 10, 20, 30 };
+    const uint64_t expectedSizes[] = { 100, 33, 0 };
+    const uint64_t expectedLastUses[] = { 3, 2, 2 };
+    uint64_t offset = sizeof(Header) + sizeof(IndexEntry) * 3;
+    for (size_t index = 0; index < 3; index++)
+    {
+        const IndexEntry entry = ReadIndexEntry(data, index);
+        CHECK(entry.Hash == expectedHashes[index]);
+        CHECK(entry.Size == expectedSizes[index]);
+        CHECK(entry.LastUse == expectedLastUses[index]);
+        // Bytecode is packed behind the index in index order.
+        CHECK(entry.Offset == offset);
+        const std::vector<uint8_t> bytecode(data.begin() + static_cast<ptrdiff_t>(entry.Offset),
+            data.begin() + static_cast<ptrdiff_t>(entry.Offset + entry.Size));
+        CHECK(bytecode == MakeBytecode(entry.Hash, static_cast<size_t>(entry.Size)));
+        CHECK(entry.Checksum == HashBytes(bytecode.data(), bytecode.size()));
+        offset += entry.Size;
+    }
+    CHECK(offset == data.size());
+}
+
+void TestStaleAndCorruptedStores()
+{
+    tests::TemporaryFile file("ShaderStoreTests.corrupted");
+    {
+        ShaderStore store(file.GetPath(), kKey, kUnlimited);
+        Insert(store, 1, 64);
+        Insert(store, 2, 64);
+        CHECK(store.Save());
+    }
+    CHECK(ShaderStore(file.GetPath(), kKey + 1, kUnlimited).GetNumEntries() == 0);
+
+    // Flipped bytecode fails its checksum on lookup and the entry goes away.
+    const std::vector<uint8_t> original = ReadFile(file.GetPath());
+    std::vector<uint8_t> corrupted = original;
+    const IndexEntry first = ReadIndexEntry(original, 0);
+    corrupted[static_cast<size_t>(first.Offset)] ^= 0x01;
+    WriteFile(file.GetPath(), corrupted);
+    {
+        ShaderStore store(file.GetPath(), kKey, kUnlimited);
+        CHECK(store.GetNumEntries() == 2);
+        std::vector<uint8_t> bytecode;
+        CHECK(!store.Find(first.Hash, bytecode));
+        CHECK(store.GetNumEntries() == 1);
+        CHECK(Contains(store, 3 - first.Hash, 64));
+        CHECK(store.GetStatistics().NumMisses == 1);
+        CHECK(store.GetStatistics().NumHits == 1);
+    }
+
+    // An index entry pointing past the end is skipped, the others still load.
+    corrupted = original;
+    IndexEntry broken = first;
+    broken.Offset = original.size();
+    memcpy(corrupted.data() + sizeof(Header), &broken, sizeof(broken));
+    WriteFile(file.GetPath(), corrupted);
+    CHECK(ShaderStore(file.GetPath(), kKey, kUnlimited).GetNumEntries() == 1);
+
+    // More entries than the file can hold, or a truncated header, read as an empty store.
+    corrupted = original;
+    Header header;
+    memcpy(&header, corrupted.data(), sizeof(header));
+    header.NumEntries = 1000;
+    memcpy(corrupted.data(), &header, sizeof(header));
+    WriteFile(file.GetPath(), corrupted);
+    CHECK(ShaderStore(file.GetPath(), kKey, kUnlimited).GetNumEntries() == 0);
+
+    WriteFile(file.GetPath(), std::vector<uint8_t>(original.begin(), original.begin() + 8));
+    CHECK(ShaderStore(file.GetPath(), kKey, kUnlimited).GetNumEntries() == 0);
+}
+
+void TestEviction()
+{
+    tests::TemporaryFile file("ShaderStoreTests.eviction");
+    {
+        ShaderStore store(file.GetPath(), kKey, 1000);
+        for (uint64_t hash = 0; hash < 8; hash++)
+        {
+            Insert(store, hash, 100);
+        }
+        CHECK(store.Save());
+        CHECK(store.GetNumEntries() == 8);
+    }
+    {
+        // Inserting another 400 bytes goes over the budget; the least recently used entries are dropped and
+        // equal generations drop the larger hashes first.
+        ShaderStore store(file.GetPath(), kKey, 1000);
+        CHECK(Contains(store, 6, 100));
+        CHECK(Contains(store, 7, 100));
+        for (uint64_t hash = 100; hash < 104; hash++)
+        {
+            Insert(store, hash, 100);
+        }
+        CHECK(store.GetTotalSize() == 1200);
+        CHECK(store.Save());
+        CHECK(store.GetStatistics().NumEvicted == 2);
+        CHECK(store.GetNumEntries() == 10);
+        CHECK(store.GetTotalSize() == 1000);
+    }
+
+    {
+        ShaderStore store(file.GetPath(), kKey, 1000);
+        for (uint64_t hash : { 0, 1, 2, 3, 6, 7, 100, 101, 102, 103 })
+        {
+            CHECK(Contains(store, hash, 100));
+        }
+        std::vector<uint8_t> bytecode;
+        CHECK(!store.Find(4, bytecode));
+        CHECK(!store.Find(5, bytecode));
+    }
+
+    // The most recent entry is larger than the whole budget, it is dropped alone.
+    ShaderStore store(file.GetPath(), kKey, 1000);
+    Insert(store, 200, 2000);
+    CHECK(store.Save());
+    CHECK(store.GetStatistics().NumEvicted == 1);
+    CHECK(store.GetNumEntries() == 10);
+    std::vector<uint8_t> bytecode;
+    CHECK(!store.Find(200, bytecode));
+}
+
+// Random sessions against a model of the last uses and the eviction order.
+void TestRandomSessions()
+{
+    const uint64_t kMaxSize = 4096;
+    tests::TemporaryFile file("ShaderStoreTests.random");
+    std::mt19937 random(11);
+
+    struct ModelEntry
+    {
+        size_t Size;
+        uint64_t LastUse;
+    };
+    std::map<uint64_t, ModelEntry> model;
+
+    for (int session = 0; session < 30; session++)
+    {
+        ShaderStore store(file.GetPath(), kKey, kMaxSize);
+        const uint64_t generation = store.GetGeneration();
+        CHECK(store.GetNumEntries() == model.size());
+
+        for (int operation = 0; operation < 20; operation++)
+        {
+            const uint64_t hash = random() % 64;
+            auto it = model.find(hash);
+            if (random() % 2 == 0)
+            {
+                CHECK((it != model.end()) == Contains(store, hash, it != model.end() ? it->second.Size : 0));
+                if (it != model.end())
+                {
+                    it->second.LastUse = generation;
+                }
+            }
+            else
+            {
+                const size_t size = static_cast<size_t>(random() % 512);
+                Insert(store, hash, size);
+                model[hash] = { size, generation };
+            }
+        }
+        CHECK(store.Save());
+
+        // Keep the most recent uses, smaller hashes first among equal generations, until the budget is full.
+        std::vector<std::pair<uint64_t, ModelEntry>> order(model.begin(), model.end());
+        std::stable_sort(order.begin(), order.end(), [](const std::pair<uint64_t, ModelEntry>& a, const std::pair<uint64_t, ModelEntry>& b)
+            {
+                return a.second.LastUse > b.second.LastUse;
+            });
+        uint64_t keptSize = 0;
+        size_t numKept = 0;
+        while (numKept < order.size() && keptSize + order[numKept].second.Size <= kMaxSize)
+        {
+            keptSize += order[numKept++].second.Size;
+        }
+        for (size_t index = numKept; index < order.size(); index++)
+        {
+            model.erase(order[index].first);
+        }
+        CHECK(store.GetNumEntries() == model.size());
+        CHECK(store.GetTotalSize() == keptSize);
+    }
+}
+
+// The store is replaced through a temporary file; a write that fails keeps the old file and every entry.
+void TestFailedWriteKeepsEntries()
+{
+    tests::TemporaryFile file("ShaderStoreTests.atomic");
+    {
+        ShaderStore store(file.GetPath(), kKey, kUnlimited);
+        Insert(store, 1, 256);
+        CHECK(store.Save());
+        CHECK(!std::filesystem::exists(file.GetPath() + ".tmp"));
+    }
+    const std::vector<uint8_t> original = ReadFile(file.GetPath());
+
+    // A directory in place of the temporary file makes the write fail.
+    std::filesystem::create_directory(file.GetPath() + ".tmp");
+    {
+        ShaderStore store(file.GetPath(), kKey, kUnlimited);
+        Insert(store, 2, 128);
+        CHECK(!store.Save());
+        CHECK(ReadFile(file.GetPath()) == original);
+
+        // The mapped entry and the new one are still there, and the next Save() writes both.
+        CHECK(store.GetNumEntries() == 2);
+        CHECK(store.GetTotalSize() == 384);
+        CHECK(Contains(store, 1, 256));
+        CHECK(Contains(store, 2, 128));
+
+        std::filesystem::remove(file.GetPath() + ".tmp");
+        CHECK(store.Save());
+        CHECK(Contains(store, 1, 256));
+        CHECK(Contains(store, 2, 128));
+    }
+
+    ShaderStore store(file.GetPath(), kKey, kUnlimited);
+    CHECK(store.GetNumEntries() == 2);
+    CHECK(Contains(store, 1, 256));
+    CHECK(Contains(store, 2, 128));
+}
+
+void TestMemoryOnly()
+{
+    ShaderStore store("", kKey, kUnlimited);
+    Insert(store, 1, 16);
+    CHECK(Contains(store, 1, 16));
+    CHECK(!store.Save());
+    CHECK(store.GetNumEntries() == 1);
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestFormat);
+    RUN_TEST(TestStaleAndCorruptedStores);
+    RUN_TEST(TestEviction);
+    RUN_TEST(TestRandomSessions);
+    RUN_TEST(TestFailedWriteKeepsEntries);
+    RUN_TEST(TestMemoryOnly);
+    return 0;
+}
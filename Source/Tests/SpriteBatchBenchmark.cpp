@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "SpriteBatch.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+//
+// SpriteBatch::Pack() of a frame of 100k sprites, added in material order and with the materials interleaved.
+// Each scenario runs once checking the packed streams and ranges against a stable sort of the instances,
+// then once timed without it.
+//
+namespace
+{
+
+const size_t kNumSprites = 100000;
+
+struct Sprite
+{
+    uint32_t Material;
+    SpriteBatch::Float2 Center;
+    SpriteBatch::Float2 Extent;
+    uint32_t Color;
+};
+
+// Upload memory stand-in, aligned to kStreamAlignment.
+struct alignas(SpriteBatch::kStreamAlignment) Block
+{
+    uint8_t Bytes[SpriteBatch::kStreamAlignment];
+};
+
+std::vector<Sprite> CreateSprites(uint32_t numMaterials, bool sorted, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> positions(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> sizes(0.001f, 0.01f);
+    std::vector<Sprite> sprites(kNumSprites);
+    for (Sprite& sprite : sprites)
+    {
+        sprite.Material = random() % numMaterials;
+        sprite.Center = { positions(random), positions(random) };
+        sprite.Extent = { sizes(random), sizes(random) };
+        sprite.Color = random();
+    }
+    if (sorted)
+    {
+        std::stable_sort(sprites.begin(), sprites.end(),
+            [](const Sprite& a, const Sprite& b) { return a.Material < b.Material; });
+    }
+    return sprites;
+}
+
+// The streams and ranges Pack() must produce: the instances stably sorted by material.
+void Validate(const SpriteBatch& batch, const std::vector<Sprite>& sprites, const uint8_t* packed)
+{
+    std::vector<Sprite> expected = sprites;
+    std::stable_sort(expected.begin(), expected.end(),
+        [](const Sprite& a, const Sprite& b) { return a.Material < b.Material; });
+
+    const auto* centers = reinterpret_cast<const SpriteBatch::Float2*>(packed + batch.GetStreamOffset(SpriteBatch::kStreamCenter));
+    const auto* extents = reinterpret_cast<const SpriteBatch::Float2*>(packed + batch.GetStreamOffset(SpriteBatch::kStreamExtent));
+    const auto* colors = reinterpret_cast<const uint32_t*>(packed + batch.GetStreamOffset(SpriteBatch::kStreamColor));
+    for (size_t index = 0; index < expected.size(); index++)
+    {
+        CHECK(memcmp(&centers[index], &expected[index].Center, sizeof(SpriteBatch::Float2)) == 0);
+        CHECK(memcmp(&extents[index], &expected[index].Extent, sizeof(SpriteBatch::Float2)) == 0);
+        CHECK(colors[index] == expected[index].Color);
+    }
+
+    // The ranges cover the instances in ascending material order without gaps or empty ranges.
+    uint32_t first = 0;
+    uint32_t previousMaterial = 0;
+    for (const SpriteBatch::MaterialRange& range : batch.GetMaterialRanges())
+    {
+        CHECK(range.FirstInstance == first && range.NumInstances > 0);
+        CHECK(first == 0 || range.Material > previousMaterial);
+        for (uint32_t index = range.FirstInstance; index < range.FirstInstance + range.NumInstances; index++)
+        {
+            CHECK(expected[index].Material == range.Material);
+        }
+        first += range.NumInstances;
+        previousMaterial = range.Material;
+    }
+    CHECK(first == expected.size());
+}
+
+// Every frame refills the batch and packs it, as DemoBlob does.
+void BenchmarkPack(const char* name, uint32_t numMaterials, bool sorted, int frames, bool validate)
+{
+    const std::vector<Sprite> sprites = CreateSprites(numMaterials, sorted, numMaterials);
+    SpriteBatch batch;
+    batch.Reserve(kNumSprites);
+    std::vector<Block> destination;
+
+    double fillMilliseconds = 0.0;
+    double packMilliseconds = 0.0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        fillMilliseconds += tests::MeasureMilliseconds([&]()
+            {
+                batch.Clear();
+                for (const Sprite& sprite : sprites)
+                {
+                    batch.Add(sprite.Material, sprite.Center.X, sprite.Center.Y, sprite.Extent.X, sprite.Extent.Y, sprite.Color);
+                }
+            });
+
+        const uint64_t packedSize = batch.GetPackedSize();
+        CHECK(packedSize % SpriteBatch::kStreamAlignment == 0);
+        destination.resize(static_cast<size_t>(packedSize / SpriteBatch::kStreamAlignment));
+        packMilliseconds += tests::MeasureMilliseconds([&]() { batch.Pack(destination.data()); });
+
+        if (validate)
+        {
+            Validate(batch, sprites, destination.data()->Bytes);
+        }
+    }
+
+    CHECK(batch.GetMaterialRanges().size() <= numMaterials);
+    if (!validate)
+    {
+        std::printf("%s: %zu sprites, %zu materials, %.3f ms fill, %.3f ms pack per frame\n",
+            name, kNumSprites, batch.GetMaterialRanges().size(), fillMilliseconds / frames, packMilliseconds / frames);
+    }
+}
+
+}; // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames = tests::GetIterations(argc, argv, 200);
+    BenchmarkPack("Material order", 16, true, 1, true);
+    BenchmarkPack("Interleaved materials", 16, false, 1, true);
+    BenchmarkPack("Interleaved, many materials", 1000, false, 1, true);
+
+    BenchmarkPack("Material order", 16, true, frames, false);
+    BenchmarkPack("Interleaved materials", 16, false, frames, false);
+    return 0;
+}
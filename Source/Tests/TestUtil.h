@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+//
+// Minimal helpers for the tests and benchmarks run by ctest.
+// CHECK() stays active in release builds, a failure prints the condition and exits with a non-zero code.
+//
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (false)
+
+#define RUN_TEST(test) \
+    do \
+    { \
+        std::printf("%s\n", #test); \
+        std::fflush(stdout); \
+        test(); \
+    } while (false)
+
+namespace tests
+{
+
+// Milliseconds of wall time `function` takes.
+template <typename Function>
+double MeasureMilliseconds(Function&& function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Iterations of a benchmark: the first argument if given, which ctest sets low to keep the run short.
+inline int GetIterations(int argc, char** argv, int defaultIterations)
+{
+    return argc > 1 ? std::atoi(argv[1]) : defaultIterations;
+}
+
+// A file in the working directory of the test, removed with its temporary sibling of WriteFileAtomic() on both ends.
+class TemporaryFile
+{
+public:
+    explicit TemporaryFile(const std::string& path) : path_(path) { Remove(); }
+    ~TemporaryFile() { Remove(); }
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+    const std::string& GetPath() const { return path_; }
+
+private:
+    void Remove()
+    {
+        std::remove(path_.c_str());
+        std::remove((path_ + ".tmp").c_str());
+    }
+
+    std::string path_;
+};
+
+}; // namespace tests
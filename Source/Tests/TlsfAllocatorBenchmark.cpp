@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "TlsfAllocator.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+//
+// TlsfAllocator as GeometryArena uses it: meshes of a few hundred bytes to a few hundred kilobytes, vertex
+// ranges aligned to their stride and index ranges to 4 bytes, freed and replaced in random order.
+// Each scenario runs once checking every range against the live ranges for overlap, then once timed without it.
+//
+namespace
+{
+
+using Allocation = TlsfAllocator::Allocation;
+
+// Live ranges by offset, empty when not validating.
+class Shadow
+{
+public:
+    explicit Shadow(bool validate) : validate_(validate) {}
+
+    void Add(const Allocation& allocation, uint64_t alignment, uint64_t size)
+    {
+        if (!validate_)
+        {
+            return;
+        }
+        CHECK(allocation.Offset % alignment == 0);
+        CHECK(allocation.Offset + allocation.Size <= size);
+        const auto next = live_.lower_bound(allocation.Offset);
+        CHECK(next == live_.end() || next->first >= allocation.Offset + allocation.Size);
+        CHECK(next == live_.begin() || std::prev(next)->first + std::prev(next)->second <= allocation.Offset);
+        live_.emplace(allocation.Offset, allocation.Size);
+    }
+
+    void Remove(const Allocation& allocation)
+    {
+        if (validate_)
+        {
+            CHECK(live_.erase(allocation.Offset) == 1);
+        }
+    }
+
+private:
+    bool validate_;
+    std::map<uint64_t, uint64_t> live_;
+};
+
+// Every operation frees a random live range and allocates a new one, `numLive` ranges stay allocated
+// and fill about `occupancy` of the buffer.
+void BenchmarkChurn(const char* name, int iterations, size_t numLive, double occupancy, bool validate)
+{
+    const uint64_t kStrides[] = { 4, 12, 16, 20, 24, 32, 48 };
+    const uint64_t kAverageSize = 32 * 1024;
+    const uint64_t size = static_cast<uint64_t>(numLive * kAverageSize / occupancy);
+    TlsfAllocator allocator(size);
+    Shadow shadow(validate);
+    std::mt19937 random(static_cast<uint32_t>(occupancy * 100));
+    std::uniform_int_distribution<uint64_t> bytes(256, 2 * kAverageSize - 256);
+
+    std::vector<Allocation> live;
+    live.reserve(numLive);
+    uint64_t numFailures = 0;
+    size_t maxFreeRanges = 0;
+    auto allocate = [&]()
+        {
+            const uint64_t stride = kStrides[random() % (sizeof(kStrides) / sizeof(kStrides[0]))];
+            const uint64_t rangeSize = bytes(random) / stride * stride;
+            const Allocation allocation = allocator.Allocate(rangeSize, stride);
+            if (!allocation.IsValid())
+            {
+                numFailures++;
+                return;
+            }
+            shadow.Add(allocation, stride, size);
+            live.push_back(allocation);
+        };
+
+    while (live.size() < numLive && numFailures == 0)
+    {
+        allocate();
+    }
+    CHECK(numFailures == 0);
+
+    const double milliseconds = tests::MeasureMilliseconds([&]()
+        {
+            for (int i = 0; i < iterations; i++)
+            {
+                if (!live.empty())
+                {
+                    const size_t index = random() % live.size();
+                    shadow.Remove(live[index]);
+                    allocator.Free(live[index]);
+                    live[index] = live.back();
+                    live.pop_back();
+                }
+                // Refill to the target, a failure leaves one range less until the next operation.
+                while (live.size() < numLive)
+                {
+                    const size_t before = live.size();
+                    allocate();
+                    if (live.size() == before)
+                    {
+                        break;
+                    }
+                }
+                if (allocator.GetNumFreeRanges() > maxFreeRanges)
+                {
+                    maxFreeRanges = allocator.GetNumFreeRanges();
+                }
+            }
+        });
+
+    for (const Allocation& allocation : live)
+    {
+        allocator.Free(allocation);
+    }
+    CHECK(allocator.GetFreeSize() == size);
+    CHECK(allocator.GetNumFreeRanges() == 1);
+
+    if (!validate)
+    {
+        std::printf("%s: %d free and allocate pairs over %zu live ranges, %.1f ns per pair, %llu failures, at most %zu free ranges\n",
+            name, iterations, numLive, milliseconds * 1e6 / iterations, static_cast<unsigned long long>(numFailures), maxFreeRanges);
+    }
+}
+
+}; // namespace
+
+int main(int argc, char** argv)
+{
+    const int iterations = tests::GetIterations(argc, argv, 2000000);
+    const int validatedIterations = iterations < 200000 ? iterations : 200000;
+    BenchmarkChurn("Half full", validatedIterations, 4096, 0.5, true);
+    BenchmarkChurn("Nearly full", validatedIterations, 4096, 0.9, true);
+
+    BenchmarkChurn("Half full", iterations, 4096, 0.5, false);
+    BenchmarkChurn("Nearly full", iterations, 4096, 0.9, false);
+    return 0;
+}
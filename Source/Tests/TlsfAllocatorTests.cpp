@@ -0,0 +1,267 @@
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "TlsfAllocator.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+using Allocation = TlsfAllocator::Allocation;
+
+//
+// The live allocations by offset, to check the allocator against: no overlap, the accounting, and that
+// free ranges are coalesced, i.e. the allocator has exactly one free range per gap between allocations.
+//
+class Shadow
+{
+public:
+    explicit Shadow(uint64_t size) : size_(size) {}
+
+    void Add(const Allocation& allocation)
+    {
+        CHECK(allocation.Offset + allocation.Size <= size_);
+        const auto next = live_.lower_bound(allocation.Offset);
+        CHECK(next == live_.end() || next->first >= allocation.Offset + allocation.Size);
+        if (next != live_.begin())
+        {
+            const auto previous = std::prev(next);
+            CHECK(previous->first + previous->second.Size <= allocation.Offset);
+        }
+        live_.emplace(allocation.Offset, allocation);
+        usedSize_ += allocation.Size;
+    }
+
+    void Remove(const Allocation& allocation)
+    {
+        CHECK(live_.erase(allocation.Offset) == 1);
+        usedSize_ -= allocation.Size;
+    }
+
+    void Clear()
+    {
+        live_.clear();
+        usedSize_ = 0;
+    }
+
+    // Whether a gap between allocations holds `size` bytes at `alignment`.
+    bool Fits(uint64_t size, uint64_t alignment) const
+    {
+        uint64_t end = 0;
+        auto fits = [&](uint64_t offset)
+            {
+                const uint64_t aligned = (end + alignment - 1) / alignment * alignment;
+                return aligned + size <= offset;
+            };
+        for (const auto& entry : live_)
+        {
+            if (fits(entry.first))
+            {
+                return true;
+            }
+            end = entry.first + entry.second.Size;
+        }
+        return fits(size_);
+    }
+
+    // Size of the largest gap between allocations.
+    uint64_t Check(const TlsfAllocator& allocator) const
+    {
+        CHECK(allocator.GetFreeSize() == size_ - usedSize_);
+        CHECK(allocator.GetNumAllocations() == live_.size());
+
+        uint32_t numGaps = 0;
+        uint64_t largestGap = 0;
+        uint64_t end = 0;
+        auto addGap = [&](uint64_t offset)
+            {
+                if (offset > end)
+                {
+                    numGaps++;
+                    largestGap = offset - end > largestGap ? offset - end : largestGap;
+                }
+            };
+        for (const auto& entry : live_)
+        {
+            addGap(entry.first);
+            end = entry.first + entry.second.Size;
+        }
+        addGap(size_);
+
+        CHECK(allocator.GetNumFreeRanges() == numGaps);
+        CHECK(allocator.GetLargestFreeSize() == largestGap);
+        return largestGap;
+    }
+
+private:
+    uint64_t size_;
+    uint64_t usedSize_ = 0;
+    std::map<uint64_t, Allocation> live_;
+};
+
+void TestCoalescing()
+{
+    TlsfAllocator allocator(1024);
+    Shadow shadow(1024);
+    const Allocation a = allocator.Allocate(100);
+    const Allocation b = allocator.Allocate(200);
+    const Allocation c = allocator.Allocate(300);
+    CHECK(a.IsValid() && b.IsValid() && c.IsValid());
+    shadow.Add(a);
+    shadow.Add(b);
+    shadow.Add(c);
+    shadow.Check(allocator);
+
+    // Freeing the middle leaves a hole, its neighbours then merge with it from both sides.
+    allocator.Free(b);
+    shadow.Remove(b);
+    CHECK(shadow.Check(allocator) == 1024 - 600);
+    allocator.Free(a);
+    shadow.Remove(a);
+    CHECK(shadow.Check(allocator) == 1024 - 600);
+    CHECK(allocator.GetNumFreeRanges() == 2);
+    allocator.Free(c);
+    CHECK(allocator.GetNumFreeRanges() == 1);
+    CHECK(allocator.GetLargestFreeSize() == 1024);
+    CHECK(allocator.GetNumAllocations() == 0);
+}
+
+// Vertex strides are not powers of two; the padding in front of an aligned range stays allocatable.
+void TestAlignment()
+{
+    TlsfAllocator allocator(4096);
+    const Allocation first = allocator.Allocate(5);
+    const Allocation strided = allocator.Allocate(120, 12);
+    CHECK(strided.IsValid() && strided.Offset == 12);
+    CHECK(allocator.GetNumFreeRanges() == 2);
+
+    const Allocation padding = allocator.Allocate(7);
+    CHECK(padding.IsValid() && padding.Offset == 5);
+    CHECK(allocator.GetNumFreeRanges() == 1);
+
+    const Allocation page = allocator.Allocate(256, 256);
+    CHECK(page.IsValid() && page.Offset % 256 == 0);
+
+    // Equal sizes and alignments fill a range completely, although the last one has no room for worst case padding.
+    TlsfAllocator heap(1024);
+    for (uint64_t offset = 0; offset < 1024; offset += 256)
+    {
+        const Allocation allocation = heap.Allocate(256, 256);
+        CHECK(allocation.IsValid() && allocation.Offset == offset);
+    }
+    CHECK(heap.GetFreeSize() == 0);
+
+    allocator.Free(first);
+    allocator.Free(padding);
+    allocator.Free(strided);
+    allocator.Free(page);
+    CHECK(allocator.GetNumFreeRanges() == 1);
+    CHECK(allocator.GetFreeSize() == 4096);
+}
+
+void TestLimits()
+{
+    TlsfAllocator allocator(1000);
+    CHECK(!allocator.Allocate(0).IsValid());
+    CHECK(!allocator.Allocate(1001).IsValid());
+    const Allocation whole = allocator.Allocate(1000, 3);
+    CHECK(whole.IsValid() && whole.Offset == 0);
+    CHECK(!allocator.Allocate(1).IsValid());
+    CHECK(allocator.GetLargestFreeSize() == 0);
+    allocator.Free(Allocation());
+    allocator.Free(whole);
+
+    // The free size suffices, but not at an aligned offset.
+    const Allocation first = allocator.Allocate(1);
+    CHECK(!allocator.Allocate(999, 3).IsValid());
+    CHECK(!allocator.Allocate(2, 1000).IsValid());
+    CHECK(allocator.Allocate(997, 3).Offset == 3);
+    CHECK(allocator.GetNumFreeRanges() == 1);
+    allocator.Free(first);
+
+    allocator.Reset();
+    CHECK(allocator.GetFreeSize() == 1000 && allocator.GetNumAllocations() == 0);
+    CHECK(allocator.Allocate(1000).IsValid());
+
+    TlsfAllocator empty(0);
+    CHECK(!empty.Allocate(1).IsValid());
+    CHECK(empty.GetNumFreeRanges() == 0);
+}
+
+// Random allocations and frees against the shadow. A failed allocation is only allowed when no gap holds
+// the request at its alignment.
+void TestFuzz()
+{
+    const int kNumSeeds = 100;
+    const int kNumOperations = 10000;
+    const uint64_t kSize = 1 << 20;
+    const uint64_t kAlignments[] = { 1, 1, 1, 4, 12, 16, 24, 256, 4096 };
+
+    for (int seed = 1; seed <= kNumSeeds; seed++)
+    {
+        std::mt19937 random(seed);
+        TlsfAllocator allocator(kSize);
+        Shadow shadow(kSize);
+        std::vector<Allocation> live;
+
+        for (int operation = 0; operation < kNumOperations; operation++)
+        {
+            if (random() % 2000 == 0)
+            {
+                allocator.Reset();
+                shadow.Clear();
+                live.clear();
+            }
+            else if (live.empty() || random() % 100 < 55)
+            {
+                // Sizes spread over every first level up to a sixteenth of the range.
+                const uint64_t size = (random() % (1ull << (random() % 17))) + 1;
+                const uint64_t alignment = kAlignments[random() % (sizeof(kAlignments) / sizeof(kAlignments[0]))];
+                const Allocation allocation = allocator.Allocate(size, alignment);
+                if (!allocation.IsValid())
+                {
+                    CHECK(!shadow.Fits(size, alignment));
+                    continue;
+                }
+                CHECK(allocation.Size == size);
+                CHECK(allocation.Offset % alignment == 0);
+                shadow.Add(allocation);
+                live.push_back(allocation);
+            }
+            else
+            {
+                const size_t index = random() % live.size();
+                allocator.Free(live[index]);
+                shadow.Remove(live[index]);
+                live[index] = live.back();
+                live.pop_back();
+            }
+            if (operation % 16 == 0)
+            {
+                shadow.Check(allocator);
+            }
+        }
+
+        for (const Allocation& allocation : live)
+        {
+            allocator.Free(allocation);
+        }
+        CHECK(allocator.GetFreeSize() == kSize);
+        CHECK(allocator.GetNumFreeRanges() == 1);
+    }
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestCoalescing);
+    RUN_TEST(TestAlignment);
+    RUN_TEST(TestLimits);
+    RUN_TEST(TestFuzz);
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "UploadScheduler.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+namespace
+{
+
+using Ticket = UploadScheduler::Ticket;
+
+void TestScenario()
+{
+    SimulatedUploadQueueBackend backend;
+    UploadScheduler scheduler(backend, 100);
+
+    // Batches close once full, not on every Commit().
+    backend.RecordCopy(40);
+    const Ticket first = scheduler.Commit();
+    CHECK(first == 1);
+    CHECK(backend.GetSubmittedValue() == 0);
+    backend.RecordCopy(70);
+    const Ticket second = scheduler.Commit();
+    CHECK(second == 1);
+    CHECK(backend.GetSubmittedValue() == 1);
+    CHECK(backend.GetRecordedSize() == 0);
+
+    // No new data, no wait.
+    scheduler.PrepareConsumerSubmission();
+    CHECK(backend.GetConsumerWaits().empty());
+
+    scheduler.Require(first);
+    scheduler.PrepareConsumerSubmission();
+    CHECK((backend.GetConsumerWaits() == std::vector<uint64_t>{ 1 }));
+
+    // The earlier wait still holds.
+    scheduler.Require(second);
+    scheduler.PrepareConsumerSubmission();
+    CHECK(backend.GetConsumerWaits().size() == 1);
+
+    // A consumer needing the batch being recorded submits it.
+    backend.RecordCopy(10);
+    const Ticket third = scheduler.Commit();
+    CHECK(third == 2);
+    scheduler.Require(first);
+    scheduler.Require(third);
+    scheduler.PrepareConsumerSubmission();
+    CHECK(backend.GetSubmittedValue() == 2);
+    CHECK((backend.GetConsumerWaits() == std::vector<uint64_t>{ 1, 2 }));
+    CHECK(!scheduler.IsCompleted(third));
+    backend.Complete(2);
+    CHECK(scheduler.IsCompleted(third));
+
+    // The backend submitted the copies before Commit(), when it ran out of staging memory: the ticket names an
+    // empty batch, and the wait goes to the submission holding the copies.
+    backend.RecordCopy(10);
+    CHECK(backend.SubmitCopies() == 3);
+    const Ticket fourth = scheduler.Commit();
+    CHECK(fourth == 4);
+    scheduler.Require(fourth);
+    scheduler.PrepareConsumerSubmission();
+    CHECK(backend.GetSubmittedValue() == 3);
+    CHECK((backend.GetConsumerWaits() == std::vector<uint64_t>{ 1, 2, 3 }));
+
+    // Completed copies need no wait.
+    backend.Complete(3);
+    scheduler.Require(3);
+    scheduler.PrepareConsumerSubmission();
+    CHECK(backend.GetConsumerWaits().size() == 3);
+
+    CHECK(scheduler.Flush() == 0);
+    backend.RecordCopy(5);
+    CHECK(scheduler.Commit() == 4);
+    CHECK(scheduler.Flush() == 4);
+
+    // Submissions by the backend itself aren't counted.
+    const UploadScheduler::Statistics statistics = scheduler.GetStatistics();
+    CHECK(statistics.NumSubmissions == 3);
+    CHECK(statistics.NumConsumerWaits == 3);
+}
+
+// Random copies, commits, submissions by the backend, copy queue progress and consumer submissions.
+void TestRandomSteps()
+{
+    const int kNumSeeds = 500;
+    const int kNumSteps = 20000;
+
+    for (int seed = 1; seed <= kNumSeeds; seed++)
+    {
+        std::mt19937 random(seed);
+        SimulatedUploadQueueBackend backend;
+        const uint64_t maxBatchSize = 1 + random() % 1000;
+        UploadScheduler scheduler(backend, maxBatchSize);
+
+        // Newest batch holding a copy of the open commit, and of each committed ticket.
+        uint64_t openBatch = 0;
+        std::vector<std::pair<Ticket, uint64_t>> committed;
+        // Tickets and batches the next consumer submission reads.
+        std::vector<std::pair<Ticket, uint64_t>> required;
+        bool requiresData = false;
+        uint64_t lastWait = 0;
+
+        for (int step = 0; step < kNumSteps; step++)
+        {
+            const uint32_t action = random() % 100;
+            if (action < 35)
+            {
+                backend.RecordCopy(1 + random() % 300);
+                openBatch = backend.GetRecordingFenceValue();
+            }
+            else if (action < 55)
+            {
+                const Ticket ticket = scheduler.Commit();
+                CHECK(ticket == backend.GetRecordingFenceValue() || ticket == backend.GetSubmittedValue());
+                CHECK(backend.GetRecordedSize() < maxBatchSize);
+                if (openBatch != 0)
+                {
+                    CHECK(openBatch <= ticket);
+                    committed.emplace_back(ticket, openBatch);
+                    openBatch = 0;
+                }
+            }
+            else if (action < 60)
+            {
+                backend.SubmitCopies();
+            }
+            else if (action < 72)
+            {
+                const uint64_t submitted = backend.GetSubmittedValue();
+                const uint64_t completed = backend.GetCompletedValue();
+                backend.Complete(completed + random() % (submitted - completed + 1));
+            }
+            else if (action < 85)
+            {
+                if (!committed.empty())
+                {
+                    const std::pair<Ticket, uint64_t>& entry = committed[committed.size() - 1 - random() % std::min<size_t>(committed.size(), 8)];
+                    scheduler.Require(entry.first);
+                    required.push_back(entry);
+                    requiresData = true;
+                }
+            }
+            else if (action < 95)
+            {
+                const uint64_t completed = backend.GetCompletedValue();
+                const size_t numWaits = backend.GetConsumerWaits().size();
+                bool covered = true;
+                for (const std::pair<Ticket, uint64_t>& entry : required)
+                {
+                    covered = covered && (entry.first <= completed || entry.first <= lastWait);
+                }
+                scheduler.PrepareConsumerSubmission();
+
+                // Submissions with no ticket past the completed and waited values never wait, and waits only move forward.
+                if (!requiresData || covered)
+                {
+                    CHECK(backend.GetConsumerWaits().size() == numWaits);
+                }
+                CHECK(backend.GetConsumerWaits().size() <= numWaits + 1);
+                if (backend.GetConsumerWaits().size() > numWaits)
+                {
+                    const uint64_t wait = backend.GetConsumerWaits().back();
+                    CHECK(wait > lastWait && wait > completed);
+                    CHECK(wait <= backend.GetSubmittedValue());
+                    lastWait = wait;
+                }
+
+                // Every batch read has been submitted, and is complete or covered by a wait.
+                for (const std::pair<Ticket, uint64_t>& entry : required)
+                {
+                    CHECK(entry.second <= backend.GetSubmittedValue());
+                    CHECK(entry.second <= completed || entry.second <= lastWait);
+                }
+                required.clear();
+                requiresData = false;
+            }
+            else
+            {
+                scheduler.Flush();
+                CHECK(backend.GetRecordedSize() == 0);
+            }
+        }
+
+        CHECK(scheduler.GetStatistics().NumConsumerWaits == backend.GetConsumerWaits().size());
+    }
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestScenario);
+    RUN_TEST(TestRandomSteps);
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "TestUtil.h"
+#include "VectorField.h"
+
+//
+// The CPU reference of DemoBlob's vector field step, which the sample compares the compute shader's output with.
+//
+namespace
+{
+
+// Texel of velocity 0, the rest state: 0.5 in rg rounds to 128, which decodes to 1/255 and decays back to it.
+const uint8_t kRest[kVectorFieldTexelSize] = { 128, 128, 1, 255 };
+
+VectorFieldParameters MakeParameters(uint32_t width, uint32_t height)
+{
+    VectorFieldParameters parameters;
+    parameters.Width = width;
+    parameters.Height = height;
+    parameters.Aspect = static_cast<float>(width) / static_cast<float>(height);
+    return parameters;
+}
+
+std::vector<uint8_t> MakeField(const VectorFieldParameters& parameters, const uint8_t texel[kVectorFieldTexelSize])
+{
+    std::vector<uint8_t> field(static_cast<size_t>(parameters.Width) * parameters.Height * kVectorFieldTexelSize);
+    for (size_t index = 0; index < field.size(); index++)
+    {
+        field[index] = texel[index % kVectorFieldTexelSize];
+    }
+    return field;
+}
+
+std::vector<uint8_t> Step(const VectorFieldParameters& parameters, const std::vector<uint8_t>& source, int numSteps)
+{
+    std::vector<uint8_t> field = source;
+    std::vector<uint8_t> target(source.size());
+    for (int step = 0; step < numSteps; step++)
+    {
+        StepVectorField(parameters, field.data(), target.data());
+        field.swap(target);
+    }
+    return field;
+}
+
+const uint8_t* GetTexel(const VectorFieldParameters& parameters, const std::vector<uint8_t>& field, uint32_t x, uint32_t y)
+{
+    return &field[(static_cast<size_t>(y) * parameters.Width + x) * kVectorFieldTexelSize];
+}
+
+bool IsAtRest(const uint8_t* texel)
+{
+    return texel[0] == kRest[0] && texel[1] == kRest[1] && texel[2] == kRest[2] && texel[3] == kRest[3];
+}
+
+// Velocity of a texel, in 1/255 steps of its encoding away from rest.
+int GetVelocityX(const uint8_t* texel)
+{
+    return static_cast<int>(texel[0]) - kRest[0];
+}
+
+int GetVelocityY(const uint8_t* texel)
+{
+    return static_cast<int>(texel[1]) - kRest[1];
+}
+
+void TestRest()
+{
+    VectorFieldParameters parameters = MakeParameters(32, 32);
+    parameters.Strength = 0.0f;
+    const std::vector<uint8_t> rest = MakeField(parameters, kRest);
+    CHECK(Step(parameters, rest, 10) == rest);
+}
+
+// Around the center the swirl turns clockwise on screen, y being down.
+void TestSwirlDirection()
+{
+    const VectorFieldParameters parameters = MakeParameters(64, 64);
+    const std::vector<uint8_t> field = Step(parameters, MakeField(parameters, kRest), 1);
+
+    const uint8_t* right = GetTexel(parameters, field, 44, 32);
+    const uint8_t* left = GetTexel(parameters, field, 19, 32);
+    const uint8_t* top = GetTexel(parameters, field, 32, 19);
+    const uint8_t* bottom = GetTexel(parameters, field, 32, 44);
+    CHECK(GetVelocityY(right) > 0 && std::abs(GetVelocityX(right)) < GetVelocityY(right));
+    CHECK(GetVelocityY(left) < 0 && std::abs(GetVelocityX(left)) < -GetVelocityY(left));
+    CHECK(GetVelocityX(top) > 0 && std::abs(GetVelocityY(top)) < GetVelocityX(top));
+    CHECK(GetVelocityX(bottom) < 0 && std::abs(GetVelocityY(bottom)) < -GetVelocityX(bottom));
+
+    // The length is in b, and the swirl fades out towards the radius.
+    CHECK(right[2] > kRest[2] && right[3] == 255);
+    const uint8_t* outer = GetTexel(parameters, field, 46, 32);
+    CHECK(GetVelocityY(outer) > 0 && GetVelocityY(outer) < GetVelocityY(right));
+}
+
+// Outside the radius the field stays at rest, however long the swirl runs, with a non-square field too.
+void TestFarField()
+{
+    const VectorFieldParameters parameters = MakeParameters(96, 48);
+    const std::vector<uint8_t> field = Step(parameters, MakeField(parameters, kRest), 100);
+    const float radius = parameters.Radius * parameters.Height;
+    size_t numMoving = 0;
+    for (uint32_t y = 0; y < parameters.Height; y++)
+    {
+        for (uint32_t x = 0; x < parameters.Width; x++)
+        {
+            const float offsetX = x + 0.5f - parameters.Width * parameters.CenterX;
+            const float offsetY = y + 0.5f - parameters.Height * parameters.CenterY;
+            const bool outside = std::sqrt(offsetX * offsetX + offsetY * offsetY) > radius + 2.0f * parameters.Advection;
+            const bool atRest = IsAtRest(GetTexel(parameters, field, x, y));
+            CHECK(atRest || !outside);
+            numMoving += atRest ? 0 : 1;
+        }
+    }
+    CHECK(numMoving > 0);
+}
+
+// Without a swirl, a uniform velocity only decays towards rest. It stops short of it where a step changes the encoding
+// by less than half a 1/255 step, 10 steps away from 128 at the default decay.
+void TestDecay()
+{
+    VectorFieldParameters parameters = MakeParameters(16, 16);
+    parameters.Strength = 0.0f;
+    const uint8_t moving[kVectorFieldTexelSize] = { 255, 64, 0, 255 };
+    std::vector<uint8_t> field = MakeField(parameters, moving);
+    int previousX = GetVelocityX(moving);
+    int previousY = GetVelocityY(moving);
+    for (int step = 0; step < 200; step++)
+    {
+        field = Step(parameters, field, 1);
+        const uint8_t* texel = GetTexel(parameters, field, 5, 9);
+        CHECK(CompareVectorFields(field.data(), MakeField(parameters, texel).data(), 16 * 16, 0).NumMismatches == 0);
+        CHECK(GetVelocityX(texel) >= 0 && GetVelocityX(texel) <= previousX);
+        CHECK(GetVelocityY(texel) <= 0 && GetVelocityY(texel) >= previousY);
+        previousX = GetVelocityX(texel);
+        previousY = GetVelocityY(texel);
+    }
+    const uint8_t* texel = GetTexel(parameters, field, 0, 0);
+    CHECK(GetVelocityX(texel) > 0 && GetVelocityX(texel) <= 10);
+    CHECK(GetVelocityY(texel) < 0 && GetVelocityY(texel) >= -10);
+    CHECK(Step(parameters, field, 1) == field);
+}
+
+// Texels fetch upstream: a band moving right keeps its velocity up to its leading edge, and the texels at the left edge
+// fetch the clamped border.
+void TestAdvection()
+{
+    VectorFieldParameters parameters = MakeParameters(16, 4);
+    parameters.Strength = 0.0f;
+    const uint8_t moving[kVectorFieldTexelSize] = { 255, 128, 255, 255 };
+    std::vector<uint8_t> field = MakeField(parameters, kRest);
+    for (uint32_t y = 0; y < parameters.Height; y++)
+    {
+        for (uint32_t x = 0; x < 8; x++)
+        {
+            std::copy(moving, moving + kVectorFieldTexelSize, field.begin() + (y * parameters.Width + x) * kVectorFieldTexelSize);
+        }
+    }
+
+    field = Step(parameters, field, 1);
+    for (uint32_t x = 0; x < parameters.Width; x++)
+    {
+        // 0.95 in r is 249, the length 0.95 over sqrt(2) in b is 171.
+        const uint8_t* texel = GetTexel(parameters, field, x, 2);
+        CHECK(x < 8 ? texel[0] == 249 && texel[1] == 128 && texel[2] == 171 : IsAtRest(texel));
+    }
+}
+
+// Same input, same output, also when fast velocities fetch from beyond the edges.
+void TestDeterminism()
+{
+    VectorFieldParameters parameters = MakeParameters(40, 24);
+    parameters.Advection = 50.0f;
+    parameters.Strength = 1.0f;
+    parameters.CenterX = 0.9f;
+    const std::vector<uint8_t> rest = MakeField(parameters, kRest);
+    const std::vector<uint8_t> first = Step(parameters, rest, 30);
+    const std::vector<uint8_t> second = Step(parameters, rest, 30);
+    CHECK(first == second);
+    CHECK(first != rest);
+}
+
+void TestCompare()
+{
+    const uint8_t expected[] = { 10, 20, 30, 255, 100, 100, 100, 255, 0, 0, 0, 255 };
+    uint8_t actual[] = { 10, 20, 30, 255, 100, 100, 100, 255, 0, 0, 0, 255 };
+    VectorFieldDifference difference = CompareVectorFields(expected, actual, 3, 0);
+    CHECK(difference.MaxDifference == 0 && difference.NumMismatches == 0);
+
+    // Rounding differences within the tolerance count towards the maximum only, several channels of a texel once.
+    actual[1] = 21;
+    actual[4] = 97;
+    actual[6] = 103;
+    difference = CompareVectorFields(expected, actual, 3, 1);
+    CHECK(difference.MaxDifference == 3 && difference.NumMismatches == 1);
+    difference = CompareVectorFields(expected, actual, 3, 0);
+    CHECK(difference.MaxDifference == 3 && difference.NumMismatches == 2);
+    difference = CompareVectorFields(actual, expected, 3, 3);
+    CHECK(difference.MaxDifference == 3 && difference.NumMismatches == 0);
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestRest);
+    RUN_TEST(TestSwirlDirection);
+    RUN_TEST(TestFarField);
+    RUN_TEST(TestDecay);
+    RUN_TEST(TestAdvection);
+    RUN_TEST(TestDeterminism);
+    RUN_TEST(TestCompare);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "VertexFormat.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+//
+// VertexFormat::Encode() throughput over 1M vertices, for the layouts of the samples next to a layout that only
+// repacks floats. Each layout runs once checking Decode(Encode(x)) against x, then once timed.
+//
+namespace
+{
+
+const size_t kNumVertices = 1 << 20;
+
+struct SourceVertex
+{
+    float Position[3];
+    float Normal[4];
+    float Color[4];
+    float Uv[2];
+};
+
+std::vector<SourceVertex> CreateSourceVertices()
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> signedValues(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unsignedValues(0.0f, 1.0f);
+    std::vector<SourceVertex> vertices(kNumVertices);
+    for (SourceVertex& vertex : vertices)
+    {
+        for (float& value : vertex.Position)
+        {
+            value = signedValues(random);
+        }
+        for (float& value : vertex.Normal)
+        {
+            value = signedValues(random);
+        }
+        for (float& value : vertex.Color)
+        {
+            value = unsignedValues(random);
+        }
+        for (float& value : vertex.Uv)
+        {
+            value = unsignedValues(random);
+        }
+    }
+    return vertices;
+}
+
+// Largest difference between a source float and its decoded value, over the components the layout stores.
+float GetMaxError(const VertexFormat& format, const std::vector<SourceVertex>& source, const std::vector<uint8_t>& packed)
+{
+    std::vector<SourceVertex> decoded(source.size(), SourceVertex{});
+    format.Decode(packed.data(), source.size(), decoded.data(), sizeof(SourceVertex));
+
+    float maxError = 0.0f;
+    for (size_t vertex = 0; vertex < source.size(); vertex++)
+    {
+        const float* expected = reinterpret_cast<const float*>(&source[vertex]);
+        const float* actual = reinterpret_cast<const float*>(&decoded[vertex]);
+        for (const VertexFormat::Attribute& attribute : format.GetAttributes())
+        {
+            for (uint32_t component = 0; component < GetNumComponents(attribute.Format); component++)
+            {
+                const size_t index = attribute.SourceOffset / sizeof(float) + component;
+                maxError = std::fmax(maxError, std::fabs(expected[index] - actual[index]));
+            }
+        }
+    }
+    return maxError;
+}
+
+void BenchmarkEncode(const char* name, const VertexFormat& format, float maxError, int passes, bool validate)
+{
+    static const std::vector<SourceVertex> source = CreateSourceVertices();
+    std::vector<uint8_t> packed(kNumVertices * format.GetStride());
+
+    const double milliseconds = tests::MeasureMilliseconds([&]()
+        {
+            for (int pass = 0; pass < passes; pass++)
+            {
+                format.Encode(source.data(), sizeof(SourceVertex), kNumVertices, packed.data());
+            }
+        });
+
+    if (validate)
+    {
+        CHECK(GetMaxError(format, source, packed) <= maxError + 1e-6f);
+    }
+    else
+    {
+        std::printf("%s: %u bytes per vertex, %.1fM vertices/s\n",
+            name, format.GetStride(), static_cast<double>(kNumVertices) * passes / (milliseconds * 1e3));
+    }
+}
+
+}; // namespace
+
+int main(int argc, char** argv)
+{
+    const int passes = tests::GetIterations(argc, argv, 50);
+
+    // The same attributes as floats, the cost of the encoder without conversions.
+    VertexFormat floats;
+    floats.Add("POSITION", 0, VertexAttributeFormat::Float32x2, offsetof(SourceVertex, Position))
+        .Add("COLOR", 0, VertexAttributeFormat::Float32x4, offsetof(SourceVertex, Color))
+        .Add("TEXCOORD", 0, VertexAttributeFormat::Float32x2, offsetof(SourceVertex, Uv));
+
+    // DemoBlob's quad.
+    VertexFormat demoBlob;
+    demoBlob.Add("POSITION", 0, VertexAttributeFormat::Snorm16x2, offsetof(SourceVertex, Position))
+        .Add("COLOR", 0, VertexAttributeFormat::Unorm8x4, offsetof(SourceVertex, Color))
+        .Add("TEXCOORD", 0, VertexAttributeFormat::Unorm16x2, offsetof(SourceVertex, Uv));
+
+    // A lit mesh, the texture coordinates as halves.
+    VertexFormat mesh;
+    mesh.Add("POSITION", 0, VertexAttributeFormat::Float32x3, offsetof(SourceVertex, Position))
+        .Add("NORMAL", 0, VertexAttributeFormat::Snorm8x4, offsetof(SourceVertex, Normal))
+        .Add("TEXCOORD", 0, VertexAttributeFormat::Float16x2, offsetof(SourceVertex, Uv));
+
+    // Half a step of the coarsest format in the layout.
+    BenchmarkEncode("Floats", floats, 0.0f, 1, true);
+    BenchmarkEncode("DemoBlob", demoBlob, 0.5f / 255.0f, 1, true);
+    BenchmarkEncode("Mesh", mesh, 0.5f / 127.0f, 1, true);
+
+    BenchmarkEncode("Floats", floats, 0.0f, passes, false);
+    BenchmarkEncode("DemoBlob", demoBlob, 0.5f / 255.0f, passes, false);
+    BenchmarkEncode("Mesh", mesh, 0.5f / 127.0f, passes, false);
+    return 0;
+}
@@ -0,0 +1,325 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "VertexFormat.h"
+#include "TestUtil.h"
+
+using namespace graphics;
+
+//
+// Built twice by CMake, with the SSE2 conversions and with VERTEX_FORMAT_NO_SSE2. Both builds compare Encode()
+// byte for byte with the reference below, so the two paths produce the same bytes.
+//
+namespace
+{
+
+const VertexAttributeFormat kFormats[] =
+{
+    VertexAttributeFormat::Float32x2,
+    VertexAttributeFormat::Float32x3,
+    VertexAttributeFormat::Float32x4,
+    VertexAttributeFormat::Float16x2,
+    VertexAttributeFormat::Float16x4,
+    VertexAttributeFormat::Unorm8x4,
+    VertexAttributeFormat::Snorm8x4,
+    VertexAttributeFormat::Unorm16x2,
+    VertexAttributeFormat::Snorm16x2,
+    VertexAttributeFormat::Unorm16x4,
+    VertexAttributeFormat::Snorm16x4,
+};
+const uint32_t kNumFormats = sizeof(kFormats) / sizeof(kFormats[0]);
+
+// Every attribute reads four floats of its own, the formats with fewer components ignore the rest.
+const uint32_t kSourceStride = kNumFormats * 4 * sizeof(float);
+
+bool IsHalf(VertexAttributeFormat format)
+{
+    return format == VertexAttributeFormat::Float16x2 || format == VertexAttributeFormat::Float16x4;
+}
+
+bool IsSnorm(VertexAttributeFormat format)
+{
+    return format == VertexAttributeFormat::Snorm8x4 || format == VertexAttributeFormat::Snorm16x2 ||
+        format == VertexAttributeFormat::Snorm16x4;
+}
+
+uint32_t GetComponentSize(VertexAttributeFormat format)
+{
+    return GetFormatSize(format) / GetNumComponents(format);
+}
+
+bool IsNormalized(VertexAttributeFormat format)
+{
+    return !IsHalf(format) && GetComponentSize(format) < 4;
+}
+
+float GetScale(VertexAttributeFormat format)
+{
+    return static_cast<float>((1u << (GetComponentSize(format) * 8 - (IsSnorm(format) ? 1 : 0))) - 1);
+}
+
+VertexFormat CreateAllFormats()
+{
+    VertexFormat format;
+    for (uint32_t index = 0; index < kNumFormats; index++)
+    {
+        format.Add("ATTRIBUTE", index, kFormats[index], index * 4 * sizeof(float));
+    }
+    return format;
+}
+
+// Float to half by the definition, in double: round to nearest even, overflow to infinity, NaN to a quiet NaN.
+uint16_t ReferenceHalf(float value)
+{
+    const uint16_t sign = std::signbit(value) ? 0x8000 : 0;
+    if (std::isnan(value))
+    {
+        return sign | 0x7e00;
+    }
+    const double magnitude = std::fabs(static_cast<double>(value));
+    if (magnitude >= 65520.0)
+    {
+        return sign | 0x7c00;
+    }
+    if (magnitude < std::ldexp(1.0, -14))
+    {
+        // A rounded up denormal of 1024 is the smallest normal, the bits carry over.
+        return sign | static_cast<uint16_t>(std::nearbyint(std::ldexp(magnitude, 24)));
+    }
+    int exponent = 0;
+    std::frexp(magnitude, &exponent);
+    exponent--;
+    double mantissa = std::nearbyint(std::ldexp(magnitude, 10 - exponent));
+    if (mantissa == 2048.0)
+    {
+        mantissa = 1024.0;
+        exponent++;
+    }
+    return sign | static_cast<uint16_t>(((exponent + 15) << 10) | (static_cast<uint32_t>(mantissa) - 1024));
+}
+
+// What Encode() has to write for one attribute: the rounding and clamping its documentation promises.
+void EncodeReference(VertexAttributeFormat format, const float* source, uint8_t* destination)
+{
+    const uint32_t componentSize = GetComponentSize(format);
+    for (uint32_t component = 0; component < GetNumComponents(format); component++)
+    {
+        uint8_t* target = destination + component * componentSize;
+        float value = source[component];
+        if (IsHalf(format))
+        {
+            const uint16_t half = ReferenceHalf(value);
+            std::memcpy(target, &half, sizeof(half));
+        }
+        else if (!IsNormalized(format))
+        {
+            std::memcpy(target, &value, sizeof(value));
+        }
+        else
+        {
+            const float lower = IsSnorm(format) ? -1.0f : 0.0f;
+            value = std::isnan(value) || value < lower ? lower : (value > 1.0f ? 1.0f : value);
+            const int32_t quantized = static_cast<int32_t>(std::nearbyint(value * GetScale(format)));
+            if (componentSize == 1)
+            {
+                *target = static_cast<uint8_t>(quantized);
+            }
+            else
+            {
+                const uint16_t word = static_cast<uint16_t>(quantized);
+                std::memcpy(target, &word, sizeof(word));
+            }
+        }
+    }
+}
+
+// Mostly values around the normalized ranges, some exact quantization ties and the values at the edges.
+std::vector<float> CreateSourceVertices(size_t numVertices, uint32_t seed)
+{
+    const float kSpecial[] =
+    {
+        std::numeric_limits<float>::quiet_NaN(), -std::numeric_limits<float>::quiet_NaN(),
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        0.0f, -0.0f, 1.0f, -1.0f, 1.0000001f, -1.0000001f, 1e30f, -1e30f,
+        65504.0f, 65519.99f, 65520.0f, -65520.0f, 6.1035156e-05f, 5.9604645e-08f, 2.9802322e-08f, 8.940697e-08f, 1e-10f, 1e-40f,
+    };
+    const float kScales[] = { 255.0f, 127.0f, 65535.0f, 32767.0f };
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> nearRange(-1.25f, 1.25f);
+    std::uniform_real_distribution<float> exponents(-30.0f, 17.0f);
+    std::vector<float> source(numVertices * kSourceStride / sizeof(float));
+    for (float& value : source)
+    {
+        const uint32_t kind = random() % 16;
+        if (kind == 0)
+        {
+            value = kSpecial[random() % (sizeof(kSpecial) / sizeof(kSpecial[0]))];
+        }
+        else if (kind == 1)
+        {
+            const float scale = kScales[random() % (sizeof(kScales) / sizeof(kScales[0]))];
+            value = (static_cast<float>(random() % static_cast<uint32_t>(scale)) + 0.5f) / scale;
+        }
+        else if (kind == 2)
+        {
+            // Magnitudes across the whole half range, denormals included.
+            value = std::exp2(exponents(random)) * (random() % 2 ? 1.0f : -1.0f);
+        }
+        else
+        {
+            value = nearRange(random);
+        }
+    }
+    return source;
+}
+
+// Encode() against the reference, over enough vertices for several chunks and a partial one.
+void TestEncodeMatchesReference()
+{
+    const VertexFormat format = CreateAllFormats();
+    const size_t kNumVertices = 10007;
+    const std::vector<float> source = CreateSourceVertices(kNumVertices, 1);
+
+    std::vector<uint8_t> packed(kNumVertices * format.GetStride());
+    format.Encode(source.data(), kSourceStride, kNumVertices, packed.data());
+
+    std::vector<uint8_t> expected(format.GetStride());
+    for (size_t vertex = 0; vertex < kNumVertices; vertex++)
+    {
+        const float* sourceVertex = source.data() + vertex * kSourceStride / sizeof(float);
+        for (const VertexFormat::Attribute& attribute : format.GetAttributes())
+        {
+            EncodeReference(attribute.Format, sourceVertex + attribute.SourceOffset / sizeof(float), expected.data() + attribute.Offset);
+        }
+        CHECK(std::memcmp(packed.data() + vertex * format.GetStride(), expected.data(), format.GetStride()) == 0);
+    }
+}
+
+// Vertices larger than the encoder's chunk are written to the destination directly.
+void TestLargeVertices()
+{
+    const uint32_t kNumAttributes = 600;
+    VertexFormat format;
+    for (uint32_t index = 0; index < kNumAttributes; index++)
+    {
+        format.Add("ATTRIBUTE", index, kFormats[index % kNumFormats], (index % kNumFormats) * 4 * sizeof(float));
+    }
+    CHECK(format.GetStride() > 4096);
+
+    const size_t kNumVertices = 5;
+    const std::vector<float> source = CreateSourceVertices(kNumVertices, 2);
+    std::vector<uint8_t> packed(kNumVertices * format.GetStride());
+    format.Encode(source.data(), kSourceStride, kNumVertices, packed.data());
+
+    std::vector<uint8_t> expected(format.GetStride());
+    for (size_t vertex = 0; vertex < kNumVertices; vertex++)
+    {
+        const float* sourceVertex = source.data() + vertex * kSourceStride / sizeof(float);
+        for (const VertexFormat::Attribute& attribute : format.GetAttributes())
+        {
+            EncodeReference(attribute.Format, sourceVertex + attribute.SourceOffset / sizeof(float), expected.data() + attribute.Offset);
+        }
+        CHECK(std::memcmp(packed.data() + vertex * format.GetStride(), expected.data(), format.GetStride()) == 0);
+    }
+}
+
+// Decode(Encode(x)) is within half a quantization step of x clamped, halves within their relative precision.
+void TestErrorBounds()
+{
+    const VertexFormat format = CreateAllFormats();
+    const size_t kNumVertices = 100000;
+    std::vector<float> source = CreateSourceVertices(kNumVertices, 3);
+    for (float& value : source)
+    {
+        value = std::isfinite(value) && std::fabs(value) <= 65504.0f ? value : 0.0f;
+    }
+
+    std::vector<uint8_t> packed(kNumVertices * format.GetStride());
+    std::vector<float> decoded(source.size(), 0.0f);
+    format.Encode(source.data(), kSourceStride, kNumVertices, packed.data());
+    format.Decode(packed.data(), kNumVertices, decoded.data(), kSourceStride);
+
+    for (size_t vertex = 0; vertex < kNumVertices; vertex++)
+    {
+        for (const VertexFormat::Attribute& attribute : format.GetAttributes())
+        {
+            const size_t first = (vertex * kSourceStride + attribute.SourceOffset) / sizeof(float);
+            for (uint32_t component = 0; component < GetNumComponents(attribute.Format); component++)
+            {
+                const float value = source[first + component];
+                const float result = decoded[first + component];
+                if (IsHalf(attribute.Format))
+                {
+                    const float bound = std::fabs(value) >= 6.1035156e-05f ? std::fabs(value) * 4.8828125e-04f : 2.9802322e-08f;
+                    CHECK(std::fabs(result - value) <= bound);
+                }
+                else if (IsNormalized(attribute.Format))
+                {
+                    const float lower = IsSnorm(attribute.Format) ? -1.0f : 0.0f;
+                    const float clamped = value < lower ? lower : (value > 1.0f ? 1.0f : value);
+                    CHECK(std::fabs(result - clamped) <= 0.5f / GetScale(attribute.Format) + 1e-6f);
+                }
+                else
+                {
+                    CHECK(result == value);
+                }
+            }
+        }
+    }
+}
+
+// Every half decodes to the float it stands for and encodes back to itself, NaNs to a NaN of the same sign.
+void TestHalfRoundTrip()
+{
+    VertexFormat format;
+    format.Add("HALF", 0, VertexAttributeFormat::Float16x2, 0);
+
+    std::vector<uint16_t> halves(65536 * 2);
+    for (uint32_t half = 0; half < 65536; half++)
+    {
+        halves[half * 2] = static_cast<uint16_t>(half);
+        halves[half * 2 + 1] = static_cast<uint16_t>(half ^ 0x8000);
+    }
+
+    std::vector<float> floats(halves.size());
+    format.Decode(halves.data(), 65536, floats.data(), 2 * sizeof(float));
+    std::vector<uint16_t> encoded(halves.size());
+    format.Encode(floats.data(), 2 * sizeof(float), 65536, encoded.data());
+
+    for (size_t index = 0; index < halves.size(); index++)
+    {
+        const uint16_t half = halves[index];
+        const bool isNan = (half & 0x7c00) == 0x7c00 && (half & 0x03ff) != 0;
+        CHECK(std::isnan(floats[index]) == isNan);
+        CHECK(std::signbit(floats[index]) == ((half & 0x8000) != 0));
+        CHECK(ReferenceHalf(floats[index]) == encoded[index]);
+        if (isNan)
+        {
+            CHECK(encoded[index] == ((half & 0x8000) | 0x7e00));
+        }
+        else
+        {
+            CHECK(encoded[index] == half);
+            // Exact: the float is the half's value by definition.
+            const int exponent = (half >> 10) & 0x1f;
+            const double magnitude = exponent == 0x1f ? std::numeric_limits<double>::infinity() :
+                std::ldexp(exponent == 0 ? (half & 0x03ff) : ((half & 0x03ff) | 0x0400), (exponent == 0 ? 1 : exponent) - 25);
+            CHECK(std::fabs(static_cast<double>(floats[index])) == magnitude);
+        }
+    }
+}
+
+}; // namespace
+
+int main()
+{
+    RUN_TEST(TestEncodeMatchesReference);
+    RUN_TEST(TestLargeVertices);
+    RUN_TEST(TestErrorBounds);
+    RUN_TEST(TestHalfRoundTrip);
+    return 0;
+}
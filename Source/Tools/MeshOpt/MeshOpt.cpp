@@ -0,0 +1,119 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "ObjReader.h"
+
+//
+// MeshOpt <input.obj> <output.mesh> [--cache-size <vertices>]
+//
+// Welds the triangles of an OBJ file into an indexed mesh, then reorders it for the post-transform cache, for
+// overdraw and for vertex fetch, and writes it as a mesh file, see MeshFile.h. The cache statistics before and after
+// are printed for a FIFO cache of the given size, 16 by default.
+//
+namespace
+{
+
+bool ReadFile(const std::string& path, std::string& content)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int PrintUsage()
+{
+    std::cerr << "Usage: MeshOpt <input.obj> <output.mesh> [--cache-size <vertices>]" << std::endl;
+    return 2;
+}
+
+void PrintStatistics(const char* label, const meshoptimizer::Mesh& mesh, uint32_t cacheSize)
+{
+    const meshoptimizer::CacheStatistics statistics =
+        meshoptimizer::AnalyzeVertexCache(mesh.Indices.data(), mesh.Indices.size(), mesh.GetNumVertices(), cacheSize);
+    std::cout << std::left << std::setw(8) << label << std::fixed << std::setprecision(3)
+        << "ACMR " << statistics.Acmr << "  ATVR " << statistics.Atvr << "  misses " << statistics.NumMisses << std::endl;
+}
+
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        return PrintUsage();
+    }
+
+    const std::string inputPath = argv[1];
+    const std::string outputPath = argv[2];
+
+    uint32_t cacheSize = meshoptimizer::kDefaultCacheSize;
+    for (int index = 3; index < argc; index++)
+    {
+        const std::string argument = argv[index];
+        if (argument == "--cache-size" && index + 1 < argc)
+        {
+            const long value = std::strtol(argv[++index], nullptr, 10);
+            if (value < 3)
+            {
+                return PrintUsage();
+            }
+            cacheSize = static_cast<uint32_t>(value);
+        }
+        else
+        {
+            return PrintUsage();
+        }
+    }
+
+    std::string source;
+    if (!ReadFile(inputPath, source))
+    {
+        std::cerr << "Can't read " << inputPath << std::endl;
+        return 1;
+    }
+
+    meshopt::ObjMesh obj;
+    try
+    {
+        obj = meshopt::ParseObj(source);
+    }
+    catch (const std::exception& exception)
+    {
+        // Formatted like compiler messages so IDEs can jump to the line.
+        std::cerr << inputPath << ": error: " << exception.what() << std::endl;
+        return 1;
+    }
+    if (obj.Vertices.empty())
+    {
+        std::cerr << inputPath << ": error: no faces" << std::endl;
+        return 1;
+    }
+
+    meshoptimizer::Mesh mesh = meshoptimizer::WeldVertices(obj.Vertices.data(), obj.GetNumVertices(), obj.Stride);
+    std::cout << mesh.GetNumTriangles() << " triangles, " << obj.GetNumVertices() << " corners welded to "
+        << mesh.GetNumVertices() << " vertices" << std::endl;
+    PrintStatistics("before", mesh, cacheSize);
+
+    // The position is the first attribute of every OBJ vertex.
+    meshoptimizer::OptimizeVertexCache(mesh);
+    meshoptimizer::OptimizeOverdraw(mesh, 0, cacheSize);
+    meshoptimizer::OptimizeVertexFetch(mesh);
+    PrintStatistics("after", mesh, cacheSize);
+
+    if (!meshoptimizer::WriteMeshFile(outputPath, mesh, obj.Attributes))
+    {
+        std::cerr << "Can't write " << outputPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "ObjReader.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+namespace meshopt
+{
+
+namespace
+{
+
+struct Corner
+{
+    long Position;
+    long TexCoord;
+    long Normal;
+};
+
+// OBJ indices are 1-based, negative ones count back from the last element read so far. 0 means absent.
+size_t ResolveIndex(long index, size_t count, size_t line)
+{
+    const long resolved = index > 0 ? index - 1 : static_cast<long>(count) + index;
+    if (index == 0 || resolved < 0 || static_cast<size_t>(resolved) >= count)
+    {
+        throw std::runtime_error("line " + std::to_string(line) + ": index " + std::to_string(index) + " out of range");
+    }
+    return static_cast<size_t>(resolved);
+}
+
+Corner ParseCorner(const std::string& token, size_t line)
+{
+    // v, v/vt, v//vn or v/vt/vn
+    Corner corner = { 0, 0, 0 };
+    const char* cursor = token.c_str();
+    char* end = nullptr;
+    corner.Position = std::strtol(cursor, &end, 10);
+    if (end == cursor)
+    {
+        throw std::runtime_error("line " + std::to_string(line) + ": malformed face corner '" + token + "'");
+    }
+    if (*end == '/')
+    {
+        cursor = end + 1;
+        if (*cursor != '/')
+        {
+            corner.TexCoord = std::strtol(cursor, &end, 10);
+        }
+        else
+        {
+            end = const_cast<char*>(cursor);
+        }
+        if (*end == '/')
+        {
+            cursor = end + 1;
+            corner.Normal = std::strtol(cursor, &end, 10);
+        }
+    }
+    return corner;
+}
+
+};
+
+ObjMesh ParseObj(const std::string& source)
+{
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<float> normals;
+    std::vector<std::vector<Corner>> faces;
+
+    std::istringstream stream(source);
+    std::string text;
+    size_t line = 0;
+    while (std::getline(stream, text))
+    {
+        line++;
+        std::istringstream lineStream(text);
+        std::string keyword;
+        if (!(lineStream >> keyword) || keyword[0] == '#')
+        {
+            continue;
+        }
+
+        if (keyword == "v" || keyword == "vn" || keyword == "vt")
+        {
+            std::vector<float>& target = keyword == "v" ? positions : keyword == "vn" ? normals : texCoords;
+            const size_t numComponents = keyword == "vt" ? 2 : 3;
+            for (size_t component = 0; component < numComponents; component++)
+            {
+                float value = 0.0f;
+                if (!(lineStream >> value))
+                {
+                    throw std::runtime_error("line " + std::to_string(line) + ": expected " + std::to_string(numComponents) + " numbers after '" + keyword + "'");
+                }
+                target.push_back(value);
+            }
+        }
+        else if (keyword == "f")
+        {
+            std::vector<Corner> face;
+            std::string token;
+            while (lineStream >> token)
+            {
+                Corner corner = ParseCorner(token, line);
+                // Resolved now, relative indices refer to what was read before the face.
+                corner.Position = static_cast<long>(ResolveIndex(corner.Position, positions.size() / 3, line));
+                corner.TexCoord = corner.TexCoord != 0 ? static_cast<long>(ResolveIndex(corner.TexCoord, texCoords.size() / 2, line)) : -1;
+                corner.Normal = corner.Normal != 0 ? static_cast<long>(ResolveIndex(corner.Normal, normals.size() / 3, line)) : -1;
+                face.push_back(corner);
+            }
+            if (face.size() < 3)
+            {
+                throw std::runtime_error("line " + std::to_string(line) + ": a face needs at least 3 corners");
+            }
+            faces.push_back(std::move(face));
+        }
+    }
+
+    ObjMesh mesh;
+    const bool hasNormals = !normals.empty();
+    const bool hasTexCoords = !texCoords.empty();
+    uint32_t numFloats = 0;
+    mesh.Attributes.push_back({ "POSITION", 0, 3, 0 });
+    numFloats += 3;
+    if (hasNormals)
+    {
+        mesh.Attributes.push_back({ "NORMAL", 0, 3, numFloats * static_cast<uint32_t>(sizeof(float)) });
+        numFloats += 3;
+    }
+    if (hasTexCoords)
+    {
+        mesh.Attributes.push_back({ "TEXCOORD", 0, 2, numFloats * static_cast<uint32_t>(sizeof(float)) });
+        numFloats += 2;
+    }
+    mesh.Stride = numFloats * sizeof(float);
+
+    auto addCorner = [&](const Corner& corner)
+        {
+            mesh.Vertices.insert(mesh.Vertices.end(), positions.begin() + corner.Position * 3, positions.begin() + corner.Position * 3 + 3);
+            if (hasNormals)
+            {
+                for (size_t component = 0; component < 3; component++)
+                {
+                    mesh.Vertices.push_back(corner.Normal >= 0 ? normals[corner.Normal * 3 + component] : 0.0f);
+                }
+            }
+            if (hasTexCoords)
+            {
+                for (size_t component = 0; component < 2; component++)
+                {
+                    mesh.Vertices.push_back(corner.TexCoord >= 0 ? texCoords[corner.TexCoord * 2 + component] : 0.0f);
+                }
+            }
+        };
+
+    for (const std::vector<Corner>& face : faces)
+    {
+        for (size_t corner = 1; corner + 1 < face.size(); corner++)
+        {
+            addCorner(face[0]);
+            addCorner(face[corner]);
+            addCorner(face[corner + 1]);
+        }
+    }
+    return mesh;
+}
+
+}; // namespace meshopt
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MeshFile.h"
+
+namespace meshopt
+{
+
+//
+// Triangles of a Wavefront OBJ file, not indexed: every corner of every face is a vertex of its own.
+//
+// Vertices are POSITION (3 floats), then NORMAL (3 floats) and TEXCOORD (2 floats) when the file has any.
+// Polygons are triangulated as fans, materials, groups and smoothing groups are ignored.
+//
+struct ObjMesh
+{
+    std::vector<float> Vertices;
+    uint32_t Stride = 0;
+    std::vector<meshoptimizer::MeshAttribute> Attributes;
+
+    size_t GetNumVertices() const { return Stride > 0 ? Vertices.size() * sizeof(float) / Stride : 0; }
+};
+
+// Throws std::runtime_error with the line number on malformed input.
+ObjMesh ParseObj(const std::string& source);
+
+}; // namespace meshopt
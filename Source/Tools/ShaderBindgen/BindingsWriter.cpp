@@ -0,0 +1,507 @@
+#include "BindingsWriter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+
+namespace shaderbindgen
+{
+
+namespace
+{
+
+const uint32_t kRegisterSize = 16;
+
+uint32_t AlignRegister(uint32_t offset)
+{
+    return (offset + kRegisterSize - 1) / kRegisterSize * kRegisterSize;
+}
+
+// Size of one element, without the padding of arrays.
+uint32_t GetPackedSize(const HlslType& type)
+{
+    if (!type.IsMatrix())
+    {
+        return 4 * type.Columns;
+    }
+    // Each column (row for row_major) takes a register of its own.
+    return type.RowMajor ? kRegisterSize * (type.Rows - 1) + 4 * type.Columns : kRegisterSize * (type.Columns - 1) + 4 * type.Rows;
+}
+
+// C++ type of the same size and layout, empty if there is none.
+std::string GetCppType(const HlslType& type)
+{
+    if (type.IsMatrix())
+    {
+        return type.Scalar == HlslType::Base::Float && type.Rows == 4 && type.Columns == 4 ? "DirectX::XMFLOAT4X4" : "";
+    }
+
+    switch (type.Scalar)
+    {
+    case HlslType::Base::Float:
+        return type.Columns == 1 ? "float" : "DirectX::XMFLOAT" + std::to_string(type.Columns);
+    case HlslType::Base::Int:
+        return type.Columns == 1 ? "int32_t" : "DirectX::XMINT" + std::to_string(type.Columns);
+    case HlslType::Base::Uint:
+        return type.Columns == 1 ? "uint32_t" : "DirectX::XMUINT" + std::to_string(type.Columns);
+    case HlslType::Base::Bool:
+        // HLSL bools are 32-bit in constant buffers.
+        return type.Columns == 1 ? "uint32_t" : "";
+    }
+    return "";
+}
+
+std::string GetFormat(const HlslType& type)
+{
+    static const char* kComponents[] = { "R32", "R32G32", "R32G32B32", "R32G32B32A32" };
+    if (type.IsMatrix() || type.Scalar == HlslType::Base::Bool)
+    {
+        return "";
+    }
+    const char* suffix = type.Scalar == HlslType::Base::Float ? "_FLOAT" : type.Scalar == HlslType::Base::Int ? "_SINT" : "_UINT";
+    return std::string("DXGI_FORMAT_") + kComponents[type.Columns - 1] + suffix;
+}
+
+bool IsSystemValue(const std::string& semantic)
+{
+    return semantic.size() > 3 && toupper(static_cast<unsigned char>(semantic[0])) == 'S' &&
+        toupper(static_cast<unsigned char>(semantic[1])) == 'V' && semantic[2] == '_';
+}
+
+void Fail(const std::string& message)
+{
+    throw std::runtime_error(message);
+}
+
+enum StageMask
+{
+    kVertexStage = 1,
+    kPixelStage = 2,
+    kComputeStage = 4
+};
+
+// Entry points sharing one root signature, and the names of its declarations.
+struct RootSignatureLayout
+{
+    // Prepended to RootParameter, kRoot<Name>, kNumRootParameters and RootSignature.
+    std::string Prefix;
+    std::vector<std::pair<std::string, int>> EntryPoints;
+    bool HasInputLayout = false;
+};
+
+const char* GetVisibility(int stages)
+{
+    switch (stages)
+    {
+    case kVertexStage:
+        return "D3D12_SHADER_VISIBILITY_VERTEX";
+    case kPixelStage:
+        return "D3D12_SHADER_VISIBILITY_PIXEL";
+    default:
+        return "D3D12_SHADER_VISIBILITY_ALL";
+    }
+}
+
+void WriteConstantBuffer(std::ostringstream& out, const HlslConstantBuffer& constantBuffer)
+{
+    struct Member
+    {
+        std::string Declaration;
+        std::string Name;
+        uint32_t Offset;
+    };
+
+    std::vector<Member> members;
+    uint32_t hlslOffset = 0;
+    uint32_t cppOffset = 0;
+    uint32_t numPaddings = 0;
+
+    auto addPadding = [&](uint32_t size)
+        {
+            members.push_back({ "uint32_t padding" + std::to_string(numPaddings++) + "[" + std::to_string(size / 4) + "];", "", cppOffset });
+            cppOffset += size;
+        };
+
+    for (const HlslVariable& variable : constantBuffer.Members)
+    {
+        const std::string context = constantBuffer.Name + "::" + variable.Name;
+        HlslType type;
+        if (!ParseHlslType(variable.TypeName, type))
+        {
+            Fail(context + ": struct members ('" + variable.TypeName + "') aren't supported in cbuffers");
+        }
+        type.RowMajor = variable.Type.RowMajor;
+
+        const std::string cppType = GetCppType(type);
+        if (cppType.empty())
+        {
+            Fail(context + ": '" + variable.TypeName + "' has no C++ equivalent");
+        }
+
+        const uint32_t elementSize = GetPackedSize(type);
+        uint32_t size = elementSize;
+        if (variable.ArraySize > 0 || type.IsMatrix())
+        {
+            hlslOffset = AlignRegister(hlslOffset);
+        }
+        else if (hlslOffset / kRegisterSize != (hlslOffset + size - 1) / kRegisterSize)
+        {
+            // Vectors don't straddle registers.
+            hlslOffset = AlignRegister(hlslOffset);
+        }
+
+        if (variable.ArraySize > 0)
+        {
+            if (elementSize % kRegisterSize != 0)
+            {
+                Fail(context + ": every element of an HLSL array starts a new register, declare it as an array of 4-component vectors");
+            }
+            size = elementSize * variable.ArraySize;
+        }
+
+        if (hlslOffset > cppOffset)
+        {
+            addPadding(hlslOffset - cppOffset);
+        }
+
+        std::string declaration = cppType + " " + variable.Name;
+        if (variable.ArraySize > 0)
+        {
+            declaration += "[" + std::to_string(variable.ArraySize) + "]";
+        }
+        members.push_back({ declaration + ";", variable.Name, hlslOffset });
+
+        hlslOffset += size;
+        cppOffset = hlslOffset;
+    }
+
+    const uint32_t totalSize = AlignRegister(hlslOffset);
+    if (totalSize > cppOffset)
+    {
+        addPadding(totalSize - cppOffset);
+    }
+
+    out << "// cbuffer " << constantBuffer.Name << " : register(b" << constantBuffer.Register << ", space" << constantBuffer.Space << ")\n";
+    out << "struct " << constantBuffer.Name << "\n{\n";
+    for (const Member& member : members)
+    {
+        out << "    " << member.Declaration << "\n";
+    }
+    out << "};\n";
+    for (const Member& member : members)
+    {
+        if (!member.Name.empty())
+        {
+            out << "static_assert(offsetof(" << constantBuffer.Name << ", " << member.Name << ") == " << member.Offset
+                << ", \"" << constantBuffer.Name << "::" << member.Name << " doesn't match the HLSL packing\");\n";
+        }
+    }
+    out << "static_assert(sizeof(" << constantBuffer.Name << ") == " << totalSize << ", \"" << constantBuffer.Name
+        << " doesn't match the HLSL size\");\n\n";
+}
+
+void WriteInputLayout(std::ostringstream& out, const HlslFile& file, const HlslFunction& function)
+{
+    struct Element
+    {
+        std::string SemanticName;
+        uint32_t SemanticIndex;
+        std::string Format;
+        uint32_t Offset;
+    };
+
+    std::vector<Element> elements;
+    uint32_t offset = 0;
+
+    auto addElement = [&](const HlslVariable& variable)
+        {
+            if (variable.Semantic.empty())
+            {
+                Fail(function.Name + ": input '" + variable.Name + "' has no semantic");
+            }
+            if (IsSystemValue(variable.Semantic))
+            {
+                return;
+            }
+
+            HlslType type;
+            std::string format;
+            if (ParseHlslType(variable.TypeName, type))
+            {
+                format = GetFormat(type);
+            }
+            if (format.empty() || variable.ArraySize > 0)
+            {
+                Fail(function.Name + ": input '" + variable.Name + "' of type '" + variable.TypeName + "' has no vertex format");
+            }
+
+            // TEXCOORD1 is semantic TEXCOORD with index 1.
+            size_t digits = variable.Semantic.size();
+            while (digits > 0 && isdigit(static_cast<unsigned char>(variable.Semantic[digits - 1])))
+            {
+                digits--;
+            }
+            const uint32_t index = digits < variable.Semantic.size() ? static_cast<uint32_t>(std::stoul(variable.Semantic.substr(digits))) : 0;
+
+            elements.push_back({ variable.Semantic.substr(0, digits), index, format, offset });
+            offset += 4 * type.Columns;
+        };
+
+    for (const HlslVariable& parameter : function.Parameters)
+    {
+        if (parameter.IsOutput)
+        {
+            continue;
+        }
+        auto structure = file.Structs.find(parameter.TypeName);
+        if (structure != file.Structs.end())
+        {
+            for (const HlslVariable& field : structure->second)
+            {
+                addElement(field);
+            }
+        }
+        else
+        {
+            addElement(parameter);
+        }
+    }
+
+    if (elements.empty())
+    {
+        return;
+    }
+
+    out << "// Vertex input of " << function.Name << ", tightly packed in slot 0\n";
+    out << "const D3D12_INPUT_ELEMENT_DESC " << function.Name << "InputLayout[] =\n{\n";
+    for (size_t index = 0; index < elements.size(); index++)
+    {
+        const Element& element = elements[index];
+        out << "    { \"" << element.SemanticName << "\", " << element.SemanticIndex << ", " << element.Format << ", 0, " << element.Offset
+            << ", D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }" << (index + 1 < elements.size() ? "," : "") << "\n";
+    }
+    out << "};\n";
+    out << "const UINT " << function.Name << "VertexStride = " << offset << ";\n\n";
+}
+
+void WriteRootSignature(std::ostringstream& out, const HlslFile& file, const RootSignatureLayout& layout)
+{
+    std::vector<std::pair<std::set<std::string>, int>> reachableIdentifiers;
+    for (const auto& entryPoint : layout.EntryPoints)
+    {
+        reachableIdentifiers.emplace_back(file.GetReachableIdentifiers(entryPoint.first), entryPoint.second);
+    }
+
+    auto getStages = [&](const std::string& name)
+        {
+            int stages = 0;
+            for (const auto& identifiers : reachableIdentifiers)
+            {
+                stages |= identifiers.first.count(name) > 0 ? identifiers.second : 0;
+            }
+            return stages;
+        };
+
+    struct Parameter
+    {
+        std::string Name;
+        std::string Initialization;
+        int Stages;
+    };
+    std::vector<Parameter> parameters;
+    int usedStages = 0;
+
+    // cbuffer members are global names, the buffer is used when any of them is.
+    std::vector<const HlslConstantBuffer*> constantBuffers;
+    for (const HlslConstantBuffer& constantBuffer : file.ConstantBuffers)
+    {
+        constantBuffers.push_back(&constantBuffer);
+    }
+    std::sort(constantBuffers.begin(), constantBuffers.end(), [](const HlslConstantBuffer* a, const HlslConstantBuffer* b)
+        {
+            return a->Space != b->Space ? a->Space < b->Space : a->Register < b->Register;
+        });
+
+    for (const HlslConstantBuffer* constantBuffer : constantBuffers)
+    {
+        int stages = 0;
+        for (const HlslVariable& member : constantBuffer->Members)
+        {
+            stages |= getStages(member.Name);
+        }
+        if (stages == 0)
+        {
+            continue;
+        }
+        usedStages |= stages;
+
+        // Constants come from per-frame upload memory which doesn't change while the command list executes.
+        std::ostringstream initialization;
+        initialization << "InitAsConstantBufferView(" << constantBuffer->Register << ", " << constantBuffer->Space
+            << ", D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, " << GetVisibility(stages) << ");";
+        parameters.push_back({ constantBuffer->Name, initialization.str(), stages });
+    }
+
+    std::vector<std::string> viewRanges;
+    std::vector<std::string> samplerRanges;
+    int viewStages = 0;
+    int samplerStages = 0;
+    for (const HlslResource& resource : file.Resources)
+    {
+        const int stages = getStages(resource.Name);
+        if (stages == 0)
+        {
+            continue;
+        }
+        usedStages |= stages;
+
+        std::ostringstream range;
+        const char* rangeType = resource.Type == HlslResource::Kind::Sampler ? "D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER" :
+            resource.Type == HlslResource::Kind::UnorderedAccess ? "D3D12_DESCRIPTOR_RANGE_TYPE_UAV" : "D3D12_DESCRIPTOR_RANGE_TYPE_SRV";
+        range << "Init(" << rangeType << ", " << resource.Count << ", " << resource.Register << ", " << resource.Space << ");  // " << resource.Name;
+        if (resource.Type == HlslResource::Kind::Sampler)
+        {
+            samplerRanges.push_back(range.str());
+            samplerStages |= stages;
+        }
+        else
+        {
+            viewRanges.push_back(range.str());
+            viewStages |= stages;
+        }
+    }
+    if (!viewRanges.empty())
+    {
+        parameters.push_back({ "Views", "InitAsDescriptorTable(" + std::to_string(viewRanges.size()) + ", ViewRanges, " + GetVisibility(viewStages) + ");", viewStages });
+    }
+    if (!samplerRanges.empty())
+    {
+        parameters.push_back({ "Samplers", "InitAsDescriptorTable(" + std::to_string(samplerRanges.size()) + ", SamplerRanges, " + GetVisibility(samplerStages) + ");", samplerStages });
+    }
+
+    const std::string& prefix = layout.Prefix;
+    out << "// Root parameters, in the order of " << prefix << "RootSignature::Parameters\n";
+    out << "enum " << prefix << "RootParameter : UINT\n{\n";
+    for (size_t index = 0; index < parameters.size(); index++)
+    {
+        out << "    k" << prefix << "Root" << parameters[index].Name << " = " << index << ",\n";
+    }
+    out << "    kNum" << prefix << "RootParameters = " << parameters.size() << "\n};\n\n";
+
+    out << "//\n// Root signature with only the bindings used by ";
+    for (size_t index = 0; index < layout.EntryPoints.size(); index++)
+    {
+        out << (index == 0 ? "" : index + 1 < layout.EntryPoints.size() ? ", " : " and ") << layout.EntryPoints[index].first;
+    }
+    out << ".\n";
+    out << "// Desc points into the object itself, so it can't be copied.\n//\n";
+    out << "struct " << prefix << "RootSignature\n{\n";
+    if (!viewRanges.empty())
+    {
+        out << "    CD3DX12_DESCRIPTOR_RANGE1 ViewRanges[" << viewRanges.size() << "];\n";
+    }
+    if (!samplerRanges.empty())
+    {
+        out << "    CD3DX12_DESCRIPTOR_RANGE1 SamplerRanges[" << samplerRanges.size() << "];\n";
+    }
+    if (!parameters.empty())
+    {
+        out << "    CD3DX12_ROOT_PARAMETER1 Parameters[kNum" << prefix << "RootParameters];\n";
+    }
+    out << "    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC Desc;\n\n";
+
+    out << "    " << prefix << "RootSignature()\n    {\n";
+    for (size_t index = 0; index < viewRanges.size(); index++)
+    {
+        out << "        ViewRanges[" << index << "]." << viewRanges[index] << "\n";
+    }
+    for (size_t index = 0; index < samplerRanges.size(); index++)
+    {
+        out << "        SamplerRanges[" << index << "]." << samplerRanges[index] << "\n";
+    }
+    for (const Parameter& parameter : parameters)
+    {
+        out << "        Parameters[k" << prefix << "Root" << parameter.Name << "]." << parameter.Initialization << "\n";
+    }
+
+    // The graphics stage flags mean nothing to compute root signatures.
+    std::vector<std::string> flags;
+    if (layout.HasInputLayout)
+    {
+        flags.push_back("D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT");
+    }
+    if ((usedStages & kComputeStage) != 0)
+    {
+        flags.push_back("D3D12_ROOT_SIGNATURE_FLAG_NONE");
+    }
+    else
+    {
+        if ((usedStages & kVertexStage) == 0)
+        {
+            flags.push_back("D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS");
+        }
+        flags.push_back("D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS");
+        flags.push_back("D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS");
+        flags.push_back("D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS");
+        if ((usedStages & kPixelStage) == 0)
+        {
+            flags.push_back("D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS");
+        }
+    }
+
+    out << "        Desc.Init_1_1(kNum" << prefix << "RootParameters, " << (parameters.empty() ? "nullptr" : "Parameters") << ", 0, nullptr,";
+    for (size_t index = 0; index < flags.size(); index++)
+    {
+        out << "\n            " << flags[index] << (index + 1 < flags.size() ? " |" : ");");
+    }
+    out << "\n    }\n\n";
+    out << "    " << prefix << "RootSignature(const " << prefix << "RootSignature&) = delete;\n";
+    out << "    " << prefix << "RootSignature& operator=(const " << prefix << "RootSignature&) = delete;\n";
+    out << "};\n\n";
+}
+
+};
+
+std::string WriteBindings(const HlslFile& file, const BindingsOptions& options)
+{
+    std::ostringstream out;
+    out << "#pragma once\n\n";
+    out << "// Generated by ShaderBindgen from " << options.SourceName << ", don't edit.\n\n";
+    out << "#include <cstddef>\n#include <cstdint>\n\n";
+    out << "#include <d3d12.h>\n#include <d3dx12.h>\n#include <DirectXMath.h>\n\n";
+    out << "namespace " << options.Name << "Bindings\n{\n\n";
+
+    for (const HlslConstantBuffer& constantBuffer : file.ConstantBuffers)
+    {
+        WriteConstantBuffer(out, constantBuffer);
+    }
+
+    bool hasInputLayout = false;
+    auto vertexFunction = file.Functions.find(options.VertexEntryPoint);
+    if (vertexFunction != file.Functions.end())
+    {
+        const std::streamoff length = out.tellp();
+        WriteInputLayout(out, file, vertexFunction->second);
+        hasInputLayout = static_cast<std::streamoff>(out.tellp()) != length;
+    }
+
+    RootSignatureLayout graphicsLayout;
+    graphicsLayout.EntryPoints = { { options.VertexEntryPoint, kVertexStage }, { options.PixelEntryPoint, kPixelStage } };
+    graphicsLayout.HasInputLayout = hasInputLayout;
+    WriteRootSignature(out, file, graphicsLayout);
+
+    // Compute pipelines take a root signature of their own.
+    if (file.Functions.count(options.ComputeEntryPoint) > 0)
+    {
+        RootSignatureLayout computeLayout;
+        computeLayout.Prefix = "Compute";
+        computeLayout.EntryPoints = { { options.ComputeEntryPoint, kComputeStage } };
+        WriteRootSignature(out, file, computeLayout);
+    }
+
+    out << "}; // namespace " << options.Name << "Bindings\n";
+    return out.str();
+}
+
+}; // namespace shaderbindgen
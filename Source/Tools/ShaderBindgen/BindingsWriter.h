@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+#include "HlslParser.h"
+
+namespace shaderbindgen
+{
+
+struct BindingsOptions
+{
+    // Names the namespace of the generated declarations, e.g. Shaders gives ShadersBindings.
+    std::string Name;
+    std::string SourceName;
+    std::string VertexEntryPoint = "VSMain";
+    std::string PixelEntryPoint = "PSMain";
+    std::string ComputeEntryPoint = "CSMain";
+};
+
+//
+// Writes the C++ side of the bindings of one HLSL file:
+// - A struct per cbuffer, laid out by the HLSL packing rules with explicit padding and static_asserted offsets.
+// - The input layout of the vertex entry point.
+// - A root signature holding only what the entry points use: a root CBV per cbuffer, one descriptor table for the
+//   SRVs and UAVs and one for the samplers, each visible to the stages which use it.
+// - The same for the compute entry point, prefixed with Compute, when the file has one.
+//
+// Throws std::runtime_error for members which have no exact C++ equivalent, e.g. arrays of scalars, whose
+// elements HLSL pads to 16 bytes.
+//
+std::string WriteBindings(const HlslFile& file, const BindingsOptions& options);
+
+}; // namespace shaderbindgen
@@ -0,0 +1,573 @@
+#include "HlslParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+namespace shaderbindgen
+{
+
+namespace
+{
+
+struct Token
+{
+    std::string Text;
+    int Line;
+};
+
+std::vector<Token> Tokenize(const std::string& source)
+{
+    std::vector<Token> tokens;
+    int line = 1;
+    bool lineStart = true;
+
+    size_t index = 0;
+    while (index < source.size())
+    {
+        const char c = source[index];
+        if (c == '\n')
+        {
+            line++;
+            lineStart = true;
+            index++;
+            continue;
+        }
+        if (isspace(static_cast<unsigned char>(c)))
+        {
+            index++;
+            continue;
+        }
+
+        // Preprocessor lines, including continuations
+        if (c == '#' && lineStart)
+        {
+            while (index < source.size() && source[index] != '\n')
+            {
+                if (source[index] == '\\' && index + 1 < source.size() && source[index + 1] == '\n')
+                {
+                    line++;
+                    index++;
+                }
+                index++;
+            }
+            continue;
+        }
+        lineStart = false;
+
+        if (c == '/' && index + 1 < source.size() && source[index + 1] == '/')
+        {
+            while (index < source.size() && source[index] != '\n')
+            {
+                index++;
+            }
+            continue;
+        }
+        if (c == '/' && index + 1 < source.size() && source[index + 1] == '*')
+        {
+            index += 2;
+            while (index + 1 < source.size() && !(source[index] == '*' && source[index + 1] == '/'))
+            {
+                line += source[index] == '\n' ? 1 : 0;
+                index++;
+            }
+            index += 2;
+            continue;
+        }
+
+        const size_t start = index;
+        if (isalpha(static_cast<unsigned char>(c)) || c == '_')
+        {
+            while (index < source.size() && (isalnum(static_cast<unsigned char>(source[index])) || source[index] == '_'))
+            {
+                index++;
+            }
+        }
+        else if (isdigit(static_cast<unsigned char>(c)))
+        {
+            while (index < source.size() && (isalnum(static_cast<unsigned char>(source[index])) || source[index] == '.'))
+            {
+                index++;
+            }
+        }
+        else if (c == '"')
+        {
+            index++;
+            while (index < source.size() && source[index] != '"')
+            {
+                index++;
+            }
+            index++;
+        }
+        else
+        {
+            index++;
+        }
+        tokens.push_back({ source.substr(start, index - start), line });
+    }
+
+    return tokens;
+}
+
+bool IsIdentifier(const std::string& text)
+{
+    return !text.empty() && (isalpha(static_cast<unsigned char>(text[0])) || text[0] == '_');
+}
+
+bool StartsWith(const std::string& text, const char* prefix)
+{
+    return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+bool IsResourceType(const std::string& name, HlslResource::Kind& kind)
+{
+    if (name == "SamplerState" || name == "SamplerComparisonState")
+    {
+        kind = HlslResource::Kind::Sampler;
+        return true;
+    }
+    if (StartsWith(name, "RWTexture") || name == "RWBuffer" || name == "RWStructuredBuffer" || name == "RWByteAddressBuffer" ||
+        name == "AppendStructuredBuffer" || name == "ConsumeStructuredBuffer")
+    {
+        kind = HlslResource::Kind::UnorderedAccess;
+        return true;
+    }
+    if (StartsWith(name, "Texture") || name == "Buffer" || name == "StructuredBuffer" || name == "ByteAddressBuffer")
+    {
+        kind = HlslResource::Kind::ShaderResource;
+        return true;
+    }
+    return false;
+}
+
+bool IsModifier(const std::string& text)
+{
+    static const std::set<std::string> kModifiers =
+    {
+        "in", "out", "inout", "uniform", "const", "precise", "linear", "centroid", "nointerpolation", "noperspective", "sample",
+        "row_major", "column_major", "globallycoherent", "static", "extern", "volatile", "shared", "groupshared"
+    };
+    return kModifiers.count(text) > 0;
+}
+
+class Parser
+{
+public:
+    explicit Parser(const std::string& source) : tokens_(Tokenize(source)), position_(0) {}
+
+    HlslFile Parse()
+    {
+        HlslFile file;
+        while (!AtEnd())
+        {
+            const std::string& text = Peek();
+            HlslResource::Kind kind;
+            if (text == "cbuffer")
+            {
+                file.ConstantBuffers.push_back(ParseConstantBuffer());
+            }
+            else if (text == "struct")
+            {
+                ParseStruct(file);
+            }
+            else if (text == ";")
+            {
+                position_++;
+            }
+            else if (IsResourceType(text, kind))
+            {
+                file.Resources.push_back(ParseResource(kind));
+            }
+            else
+            {
+                ParseDeclaration(file);
+            }
+        }
+        return file;
+    }
+
+private:
+    bool AtEnd() const { return position_ >= tokens_.size(); }
+
+    const std::string& Peek(size_t offset = 0) const
+    {
+        static const std::string kEnd;
+        return position_ + offset < tokens_.size() ? tokens_[position_ + offset].Text : kEnd;
+    }
+
+    [[noreturn]] void Fail(const std::string& message) const
+    {
+        const int line = tokens_.empty() ? 0 : tokens_[std::min(position_, tokens_.size() - 1)].Line;
+        throw std::runtime_error("line " + std::to_string(line) + ": " + message);
+    }
+
+    const std::string& Next()
+    {
+        if (AtEnd())
+        {
+            Fail("unexpected end of file");
+        }
+        return tokens_[position_++].Text;
+    }
+
+    void Expect(const char* text)
+    {
+        if (Next() != text)
+        {
+            position_--;
+            Fail(std::string("expected '") + text + "' instead of '" + Peek() + "'");
+        }
+    }
+
+    bool Accept(const char* text)
+    {
+        if (Peek() == text)
+        {
+            position_++;
+            return true;
+        }
+        return false;
+    }
+
+    std::string ExpectIdentifier()
+    {
+        const std::string& text = Next();
+        if (!IsIdentifier(text))
+        {
+            position_--;
+            Fail("expected an identifier instead of '" + text + "'");
+        }
+        return text;
+    }
+
+    uint32_t ExpectNumber()
+    {
+        const std::string& text = Next();
+        if (text.empty() || !isdigit(static_cast<unsigned char>(text[0])))
+        {
+            position_--;
+            Fail("expected a number instead of '" + text + "'");
+        }
+        return static_cast<uint32_t>(std::stoul(text));
+    }
+
+    // Skip a balanced (), {}, [] or <> group starting at the current opening token.
+    void SkipGroup()
+    {
+        const std::string open = Next();
+        const std::string close = open == "(" ? ")" : open == "{" ? "}" : open == "[" ? "]" : ">";
+        int depth = 1;
+        while (depth > 0)
+        {
+            const std::string& text = Next();
+            depth += text == open ? 1 : text == close ? -1 : 0;
+        }
+    }
+
+    // : register(b0) or : register(t1, space2), `registerClass` is the expected letter.
+    void ParseRegister(char registerClass, uint32_t& index, uint32_t& space)
+    {
+        index = 0;
+        space = 0;
+        if (!Accept(":"))
+        {
+            Fail("bindings need an explicit register()");
+        }
+        if (Peek() != "register")
+        {
+            Fail("bindings need an explicit register()");
+        }
+        position_++;
+        Expect("(");
+        const std::string slot = Next();
+        if (slot.size() < 2 || tolower(static_cast<unsigned char>(slot[0])) != registerClass)
+        {
+            position_--;
+            Fail(std::string("expected a '") + registerClass + "' register instead of '" + slot + "'");
+        }
+        index = static_cast<uint32_t>(std::stoul(slot.substr(1)));
+        if (Accept(","))
+        {
+            const std::string spaceName = Next();
+            if (!StartsWith(spaceName, "space"))
+            {
+                Fail("expected spaceN instead of '" + spaceName + "'");
+            }
+            space = static_cast<uint32_t>(std::stoul(spaceName.substr(5)));
+        }
+        Expect(")");
+    }
+
+    // [modifiers] type name [array] [: semantic]
+    HlslVariable ParseVariable(bool allowSemantic)
+    {
+        HlslVariable variable;
+        bool rowMajor = false;
+        while (IsModifier(Peek()))
+        {
+            const std::string& modifier = Next();
+            rowMajor = rowMajor || modifier == "row_major";
+            variable.IsOutput = variable.IsOutput || modifier == "out" || modifier == "inout";
+        }
+
+        variable.TypeName = ExpectIdentifier();
+        if (Peek() == "<")
+        {
+            Fail("template types like '" + variable.TypeName + "<...>' aren't supported here");
+        }
+        if (!ParseHlslType(variable.TypeName, variable.Type))
+        {
+            // A struct, resolved by the user of the variable.
+            variable.Type = HlslType();
+        }
+        variable.Type.RowMajor = rowMajor;
+
+        variable.Name = ExpectIdentifier();
+        if (Accept("["))
+        {
+            variable.ArraySize = ExpectNumber();
+            Expect("]");
+        }
+        if (Accept(":"))
+        {
+            if (Peek() == "packoffset")
+            {
+                Fail("packoffset() isn't supported, members are laid out by the default packing rules");
+            }
+            if (!allowSemantic)
+            {
+                Fail("unexpected ':' after '" + variable.Name + "'");
+            }
+            variable.Semantic = ExpectIdentifier();
+        }
+        if (Accept("="))
+        {
+            Fail("default values aren't supported for '" + variable.Name + "'");
+        }
+        return variable;
+    }
+
+    HlslConstantBuffer ParseConstantBuffer()
+    {
+        Expect("cbuffer");
+        HlslConstantBuffer constantBuffer;
+        constantBuffer.Name = ExpectIdentifier();
+        ParseRegister('b', constantBuffer.Register, constantBuffer.Space);
+        Expect("{");
+        while (!Accept("}"))
+        {
+            HlslVariable member = ParseVariable(false);
+            constantBuffer.Members.push_back(member);
+            while (Accept(","))
+            {
+                HlslVariable next = member;
+                next.Name = ExpectIdentifier();
+                next.ArraySize = 0;
+                if (Accept("["))
+                {
+                    next.ArraySize = ExpectNumber();
+                    Expect("]");
+                }
+                constantBuffer.Members.push_back(next);
+            }
+            Expect(";");
+        }
+        Accept(";");
+        return constantBuffer;
+    }
+
+    void ParseStruct(HlslFile& file)
+    {
+        Expect("struct");
+        const std::string name = ExpectIdentifier();
+        std::vector<HlslVariable> fields;
+        Expect("{");
+        while (!Accept("}"))
+        {
+            fields.push_back(ParseVariable(true));
+            Expect(";");
+        }
+        Expect(";");
+        file.Structs[name] = fields;
+    }
+
+    HlslResource ParseResource(HlslResource::Kind kind)
+    {
+        position_++;
+        if (Peek() == "<")
+        {
+            SkipGroup();
+        }
+
+        HlslResource resource;
+        resource.Type = kind;
+        resource.Name = ExpectIdentifier();
+        if (Accept("["))
+        {
+            resource.Count = ExpectNumber();
+            Expect("]");
+        }
+        const char registerClass = kind == HlslResource::Kind::Sampler ? 's' : kind == HlslResource::Kind::UnorderedAccess ? 'u' : 't';
+        ParseRegister(registerClass, resource.Register, resource.Space);
+        Expect(";");
+        return resource;
+    }
+
+    // Functions are recorded, global variables and typedefs are skipped.
+    void ParseDeclaration(HlslFile& file)
+    {
+        std::string lastIdentifier;
+        while (!AtEnd())
+        {
+            const std::string& text = Peek();
+            if (text == ";")
+            {
+                position_++;
+                return;
+            }
+            if (text == "{" || text == "[")
+            {
+                // Initializers and attributes like [numthreads(8, 8, 1)]
+                SkipGroup();
+                continue;
+            }
+            if (text == "(" && !lastIdentifier.empty())
+            {
+                ParseFunction(file, lastIdentifier);
+                return;
+            }
+            if (IsIdentifier(text))
+            {
+                lastIdentifier = text;
+            }
+            position_++;
+        }
+    }
+
+    void ParseFunction(HlslFile& file, const std::string& name)
+    {
+        HlslFunction function;
+        function.Name = name;
+
+        Expect("(");
+        if (!Accept(")"))
+        {
+            do
+            {
+                if (Peek() == "void" && Peek(1) == ")")
+                {
+                    position_++;
+                    break;
+                }
+                function.Parameters.push_back(ParseVariable(true));
+            } while (Accept(","));
+            Expect(")");
+        }
+
+        // Return semantic
+        if (Accept(":"))
+        {
+            ExpectIdentifier();
+        }
+
+        if (Accept(";"))
+        {
+            // Forward declaration
+            return;
+        }
+
+        Expect("{");
+        int depth = 1;
+        while (depth > 0)
+        {
+            const std::string& text = Next();
+            depth += text == "{" ? 1 : text == "}" ? -1 : 0;
+            if (IsIdentifier(text))
+            {
+                function.Identifiers.insert(text);
+            }
+        }
+        file.Functions[name] = function;
+    }
+
+    std::vector<Token> tokens_;
+    size_t position_;
+};
+
+};
+
+bool ParseHlslType(const std::string& name, HlslType& type)
+{
+    static const std::pair<const char*, HlslType::Base> kScalars[] =
+    {
+        { "float", HlslType::Base::Float },
+        { "int", HlslType::Base::Int },
+        { "uint", HlslType::Base::Uint },
+        { "dword", HlslType::Base::Uint },
+        { "bool", HlslType::Base::Bool },
+    };
+
+    for (const auto& scalar : kScalars)
+    {
+        const size_t length = strlen(scalar.first);
+        if (name.compare(0, length, scalar.first) != 0)
+        {
+            continue;
+        }
+
+        const std::string dimensions = name.substr(length);
+        type = HlslType();
+        type.Scalar = scalar.second;
+        if (dimensions.empty())
+        {
+            return true;
+        }
+        if (dimensions.size() == 1 && dimensions[0] >= '1' && dimensions[0] <= '4')
+        {
+            type.Columns = static_cast<uint32_t>(dimensions[0] - '0');
+            return true;
+        }
+        if (dimensions.size() == 3 && dimensions[1] == 'x' && dimensions[0] >= '1' && dimensions[0] <= '4' && dimensions[2] >= '1' && dimensions[2] <= '4')
+        {
+            type.Rows = static_cast<uint32_t>(dimensions[0] - '0');
+            type.Columns = static_cast<uint32_t>(dimensions[2] - '0');
+            return true;
+        }
+    }
+    return false;
+}
+
+std::set<std::string> HlslFile::GetReachableIdentifiers(const std::string& entryPoint) const
+{
+    std::set<std::string> identifiers;
+    std::set<std::string> visited;
+    std::vector<std::string> pending = { entryPoint };
+    while (!pending.empty())
+    {
+        const std::string name = pending.back();
+        pending.pop_back();
+        auto function = Functions.find(name);
+        if (function == Functions.end() || !visited.insert(name).second)
+        {
+            continue;
+        }
+
+        for (const std::string& identifier : function->second.Identifiers)
+        {
+            identifiers.insert(identifier);
+            if (Functions.count(identifier) > 0)
+            {
+                pending.push_back(identifier);
+            }
+        }
+    }
+    return identifiers;
+}
+
+HlslFile ParseHlsl(const std::string& source)
+{
+    return Parser(source).Parse();
+}
+
+}; // namespace shaderbindgen
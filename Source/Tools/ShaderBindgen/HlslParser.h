@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace shaderbindgen
+{
+
+//
+// HLSL type of a variable, e.g. float (1x1), float3 (1x3) or float4x4 (4x4).
+//
+struct HlslType
+{
+    enum class Base
+    {
+        Float,
+        Int,
+        Uint,
+        Bool
+    };
+
+    Base Scalar = Base::Float;
+    uint32_t Rows = 1;
+    uint32_t Columns = 1;
+    bool RowMajor = false;
+
+    bool IsMatrix() const { return Rows > 1; }
+};
+
+struct HlslVariable
+{
+    std::string Name;
+    HlslType Type;
+    std::string TypeName;
+    // 0 for non-arrays
+    uint32_t ArraySize = 0;
+    std::string Semantic;
+    bool IsOutput = false;
+};
+
+struct HlslConstantBuffer
+{
+    std::string Name;
+    uint32_t Register = 0;
+    uint32_t Space = 0;
+    std::vector<HlslVariable> Members;
+};
+
+struct HlslResource
+{
+    enum class Kind
+    {
+        ShaderResource,
+        UnorderedAccess,
+        Sampler
+    };
+
+    std::string Name;
+    Kind Type = Kind::ShaderResource;
+    uint32_t Register = 0;
+    uint32_t Space = 0;
+    uint32_t Count = 1;
+};
+
+struct HlslFunction
+{
+    std::string Name;
+    std::vector<HlslVariable> Parameters;
+    // Every identifier referenced by the body
+    std::set<std::string> Identifiers;
+};
+
+//
+// Declarations found in one HLSL file.
+//
+// This is a declaration scanner rather than a compiler: comments and preprocessor lines are skipped, and only
+// top level cbuffers, structs, resources and functions are recognized. Anything it can't make sense of is
+// reported with a line number.
+//
+struct HlslFile
+{
+    std::vector<HlslConstantBuffer> ConstantBuffers;
+    std::vector<HlslResource> Resources;
+    std::map<std::string, std::vector<HlslVariable>> Structs;
+    std::map<std::string, HlslFunction> Functions;
+
+    // Identifiers reachable from `entryPoint`, following calls into other functions of the file.
+    std::set<std::string> GetReachableIdentifiers(const std::string& entryPoint) const;
+};
+
+// Throws std::runtime_error on malformed or unsupported declarations.
+HlslFile ParseHlsl(const std::string& source);
+
+// Parses type names like float, uint3 or float4x4. Returns false for anything else.
+bool ParseHlslType(const std::string& name, HlslType& type);
+
+}; // namespace shaderbindgen
@@ -0,0 +1,113 @@
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "BindingsWriter.h"
+#include "HlslParser.h"
+
+//
+// ShaderBindgen <input.hlsl> <output.h> [--vs <entry point>] [--ps <entry point>] [--cs <entry point>]
+//
+// Generates the C++ declarations matching the bindings of an HLSL file, see BindingsWriter.h. The output is only
+// rewritten when its content changes, so sources including it don't rebuild for unrelated shader edits.
+//
+namespace
+{
+
+bool ReadFile(const std::string& path, std::string& content)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string GetStem(const std::string& path)
+{
+    const size_t separator = path.find_last_of("/\\");
+    std::string name = separator != std::string::npos ? path.substr(separator + 1) : path;
+    const size_t extension = name.find_last_of('.');
+    return extension != std::string::npos ? name.substr(0, extension) : name;
+}
+
+int PrintUsage()
+{
+    std::cerr << "Usage: ShaderBindgen <input.hlsl> <output.h> [--vs <entry point>] [--ps <entry point>] [--cs <entry point>]" << std::endl;
+    return 2;
+}
+
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        return PrintUsage();
+    }
+
+    const std::string inputPath = argv[1];
+    const std::string outputPath = argv[2];
+
+    shaderbindgen::BindingsOptions options;
+    options.Name = GetStem(inputPath);
+    options.SourceName = options.Name + inputPath.substr(inputPath.find_last_of('.') != std::string::npos ? inputPath.find_last_of('.') : inputPath.size());
+    for (int index = 3; index < argc; index++)
+    {
+        const std::string argument = argv[index];
+        if (argument == "--vs" && index + 1 < argc)
+        {
+            options.VertexEntryPoint = argv[++index];
+        }
+        else if (argument == "--ps" && index + 1 < argc)
+        {
+            options.PixelEntryPoint = argv[++index];
+        }
+        else if (argument == "--cs" && index + 1 < argc)
+        {
+            options.ComputeEntryPoint = argv[++index];
+        }
+        else
+        {
+            return PrintUsage();
+        }
+    }
+
+    std::string source;
+    if (!ReadFile(inputPath, source))
+    {
+        std::cerr << "Can't read " << inputPath << std::endl;
+        return 1;
+    }
+
+    std::string bindings;
+    try
+    {
+        bindings = shaderbindgen::WriteBindings(shaderbindgen::ParseHlsl(source), options);
+    }
+    catch (const std::exception& exception)
+    {
+        // Formatted like compiler messages so IDEs can jump to the line.
+        std::cerr << inputPath << ": error: " << exception.what() << std::endl;
+        return 1;
+    }
+
+    std::string existing;
+    if (ReadFile(outputPath, existing) && existing == bindings)
+    {
+        return 0;
+    }
+
+    std::ofstream output(outputPath, std::ios::binary);
+    output << bindings;
+    if (!output)
+    {
+        std::cerr << "Can't write " << outputPath << std::endl;
+        return 1;
+    }
+    return 0;
+}